@@ -0,0 +1,158 @@
+/*
+ *  BME280.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Driver for the Bosch BME280 humidity, temperature and pressure sensor on
+ *  I2C, behind the sensor interface of "Sensor.h". The sensor runs in normal
+ *  mode and converts on its own, the driver only fetches the result registers
+ *  by DMA and compensates them with the integer formulas of the datasheet.
+ *
+ *  Only built when the HAL I2C module is enabled (HAL_I2C_MODULE_ENABLED)
+ */
+
+#ifndef SRC_BME280_H_
+#define SRC_BME280_H_
+
+#include "stm32f4xx_hal.h" // must be modified according to target platform
+#include "Sensor.h"
+
+#ifdef HAL_I2C_MODULE_ENABLED
+
+/* I2C addresses, SDO pin low or high (shifted for the HAL) */
+#define BME280_ADDRESS_LOW (0x76 << 1)
+#define BME280_ADDRESS_HIGH (0x77 << 1)
+
+/* Registers */
+#define BME280_REG_CALIB 0x88	// First calibration register (dig_T1)
+#define BME280_REG_ID 0xD0
+#define BME280_REG_CALIB_H 0xE1	// Humidity calibration (dig_H2)
+#define BME280_REG_CTRL_HUM 0xF2
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_CONFIG 0xF5
+#define BME280_REG_DATA 0xF7	// press_msb, 8 result registers up to hum_lsb
+
+#define BME280_CHIP_ID 0x60
+
+/* Registers from the calibration to the last result register, read in one burst */
+#define BME280_BURST_SIZE (BME280_REG_DATA + 8 - BME280_REG_CALIB)
+#define BME280_DATA_SIZE 8
+
+/* Oversampling x1 for all three, normal mode, 250 ms standby, filter off */
+#define BME280_CTRL_HUM_VALUE 0x01
+#define BME280_CTRL_MEAS_VALUE 0x27
+#define BME280_CONFIG_VALUE 0x60
+
+/* Interval between fetches of the result registers in milliseconds */
+#define BME280_INTERVAL 1000
+
+/* Timeout of the blocking register accesses of BME280init in milliseconds */
+#define BME280_I2C_TIMEOUT 10
+
+/*
+ * Compensation parameters of the sensor (trimmed in the factory)
+ */
+typedef struct
+{
+	uint16_t T1;
+	int16_t T2;
+	int16_t T3;
+	uint16_t P1;
+	int16_t P2;
+	int16_t P3;
+	int16_t P4;
+	int16_t P5;
+	int16_t P6;
+	int16_t P7;
+	int16_t P8;
+	int16_t P9;
+	uint8_t H1;
+	int16_t H2;
+	uint8_t H3;
+	int16_t H4;
+	int16_t H5;
+	int8_t H6;
+} BME280_CalibTypeDef;
+
+/*
+ * BME280 sensor and its last reading
+ */
+typedef struct
+{
+	I2C_HandleTypeDef *hi2c;			// Bus of the sensor
+	uint16_t address;					// BME280_ADDRESS_LOW or BME280_ADDRESS_HIGH
+	volatile uint8_t phase;				// Transfer in progress
+	uint32_t lastStart;					// Tick of the last fetch
+	uint8_t triggered;					// Fetches only started by BME280trigger
+	uint8_t buffer[BME280_BURST_SIZE];	// Registers from BME280_REG_CALIB on
+	BME280_CalibTypeDef calib;
+	uint8_t cachedValid;
+	Sensor_ReadingTypeDef cached;		// Last valid reading
+	uint32_t cachedTick;
+} BME280_HandleTypeDef;
+
+	/*
+	 * @brief	Check the chip id, configure the sensor (normal mode) and start
+	 * 			the DMA burst of the calibration and result registers
+	 * 			The burst is completed by BME280update
+	 * @param	hbme handle to initialize
+	 * @param	hi2c I2C handle, must be setup prior with a DMA receive stream
+	 * @param	address BME280_ADDRESS_LOW or BME280_ADDRESS_HIGH
+	 * @retval	HAL_OK, HAL_ERROR if there is no BME280 at the address
+	 */
+	HAL_StatusTypeDef BME280init(BME280_HandleTypeDef *hbme, I2C_HandleTypeDef *hi2c,
+			uint16_t address);
+
+	/*
+	 * @brief	Sensor front-end, call as often as possible (never blocks)
+	 * 			Fetches the result registers by DMA every BME280_INTERVAL and
+	 * 			caches the compensated reading once the transfer is over
+	 * 			Once BME280trigger has been called, fetches are only started by it
+	 * @param	hbme sensor
+	 * @retval	SENSOR_OK when a new reading was cached by this call,
+	 * 			SENSOR_BUSY while a transfer is in progress,
+	 * 			SENSOR_IDLE while waiting for the next fetch,
+	 * 			SENSOR_ERROR if the transfer failed
+	 */
+	Sensor_StatusTypeDef BME280update(BME280_HandleTypeDef *hbme);
+
+	/*
+	 * @brief	Start a fetch of the result registers now, for sampling on an
+	 * 			external schedule (may be called from an interrupt). From the
+	 * 			first call on, BME280update no longer starts fetches.
+	 * @param	hbme sensor
+	 * @retval	SENSOR_BUSY if the fetch was started, SENSOR_IDLE if one is in
+	 * 			progress, SENSOR_ERROR if it could not start
+	 */
+	Sensor_StatusTypeDef BME280trigger(BME280_HandleTypeDef *hbme);
+
+	/*
+	 * @brief	Last valid reading cached by BME280update
+	 * @param	hbme sensor
+	 * @param	reading variable for humidity, temperature and pressure
+	 * 			not changed when the sample is SENSOR_SAMPLE_INVALID
+	 * @param	age variable for the time since the fetch in ms (may be NULL)
+	 * @retval	SENSOR_SAMPLE_FRESH, SENSOR_SAMPLE_STALE when older than
+	 * 			SENSOR_STALE_AGE, SENSOR_SAMPLE_INVALID before the first reading
+	 */
+	uint8_t BME280last_reading(BME280_HandleTypeDef *hbme, Sensor_ReadingTypeDef *reading,
+			uint32_t *age);
+
+	/*
+	 * @brief	Time until the next fetch is due, BME280_INTERVAL after the
+	 * 			last one started, for scheduling a retry or the first trigger
+	 * @param	hbme sensor
+	 * @retval	Milliseconds, 0 if a fetch is due now
+	 */
+	uint32_t BME280next_conversion(BME280_HandleTypeDef *hbme);
+
+	/*
+	 * Sensor interface ("Sensor.h") of the driver, the context is the
+	 * BME280_HandleTypeDef of the sensor
+	 */
+	extern const Sensor_DriverTypeDef BME280_sensor_driver;
+
+#endif /* HAL_I2C_MODULE_ENABLED */
+
+#endif /* SRC_BME280_H_ */
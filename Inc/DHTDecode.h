@@ -0,0 +1,60 @@
+/*
+ *  DHTDecode.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Decoder of DHT frames from the timestamps of the line edges.
+ *  Independent of the hardware (no HAL), so it builds for any target.
+ *
+ *  Bits are told apart by the width of their high pulse. Instead of a fixed
+ *  threshold, the 40 widths of a frame are split in two clusters (1-D
+ *  k-means), so long cables, slow clones and a different timer clock that
+ *  stretch or shrink every pulse do not move a bit across the threshold.
+ */
+
+#ifndef SRC_DHTDECODE_H_
+#define SRC_DHTDECODE_H_
+
+#include <stdint.h>
+
+/* Edges of a frame: response low and high, start of the first bit, 2 per bit */
+#define DHT_DECODE_EDGES 83
+
+/* Bits of a frame */
+#define DHT_DECODE_BITS 40
+
+/* Nominal threshold in microseconds (26 - 28 us for 0, 70 us for 1), used
+ * when the widths do not form two clusters (every bit has the same value) */
+#define DHT_DECODE_THRESHOLD 40
+
+/* Smallest distance in microseconds between the two cluster centers */
+#define DHT_DECODE_MIN_SPREAD 20
+
+/*
+ * Result of a decode
+ */
+typedef struct
+{
+	uint8_t data[5];						// Frame (RH, temp, check-sum)
+	uint32_t zeroWidth;						// Mean high pulse of the 0 bits
+	uint32_t oneWidth;						// Mean high pulse of the 1 bits
+	uint32_t threshold;						// Width separating 0 and 1 bits
+	uint8_t confidence[DHT_DECODE_BITS];	// Per bit, 0 (on the threshold) to 255 (on its cluster center or beyond)
+} DHTDecode_ResultTypeDef;
+
+	/*
+	 * @brief	Decode a frame from the timestamps of its edges
+	 * 			Edge 0 is the start of the sensor response, bit i rises on
+	 * 			edge 3 + 2i and falls on edge 4 + 2i
+	 * @param	edges timestamps of the line edges in microseconds
+	 * 			(any unit works, DHT_DECODE_MIN_SPREAD assumes microseconds)
+	 * @param	count number of timestamps
+	 * @param	result decoded frame and bit thresholds
+	 * @param	withConfidence 1 to fill result->confidence
+	 * @retval	1 if there are enough edges for a frame, 0 otherwise
+	 */
+	uint8_t DHTdecode(const uint32_t *edges, uint16_t count, DHTDecode_ResultTypeDef *result,
+			uint8_t withConfidence);
+
+#endif /* SRC_DHTDECODE_H_ */
@@ -0,0 +1,105 @@
+/*
+ *  DHTMulti.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Reads up to 16 DHT sensors wired to the pins of one GPIO port at the same
+ *  time. All sensors get the start pulse together, the port's input data
+ *  register is sampled at a fixed rate while the frames come in, and every
+ *  sensor's bits are decoded from that one buffer, all lines at once
+ *  (bit-sliced: one bit per line in each word, the samples before every
+ *  fall and'ed together tell the 1 bits of all the lines that fell).
+ *
+ *  Uses the frame check of "DHTemp.h"
+ */
+
+#ifndef SRC_DHTMULTI_H_
+#define SRC_DHTMULTI_H_
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h" // must be modified according to target platform
+#include "DHTemp.h"
+
+/* Sampling period of the port in microseconds */
+#define DHT_MULTI_SAMPLE_US 4
+
+/* Samples per read, enough for the response and the frame (6.1 ms) */
+#define DHT_MULTI_SAMPLES 1536
+
+/* High pulses longer than this many samples are 1 bits (DHT_BIT_THRESHOLD) */
+#define DHT_MULTI_BIT_THRESHOLD (DHT_BIT_THRESHOLD / DHT_MULTI_SAMPLE_US)
+
+/* Number of lines of a port */
+#define DHT_MULTI_LINES 16
+
+/*
+ * DHT sensors on one port and the result of their last read
+ */
+typedef struct
+{
+	GPIO_TypeDef *gpio;						// Port of the sensors
+	uint16_t pins;							// One bit per sensor line (GPIO_PIN_x)
+	TIM_HandleTypeDef *htim;				// Timer with microsecond per tick
+	uint8_t phase;							// Read in progress
+	uint32_t phaseStart;					// Timer count at the start of the phase
+	uint16_t samples[DHT_MULTI_SAMPLES];	// Input data register samples
+	DHT_StatusTypeDef status[DHT_MULTI_LINES];	// Result per line (pin number)
+	int16_t RH[DHT_MULTI_LINES];			// Humidity x10 per line, if DHT_OK
+	int16_t temp[DHT_MULTI_LINES];			// Temperature x10 per line, if DHT_OK
+} DHTMulti_HandleTypeDef;
+
+	/*
+	 * @brief	Define the sensor lines and timer, set the lines in idle state
+	 * @param	hdht handle to initialize
+	 * @param	GPIOx where x can be (A, B, C, etc.) to select the GPIO peripheral
+	 * @param	pins lines of the sensors, GPIO_PIN_x values or'ed together
+	 * @param	htim TIM handle, must be setup prior with microsecond per tick
+	 * @retval 	None
+	 */
+	void DHTmulti_init(DHTMulti_HandleTypeDef *hdht, GPIO_TypeDef *GPIOx, uint16_t pins,
+			TIM_HandleTypeDef *htim);
+
+	/*
+	 * @brief	Start a read of every sensor without blocking
+	 * 			(pulls all lines low for the start pulse)
+	 * @param	hdht sensors to read
+	 * @retval	None
+	 */
+	void DHTmulti_start_read(DHTMulti_HandleTypeDef *hdht);
+
+	/*
+	 * @brief	Advance a read started by DHTmulti_start_read
+	 * 			Returns right away during the start pulse. Once it is over,
+	 * 			the lines are released and sampled for about 6 ms (this call
+	 * 			blocks, interrupts longer than a few microseconds stretch the
+	 * 			samples), then every line is decoded.
+	 * @param	hdht sensors being read
+	 * @retval	DHT_BUSY during the start pulse, DHT_OK when the read is over
+	 * 			(per line results in hdht->status), DHT_IDLE if no read was started
+	 */
+	DHT_StatusTypeDef DHTmulti_poll(DHTMulti_HandleTypeDef *hdht);
+
+	/*
+	 * @brief	Decode the frames of every line from port samples
+	 * 			Independent of the hardware, the samples may come from anywhere
+	 * @param	samples input data register samples taken every
+	 * 			DHT_MULTI_SAMPLE_US, starting after the lines are released
+	 * @param	count number of samples
+	 * @param	pins lines to decode
+	 * @param	frames the 5 bytes of the frame of each line (pin number)
+	 * @param	status DHT_OK, DHT_NO_RESPONSE or DHT_TIMEOUT per line,
+	 * 			the check-sum is not checked here
+	 * @retval	None
+	 */
+	void DHTmulti_decode(const uint16_t *samples, uint32_t count, uint16_t pins,
+			uint8_t frames[DHT_MULTI_LINES][5], DHT_StatusTypeDef *status);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* SRC_DHTMULTI_H_ */
@@ -18,42 +18,291 @@
 
 #include "stm32f4xx_hal.h" // must be modified according to target platform
 #include "Delay.h"
+#include "DHTDecode.h"
+#include "Sensor.h"
+
+/* Edges of a frame: response low and high, start of the first bit, 2 per bit */
+#define DHT_FRAME_EDGES DHT_DECODE_EDGES
+
+/* Sensor models */
+#define DHT_MODEL_AUTO 0
+#define DHT_MODEL_DHT11 1
+#define DHT_MODEL_DHT22 2
+
+/* Start pulse in microseconds, at least 1 ms for DHT22 and 18 ms for DHT11
+ * (the DHT11 pulse is used until the model is known, the DHT22 takes up to 20 ms) */
+#define DHT_START_PULSE 10000
+#define DHT11_START_PULSE 18000
+
+/* Minimum time between the start of two conversions in ms */
+#define DHT22_INTERVAL 2000
+#define DHT11_INTERVAL 1000
+
+/* Retries after failed conversions: the interval doubles up to DHT_BACKOFF_MAX ms */
+#define DHT_BACKOFF_MAX 60000
+#define DHT_BACKOFF_SHIFT_MAX 5
+
+/* Triggers up to this many ms before the end of the interval are accepted (DHTtrigger) */
+#define DHT_TRIGGER_SLACK 10
+
+/* Cached readings older than this many ms are stale */
+#define DHT_STALE_AGE SENSOR_STALE_AGE
+
+/* Tags of the cached reading */
+#define DHT_SAMPLE_INVALID SENSOR_SAMPLE_INVALID
+#define DHT_SAMPLE_FRESH SENSOR_SAMPLE_FRESH
+#define DHT_SAMPLE_STALE SENSOR_SAMPLE_STALE
+
+/* Longest wait for the sensor response after the start pulse in microseconds */
+#define DHT_RESPONSE_TIMEOUT 200
+
+/* Longest read after the start pulse in microseconds (response and 40 bits of at most 120 us) */
+#define DHT_FRAME_TIMEOUT 6000
+
+/* High pulses longer than this are 1 bits (26 - 28 us for 0, 70 us for 1),
+ * nominal value only, both reads adapt it to every frame (DHTdecode) */
+#define DHT_BIT_THRESHOLD DHT_DECODE_THRESHOLD
+
+/* Longest wait for a level change of the line in microseconds
+ * (the longest level the sensor sends is the 80 us response) */
+#define DHT_EDGE_TIMEOUT 100
+
+/*
+ * Result of a read
+ */
+typedef enum
+{
+	DHT_OK = 0,			// Frame received and check-sum verified
+	DHT_NO_RESPONSE,	// The sensor did not answer the start pulse
+	DHT_TIMEOUT,		// The sensor stopped sending in the middle of the frame
+	DHT_CHECKSUM,		// The check-sum does not match the data
+	DHT_BUSY,			// DHTpoll: the read is still in progress
+	DHT_IDLE			// DHTpoll: no read has been started
+} DHT_StatusTypeDef;
+
+#ifdef DHT_TELEMETRY
+/* Telemetry histograms: response latency (release of the line to the first
+ * edge) in 10 us bins, high pulse widths of the bits in 8 us bins, the last
+ * bin of each also counts everything above it */
+#define DHT_TELEMETRY_LATENCY_BINS 8
+#define DHT_TELEMETRY_LATENCY_BIN 10
+#define DHT_TELEMETRY_WIDTH_BINS 16
+#define DHT_TELEMETRY_WIDTH_BIN 8
+
+/*
+ * Signal quality counters, compiled in with DHT_TELEMETRY defined
+ * Counters saturate instead of wrapping
+ */
+typedef struct
+{
+	uint32_t reads;			// Reads that ended (any status)
+	uint32_t ok;			// DHT_OK
+	uint32_t noResponse;	// DHT_NO_RESPONSE
+	uint32_t timeouts;		// DHT_TIMEOUT
+	uint32_t checksums;		// DHT_CHECKSUM
+	uint32_t retries;		// Reads started after a failed one
+	uint16_t latency[DHT_TELEMETRY_LATENCY_BINS];
+	uint16_t widths[DHT_TELEMETRY_WIDTH_BINS];
+} DHT_TelemetryTypeDef;
+#endif
 
 	/*
 	 * @brief	Receive RH, Temp, and Check-sum data and update parameters
+	 * 			Every wait on the line is bounded by DHT_EDGE_TIMEOUT, so a read
+	 * 			takes at most about 26 ms (18 ms start pulse, 40 bits of at most
+	 * 			2 x DHT_EDGE_TIMEOUT). The high pulse of every bit is timed and
+	 * 			the frame decoded from the widths as DHTpoll does (DHTdecode)
 	 * @param	RH variable for humidity x10 as per DHT documentation
 	 * @param	temp variable for temperature x10 as per DHT documentation
-	 * @retval	None
+	 * 			RH and temp are only updated when the status is DHT_OK
+	 * @retval	DHT_OK, DHT_NO_RESPONSE, DHT_TIMEOUT or DHT_CHECKSUM
 	 */
-	void DHTreceive_data(int16_t *RH, int16_t *temp);
+	DHT_StatusTypeDef DHTreceive_data(int16_t *RH, int16_t *temp);
 
 	/*
 	 * @brief	Define library GPIO pin and timer parameters, initialize GPIO pin
 	 * @param	GPIOx where x can be (A, B, C, etc.) to select the GPIO peripheral
 	 * @param	GPIO_Pin specifies the port bit to serve as communication line
 	 * 			of the form GPIO_PIN_x (where x = 0, 1, 2, etc.)
-	 * @param	htim TIM handle for Delay library
-	 * 			Must be setup prior with microsecond per tick
+	 * @param	htim TIM handle of the edge timestamps and read deadlines
+	 * 			Must be setup prior with microsecond per tick, it is started
+	 * 			here and left running (other users may share it)
 	 * @retval 	None
 	 */
-	void DHTinit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin, TIM_HandleTypeDef htim);
+	void DHTinit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin, TIM_HandleTypeDef *htim);
+
+	/*
+	 * @brief	Start a read without blocking.
+	 * 			Pulls the line low for the start pulse and returns. DHTpoll
+	 * 			releases the line once the start pulse has passed, with an EXTI
+	 * 			interrupt on both edges. DHTcapture_edge timestamps every edge
+	 * 			with the timer counter and the frame is decoded from the pulse
+	 * 			widths once it is complete.
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTstart_read();
+
+	/*
+	 * @brief	Advance a read started by DHTstart_read, never blocks.
+	 * 			Start pulse, sensor response, frame reception and decoding
+	 * 			each end on a deadline of the timer counter, so the read fails
+	 * 			with a status instead of waiting for a missing edge.
+	 * @param	RH variable for humidity x10 as per DHT documentation
+	 * @param	temp variable for temperature x10 as per DHT documentation
+	 * 			RH and temp are only updated when the status is DHT_OK
+	 * @retval	DHT_BUSY while the read is in progress, then its result once
+	 * 			(DHT_OK, DHT_NO_RESPONSE, DHT_TIMEOUT or DHT_CHECKSUM),
+	 * 			DHT_IDLE when no read has been started
+	 */
+	DHT_StatusTypeDef DHTpoll(int16_t *RH, int16_t *temp);
+
+	/*
+	 * @brief	Record an edge of the communication line.
+	 * 			Must be called from HAL_GPIO_EXTI_Callback for the DHT pin.
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTcapture_edge();
+
+	/*
+	 * @brief	Check the check-sum of a frame and convert its values
+	 * 			(also used by "DHTMulti.h" for the frame of each of its lines)
+	 * @param	data the 5 bytes of the frame (RH, temp, check-sum)
+	 * @param	model DHT_MODEL_DHT11, DHT_MODEL_DHT22 or DHT_MODEL_AUTO
+	 * 			to pick the encoding with DHTdetect_model
+	 * @param	RH variable for humidity x10, updated if the check-sum matches
+	 * @param	temp variable for temperature x10, updated if the check-sum matches
+	 * @retval	DHT_OK or DHT_CHECKSUM
+	 */
+	DHT_StatusTypeDef DHTconvert_frame(const uint8_t *data, uint8_t model, int16_t *RH, int16_t *temp);
+
+	/*
+	 * @brief	Tell the encoding of a frame.
+	 * 			A DHT22 sends humidity x10 (at most 1000), so its first byte is
+	 * 			at most 3. A DHT11 sends the integral part of the humidity
+	 * 			(20 - 90 %) there.
+	 * @param	data the 5 bytes of the frame
+	 * @retval	DHT_MODEL_DHT11 or DHT_MODEL_DHT22
+	 */
+	uint8_t DHTdetect_model(const uint8_t *data);
+
+	/*
+	 * @brief	Select the sensor model (DHT_MODEL_AUTO by default)
+	 * 			The model sets the frame encoding, the start pulse and the
+	 * 			interval between conversions of DHTupdate.
+	 * @param	sensorModel DHT_MODEL_DHT11, DHT_MODEL_DHT22 or DHT_MODEL_AUTO
+	 * @retval	None
+	 */
+	void DHTset_model(uint8_t sensorModel);
+
+	/*
+	 * @brief	Sensor front-end, call as often as possible (never blocks).
+	 * 			Starts a conversion once the minimum interval of the model has
+	 * 			passed since the last one (DHT22_INTERVAL or DHT11_INTERVAL,
+	 * 			DHT22_INTERVAL until an auto-detected model is known), advances
+	 * 			it with DHTpoll and caches the result if it is valid.
+	 * 			After a failed conversion the interval doubles with every
+	 * 			further failure, up to DHT_BACKOFF_MAX, plus up to a quarter of
+	 * 			random jitter, and is back to normal after a valid one.
+	 * 			Once DHTtrigger has been called, conversions are only started
+	 * 			by it.
+	 * @param	None
+	 * @retval	DHT_OK when a new reading was cached by this call,
+	 * 			DHT_BUSY while a conversion is in progress,
+	 * 			DHT_IDLE while waiting for the next conversion,
+	 * 			otherwise the error of the conversion that just ended
+	 */
+	DHT_StatusTypeDef DHTupdate();
+
+	/*
+	 * @brief	Start a conversion now, for sampling on an external schedule.
+	 * 			May be called from a timer interrupt of lower priority than the
+	 * 			EXTI interrupt of the line. From the first call on, DHTupdate
+	 * 			only completes conversions and no longer starts them.
+	 * 			The trigger is skipped while a conversion is in progress,
+	 * 			during the backoff after failures and while the minimum
+	 * 			interval of the model has not passed (DHT_TRIGGER_SLACK early
+	 * 			is accepted).
+	 * @param	None
+	 * @retval	DHT_BUSY if a conversion was started, DHT_IDLE if skipped
+	 */
+	DHT_StatusTypeDef DHTtrigger();
+
+	/*
+	 * @brief	Time until DHTtrigger will start a conversion, for scheduling
+	 * 			the retry at the end of a backoff
+	 * @param	None
+	 * @retval	Milliseconds, 0 if a trigger would start a conversion now
+	 */
+	uint32_t DHTnext_conversion();
+
+	/*
+	 * @brief	Last valid reading cached by DHTupdate
+	 * @param	RH variable for humidity x10
+	 * @param	temp variable for temperature x10
+	 * 			RH and temp are not changed when the sample is DHT_SAMPLE_INVALID
+	 * @param	age variable for the time since the conversion in ms (may be NULL)
+	 * @retval	DHT_SAMPLE_FRESH, DHT_SAMPLE_STALE when older than DHT_STALE_AGE,
+	 * 			DHT_SAMPLE_INVALID (0) before the first valid conversion
+	 */
+	uint8_t DHTlast_reading(int16_t *RH, int16_t *temp, uint32_t *age);
+
+	/*
+	 * Sensor interface ("Sensor.h") of the driver, DHTupdate and
+	 * DHTlast_reading behind it, the context is not used (NULL)
+	 */
+	extern const Sensor_DriverTypeDef DHT_sensor_driver;
+
+#ifdef DHT_TELEMETRY
+	/*
+	 * @brief	Copy the telemetry counters (only with DHT_TELEMETRY defined)
+	 * @param	snapshot counters since DHTinit or the last DHTtelemetry_reset
+	 * @retval	None
+	 */
+	void DHTtelemetry(DHT_TelemetryTypeDef *snapshot);
+
+	/*
+	 * @brief	Clear the telemetry counters (only with DHT_TELEMETRY defined)
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTtelemetry_reset();
+
+	/*
+	 * @brief	Send the telemetry counters over SWO (ITM port 0, only with
+	 * 			DHT_TELEMETRY defined), nothing is sent without a debugger
+	 * 			Three lines: the read counters, then the latency and the bit
+	 * 			width histograms, bins separated by commas
+	 * 			"DHT reads=12 ok=10 no-response=1 timeouts=1 checksums=0 retries=2"
+	 * 			"DHT latency/10us 0,0,11,0,0,0,0,0"
+	 * 			"DHT width/8us 0,0,0,230,...,0"
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTtelemetry_report();
+#endif
 
 	/*
 	 * @brief	Begin communication between MCU and AM2302.
 	 * 			The function performs preparation for communication pattern
 	 * 			between the MCU and AM2302.
 	 * @param	None
-	 * @retval	comStatus boolean value signifying the success of establishing
-	 * 			communication between the two devices
+	 * @retval	DHT_OK if communication between the two devices has been
+	 * 			established, DHT_NO_RESPONSE or DHT_TIMEOUT otherwise
 	 */
-	uint8_t begin_com();
+	DHT_StatusTypeDef begin_com();
 
 	/*
-	 * @brief	Receive one bit of data
-	 * @param	None
-	 * @retval	dataBit RH/Temp/Check-sum bit of data
+	 * @brief	Receive one bit of data: time its high pulse
+	 * 			The value is told by DHTdecode from the widths of the whole
+	 * 			frame, not by sampling the line at a fixed point
+	 * @param	frameStart cycle count (delay_now) the timestamps count from
+	 * @param	edges timestamps of the rise and the fall of the bit in
+	 * 			microseconds, as DHTdecode takes them
+	 * @retval	DHT_OK, or DHT_TIMEOUT if the sensor stopped sending
 	 */
-	uint8_t receive_bit();
+	DHT_StatusTypeDef receive_bit(uint32_t frameStart, uint32_t *edges);
 
 	/*
 	 * @brief	Set communication line in idle state
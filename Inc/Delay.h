@@ -3,6 +3,11 @@
  *
  *  Created on: Dec 22, 2022
  *      Author: Jake Ivanov
+ *
+ *  Busy-wait delays and deadlines on the Cortex-M4 DWT cycle counter.
+ *  The counter is never stopped, a deadline is a cycle count and is compared
+ *  with a signed difference, so it stays correct across the counter wrap as
+ *  long as it is less than 2^31 cycles away (25 s at 84 MHz).
  */
 
 #ifndef SRC_DELAY_H_
@@ -10,10 +15,61 @@
 
 #include "stm32f4xx_hal.h"
 
+	/*
+	 * @brief	Start the cycle counter, call once after the clock is configured
+	 * 			(calling it again only picks up a new SystemCoreClock)
+	 * @param	None
+	 * @retval	None
+	 */
+	void delay_init(void);
+
+	/*
+	 * @brief	Current count of the cycle counter
+	 * @param	None
+	 * @retval	Core clock cycles, wraps at 2^32
+	 */
+	uint32_t delay_now(void);
+
+	/*
+	 * @brief	Deadline some time from now
+	 * @param	ns/us	Time to the deadline, less than 2^31 cycles
+	 * @retval	Cycle count of the deadline, for delay_expired
+	 */
+	uint32_t delay_deadline_ns(uint32_t ns);
+	uint32_t delay_deadline_us(uint32_t us);
+
+	/*
+	 * @brief	Whether a deadline has passed (wrap-safe)
+	 * @param	deadline	Cycle count from delay_deadline_ns/us or delay_now
+	 * @retval	1 once the cycle counter has reached the deadline, 0 before
+	 */
+	uint8_t delay_expired(uint32_t deadline);
+
+	/*
+	 * @brief	Time since a cycle count
+	 * @param	since	Cycle count from delay_now, less than 2^32 cycles ago
+	 * @retval	Elapsed time in microseconds, rounded down
+	 */
+	uint32_t delay_elapsed_us(uint32_t since);
+
+	/*
+	 * @brief	Blocking delays of at least the given time
+	 * @param	ns/us	Time to wait, less than 2^31 cycles
+	 * @param	ms		Time to wait in milliseconds, any value
+	 * @retval	None
+	 */
+	void delay_ns(uint32_t ns);
+	void delay_us(uint32_t us);
+	void delay_ms(uint32_t ms);
+
 	/*
 	 * @brief	Provides blocking delay in microseconds.
+	 * 			Kept for existing callers, delay_us does not need a timer.
+	 * 			The timer is started if needed and left running.
 	 * @param	htim	TIM handle.
-	 * 					Must be setup prior with microsecond per tick
+	 * 					Must be setup prior with microsecond per tick and an
+	 * 					auto-reload value of 2^n - 1 (0xFFFF, 0xFFFFFFFF): the
+	 * 					ticks are counted modulo the reload value + 1
 	 * @param	delay	Desired delay in microseconds.
 	 * 					Max delay - 65535/(2^32 - 1) microseconds (16/32 bit timer).
 	 * @retval	None
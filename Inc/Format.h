@@ -0,0 +1,58 @@
+/*
+ * Format.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ *
+ *  Integer and fixed-point number formatting without printf
+ *  Nothing is allocated, every function writes into a buffer given by the caller
+ */
+
+#ifndef SRC_FORMAT_H_
+#define SRC_FORMAT_H_
+
+#include <stdint.h>
+
+// field alignment
+#define FMT_ALIGN_LEFT 0x00
+#define FMT_ALIGN_RIGHT 0x01
+
+// widest field, the length of an HD44780 line
+#define FMT_MAX_WIDTH 40
+
+// most decimals a fixed-point value can have (10^9 still fits in 32 bits)
+#define FMT_MAX_DECIMALS 9
+
+// buffer size that holds any field (widest field and the terminating null)
+#define FMT_BUFFER_SIZE (FMT_MAX_WIDTH + 1)
+
+	/*
+	 * @brief	Formats an integer in decimal.
+	 * @param	buffer	Destination, at least FMT_BUFFER_SIZE bytes.
+	 * @param	value	Integer to format (the whole int32 range).
+	 * @retval	Number of characters written, not counting the terminating null.
+	 */
+	uint8_t fmt_int(char *buffer, int32_t value);
+
+	/*
+	 * @brief	Formats an unsigned integer in decimal (counters, cycle counts).
+	 * @param	buffer	Destination, at least FMT_BUFFER_SIZE bytes.
+	 * @param	value	Integer to format (the whole uint32 range).
+	 * @retval	Number of characters written, not counting the terminating null.
+	 */
+	uint8_t fmt_uint(char *buffer, uint32_t value);
+
+	/*
+	 * @brief	Formats a fixed-point value, e.g. 725 with 1 decimal as "72.5".
+	 * 			Values between -1 and 1 get a leading zero ("-0.5").
+	 * @param	buffer		Destination, at least FMT_BUFFER_SIZE bytes.
+	 * @param	value		Value in units of 10^-decimals (deci-units for 1 decimal).
+	 * @param	decimals	Digits after the decimal point, 0 - FMT_MAX_DECIMALS.
+	 * @param	width		Minimum field width, padded with spaces (0 - FMT_MAX_WIDTH).
+	 * 						Numbers wider than the field are written in full.
+	 * @param	align		FMT_ALIGN_LEFT or FMT_ALIGN_RIGHT.
+	 * @retval	Number of characters written, not counting the terminating null.
+	 */
+	uint8_t fmt_fixed(char *buffer, int32_t value, uint8_t decimals, uint8_t width, uint8_t align);
+
+#endif /* SRC_FORMAT_H_ */
@@ -22,7 +22,7 @@ extern "C" {
 #endif
 
 #include <stm32f4xx_hal.h> // must be modified according to target platform
-#include <stdio.h>
+#include "Format.h"
 
 // commands
 #define LCD_CLEARDISPLAY 0x01
@@ -62,7 +62,173 @@ extern "C" {
 #define LCD_5x10DOTS 0x04
 #define LCD_5x8DOTS 0x00
 
+// write modes (how the driver waits for the LCD between bytes)
+#define LCD_WAIT_DELAY 0x00
+#define LCD_WAIT_BUSYFLAG 0x01
+
+// busy flag (D7) as returned by a read with RS = 0, RW = 1
+#define LCD_BUSYFLAG 0x80
+
+// write modes (whether LCD calls wait for the bus or return immediately)
+#define LCD_WRITE_BLOCKING 0x00
+#define LCD_WRITE_ASYNC 0x01
+#define LCD_WRITE_DMA 0x02
+
+// number of bytes the asynchronous queue can hold (a full 16x2 frame
+// with its two address commands fits twice)
+#define LCD_QUEUE_SIZE 128
+
+// BSRR words per DMA buffer (two buffers), a byte takes 13 words at 5 us per tick
+// A clear or home (LCD_EXEC_LONG_NS) needs more words than a buffer holds below
+// about 4.3 us per tick, its wait then runs on into the following buffers
+#define LCD_DMA_WORDS 512
+
+// shortest DMA tick: the enable pulse is at least 5 ticks, and DMA2 needs
+// some margin to keep up with the timer
+#define LCD_DMA_MIN_TICK_NS 100
+
+// bus timings used to compile DMA waveforms, in nanoseconds
+// (enable pulse width, and execution times with margin for a slow oscillator)
+#define LCD_ENABLE_NS 450
+#define LCD_EXEC_NS 50000
+#define LCD_EXEC_LONG_NS 2200000
+
+// PCF8574 I2C backpack pin mapping (P4 - P7 carry D4 - D7)
+#define LCD_PCF_RS 0x01
+#define LCD_PCF_RW 0x02
+#define LCD_PCF_EN 0x04
+#define LCD_PCF_BACKLIGHT 0x08
+
+// bytes per I2C transaction, 4 per character plus one
+#define LCD_I2C_BUFFER 129
+
+// DDRAM size, the largest number of cells the frame buffer can hold
+#define LCD_DDRAM_SIZE 80
+
+// longest line of an HD44780 (1 and 2 line displays)
+#define LCD_MAX_COLS 40
+
+// maximum number of displays in DMA mode at the same time
+#define LCD_MAX_DMA_DISPLAYS 4
+
+// maximum number of busy flag reads before giving up on the LCD
+// (a clear takes ~1.52 ms, each read takes at least 1 us)
+#define LCD_BUSY_TIMEOUT 4000
+
 /*
+     * LCD_TransportTypeDef
+     * -------
+     * The bus bytes go out on, selected by pin_setup, pin_setup_4bit or i2c_setup
+     *
+     * bitmode: LCD_8BITMODE or LCD_4BITMODE (the function set of the bus)
+     * init: reset sequence up to the point where the LCD talks in bitmode
+     * send: send one byte (mode: 0 = command, 1 = data)
+     * write: send a run of bytes with the same mode
+     */
+    typedef struct __LCD_HandleTypeDef LCD_HandleTypeDef;
+
+    typedef struct
+    {
+        unsigned char bitmode;
+        void (*init)(LCD_HandleTypeDef *lcd);
+        void (*send)(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode);
+        void (*write)(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length, unsigned char mode);
+    } LCD_TransportTypeDef;
+
+    /*
+     * LCD_HandleTypeDef
+     * -------
+     * Everything the driver knows about one display
+     * Every LCD function takes a pointer to one, so several displays can be
+     * driven side by side. Only the setup functions (pin_setup, pin_setup_4bit
+     * or i2c_setup) and begin touch a fresh handle, which should be zeroed
+     * (a static or {0} initialized variable)
+     */
+    struct __LCD_HandleTypeDef
+    {
+        // display state
+        unsigned char displaycontrol;
+        unsigned char displayfunction;
+        unsigned char displaymode;
+        unsigned char numlines;
+        unsigned char numcols;
+        unsigned char waitmode;
+        unsigned char rowOffsets[4];
+
+        // bus pins, all on gpioPort
+        GPIO_TypeDef  *gpioPort;
+        uint16_t      dataPins[8];
+        uint16_t      rs;
+        uint16_t      rw;
+        uint16_t      enable;
+        uint16_t      busyPin;
+        uint32_t      dataModerMask;
+        uint32_t      dataModerOutput;
+
+        // BSRR words placing every byte value on the data pins (set bits in the
+        // low half, reset bits in the high half), built once by pin_setup
+        uint32_t      busTable[256];
+
+        // BSRR words for rs = mode (0 = command, 1 = data) and rw = 0
+        uint32_t      ctrlWords[2];
+
+        // Bus the bytes go out on (8-bit parallel, 4-bit parallel or I2C backpack)
+        const LCD_TransportTypeDef *transport;
+
+#ifdef HAL_I2C_MODULE_ENABLED
+        // PCF8574 backpack: every LCD byte is packed as 4 expander writes
+        // (nibble with enable high, nibble with enable low, twice)
+        I2C_HandleTypeDef *i2c;
+        uint16_t          i2cAddress;
+        uint8_t           i2cBacklight;
+        uint8_t           i2cBuffer[LCD_I2C_BUFFER];
+#endif
+
+        // Frame buffer: frame holds what the application wants on the screen,
+        // shadow what the LCD's DDRAM currently holds (one byte per visible cell,
+        // row after row, numcols cells per row)
+        unsigned char buffered;
+        unsigned char frame[LCD_DDRAM_SIZE];
+        unsigned char shadow[LCD_DDRAM_SIZE];
+        unsigned char frameCol;
+        unsigned char frameRow;
+
+        // CGRAM glyph cache: the bitmap in each of the 8 custom character
+        // slots, its hash and the last time it was used (0 = slot empty)
+        unsigned char glyphs[8][8];
+        uint32_t      glyphHash[8];
+        uint32_t      glyphUsed[8];
+        uint32_t      glyphClock;
+        uint32_t      glyphUploads; // slots written since begin
+
+        // Asynchronous mode: bytes queued by the application (bit 8 = rs) and
+        // drained one bus phase per processQueue call
+        unsigned char              writemode;
+        TIM_HandleTypeDef          *asyncTimer;
+        volatile unsigned char     timerRunning;
+        volatile uint16_t          queue[LCD_QUEUE_SIZE];
+        volatile unsigned int      queueHead; // written by the application only
+        volatile unsigned int      queueTail; // written by processQueue only
+        volatile unsigned char     phase;
+        uint16_t                   current;
+        uint32_t                   waitStart; // cycle count (HAL tick without the cycle counter)
+        uint32_t                   busyTries;
+
+        // DMA mode: precompiled BSRR words streamed to the GPIO port by a
+        // timer-paced DMA stream, one buffer is filled while the other is sent
+        TIM_HandleTypeDef          *dmaTimer;
+        DMA_HandleTypeDef          *dmaHandle;
+        uint32_t                   dmaBuffers[2][LCD_DMA_WORDS];
+        unsigned int               dmaLen;    // words in the buffer being filled
+        unsigned char              dmaFill;   // index of the buffer being filled
+        volatile unsigned char     dmaBusy;   // the other buffer is being sent
+        unsigned int               dmaEnableTicks;
+        unsigned int               dmaExecTicks;
+        unsigned int               dmaLongTicks;
+        unsigned int               dmaCarry;  // idle words of a split wait still to be sent
+    };
+
+    /*
      * Pin setup
      * -------
      * Maps the STM32 pins to the LCD pins
@@ -73,10 +239,44 @@ extern "C" {
      * and that the pins are of the form GPIO_PIN_x (where x = 0, 1, 2, etc.)
      *
      * The function assumes all GPIO ports have already been initialized prior by the user
+     *
+     * The single port lets every byte go out with one BSRR store: the set/reset
+     * words for all 256 byte values are computed here once
      */
-    void pin_setup(GPIO_TypeDef *GPIOx, uint16_t d0, uint16_t d1, uint16_t d2, uint16_t d3,
+    void pin_setup(LCD_HandleTypeDef *lcd, GPIO_TypeDef *GPIOx, uint16_t d0, uint16_t d1, uint16_t d2, uint16_t d3,
     		uint16_t d4, uint16_t d5, uint16_t d6, uint16_t d7, uint16_t rs, uint16_t rw, uint16_t e);
 
+    /*
+     * Pin setup (4-bit)
+     * -------
+     * Maps the STM32 pins to the LCD pins for a 4-bit bus (D0 - D3 of the LCD left open)
+     * Same requirements as pin_setup, which it replaces
+     *
+     * Bytes are sent as two nibbles, high nibble first
+     */
+    void pin_setup_4bit(LCD_HandleTypeDef *lcd, GPIO_TypeDef *GPIOx, uint16_t d4, uint16_t d5, uint16_t d6, uint16_t d7,
+    		uint16_t rs, uint16_t rw, uint16_t e);
+
+#ifdef HAL_I2C_MODULE_ENABLED
+    /*
+     * I2C setup
+     * -------
+     * Drive the LCD through a PCF8574 I2C backpack instead of GPIO pins
+     * (P0 = rs, P1 = rw, P2 = enable, P3 = backlight, P4 - P7 = D4 - D7)
+     * This function replaces pin_setup
+     *
+     * Whole strings are packed into one I2C transaction. If hi2c has a TX DMA
+     * stream linked the transaction is sent with DMA and the call returns
+     * right away (the next call waits for it to finish)
+     * The busy flag is not read, the bus speed (at most 400 kHz) provides the
+     * execution time between bytes
+     *
+     * hi2c: I2C handle, initialized by the user
+     * address: 7 bit address of the backpack (0x27 or 0x3F for most boards)
+     */
+    void i2c_setup(LCD_HandleTypeDef *lcd, I2C_HandleTypeDef *hi2c, uint8_t address);
+#endif
+
     /*
      * begin
      * ------
@@ -89,13 +289,13 @@ extern "C" {
      *
      * dotsize: can be either LCD_5x8DOTS or LCD_5x10DOTS (mine is 5x8)
      */
-    void begin(unsigned char cols, unsigned char lines, unsigned char dotsize);
+    void begin(LCD_HandleTypeDef *lcd, unsigned char cols, unsigned char lines, unsigned char dotsize);
 
     /* write
      * -------
      * Write a character to the LCD
      */
-    void write(unsigned char chr);
+    void write(LCD_HandleTypeDef *lcd, unsigned char chr);
 
 
     /* print
@@ -103,21 +303,34 @@ extern "C" {
      * Print a string
      *
      */
-    void print(unsigned char *chr);
+    void print(LCD_HandleTypeDef *lcd, unsigned char *chr);
 
     /* print_int
      * ------
      * Print an integer
      *
      */
-    void print_int(int num);
+    void print_int(LCD_HandleTypeDef *lcd, int num);
+
+    /* print_fixed
+     * ------
+     * Print a fixed-point value in a field of constant width, so a shorter
+     * value overwrites all of a longer one without printing extra spaces
+     *
+     * value: value in units of 10^-decimals (e.g. 725 with 1 decimal is 72.5)
+     * decimals: digits after the decimal point (0 - FMT_MAX_DECIMALS)
+     * width: field width, padded with spaces (0 prints just the number)
+     * align: FMT_ALIGN_LEFT or FMT_ALIGN_RIGHT
+     */
+    void print_fixed(LCD_HandleTypeDef *lcd, int32_t value, unsigned char decimals, unsigned char width,
+            unsigned char align);
 
     /* displayON
      * ------------
      * Turn on the display
      *
      */
-    void displayON();
+    void displayON(LCD_HandleTypeDef *lcd);
 
     /* display
      * -----------
@@ -126,7 +339,7 @@ extern "C" {
      * Arduino LiquidCrystal library
      *
      */
-    void display();
+    void display(LCD_HandleTypeDef *lcd);
 
 
      /* displayOFF
@@ -134,7 +347,7 @@ extern "C" {
      * Turn off the display
      *
      */
-    void displayOFF();
+    void displayOFF(LCD_HandleTypeDef *lcd);
 
     /* noDisplay
      * -----------
@@ -143,13 +356,13 @@ extern "C" {
      * Arduino LiquidCrystal library
      *
      */
-    void noDisplay();
+    void noDisplay(LCD_HandleTypeDef *lcd);
 
     /* clear
      * -------
      * Clears the screen and return cursor to home
      */
-    void clear();
+    void clear(LCD_HandleTypeDef *lcd);
 
     /* home
      * --------
@@ -157,7 +370,7 @@ extern "C" {
      * Doesn't clear the screen
      *
      */
-    void home();
+    void home(LCD_HandleTypeDef *lcd);
 
     /*
      * setRowOffsets
@@ -175,7 +388,7 @@ extern "C" {
      * row3: starting address of second row in the second line
 
      */
-    void setRowOffsets(unsigned char row0, unsigned char row1, unsigned char row2, unsigned char row3);
+    void setRowOffsets(LCD_HandleTypeDef *lcd, unsigned char row0, unsigned char row1, unsigned char row2, unsigned char row3);
 
     /*
      * setCursor
@@ -185,42 +398,42 @@ extern "C" {
      * col: column number (in my case 0 to 31), the col after 15 are not visible (right of screen)
      * row: row number (in my case 0 to 3)
      */
-    void setCursor(unsigned char col, unsigned row);
+    void setCursor(LCD_HandleTypeDef *lcd, unsigned char col, unsigned row);
 
     /*cursor
      *----------
      * Display the cursor as an underline
      */
-    void cursor();
+    void cursor(LCD_HandleTypeDef *lcd);
 
     /*noCursor
      *----------
      * Display the cursor as an underline
      */
-    void noCursor();
+    void noCursor(LCD_HandleTypeDef *lcd);
 
     /* blink
      *----------
      * blink on the blinking cursor
      */
-    void blink();
+    void blink(LCD_HandleTypeDef *lcd);
 
     /*noBlink
      *----------
      * turn off the blinking cursor
      */
-    void noBlink();
+    void noBlink(LCD_HandleTypeDef *lcd);
 
     /* scrollDisplayLeft
      * -------------------
      * Scrolls the contents of the display (text and cursor) one space to the left)
      */
-    void scrollDisplayLeft();
+    void scrollDisplayLeft(LCD_HandleTypeDef *lcd);
 
     /* scrollDisplayRight
      * Scrolls the contents of the display (text and cursor) one space to the right
      */
-    void scrollDisplayRight();
+    void scrollDisplayRight(LCD_HandleTypeDef *lcd);
 
     /* leftToRight
      * -------------
@@ -229,7 +442,7 @@ extern "C" {
      * display will go from left to right, but does not affect previously-output
      * text.
      */
-    void leftToRight();
+    void leftToRight(LCD_HandleTypeDef *lcd);
 
     /* rightToLeft
      * -------------
@@ -238,20 +451,189 @@ extern "C" {
      *  written to the display will go from right to left, but does not affect
      *  previously-output text.
      */
-    void rightToLeft() ;
+    void rightToLeft(LCD_HandleTypeDef *lcd) ;
 
     /* autoscroll
      * ------------------
      * Turns on automatic scrolling of the LCD
      *
      */
-    void autoscroll(void);
+    void autoscroll(LCD_HandleTypeDef *lcd);
 
     /* noAutoscroll
      * ------------------
      * Turns off automatic scrolling of the LCD
      */
-    void noAutoscroll();
+    void noAutoscroll(LCD_HandleTypeDef *lcd);
+
+    /* setWaitMode
+     * ------------------
+     * Select how the driver waits for the LCD to finish each byte
+     *
+     * mode: LCD_WAIT_DELAY (default) uses fixed millisecond delays and never reads
+     *       from the LCD, LCD_WAIT_BUSYFLAG reads the busy flag on D7 through the
+     *       rw pin and sends the next byte as soon as the LCD is ready.
+     *       LCD_WAIT_BUSYFLAG requires rw to be wired to the MCU (not tied to ground)
+     *       and is ignored for the I2C backpack
+     *
+     * begin always initializes the LCD with fixed delays, since the busy flag
+     * can not be checked before the function set is complete
+     */
+    void setWaitMode(LCD_HandleTypeDef *lcd, unsigned char mode);
+
+    /* frameBufferON
+     * ------------------
+     * Route write, print, setCursor, clear and home to a RAM frame buffer
+     * Nothing is sent to the LCD until flush is called
+     *
+     * The LCD is cleared so that it matches the (blank) frame buffer
+     */
+    void frameBufferON(LCD_HandleTypeDef *lcd);
+
+    /* frameBufferOFF
+     * ------------------
+     * Write straight to the LCD again (the frame buffer content is kept
+     * on the screen but no longer tracked)
+     */
+    void frameBufferOFF(LCD_HandleTypeDef *lcd);
+
+    /* flush
+     * ------------------
+     * Send the cells of the frame buffer that differ from what the LCD holds
+     *
+     * Each run of changed cells of a row is sent as one LCD_SETDDRAMADDR
+     * followed by an auto-increment run. Unchanged cells are never resent:
+     * bridging even a single one costs the byte the address command saves.
+     * The LCD cursor is left after the last changed cell.
+     */
+    void flush(LCD_HandleTypeDef *lcd);
+
+    /* flushAll
+     * ------------------
+     * flush several displays at once
+     *
+     * Displays on the 8-bit bus in blocking mode are switched to asynchronous
+     * mode for the duration of the call and their queues are drained one bus
+     * phase at a time, round robin, so one controller executes a byte while
+     * the next display's byte is put on its bus. The frame takes about as long
+     * as the slowest display instead of the sum of all of them.
+     * Two phases of the same display are at least 500 ns apart (enable pulse
+     * width, busy flag delay), timed on the DWT cycle counter when it runs.
+     * Displays in asynchronous or DMA mode are flushed into their own queues,
+     * the others (4-bit, I2C) one after the other.
+     *
+     * lcds: handles of the displays, only the first 32 are interleaved
+     * count: number of handles
+     */
+    void flushAll(LCD_HandleTypeDef **lcds, unsigned int count);
+
+    /* loadGlyph
+     * ------------------
+     * Get a character code (0 - 7) that shows a custom 5x8 glyph
+     *
+     * The 8 CGRAM slots are used as a cache: a glyph that is already in one
+     * is not sent again, otherwise the least recently used slot that no frame
+     * buffer cell shows, and no cell still on the LCD until the next flush, is
+     * overwritten (every slot is a candidate when the frame buffer is off).
+     * Returns -1 if every slot is on screen or, in
+     * asynchronous or DMA mode, if the queue has no room for the upload
+     *
+     * Uploading leaves the LCD address in CGRAM, so without the frame buffer
+     * call setCursor before printing again (flush takes care of it otherwise)
+     *
+     * bitmap: 8 rows, top first, the 5 low bits of each are the pixels
+     */
+    int loadGlyph(LCD_HandleTypeDef *lcd, const unsigned char *bitmap);
+
+    /* printBar
+     * ------------------
+     * Print a horizontal bar gauge of width cells at col, row
+     * Full cells use the ROM block character (0xFF), the partly filled cell
+     * uses one of 4 cached glyphs
+     *
+     * value: filled part of the gauge, from 0 to max
+     */
+    void printBar(LCD_HandleTypeDef *lcd, unsigned char col, unsigned char row, int32_t value, int32_t max,
+            unsigned char width);
+
+    /* printSparkline
+     * ------------------
+     * Print samples as a column chart at col, row, one pixel column per
+     * sample, 5 samples per cell (at most 40 samples, the 8 CGRAM slots)
+     * Cells whose glyph can not be loaded show '_'
+     *
+     * samples: oldest first
+     * min, max: values drawn as the lowest and the highest column
+     */
+    void printSparkline(LCD_HandleTypeDef *lcd, unsigned char col, unsigned char row, const int16_t *samples,
+            unsigned char count, int16_t min, int16_t max);
+
+    /* asyncON
+     * ------------------
+     * Queue every byte instead of waiting for the LCD
+     * send, print, setCursor, clear, etc. return immediately and the bytes are
+     * put on the bus one phase at a time by processQueue
+     *
+     * htim: timer whose update interrupt calls processQueue, started whenever
+     *       there is something in the queue and stopped when it runs empty.
+     *       The period must be at least 1 us (enable pulse and cycle times)
+     *       NULL if the application calls processQueue itself
+     *
+     * Only available on the 8-bit parallel bus
+     */
+    void asyncON(LCD_HandleTypeDef *lcd, TIM_HandleTypeDef *htim);
+
+    /* asyncOFF
+     * ------------------
+     * Wait for the queue to drain and go back to blocking writes
+     */
+    void asyncOFF(LCD_HandleTypeDef *lcd);
+
+    /* isIdle
+     * ------------------
+     * Returns 1 when every queued byte has been executed by the LCD
+     * (always 1 in blocking mode)
+     */
+    unsigned char isIdle(LCD_HandleTypeDef *lcd);
+
+    /* dmaON
+     * ------------------
+     * Compile every byte into BSRR words (rs/rw/data setup, enable high,
+     * enable low and the execution time) that a DMA stream copies to the GPIO
+     * port's BSRR on every update event of a timer, so sending a frame costs
+     * no CPU time after it has been compiled
+     *
+     * The bytes are collected until dmaCommit (flush commits on its own)
+     * The busy flag is not used, every byte is given the worst case execution time
+     * An execution time that does not fit in the buffer any more is finished
+     * with empty words at the start of the next buffer, which the transfer
+     * complete interrupt sends right away (so a clear or home works with any tick)
+     *
+     * htim: timer with its update event routed to hdma (e.g. TIM1_UP on DMA2
+     *       stream 5 channel 6), stopped while nothing is being sent
+     * hdma: memory to peripheral stream, word sized, normal mode
+     * tick_ns: timer period in nanoseconds, at least LCD_DMA_MIN_TICK_NS
+     *          (DMA mode is not turned on for shorter ticks)
+     *
+     * Only available on the 8-bit parallel bus, for at most LCD_MAX_DMA_DISPLAYS
+     * displays at a time
+     */
+    void dmaON(LCD_HandleTypeDef *lcd, TIM_HandleTypeDef *htim, DMA_HandleTypeDef *hdma, uint32_t tick_ns);
+
+    /* dmaOFF
+     * ------------------
+     * Send whatever is left, wait for it and go back to blocking writes
+     */
+    void dmaOFF(LCD_HandleTypeDef *lcd);
+
+    /* dmaCommit
+     * ------------------
+     * Start sending the bytes collected since the last commit
+     * Returns 0 if the previous transfer is still running (nothing is started,
+     * the bytes stay in the buffer and more can be added). The transfer
+     * complete interrupt then commits them as soon as that transfer is done
+     */
+    unsigned char dmaCommit(LCD_HandleTypeDef *lcd);
 
     //------------------------------------------------------------------
     //                    Lower level functions
@@ -262,11 +644,12 @@ extern "C" {
      * -------------
      * send Data or command to the LCD
      * the function will take care of setting the correct values for rs and rw
+     * In asynchronous and DMA modes the byte is queued, waiting for room if needed
      *
      * value: the 8 bits data value to be sent to the LCD driver
      * mode: 0 = command, 1 = data
      */
-    void send(unsigned char value, unsigned char mode);
+    void send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode);
 
     /*
      * sendData
@@ -277,7 +660,7 @@ extern "C" {
      * value: the 8 bits data value to be sent to the LCD driver
      *
      */
-    void sendData(unsigned char value);
+    void sendData(LCD_HandleTypeDef *lcd, unsigned char value);
 
      /*
      * sendCommand
@@ -288,16 +671,89 @@ extern "C" {
      * value: the 8 bits command value to be sent to the LCD driver
      *
      */
-    void sendCommand(unsigned char value);
+    void sendCommand(LCD_HandleTypeDef *lcd, unsigned char value);
+
+    /*
+     * writeBuffer
+     * -------------
+     * send a run of data bytes (characters) to the LCD
+     * rs and rw are computed once for the whole run and ride along with
+     * every data store, so each byte costs one BSRR write plus the enable pulse
+     * In asynchronous and DMA modes the bytes are queued, waiting for room if needed
+     *
+     * buffer: the bytes to send
+     * length: number of bytes in buffer
+     */
+    void writeBuffer(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length);
 
     /* pulseEnable
      * ----------------
-     * create a short tick (1 ms) on the enable pin
+     * create a short tick on the enable pin
+     * (1 ms in LCD_WAIT_DELAY mode, ~0.5 us in LCD_WAIT_BUSYFLAG mode)
      *
      * This function is used to issue an enable tick whenever you need to write
      * or read the value on the data pins
      */
-    void pulseEnable(void);
+    void pulseEnable(LCD_HandleTypeDef *lcd);
+
+    /* waitReady
+     * ----------------
+     * Poll the busy flag until the LCD is ready to accept the next byte
+     * The data pins are switched to inputs for the duration of the poll
+     *
+     * Gives up after LCD_BUSY_TIMEOUT reads so a disconnected LCD can not hang the MCU
+     */
+    void waitReady(LCD_HandleTypeDef *lcd);
+
+    /* queuePush
+     * ----------------
+     * Append a byte to the asynchronous queue and make sure the timer is
+     * running to drain it (or, in DMA mode, compile it into the buffer
+     * being filled)
+     *
+     * value: the 8 bits data value to be sent to the LCD driver
+     * mode: 0 = command, 1 = data
+     * returns 0 if the queue is full (the byte is dropped)
+     */
+    unsigned char queuePush(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode);
+
+    /* queueSpace
+     * ----------------
+     * Number of bytes that can still be queued
+     */
+    unsigned int queueSpace(LCD_HandleTypeDef *lcd);
+
+    /* processQueue
+     * ----------------
+     * Advance the asynchronous queue by one bus phase and return immediately
+     * Meant to be called from a timer interrupt (or the main loop), the time
+     * between two calls provides the setup and hold times of each phase
+     *
+     * A byte takes three calls (setup, enable high, enable low) followed by
+     * busy flag reads in LCD_WAIT_BUSYFLAG mode, or a wait of LCD_EXEC_NS
+     * (LCD_EXEC_LONG_NS for clear and home) on the DWT cycle counter in
+     * LCD_WAIT_DELAY mode (at least 1 ms, 2 ms for clear and home, on the HAL
+     * tick if the cycle counter is not running)
+     */
+    void processQueue(LCD_HandleTypeDef *lcd);
+
+    /* encodeWaveform
+     * ----------------
+     * Compile one byte into the BSRR words of its bus cycle, one word per timer tick:
+     * rs/rw/data with enable low, enable high held for at least LCD_ENABLE_NS,
+     * enable low, then empty words (no pin change) for the execution time
+     * (LCD_EXEC_NS, LCD_EXEC_LONG_NS for clear and home)
+     * Uses the tick length given to dmaON
+     * Empty words that do not fit are left in dmaCarry, to be sent first
+     * in the next buffer
+     *
+     * words: where to put the words
+     * maxWords: room left in words
+     * value: the 8 bits data value to be sent to the LCD driver
+     * mode: 0 = command, 1 = data
+     * returns the number of words written, 0 if the bus cycle does not fit
+     */
+    unsigned int encodeWaveform(LCD_HandleTypeDef *lcd, uint32_t *words, unsigned int maxWords, unsigned char value, unsigned char mode);
 
     /*
      * write8bits
@@ -306,7 +762,7 @@ extern "C" {
      * This function assumes an 8 bit mode
      *
      */
-    void write8bits(unsigned char value);
+    void write8bits(LCD_HandleTypeDef *lcd, unsigned char value);
 
 
 
@@ -0,0 +1,140 @@
+/*
+ *  SHT3x.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Driver for the Sensirion SHT30/31/35 humidity and temperature sensor on
+ *  I2C, behind the sensor interface of "Sensor.h". Every reading is a single
+ *  shot measurement (the sensor sleeps in between): the command and the
+ *  result go over the bus by DMA, the conversion time is waited out on the
+ *  HAL tick, so no call blocks. Both data words are checked with their CRC.
+ *
+ *  Only built when the HAL I2C module is enabled (HAL_I2C_MODULE_ENABLED)
+ */
+
+#ifndef SRC_SHT3X_H_
+#define SRC_SHT3X_H_
+
+#include "stm32f4xx_hal.h" // must be modified according to target platform
+#include "Sensor.h"
+
+#ifdef HAL_I2C_MODULE_ENABLED
+
+/* I2C addresses, ADDR pin low or high (shifted for the HAL) */
+#define SHT3X_ADDRESS_LOW (0x44 << 1)
+#define SHT3X_ADDRESS_HIGH (0x45 << 1)
+
+/* Commands, sent MSB first */
+#define SHT3X_CMD_MEASURE 0x2400		// Single shot, high repeatability, no clock stretching
+#define SHT3X_CMD_SOFT_RESET 0x30A2
+#define SHT3X_CMD_READ_STATUS 0xF32D
+
+/* Longest conversion at high repeatability (15.5 ms) and soft reset (1.5 ms) in ms */
+#define SHT3X_MEASURE_TIME 16
+#define SHT3X_RESET_TIME 2
+
+/* CRC-8 of every data word: polynomial x^8 + x^5 + x^4 + 1, initial value 0xFF */
+#define SHT3X_CRC_POLYNOMIAL 0x31
+#define SHT3X_CRC_INIT 0xFF
+
+/* Result of a measurement: temperature and humidity words, each with its CRC */
+#define SHT3X_DATA_SIZE 6
+
+/* Interval between measurements in milliseconds */
+#define SHT3X_INTERVAL 1000
+
+/* Timeout of the blocking transfers of SHT3xinit in milliseconds */
+#define SHT3X_I2C_TIMEOUT 10
+
+/*
+ * SHT3x sensor and its last reading
+ */
+typedef struct
+{
+	I2C_HandleTypeDef *hi2c;			// Bus of the sensor
+	uint16_t address;					// SHT3X_ADDRESS_LOW or SHT3X_ADDRESS_HIGH
+	volatile uint8_t phase;				// Step of the measurement in progress
+	uint32_t lastStart;					// Tick of the last measurement command
+	uint8_t triggered;					// Measurements only started by SHT3xtrigger
+	uint8_t command[2];					// Sent by DMA
+	uint8_t buffer[SHT3X_DATA_SIZE];	// Received by DMA
+	uint8_t cachedValid;
+	Sensor_ReadingTypeDef cached;		// Last valid reading
+	uint32_t cachedTick;
+} SHT3x_HandleTypeDef;
+
+	/*
+	 * @brief	Reset the sensor, check that it answers with a valid status
+	 * 			word and start the first measurement
+	 * 			The measurement is completed by SHT3xupdate
+	 * @param	hsht handle to initialize
+	 * @param	hi2c I2C handle, must be setup prior with DMA streams
+	 * @param	address SHT3X_ADDRESS_LOW or SHT3X_ADDRESS_HIGH
+	 * @retval	HAL_OK, HAL_ERROR if there is no SHT3x at the address
+	 */
+	HAL_StatusTypeDef SHT3xinit(SHT3x_HandleTypeDef *hsht, I2C_HandleTypeDef *hi2c,
+			uint16_t address);
+
+	/*
+	 * @brief	Sensor front-end, call as often as possible (never blocks)
+	 * 			Starts a measurement every SHT3X_INTERVAL, reads the result
+	 * 			once the conversion time has passed and caches it if both
+	 * 			CRCs match
+	 * 			Once SHT3xtrigger has been called, measurements are only
+	 * 			started by it
+	 * @param	hsht sensor
+	 * @retval	SENSOR_OK when a new reading was cached by this call,
+	 * 			SENSOR_BUSY while a measurement is in progress,
+	 * 			SENSOR_IDLE while waiting for the next measurement,
+	 * 			SENSOR_ERROR if a transfer failed or a CRC did not match
+	 */
+	Sensor_StatusTypeDef SHT3xupdate(SHT3x_HandleTypeDef *hsht);
+
+	/*
+	 * @brief	Start a measurement now, for sampling on an external schedule
+	 * 			(may be called from an interrupt). From the first call on,
+	 * 			SHT3xupdate no longer starts measurements.
+	 * @param	hsht sensor
+	 * @retval	SENSOR_BUSY if the measurement was started, SENSOR_IDLE if
+	 * 			one is in progress, SENSOR_ERROR if it could not start
+	 */
+	Sensor_StatusTypeDef SHT3xtrigger(SHT3x_HandleTypeDef *hsht);
+
+	/*
+	 * @brief	Last valid reading cached by SHT3xupdate
+	 * @param	hsht sensor
+	 * @param	reading variable for humidity and temperature
+	 * 			not changed when the sample is SENSOR_SAMPLE_INVALID
+	 * @param	age variable for the time since the measurement in ms (may be NULL)
+	 * @retval	SENSOR_SAMPLE_FRESH, SENSOR_SAMPLE_STALE when older than
+	 * 			SENSOR_STALE_AGE, SENSOR_SAMPLE_INVALID before the first reading
+	 */
+	uint8_t SHT3xlast_reading(SHT3x_HandleTypeDef *hsht, Sensor_ReadingTypeDef *reading,
+			uint32_t *age);
+
+	/*
+	 * @brief	CRC-8 of a data word as the sensor computes it
+	 * @param	data bytes, MSB first
+	 * @param	length number of bytes
+	 * @retval	CRC (0x92 for 0xBE 0xEF)
+	 */
+	uint8_t SHT3xcrc(const uint8_t *data, uint16_t length);
+
+	/*
+	 * @brief	Time until the next measurement is due, SHT3X_INTERVAL after the
+	 * 			last one started, for scheduling a retry or the first trigger
+	 * @param	hsht sensor
+	 * @retval	Milliseconds, 0 if a measurement is due now
+	 */
+	uint32_t SHT3xnext_conversion(SHT3x_HandleTypeDef *hsht);
+
+	/*
+	 * Sensor interface ("Sensor.h") of the driver, the context is the
+	 * SHT3x_HandleTypeDef of the sensor
+	 */
+	extern const Sensor_DriverTypeDef SHT3x_sensor_driver;
+
+#endif /* HAL_I2C_MODULE_ENABLED */
+
+#endif /* SRC_SHT3X_H_ */
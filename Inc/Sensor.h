@@ -0,0 +1,167 @@
+/*
+ * Sensor.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ *
+ *  Driver interface shared by the sensor backends (DHTemp, BME280)
+ *  The application only calls sensor_update and sensor_last_reading, the
+ *  backend behind a handle is picked when the handle is set up
+ */
+
+#ifndef SRC_SENSOR_H_
+#define SRC_SENSOR_H_
+
+#include <stdint.h>
+#include "Units.h"
+
+// fields of a reading
+#define SENSOR_HAS_RH 0x01
+#define SENSOR_HAS_TEMP 0x02
+#define SENSOR_HAS_PRESSURE 0x04
+
+// cached readings older than this many ms are stale
+#define SENSOR_STALE_AGE 10000
+
+// tags of the cached reading
+#define SENSOR_SAMPLE_INVALID 0
+#define SENSOR_SAMPLE_FRESH 1
+#define SENSOR_SAMPLE_STALE 2
+
+/*
+ * Result of a sensor update
+ */
+typedef enum
+{
+	SENSOR_OK = 0,		// A new reading was cached
+	SENSOR_BUSY,		// A conversion is in progress
+	SENSOR_IDLE,		// Waiting for the next conversion
+	SENSOR_ERROR		// The conversion failed, the last reading is kept
+} Sensor_StatusTypeDef;
+
+/*
+ * One reading, only the fields flagged in fields are valid
+ */
+typedef struct
+{
+	Units_DeciTypeDef RH;	// Relative humidity in 0.1 %
+	Units_DeciTypeDef temp;	// Temperature in 0.1 C
+	uint32_t pressure;	// Pressure in Pa
+	uint32_t timestamp;	// HAL tick (ms) when the conversion started
+	uint8_t fields;		// SENSOR_HAS_ flags
+} Sensor_ReadingTypeDef;
+
+/*
+ * Functions of a backend, context is the backend's own handle
+ */
+typedef struct
+{
+	const char *name;
+	Sensor_StatusTypeDef (*update)(void *context);
+	Sensor_StatusTypeDef (*trigger)(void *context);
+	uint8_t (*last_reading)(void *context, Sensor_ReadingTypeDef *reading, uint32_t *age);
+	uint32_t (*next_conversion)(void *context);
+} Sensor_DriverTypeDef;
+
+/*
+ * A sensor: backend and its handle
+ */
+typedef struct
+{
+	const Sensor_DriverTypeDef *driver;
+	void *context;
+} Sensor_HandleTypeDef;
+
+/*
+ * A published reading and its tag
+ */
+typedef struct
+{
+	Sensor_ReadingTypeDef reading;
+	uint8_t tag;		// SENSOR_SAMPLE_ tag when it was published
+	uint32_t version;	// Number of the publication, 0 before the first
+} Sensor_SampleTypeDef;
+
+/*
+ * Last sample handed from one writer to readers in any context, interrupts
+ * included (seqlock over two slots). The writer only fills the slot readers
+ * are not directed to, then publishes its version, so a reader never waits
+ * for the writer, never sees half of a sample and never gets a version
+ * older than one it already got.
+ */
+typedef struct
+{
+	Sensor_SampleTypeDef slots[2];
+	uint32_t sequence[2];	// Odd while the slot is written
+	uint32_t version;		// Last published version, in slot version & 1
+} Sensor_RecordTypeDef;
+
+	/*
+	 * @brief	Advance the sensor, call as often as possible (never blocks)
+	 * @param	sensor sensor to update
+	 * @retval	SENSOR_OK when a new reading was cached by this call,
+	 * 			SENSOR_BUSY, SENSOR_IDLE or SENSOR_ERROR otherwise
+	 */
+	Sensor_StatusTypeDef sensor_update(const Sensor_HandleTypeDef *sensor);
+
+	/*
+	 * @brief	Start a conversion now, for sampling on an external schedule
+	 * 			(may be called from a timer interrupt). From the first trigger
+	 * 			on, sensor_update only completes conversions and no longer
+	 * 			starts them on the backend's own interval.
+	 * @param	sensor sensor to trigger
+	 * @retval	SENSOR_BUSY if a conversion was started, SENSOR_IDLE if the
+	 * 			trigger was skipped (conversion in progress, backing off after
+	 * 			failures, too soon for the sensor), SENSOR_ERROR if it failed
+	 */
+	Sensor_StatusTypeDef sensor_trigger(const Sensor_HandleTypeDef *sensor);
+
+	/*
+	 * @brief	Last valid reading of the sensor
+	 * @param	sensor sensor to read
+	 * @param	reading variable for the reading, not changed when invalid
+	 * @param	age variable for the time since the conversion in ms (may be NULL)
+	 * @retval	SENSOR_SAMPLE_FRESH, SENSOR_SAMPLE_STALE or SENSOR_SAMPLE_INVALID
+	 */
+	uint8_t sensor_last_reading(const Sensor_HandleTypeDef *sensor,
+			Sensor_ReadingTypeDef *reading, uint32_t *age);
+
+	/*
+	 * @brief	Time until the sensor is due for its next conversion (the end of
+	 * 			its interval, or of the backoff after failures), for scheduling
+	 * 			a retry or the first trigger
+	 * @param	sensor sensor to ask
+	 * @retval	Milliseconds, 0 if a conversion is due now
+	 */
+	uint32_t sensor_next_conversion(const Sensor_HandleTypeDef *sensor);
+
+	/*
+	 * @brief	Empty a sample record (version 0, SENSOR_SAMPLE_INVALID)
+	 * @param	record record to initialize
+	 * @retval	None
+	 */
+	void sensor_record_init(Sensor_RecordTypeDef *record);
+
+	/*
+	 * @brief	Publish a sample, from a single writer context
+	 * @param	record record to update
+	 * @param	reading reading to publish
+	 * @param	tag SENSOR_SAMPLE_ tag of the reading
+	 * @retval	None
+	 */
+	void sensor_publish(Sensor_RecordTypeDef *record, const Sensor_ReadingTypeDef *reading,
+			uint8_t tag);
+
+	/*
+	 * @brief	Copy the last published sample, from any context (never blocks,
+	 * 			never disables interrupts). Succeeds on the first attempt unless
+	 * 			the writer publishes twice while it copies, which only happens
+	 * 			if the writer can preempt the reader.
+	 * @param	record record to read
+	 * @param	sample variable for the sample, only valid if 1 is returned
+	 * @retval	1 if a consistent sample was copied, 0 if the writer kept
+	 * 			overwriting it (read again later)
+	 */
+	uint8_t sensor_snapshot(const Sensor_RecordTypeDef *record, Sensor_SampleTypeDef *sample);
+
+#endif /* SRC_SENSOR_H_ */
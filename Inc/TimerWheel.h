@@ -0,0 +1,187 @@
+/*
+ *  TimerWheel.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Software timers on one compare channel of a free-running 32-bit timer.
+ *  Timers sit in a hierarchical wheel (WHEEL_LEVELS levels of WHEEL_SLOTS
+ *  slots, one tick per slot on the first level), so starting and cancelling
+ *  a timer is O(1). The compare is always set to the next tick that has work
+ *  (an expiry, or timers to move down a level), no interrupt fires on the
+ *  ticks in between. Callbacks run in the interrupt of the timer.
+ *  The timer count at each callback is its timestamp: the period between
+ *  the timestamps of a timer (its jitter) can be tracked with wheel_track.
+ */
+
+#ifndef SRC_TIMERWHEEL_H_
+#define SRC_TIMERWHEEL_H_
+
+#include "stm32f4xx_hal.h" // must be modified according to target platform
+
+/* Timer counts per tick, 1 ms at 1 MHz */
+#define WHEEL_TICK 1000
+
+/* Slots per level (a power of two) and levels, 64^4 ticks (4.6 hours at 1 ms) */
+#define WHEEL_SLOT_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)
+#define WHEEL_LEVELS 4
+
+/* Longest delay or period in ticks */
+#define WHEEL_MAX_DELAY ((1UL << (WHEEL_SLOT_BITS * WHEEL_LEVELS)) - 1)
+
+/* Longest time without an interrupt in ticks, keeps the timer count from wrapping */
+#define WHEEL_MAX_SLEEP (0x7FFFFFFFUL / WHEEL_TICK)
+
+/*
+ * Period statistics of one timer, in timer counts (microseconds at 1 MHz)
+ */
+typedef struct
+{
+	uint32_t samples;		// Callbacks since wheel_track
+	uint32_t stamp;			// Timer count at the last callback (timestamp of the expiry)
+	uint32_t periodMin;		// Time between the timestamps of two callbacks,
+	uint32_t periodMax;		// the jitter is periodMax - periodMin
+} TimerWheel_JitterTypeDef;
+
+/*
+ * Software timer, owned by the caller and linked into the wheel while running
+ */
+typedef struct __TimerWheel_TimerTypeDef
+{
+	struct __TimerWheel_TimerTypeDef *next;		// Timers of the same slot
+	struct __TimerWheel_TimerTypeDef *prev;
+	uint32_t expires;							// Tick of the expiry
+	uint32_t period;							// Ticks between expiries, 0 for one-shot
+	void (*callback)(void *context);			// Called in the timer interrupt
+	void *context;
+	TimerWheel_JitterTypeDef *jitter;			// Period statistics, NULL when not tracked
+	uint8_t level;								// Position in the wheel
+	uint8_t slot;
+	uint8_t active;
+} TimerWheel_TimerTypeDef;
+
+/*
+ * Timing statistics of the expiries, in timer counts (microseconds at 1 MHz)
+ */
+typedef struct
+{
+	uint32_t expired;		// Callbacks since the start or the last reset
+	uint32_t missed;		// Periods skipped because the interrupt came too late
+	uint32_t latencyMin;	// Time from the expiry tick to the callback
+	uint32_t latencyMax;
+	uint32_t latencySum;	// Mean latency is latencySum / expired
+} TimerWheel_StatsTypeDef;
+
+/*
+ * Timer wheel
+ */
+typedef struct
+{
+	TIM_HandleTypeDef *htim;		// Free-running 32-bit timer
+	uint32_t channel;				// TIM_CHANNEL_x of the compare
+	uint32_t now;					// Tick the wheel has been processed up to
+	uint32_t base;					// Timer count of the start of tick now
+	uint64_t occupied[WHEEL_LEVELS];	// One bit per non-empty slot
+	TimerWheel_TimerTypeDef *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+	TimerWheel_StatsTypeDef stats;
+} TimerWheel_HandleTypeDef;
+
+	/*
+	 * @brief	Start the wheel, empty, at tick 0
+	 * @param	hwheel handle to initialize
+	 * @param	htim TIM handle, must be setup prior as a free-running 32-bit
+	 * 			counter (period 0xFFFFFFFF) with its interrupt enabled
+	 * @param	channel TIM_CHANNEL_x of the compare, configured in timing mode
+	 * @retval	None
+	 */
+	void wheel_init(TimerWheel_HandleTypeDef *hwheel, TIM_HandleTypeDef *htim, uint32_t channel);
+
+	/*
+	 * @brief	Start (or restart) a timer
+	 * @param	hwheel wheel
+	 * @param	timer timer, must stay valid while it runs
+	 * @param	delay ticks to the first expiry, 1 to WHEEL_MAX_DELAY
+	 * @param	period ticks between the following expiries, 0 for a one-shot
+	 * 			timer, periodic timers stay on the grid of their first expiry
+	 * @param	callback function called in the timer interrupt on expiry
+	 * @param	context argument of the callback
+	 * @retval	None
+	 */
+	void wheel_start(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer,
+			uint32_t delay, uint32_t period, void (*callback)(void *context), void *context);
+
+	/*
+	 * @brief	Stop a timer, nothing happens if it is not running
+	 * @param	hwheel wheel
+	 * @param	timer timer to stop
+	 * @retval	None
+	 */
+	void wheel_cancel(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer);
+
+	/*
+	 * @brief	Run the expired timers and set the compare to the next tick
+	 * 			with work, call from HAL_TIM_OC_DelayElapsedCallback for the
+	 * 			channel of the wheel
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	void wheel_process(TimerWheel_HandleTypeDef *hwheel);
+
+	/*
+	 * @brief	Current tick
+	 * @param	hwheel wheel
+	 * @retval	Ticks since wheel_init
+	 */
+	uint32_t wheel_now(TimerWheel_HandleTypeDef *hwheel);
+
+	/*
+	 * @brief	Copy the timing statistics
+	 * @param	hwheel wheel
+	 * @param	snapshot statistics since wheel_init or the last wheel_stats_reset
+	 * @retval	None
+	 */
+	void wheel_stats(TimerWheel_HandleTypeDef *hwheel, TimerWheel_StatsTypeDef *snapshot);
+
+	/*
+	 * @brief	Clear the timing statistics
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	void wheel_stats_reset(TimerWheel_HandleTypeDef *hwheel);
+
+	/*
+	 * @brief	Keep the period statistics of a timer from its next callback on
+	 * 			(running or not, wheel_start keeps them)
+	 * @param	hwheel wheel
+	 * @param	timer timer to track
+	 * @param	jitter statistics, cleared here, NULL to stop tracking
+	 * @retval	None
+	 */
+	void wheel_track(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer,
+			TimerWheel_JitterTypeDef *jitter);
+
+	/*
+	 * @brief	Copy the period statistics of a tracked timer
+	 * @param	hwheel wheel
+	 * @param	timer tracked timer
+	 * @param	snapshot statistics since wheel_track
+	 * @retval	None
+	 */
+	void wheel_jitter(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer,
+			TimerWheel_JitterTypeDef *snapshot);
+
+	/*
+	 * @brief	Send the timing statistics over SWO (ITM port 0), nothing is
+	 * 			sent without a debugger, times in timer counts (us at 1 MHz)
+	 * 			A line for the wheel, then one for the timer if it is tracked,
+	 * 			with its shortest and longest period
+	 * 			"wheel expired=30 missed=0 latency=2-9"
+	 * 			"timer samples=15 period=1999998-2000003"
+	 * @param	hwheel wheel
+	 * @param	timer timer tracked by wheel_track, may be NULL
+	 * @retval	None
+	 */
+	void wheel_report(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer);
+
+#endif /* SRC_TIMERWHEEL_H_ */
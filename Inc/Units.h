@@ -0,0 +1,43 @@
+/*
+ * Units.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ *
+ *  Integer-only unit conversion of deci-unit values (tenths of a unit in an
+ *  int16), rounded to the nearest tenth, halves away from zero. No floating
+ *  point is used, so nothing of the soft-float double library is linked in.
+ */
+
+#ifndef SRC_UNITS_H_
+#define SRC_UNITS_H_
+
+#include <stdint.h>
+
+// temperature units
+#define UNITS_CELSIUS 0
+#define UNITS_FAHRENHEIT 1
+#define UNITS_KELVIN 2
+
+/*
+ * Value in tenths of its unit, e.g. 253 for 25.3 C (-3276.8 to 3276.7)
+ */
+typedef int16_t Units_DeciTypeDef;
+
+	/*
+	 * @brief	Converts a temperature from Celsius.
+	 * @param	celsius	Temperature in 0.1 C.
+	 * @param	unit	UNITS_CELSIUS, UNITS_FAHRENHEIT or UNITS_KELVIN.
+	 * @retval	Temperature in 0.1 of the unit, rounded to the nearest tenth
+	 * 			(halves away from zero), saturated to the int16 range.
+	 */
+	Units_DeciTypeDef units_temp(Units_DeciTypeDef celsius, uint8_t unit);
+
+	/*
+	 * @brief	Symbol of a temperature unit, for display.
+	 * @param	unit	UNITS_CELSIUS, UNITS_FAHRENHEIT or UNITS_KELVIN.
+	 * @retval	"C", "F" or "K".
+	 */
+	const char *units_temp_symbol(uint8_t unit);
+
+#endif /* SRC_UNITS_H_ */
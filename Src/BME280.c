@@ -0,0 +1,371 @@
+/*
+ * BME280.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "BME280.h"
+
+#ifdef HAL_I2C_MODULE_ENABLED
+
+	#define BME280_PHASE_IDLE	0 // waiting for the next fetch
+	#define BME280_PHASE_CALIB	1 // burst of the calibration and result registers
+	#define BME280_PHASE_DATA	2 // fetch of the result registers
+
+	/* Offset of a register in the burst buffer */
+	#define REG(reg) ((reg) - BME280_REG_CALIB)
+
+	/* Raw temperature of a skipped or not yet finished conversion */
+	#define BME280_RAW_SKIPPED 0x80000
+
+	/*
+	 * @brief	Little endian 16-bit register pair of the burst buffer
+	 * @param	hbme sensor
+	 * @param	reg register of the low byte
+	 * @retval	Register value
+	 */
+	static uint16_t reg16(BME280_HandleTypeDef *hbme, uint8_t reg)
+	{
+		return hbme->buffer[REG(reg)] | (hbme->buffer[REG(reg) + 1] << 8);
+	}
+
+	/*
+	 * @brief	Unpack the compensation parameters from the burst buffer
+	 * @param	hbme sensor
+	 * @retval	None
+	 */
+	static void parse_calibration(BME280_HandleTypeDef *hbme)
+	{
+		BME280_CalibTypeDef *calib = &hbme->calib;
+		const uint8_t *h = &hbme->buffer[REG(BME280_REG_CALIB_H)];
+
+		calib->T1 = reg16(hbme, 0x88);
+		calib->T2 = (int16_t) reg16(hbme, 0x8A);
+		calib->T3 = (int16_t) reg16(hbme, 0x8C);
+		calib->P1 = reg16(hbme, 0x8E);
+		calib->P2 = (int16_t) reg16(hbme, 0x90);
+		calib->P3 = (int16_t) reg16(hbme, 0x92);
+		calib->P4 = (int16_t) reg16(hbme, 0x94);
+		calib->P5 = (int16_t) reg16(hbme, 0x96);
+		calib->P6 = (int16_t) reg16(hbme, 0x98);
+		calib->P7 = (int16_t) reg16(hbme, 0x9A);
+		calib->P8 = (int16_t) reg16(hbme, 0x9C);
+		calib->P9 = (int16_t) reg16(hbme, 0x9E);
+		calib->H1 = hbme->buffer[REG(0xA1)];
+		calib->H2 = (int16_t) (h[0] | (h[1] << 8));
+		calib->H3 = h[2];
+		/* H4 and H5 are signed 12-bit values sharing the nibbles of 0xE5 */
+		calib->H4 = (int16_t) ((int8_t) h[3] * 16 | (h[4] & 0x0F));
+		calib->H5 = (int16_t) ((int8_t) h[5] * 16 | (h[4] >> 4));
+		calib->H6 = (int8_t) h[6];
+	}
+
+	/*
+	 * @brief	Compensate the result registers of the burst buffer
+	 * 			(integer formulas of the BME280 datasheet, section 4.2.3)
+	 * @param	hbme sensor
+	 * @param	reading variable for humidity x10, temperature x10 and pressure
+	 * @retval	1 if the registers hold a conversion, 0 otherwise
+	 */
+	static uint8_t compensate(BME280_HandleTypeDef *hbme, Sensor_ReadingTypeDef *reading)
+	{
+		const BME280_CalibTypeDef *calib = &hbme->calib;
+		const uint8_t *data = &hbme->buffer[REG(BME280_REG_DATA)];
+		int32_t adcP = (data[0] << 12) | (data[1] << 4) | (data[2] >> 4);
+		int32_t adcT = (data[3] << 12) | (data[4] << 4) | (data[5] >> 4);
+		int32_t adcH = (data[6] << 8) | data[7];
+
+		if (adcT == BME280_RAW_SKIPPED)
+		{
+			return 0;
+		}
+
+		/* Temperature, t_fine carries it into the pressure and humidity formulas */
+		int32_t var1 = ((((adcT >> 3) - ((int32_t) calib->T1 << 1))) * calib->T2) >> 11;
+		int32_t var2 = (((((adcT >> 4) - calib->T1) * ((adcT >> 4) - calib->T1)) >> 12)
+				* calib->T3) >> 14;
+		int32_t tFine = var1 + var2;
+		int32_t temp = (tFine * 5 + 128) >> 8; // 0.01 C
+		reading->temp = (int16_t) ((temp + (temp < 0 ? -5 : 5)) / 10);
+
+		/* Pressure in Pa as Q24.8 */
+		int64_t p1 = (int64_t) tFine - 128000;
+		int64_t p2 = p1 * p1 * calib->P6;
+		p2 += (p1 * calib->P5) * 131072;
+		p2 += (int64_t) calib->P4 * 34359738368;
+		p1 = ((p1 * p1 * calib->P3) >> 8) + ((p1 * calib->P2) * 4096);
+		p1 = ((140737488355328 + p1) * calib->P1) >> 33;
+		if (p1 != 0)
+		{
+			int64_t p = 1048576 - adcP;
+			p = ((p * 2147483648 - p2) * 3125) / p1;
+			p1 = ((int64_t) calib->P9 * (p >> 13) * (p >> 13)) >> 25;
+			p2 = ((int64_t) calib->P8 * p) >> 19;
+			p = ((p + p1 + p2) >> 8) + ((int64_t) calib->P7 << 4);
+			reading->pressure = (uint32_t) ((p + 128) >> 8);
+		}
+		else
+		{
+			reading->pressure = 0; // avoids a division by zero with blank calibration
+		}
+
+		/* Humidity in % as Q22.10 */
+		int32_t h = tFine - 76800;
+		h = (((((adcH << 14) - ((int32_t) calib->H4 << 20) - (calib->H5 * h)) + 16384) >> 15)
+				* (((((((h * calib->H6) >> 10) * (((h * calib->H3) >> 11) + 32768)) >> 10)
+						+ 2097152) * calib->H2 + 8192) >> 14));
+		h -= ((((h >> 15) * (h >> 15)) >> 7) * calib->H1) >> 4;
+		h = h < 0 ? 0 : h;
+		h = h > 419430400 ? 419430400 : h;
+		reading->RH = (int16_t) (((uint32_t) (h >> 12) * 10 + 512) >> 10);
+
+		reading->fields = SENSOR_HAS_RH | SENSOR_HAS_TEMP | SENSOR_HAS_PRESSURE;
+		return 1;
+	}
+
+	/*
+	 * @brief	Start a DMA read of registers into the burst buffer
+	 * @param	hbme sensor
+	 * @param	reg first register
+	 * @param	size number of registers
+	 * @param	phase phase while the transfer is in progress
+	 * @retval	SENSOR_BUSY, SENSOR_ERROR if the transfer could not start
+	 */
+	static Sensor_StatusTypeDef start_fetch(BME280_HandleTypeDef *hbme, uint8_t reg,
+			uint16_t size, uint8_t phase)
+	{
+		hbme->lastStart = HAL_GetTick();
+		if (HAL_I2C_Mem_Read_DMA(hbme->hi2c, hbme->address, reg, I2C_MEMADD_SIZE_8BIT,
+				&hbme->buffer[REG(reg)], size) != HAL_OK)
+		{
+			return SENSOR_ERROR;
+		}
+		hbme->phase = phase;
+		return SENSOR_BUSY;
+	}
+
+	/*
+	 * @brief	Start the next fetch, the whole burst again while there is no
+	 * 			calibration (failed burst), the result registers otherwise
+	 * @param	hbme sensor
+	 * @retval	SENSOR_BUSY, SENSOR_ERROR if the transfer could not start
+	 */
+	static Sensor_StatusTypeDef start_next(BME280_HandleTypeDef *hbme)
+	{
+		if (hbme->calib.T1 == 0)
+		{
+			return start_fetch(hbme, BME280_REG_CALIB, BME280_BURST_SIZE, BME280_PHASE_CALIB);
+		}
+		return start_fetch(hbme, BME280_REG_DATA, BME280_DATA_SIZE, BME280_PHASE_DATA);
+	}
+
+	/*
+	 * @brief	Check the chip id, configure the sensor (normal mode) and start
+	 * 			the DMA burst of the calibration and result registers
+	 * 			The burst is completed by BME280update
+	 * @param	hbme handle to initialize
+	 * @param	hi2c I2C handle, must be setup prior with a DMA receive stream
+	 * @param	address BME280_ADDRESS_LOW or BME280_ADDRESS_HIGH
+	 * @retval	HAL_OK, HAL_ERROR if there is no BME280 at the address
+	 */
+	HAL_StatusTypeDef BME280init(BME280_HandleTypeDef *hbme, I2C_HandleTypeDef *hi2c,
+			uint16_t address)
+	{
+		uint8_t id = 0;
+		uint8_t value;
+
+		hbme->hi2c = hi2c;
+		hbme->address = address;
+		hbme->phase = BME280_PHASE_IDLE;
+		hbme->triggered = 0;
+		hbme->cachedValid = 0;
+
+		if (HAL_I2C_Mem_Read(hi2c, address, BME280_REG_ID, I2C_MEMADD_SIZE_8BIT, &id, 1,
+				BME280_I2C_TIMEOUT) != HAL_OK || id != BME280_CHIP_ID)
+		{
+			return HAL_ERROR;
+		}
+
+		/* ctrl_hum only takes effect with the following write of ctrl_meas */
+		value = BME280_CTRL_HUM_VALUE;
+		HAL_I2C_Mem_Write(hi2c, address, BME280_REG_CTRL_HUM, I2C_MEMADD_SIZE_8BIT, &value, 1,
+				BME280_I2C_TIMEOUT);
+		value = BME280_CONFIG_VALUE;
+		HAL_I2C_Mem_Write(hi2c, address, BME280_REG_CONFIG, I2C_MEMADD_SIZE_8BIT, &value, 1,
+				BME280_I2C_TIMEOUT);
+		value = BME280_CTRL_MEAS_VALUE;
+		if (HAL_I2C_Mem_Write(hi2c, address, BME280_REG_CTRL_MEAS, I2C_MEMADD_SIZE_8BIT, &value,
+				1, BME280_I2C_TIMEOUT) != HAL_OK)
+		{
+			return HAL_ERROR;
+		}
+
+		return start_fetch(hbme, BME280_REG_CALIB, BME280_BURST_SIZE, BME280_PHASE_CALIB)
+				== SENSOR_BUSY ? HAL_OK : HAL_ERROR;
+	}
+
+	/*
+	 * @brief	Sensor front-end, call as often as possible (never blocks)
+	 * 			Fetches the result registers by DMA every BME280_INTERVAL and
+	 * 			caches the compensated reading once the transfer is over
+	 * 			Once BME280trigger has been called, fetches are only started by it
+	 * @param	hbme sensor
+	 * @retval	SENSOR_OK when a new reading was cached by this call,
+	 * 			SENSOR_BUSY while a transfer is in progress,
+	 * 			SENSOR_IDLE while waiting for the next fetch,
+	 * 			SENSOR_ERROR if the transfer failed
+	 */
+	Sensor_StatusTypeDef BME280update(BME280_HandleTypeDef *hbme)
+	{
+		Sensor_ReadingTypeDef reading;
+
+		if (hbme->phase == BME280_PHASE_IDLE)
+		{
+			if (hbme->triggered || HAL_GetTick() - hbme->lastStart < BME280_INTERVAL)
+			{
+				return SENSOR_IDLE;
+			}
+			return start_next(hbme);
+		}
+
+		if (HAL_I2C_GetState(hbme->hi2c) != HAL_I2C_STATE_READY)
+		{
+			return SENSOR_BUSY;
+		}
+
+		uint8_t phase = hbme->phase;
+		hbme->phase = BME280_PHASE_IDLE;
+		if (HAL_I2C_GetError(hbme->hi2c) != HAL_I2C_ERROR_NONE)
+		{
+			if (phase == BME280_PHASE_CALIB)
+			{
+				hbme->calib.T1 = 0;
+			}
+			return SENSOR_ERROR;
+		}
+		if (phase == BME280_PHASE_CALIB)
+		{
+			parse_calibration(hbme);
+		}
+		if (!compensate(hbme, &reading))
+		{
+			return SENSOR_IDLE; // first conversion not finished yet
+		}
+
+		reading.timestamp = hbme->lastStart;
+		hbme->cached = reading;
+		hbme->cachedTick = HAL_GetTick();
+		hbme->cachedValid = 1;
+		return SENSOR_OK;
+	}
+
+	/*
+	 * @brief	Start a fetch of the result registers now, for sampling on an
+	 * 			external schedule (may be called from an interrupt). From the
+	 * 			first call on, BME280update no longer starts fetches.
+	 * @param	hbme sensor
+	 * @retval	SENSOR_BUSY if the fetch was started, SENSOR_IDLE if one is in
+	 * 			progress, SENSOR_ERROR if it could not start
+	 */
+	Sensor_StatusTypeDef BME280trigger(BME280_HandleTypeDef *hbme)
+	{
+		hbme->triggered = 1;
+		if (hbme->phase != BME280_PHASE_IDLE)
+		{
+			return SENSOR_IDLE;
+		}
+		return start_next(hbme);
+	}
+
+	/*
+	 * @brief	Last valid reading cached by BME280update
+	 * @param	hbme sensor
+	 * @param	reading variable for humidity, temperature and pressure
+	 * 			not changed when the sample is SENSOR_SAMPLE_INVALID
+	 * @param	age variable for the time since the fetch in ms (may be NULL)
+	 * @retval	SENSOR_SAMPLE_FRESH, SENSOR_SAMPLE_STALE when older than
+	 * 			SENSOR_STALE_AGE, SENSOR_SAMPLE_INVALID before the first reading
+	 */
+	uint8_t BME280last_reading(BME280_HandleTypeDef *hbme, Sensor_ReadingTypeDef *reading,
+			uint32_t *age)
+	{
+		if (!hbme->cachedValid)
+		{
+			return SENSOR_SAMPLE_INVALID;
+		}
+		uint32_t elapsed = HAL_GetTick() - hbme->cachedTick;
+		*reading = hbme->cached;
+		if (age != NULL)
+		{
+			*age = elapsed;
+		}
+		return elapsed > SENSOR_STALE_AGE ? SENSOR_SAMPLE_STALE : SENSOR_SAMPLE_FRESH;
+	}
+
+	/*
+	 * @brief	Time until the next fetch is due, BME280_INTERVAL after the
+	 * 			last one started, for scheduling a retry or the first trigger
+	 * @param	hbme sensor
+	 * @retval	Milliseconds, 0 if a fetch is due now
+	 */
+	uint32_t BME280next_conversion(BME280_HandleTypeDef *hbme)
+	{
+		uint32_t elapsed = HAL_GetTick() - hbme->lastStart;
+
+		return elapsed >= BME280_INTERVAL ? 0 : BME280_INTERVAL - elapsed;
+	}
+
+	/*
+	 * @brief	BME280update for the sensor interface
+	 * @param	context BME280_HandleTypeDef of the sensor
+	 * @retval	See BME280update
+	 */
+	static Sensor_StatusTypeDef sensor_update_bme280(void *context)
+	{
+		return BME280update((BME280_HandleTypeDef*) context);
+	}
+
+	/*
+	 * @brief	BME280trigger for the sensor interface
+	 * @param	context BME280_HandleTypeDef of the sensor
+	 * @retval	See BME280trigger
+	 */
+	static Sensor_StatusTypeDef sensor_trigger_bme280(void *context)
+	{
+		return BME280trigger((BME280_HandleTypeDef*) context);
+	}
+
+	/*
+	 * @brief	BME280last_reading for the sensor interface
+	 * @param	context BME280_HandleTypeDef of the sensor
+	 * @param	reading variable for the reading
+	 * @param	age variable for the time since the fetch in ms (may be NULL)
+	 * @retval	See BME280last_reading
+	 */
+	static uint8_t sensor_last_reading_bme280(void *context, Sensor_ReadingTypeDef *reading,
+			uint32_t *age)
+	{
+		return BME280last_reading((BME280_HandleTypeDef*) context, reading, age);
+	}
+
+	/*
+	 * @brief	BME280next_conversion for the sensor interface
+	 * @param	context BME280_HandleTypeDef of the sensor
+	 * @retval	See BME280next_conversion
+	 */
+	static uint32_t sensor_next_conversion_bme280(void *context)
+	{
+		return BME280next_conversion((BME280_HandleTypeDef*) context);
+	}
+
+	const Sensor_DriverTypeDef BME280_sensor_driver =
+	{
+		"BME280",
+		sensor_update_bme280,
+		sensor_trigger_bme280,
+		sensor_last_reading_bme280,
+		sensor_next_conversion_bme280
+	};
+
+#endif /* HAL_I2C_MODULE_ENABLED */
@@ -0,0 +1,129 @@
+/*
+ * DHTDecode.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "DHTDecode.h"
+
+/* k-means iterations, 40 values settle in 2 or 3 */
+#define DHT_DECODE_ITERATIONS 8
+
+	/*
+	 * @brief	Decode a frame from the timestamps of its edges
+	 * 			Edge 0 is the start of the sensor response, bit i rises on
+	 * 			edge 3 + 2i and falls on edge 4 + 2i
+	 * @param	edges timestamps of the line edges in microseconds
+	 * 			(any unit works, DHT_DECODE_MIN_SPREAD assumes microseconds)
+	 * @param	count number of timestamps
+	 * @param	result decoded frame and bit thresholds
+	 * @param	withConfidence 1 to fill result->confidence
+	 * @retval	1 if there are enough edges for a frame, 0 otherwise
+	 */
+	uint8_t DHTdecode(const uint32_t *edges, uint16_t count, DHTDecode_ResultTypeDef *result,
+			uint8_t withConfidence)
+	{
+		uint32_t widths[DHT_DECODE_BITS];
+		uint32_t low = UINT32_MAX;
+		uint32_t high = 0;
+
+		if (count < DHT_DECODE_EDGES)
+		{
+			return 0;
+		}
+
+		/* High pulse widths (unsigned differences survive a timer wrap) */
+		for (int i = 0; i < DHT_DECODE_BITS; i++)
+		{
+			widths[i] = edges[4 + 2 * i] - edges[3 + 2 * i];
+			if (widths[i] < low)
+			{
+				low = widths[i];
+			}
+			if (widths[i] > high)
+			{
+				high = widths[i];
+			}
+		}
+
+		/* Two clusters, starting from the extremes */
+		uint32_t zero = low;
+		uint32_t one = high;
+		uint32_t threshold = DHT_DECODE_THRESHOLD;
+
+		if (high - low >= DHT_DECODE_MIN_SPREAD)
+		{
+			for (int iteration = 0; iteration < DHT_DECODE_ITERATIONS; iteration++)
+			{
+				uint32_t sums[2] = {0, 0};
+				uint32_t counts[2] = {0, 0};
+
+				threshold = (zero + one) / 2;
+				for (int i = 0; i < DHT_DECODE_BITS; i++)
+				{
+					int cluster = widths[i] > threshold;
+					sums[cluster] += widths[i];
+					counts[cluster]++;
+				}
+
+				/* Both clusters keep a member, the extremes are on either side */
+				uint32_t newZero = sums[0] / counts[0];
+				uint32_t newOne = sums[1] / counts[1];
+				if (newZero == zero && newOne == one)
+				{
+					break;
+				}
+				zero = newZero;
+				one = newOne;
+			}
+			threshold = (zero + one) / 2;
+		}
+		else
+		{
+			/* One cluster, every bit has the same value */
+			if (low > DHT_DECODE_THRESHOLD)
+			{
+				zero = 0;
+			}
+			else
+			{
+				one = 2 * DHT_DECODE_THRESHOLD;
+			}
+		}
+
+		for (int i = 0; i < 5; i++)
+		{
+			result->data[i] = 0;
+		}
+		for (int i = 0; i < DHT_DECODE_BITS; i++)
+		{
+			if (widths[i] > threshold)
+			{
+				result->data[i / 8] |= 0x80 >> (i % 8);
+			}
+		}
+		result->zeroWidth = zero;
+		result->oneWidth = one;
+		result->threshold = threshold;
+
+		if (withConfidence)
+		{
+			/* Distance from the threshold relative to the distance of the
+			 * cluster center from it */
+			uint32_t halfGap = (one - zero) / 2;
+			for (int i = 0; i < DHT_DECODE_BITS; i++)
+			{
+				uint32_t distance = widths[i] > threshold ? widths[i] - threshold : threshold - widths[i];
+				if (distance >= halfGap)
+				{
+					result->confidence[i] = 255;
+				}
+				else
+				{
+					result->confidence[i] = distance * 255 / halfGap;
+				}
+			}
+		}
+		return 1;
+	}
@@ -0,0 +1,203 @@
+/*
+ * DHTMulti.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "DHTMulti.h"
+
+/* Falling edges of a read: end of the response, end of its high part, 40 bits */
+#define DHT_MULTI_FRAME_FALLS 42
+
+	#define DHT_MULTI_PHASE_IDLE	0 // no read in progress
+	#define DHT_MULTI_PHASE_START	1 // lines held low for the start pulse
+
+	/*
+	 * @brief	Set every sensor line in idle state (output, high)
+	 * @param	hdht sensors
+	 * @retval	None
+	 */
+	static void lines_idle(DHTMulti_HandleTypeDef *hdht)
+	{
+		GPIO_InitTypeDef GPIO_InitStruct = {0};
+		HAL_GPIO_WritePin(hdht->gpio, hdht->pins, GPIO_PIN_SET);
+		GPIO_InitStruct.Pin = hdht->pins;
+		GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+		HAL_GPIO_Init(hdht->gpio, &GPIO_InitStruct);
+	}
+
+	/*
+	 * @brief	Define the sensor lines and timer, set the lines in idle state
+	 * @param	hdht handle to initialize
+	 * @param	GPIOx where x can be (A, B, C, etc.) to select the GPIO peripheral
+	 * @param	pins lines of the sensors, GPIO_PIN_x values or'ed together
+	 * @param	htim TIM handle, must be setup prior with microsecond per tick
+	 * @retval 	None
+	 */
+	void DHTmulti_init(DHTMulti_HandleTypeDef *hdht, GPIO_TypeDef *GPIOx, uint16_t pins,
+			TIM_HandleTypeDef *htim)
+	{
+		hdht->gpio = GPIOx;
+		hdht->pins = pins;
+		hdht->htim = htim;
+		hdht->phase = DHT_MULTI_PHASE_IDLE;
+		for (int line = 0; line < DHT_MULTI_LINES; line++)
+		{
+			hdht->status[line] = DHT_IDLE;
+		}
+		lines_idle(hdht);
+	}
+
+	/*
+	 * @brief	Start a read of every sensor without blocking
+	 * 			(pulls all lines low for the start pulse)
+	 * @param	hdht sensors to read
+	 * @retval	None
+	 */
+	void DHTmulti_start_read(DHTMulti_HandleTypeDef *hdht)
+	{
+		HAL_TIM_Base_Start(hdht->htim);
+		HAL_GPIO_WritePin(hdht->gpio, hdht->pins, GPIO_PIN_RESET);
+		hdht->phaseStart = __HAL_TIM_GET_COUNTER(hdht->htim);
+		hdht->phase = DHT_MULTI_PHASE_START;
+	}
+
+	/*
+	 * @brief	Advance a read started by DHTmulti_start_read
+	 * 			Returns right away during the start pulse. Once it is over,
+	 * 			the lines are released and sampled for about 6 ms (this call
+	 * 			blocks, interrupts longer than a few microseconds stretch the
+	 * 			samples), then every line is decoded.
+	 * @param	hdht sensors being read
+	 * @retval	DHT_BUSY during the start pulse, DHT_OK when the read is over
+	 * 			(per line results in hdht->status), DHT_IDLE if no read was started
+	 */
+	DHT_StatusTypeDef DHTmulti_poll(DHTMulti_HandleTypeDef *hdht)
+	{
+		uint8_t frames[DHT_MULTI_LINES][5];
+
+		if (hdht->phase == DHT_MULTI_PHASE_IDLE)
+		{
+			return DHT_IDLE;
+		}
+		/* Long enough for both models, sensors on the port may differ */
+		if (__HAL_TIM_GET_COUNTER(hdht->htim) - hdht->phaseStart < DHT11_START_PULSE)
+		{
+			return DHT_BUSY;
+		}
+
+		/* Release every line by setting the pins as input */
+		HAL_GPIO_WritePin(hdht->gpio, hdht->pins, GPIO_PIN_SET);
+		GPIO_InitTypeDef GPIO_InitStruct = {0};
+		GPIO_InitStruct.Pin = hdht->pins;
+		GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+		GPIO_InitStruct.Pull = GPIO_NOPULL;
+		HAL_GPIO_Init(hdht->gpio, &GPIO_InitStruct);
+
+		/* Sample the whole port on a fixed grid of the timer (a late sample
+		 * does not shift the ones after it) */
+		uint32_t start = __HAL_TIM_GET_COUNTER(hdht->htim);
+		for (uint32_t i = 0; i < DHT_MULTI_SAMPLES; i++)
+		{
+			while (__HAL_TIM_GET_COUNTER(hdht->htim) - start < i * DHT_MULTI_SAMPLE_US)
+			{
+				// Empty loop
+			}
+			hdht->samples[i] = (uint16_t)hdht->gpio->IDR;
+		}
+
+		lines_idle(hdht); // the timer is left running, it may be shared
+		hdht->phase = DHT_MULTI_PHASE_IDLE;
+
+		DHTmulti_decode(hdht->samples, DHT_MULTI_SAMPLES, hdht->pins, frames, hdht->status);
+		for (int line = 0; line < DHT_MULTI_LINES; line++)
+		{
+			if ((hdht->pins >> line) & 1 && hdht->status[line] == DHT_OK)
+			{
+				hdht->status[line] = DHTconvert_frame(frames[line], DHT_MODEL_AUTO, &hdht->RH[line], &hdht->temp[line]);
+			}
+		}
+		return DHT_OK;
+	}
+
+	/*
+	 * @brief	Decode the frames of every line from port samples
+	 * 			Independent of the hardware, the samples may come from anywhere
+	 * @param	samples input data register samples taken every
+	 * 			DHT_MULTI_SAMPLE_US, starting after the lines are released
+	 * @param	count number of samples
+	 * @param	pins lines to decode
+	 * @param	frames the 5 bytes of the frame of each line (pin number)
+	 * @param	status DHT_OK, DHT_NO_RESPONSE or DHT_TIMEOUT per line,
+	 * 			the check-sum is not checked here
+	 * @retval	None
+	 */
+	void DHTmulti_decode(const uint16_t *samples, uint32_t count, uint16_t pins,
+			uint8_t frames[DHT_MULTI_LINES][5], DHT_StatusTypeDef *status)
+	{
+		uint64_t bits[DHT_MULTI_LINES] = {0};
+		uint8_t falls[DHT_MULTI_LINES] = {0};
+		uint16_t previous = count ? samples[0] & pins : 0;
+
+		/* Only the falls cost more than a few operations per sample */
+		for (uint32_t k = 1; k < count; k++)
+		{
+			uint16_t level = samples[k] & pins;
+			uint16_t fall = previous & ~level;
+			previous = level;
+
+			if (fall)
+			{
+				/* A high pulse is longer than the threshold if the line was high
+				 * on all of the DHT_MULTI_BIT_THRESHOLD + 1 samples before the
+				 * fall: and'ed together, they give every line at once */
+				uint16_t ones = 0;
+				if (k > DHT_MULTI_BIT_THRESHOLD)
+				{
+					ones = fall;
+					for (uint32_t j = k - DHT_MULTI_BIT_THRESHOLD - 1; j < k && ones; j++)
+					{
+						ones &= samples[j];
+					}
+				}
+
+				/* Shift the bit into the frame of every line that fell */
+				for (uint16_t lines = fall; lines != 0; lines &= lines - 1)
+				{
+					int line = __builtin_ctz(lines);
+					bits[line] = (bits[line] << 1) | ((ones >> line) & 1);
+					if (falls[line] < 0xFF)
+					{
+						falls[line]++;
+					}
+				}
+			}
+		}
+
+		/* The last 40 bits of each line are its frame */
+		for (int line = 0; line < DHT_MULTI_LINES; line++)
+		{
+			if (((pins >> line) & 1) == 0)
+			{
+				continue;
+			}
+			if (falls[line] == 0)
+			{
+				status[line] = DHT_NO_RESPONSE;
+				continue;
+			}
+			if (falls[line] < DHT_MULTI_FRAME_FALLS)
+			{
+				status[line] = DHT_TIMEOUT;
+				continue;
+			}
+			for (int i = 0; i < 5; i++)
+			{
+				frames[line][i] = (uint8_t)(bits[line] >> (32 - 8 * i));
+			}
+			status[line] = DHT_OK;
+		}
+	}
@@ -6,56 +6,373 @@
  */
 
 #include "DHTemp.h"
+#include "Format.h"
 
-	GPIO_TypeDef *gpio;
-	uint16_t pin;
-	TIM_HandleTypeDef timer;
+	static GPIO_TypeDef *gpio;
+	static uint16_t pin;
+	static TIM_HandleTypeDef *timer;
+
+	/* Capture mode */
+	static volatile uint32_t edges[DHT_FRAME_EDGES];
+	static volatile uint8_t edgeCount;
+	static volatile uint8_t capturing;
+
+	/* Cooperative read */
+	#define DHT_PHASE_IDLE		0 // no read in progress
+	#define DHT_PHASE_START		1 // line held low for the start pulse
+	#define DHT_PHASE_RESPONSE	2 // line released, waiting for the sensor
+	#define DHT_PHASE_RECEIVE	3 // frame coming in
+	static volatile uint8_t phase;	// also started by DHTtrigger from an interrupt
+	static uint32_t phaseStart;
+
+	/* Sensor front-end */
+	static uint8_t model = DHT_MODEL_AUTO;
+	static uint8_t detectedModel = DHT_MODEL_AUTO;
+	static volatile uint32_t lastStart;
+	static uint8_t triggered;		// Conversions only started by DHTtrigger
+	static uint8_t cachedValid;
+	static int16_t cachedRH;
+	static int16_t cachedTemp;
+	static uint32_t cachedTick;
+	static uint32_t cachedStart;	// Tick of the start of the cached conversion
+	static uint8_t failures;		// Failed conversions in a row
+	static uint32_t retryDelay;	// Time to the next conversion after a failure
+	static uint32_t jitter;		// xorshift state
+
+#ifdef DHT_TELEMETRY
+	/* Telemetry, only updated from the main loop (DHTpoll and DHTreceive_data) */
+	static DHT_TelemetryTypeDef telemetry;
+	static uint8_t lastFailed;
+	#define TELEMETRY(statement) statement
+#else
+	#define TELEMETRY(statement)
+#endif
 
 
 	/*
-	 * @brief	Receive RH, Temp, and Check-sum data and update parameters
-	 * @param	RH variable for humidity x10 as per DHT documentation
-	 * @param	temp variable for temperature x10 as per DHT documentation
-	 * @retval	None
+	 * @brief	Check the check-sum of a frame and convert its values
+	 * 			(also used by "DHTMulti.h" for the frame of each of its lines)
+	 * @param	data the 5 bytes of the frame (RH, temp, check-sum)
+	 * @param	model DHT_MODEL_DHT11, DHT_MODEL_DHT22 or DHT_MODEL_AUTO
+	 * 			to pick the encoding with DHTdetect_model
+	 * @param	RH variable for humidity x10, updated if the check-sum matches
+	 * @param	temp variable for temperature x10, updated if the check-sum matches
+	 * @retval	DHT_OK or DHT_CHECKSUM
 	 */
-	void DHTreceive_data(int16_t *RH, int16_t *temp)
+	DHT_StatusTypeDef DHTconvert_frame(const uint8_t *data, uint8_t model, int16_t *RH, int16_t *temp)
 	{
-		uint8_t checkSum = 0;
-		uint16_t localRH = 0;
-		uint16_t localTemp = 0;
-
-		if (begin_com() == 1)
+		/* Check-sum is the low byte of the sum of the 4 data bytes */
+		if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4])
 		{
-			for (int i = 0; i < 16; i++) // Receive RH data
-			{
-				localRH |= receive_bit() << (15 - i);
-			}
-			for (int j = 0; j < 16; j++) // Receive temp data
-			{
-				localTemp |= receive_bit() << (15 - j);
-			}
-			for (int k = 0; k < 8; k++) // Receive check-sum data
+			return DHT_CHECKSUM;
+		}
+		if (model == DHT_MODEL_AUTO)
+		{
+			model = DHTdetect_model(data);
+		}
+		if (model == DHT_MODEL_DHT11)
+		{
+			/* Integral and decimal bytes, the sign is bit 7 of the temperature decimal */
+			*RH = data[0] * 10 + data[1];
+			*temp = data[2] * 10 + (data[3] & 0x7F);
+			if (data[3] & 0x80)
 			{
-				checkSum |= receive_bit() << (8 - k);
+				*temp = -*temp;
 			}
+			return DHT_OK;
 		}
-		else //communication establishment has failed
+		*RH = (data[0] << 8) | data[1];
+		if (data[2] & 0x80) // Check if temperature is negative
 		{
-			localRH = 0;
-			localTemp = 0;
+			*temp = -(((data[2] & 0x7F) << 8) | data[3]);
 		}
-		if (localTemp & 0x8000) // Check if temperature is negative
+		else
 		{
-			*temp = -(localTemp & 0x7FFF);
+			*temp = (data[2] << 8) | data[3];
 		}
-		else
+		return DHT_OK;
+	}
+
+	/*
+	 * @brief	Tell the encoding of a frame.
+	 * 			A DHT22 sends humidity x10 (at most 1000), so its first byte is
+	 * 			at most 3. A DHT11 sends the integral part of the humidity
+	 * 			(20 - 90 %) there.
+	 * @param	data the 5 bytes of the frame
+	 * @retval	DHT_MODEL_DHT11 or DHT_MODEL_DHT22
+	 */
+	uint8_t DHTdetect_model(const uint8_t *data)
+	{
+		return data[0] > 3 ? DHT_MODEL_DHT11 : DHT_MODEL_DHT22;
+	}
+
+	/*
+	 * @brief	Model the sensor is treated as, the configured or the detected one
+	 * @param	None
+	 * @retval	DHT_MODEL_DHT11, DHT_MODEL_DHT22 or DHT_MODEL_AUTO if not known yet
+	 */
+	static uint8_t sensor_model()
+	{
+		return model != DHT_MODEL_AUTO ? model : detectedModel;
+	}
+
+	/*
+	 * @brief	Time to wait before retrying after failures
+	 * @param	interval normal interval between conversions in ms
+	 * @retval	interval x 2^(failures - 1), at most DHT_BACKOFF_MAX, plus up to a
+	 * 			quarter of random jitter so stations sharing a fault do not retry in step
+	 */
+	static uint32_t retry_delay(uint32_t interval)
+	{
+		uint32_t shift = failures - 1 < DHT_BACKOFF_SHIFT_MAX ? failures - 1 : DHT_BACKOFF_SHIFT_MAX;
+		uint32_t delay = interval << shift;
+		if (delay > DHT_BACKOFF_MAX)
+		{
+			delay = DHT_BACKOFF_MAX;
+		}
+		jitter ^= jitter << 13;
+		jitter ^= jitter >> 17;
+		jitter ^= jitter << 5;
+		return delay + jitter % (delay / 4 + 1);
+	}
+
+	/*
+	 * @brief	Start pulse for the sensor model
+	 * @param	None
+	 * @retval	Start pulse in microseconds
+	 */
+	static uint32_t start_pulse()
+	{
+		return sensor_model() == DHT_MODEL_DHT22 ? DHT_START_PULSE : DHT11_START_PULSE;
+	}
+
+	/*
+	 * @brief	Minimum interval between conversions for the sensor model
+	 * @param	None
+	 * @retval	Interval in milliseconds (DHT22_INTERVAL until a model is known)
+	 */
+	static uint32_t sensor_interval()
+	{
+		return sensor_model() == DHT_MODEL_DHT11 ? DHT11_INTERVAL : DHT22_INTERVAL;
+	}
+
+	/*
+	 * @brief	Convert a frame with the configured model, detect the model if it is auto
+	 * @param	data the 5 bytes of the frame (RH, temp, check-sum)
+	 * @param	RH variable for humidity x10, updated if the check-sum matches
+	 * @param	temp variable for temperature x10, updated if the check-sum matches
+	 * @retval	DHT_OK or DHT_CHECKSUM
+	 */
+	static DHT_StatusTypeDef convert(const uint8_t *data, int16_t *RH, int16_t *temp)
+	{
+		DHT_StatusTypeDef status = DHTconvert_frame(data, model, RH, temp);
+		if (status == DHT_OK && model == DHT_MODEL_AUTO)
 		{
-			*temp = localTemp;
+			detectedModel = DHTdetect_model(data);
+		}
+		return status;
+	}
+
+#ifdef DHT_TELEMETRY
+	/*
+	 * @brief	Add one to a histogram bin, saturating
+	 * @param	bins histogram
+	 * @param	count number of bins
+	 * @param	value measured value
+	 * @param	width width of a bin
+	 * @retval	None
+	 */
+	static void histogram_add(uint16_t *bins, uint32_t count, uint32_t value, uint32_t width)
+	{
+		uint32_t bin = value / width;
+		if (bin >= count)
+		{
+			bin = count - 1;
+		}
+		if (bins[bin] < UINT16_MAX)
+		{
+			bins[bin]++;
+		}
+	}
+
+	/*
+	 * @brief	Count the result of a read that ended
+	 * @param	status result of the read
+	 * @retval	None
+	 */
+	static void record_status(DHT_StatusTypeDef status)
+	{
+		uint32_t *counters[] = {&telemetry.ok, &telemetry.noResponse, &telemetry.timeouts,
+				&telemetry.checksums};
+
+		if (telemetry.reads < UINT32_MAX)
+		{
+			telemetry.reads++;
+		}
+		if (status <= DHT_CHECKSUM && *counters[status] < UINT32_MAX)
+		{
+			(*counters[status])++;
+		}
+		if (lastFailed && telemetry.retries < UINT32_MAX)
+		{
+			telemetry.retries++;
+		}
+		lastFailed = status != DHT_OK;
+	}
+
+	/*
+	 * @brief	Add the response latency and the bit widths of a captured frame
+	 * @param	release timer count when the line was released
+	 * @retval	None
+	 */
+	static void record_frame(uint32_t release)
+	{
+		histogram_add(telemetry.latency, DHT_TELEMETRY_LATENCY_BINS, edges[0] - release,
+				DHT_TELEMETRY_LATENCY_BIN);
+		for (int i = 0; 4 + 2 * i < edgeCount; i++)
+		{
+			histogram_add(telemetry.widths, DHT_TELEMETRY_WIDTH_BINS, edges[4 + 2 * i] - edges[3 + 2 * i],
+					DHT_TELEMETRY_WIDTH_BIN);
+		}
+	}
+
+	/*
+	 * @brief	Copy the telemetry counters (only with DHT_TELEMETRY defined)
+	 * @param	snapshot counters since DHTinit or the last DHTtelemetry_reset
+	 * @retval	None
+	 */
+	void DHTtelemetry(DHT_TelemetryTypeDef *snapshot)
+	{
+		*snapshot = telemetry;
+	}
+
+	/*
+	 * @brief	Clear the telemetry counters (only with DHT_TELEMETRY defined)
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTtelemetry_reset()
+	{
+		DHT_TelemetryTypeDef empty = {0};
+		telemetry = empty;
+		lastFailed = 0;
+	}
+
+	/*
+	 * @brief	Send a text over SWO
+	 * @param	text null terminated
+	 * @retval	None
+	 */
+	static void swo_print(const char *text)
+	{
+		while (*text)
+		{
+			ITM_SendChar(*text++);
+		}
+	}
+
+	/*
+	 * @brief	Send a histogram over SWO, bins separated by commas
+	 * @param	bins histogram
+	 * @param	count number of bins
+	 * @retval	None
+	 */
+	static void swo_histogram(const uint16_t *bins, uint32_t count)
+	{
+		char field[FMT_BUFFER_SIZE];
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			fmt_uint(field, bins[i]);
+			swo_print(i ? "," : " ");
+			swo_print(field);
+		}
+		swo_print("\n");
+	}
+
+	/*
+	 * @brief	Send the telemetry counters over SWO (ITM port 0, only with
+	 * 			DHT_TELEMETRY defined), nothing is sent without a debugger
+	 * 			Three lines: the read counters, then the latency and the bit
+	 * 			width histograms, bins separated by commas
+	 * 			"DHT reads=12 ok=10 no-response=1 timeouts=1 checksums=0 retries=2"
+	 * 			"DHT latency/10us 0,0,11,0,0,0,0,0"
+	 * 			"DHT width/8us 0,0,0,230,...,0"
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTtelemetry_report()
+	{
+		static const char *const names[] = {"DHT reads=", " ok=", " no-response=", " timeouts=",
+				" checksums=", " retries="};
+		const uint32_t counters[] = {telemetry.reads, telemetry.ok, telemetry.noResponse,
+				telemetry.timeouts, telemetry.checksums, telemetry.retries};
+		char field[FMT_BUFFER_SIZE];
+
+		for (int i = 0; i < 6; i++)
+		{
+			fmt_uint(field, counters[i]);
+			swo_print(names[i]);
+			swo_print(field);
+		}
+		swo_print("\nDHT latency/10us");
+		swo_histogram(telemetry.latency, DHT_TELEMETRY_LATENCY_BINS);
+		swo_print("DHT width/8us");
+		swo_histogram(telemetry.widths, DHT_TELEMETRY_WIDTH_BINS);
+	}
+#endif
+
+	/*
+	 * @brief	Wait for the communication line to reach a level
+	 * @param	level GPIO_PIN_SET or GPIO_PIN_RESET
+	 * @param	timeout longest wait in microseconds
+	 * @retval	DHT_OK, or DHT_TIMEOUT if the line did not change in time
+	 */
+	static DHT_StatusTypeDef wait_level(GPIO_PinState level, uint32_t timeout)
+	{
+		uint32_t deadline = delay_deadline_us(timeout);
+		while (HAL_GPIO_ReadPin(gpio, pin) != level)
+		{
+			if (delay_expired(deadline))
+			{
+				return DHT_TIMEOUT;
+			}
+		}
+		return DHT_OK;
+	}
+
+	/*
+	 * @brief	Receive RH, Temp, and Check-sum data and update parameters
+	 * 			Every wait on the line is bounded by DHT_EDGE_TIMEOUT, so a read
+	 * 			takes at most about 26 ms (18 ms start pulse, 40 bits of at most
+	 * 			2 x DHT_EDGE_TIMEOUT). The high pulse of every bit is timed and
+	 * 			the frame decoded from the widths as DHTpoll does (DHTdecode)
+	 * @param	RH variable for humidity x10 as per DHT documentation
+	 * @param	temp variable for temperature x10 as per DHT documentation
+	 * 			RH and temp are only updated when the status is DHT_OK
+	 * @retval	DHT_OK, DHT_NO_RESPONSE, DHT_TIMEOUT or DHT_CHECKSUM
+	 */
+	DHT_StatusTypeDef DHTreceive_data(int16_t *RH, int16_t *temp)
+	{
+		uint32_t stamps[DHT_FRAME_EDGES] = {0}; // laid out as the captured edges, response not timed
+		DHTDecode_ResultTypeDef frame;
+		uint32_t frameStart = delay_now();
+		DHT_StatusTypeDef status = begin_com();
+
+		for (int i = 0; i < 40 && status == DHT_OK; i++) // Receive RH, temp and check-sum data
+		{
+			status = receive_bit(frameStart, &stamps[3 + 2 * i]);
+		}
+		if (status == DHT_OK)
+		{
+			DHTdecode(stamps, DHT_FRAME_EDGES, &frame, 0);
+			status = convert(frame.data, RH, temp);
 		}
-		*RH = localRH;
 
 		/* Set communication line in idle for next update */
 		com_set_idle();
+		TELEMETRY(record_status(status));
+		return status;
 	}
 
 	/*
@@ -63,19 +380,367 @@
 	 * @param	GPIOx where x can be (A, B, C, etc.) to select the GPIO peripheral
 	 * @param	GPIO_Pin specifies the port bit to serve as communication line
 	 * 			of the form GPIO_PIN_x (where x = 0, 1, 2, etc.)
-	 * @param	htim TIM handle for Delay library
-	 * 			Must be setup prior with microsecond per tick
+	 * @param	htim TIM handle of the edge timestamps and read deadlines
+	 * 			Must be setup prior with microsecond per tick, it is started
+	 * 			here and left running (other users may share it)
 	 * @retval 	None
 	 */
-	void DHTinit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin, TIM_HandleTypeDef htim)
+	void DHTinit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin, TIM_HandleTypeDef *htim)
 	{
 		/* Define library GPIO pin and timer parameters */
 		gpio = GPIOx;
 		pin = GPIO_Pin;
 		timer = htim;
 
+		/* Free-running timer for the deadlines and timestamps, started once */
+		HAL_TIM_Base_Start(timer);
+
+		/* Cycle counter for the microsecond delays of the blocking read */
+		delay_init();
+
 		/* Set communication line in idle state before starting communication */
 		com_set_idle();
+
+		/* The first conversion waits one interval, as the sensor needs after power up */
+		lastStart = HAL_GetTick();
+		failures = 0;
+		jitter = (HAL_GetTick() ^ __HAL_TIM_GET_COUNTER(timer)) | 1;
+	}
+
+	/*
+	 * @brief	Select the sensor model (DHT_MODEL_AUTO by default)
+	 * 			The model sets the frame encoding, the start pulse and the
+	 * 			interval between conversions of DHTupdate.
+	 * @param	sensorModel DHT_MODEL_DHT11, DHT_MODEL_DHT22 or DHT_MODEL_AUTO
+	 * @retval	None
+	 */
+	void DHTset_model(uint8_t sensorModel)
+	{
+		model = sensorModel;
+		detectedModel = DHT_MODEL_AUTO;
+	}
+
+	/*
+	 * @brief	Sensor front-end, call as often as possible (never blocks).
+	 * 			Starts a conversion once the minimum interval of the model has
+	 * 			passed since the last one (DHT22_INTERVAL or DHT11_INTERVAL,
+	 * 			DHT22_INTERVAL until an auto-detected model is known), advances
+	 * 			it with DHTpoll and caches the result if it is valid.
+	 * 			After a failed conversion the interval doubles with every
+	 * 			further failure, up to DHT_BACKOFF_MAX, plus up to a quarter of
+	 * 			random jitter, and is back to normal after a valid one.
+	 * 			Once DHTtrigger has been called, conversions are only started
+	 * 			by it.
+	 * @param	None
+	 * @retval	DHT_OK when a new reading was cached by this call,
+	 * 			DHT_BUSY while a conversion is in progress,
+	 * 			DHT_IDLE while waiting for the next conversion,
+	 * 			otherwise the error of the conversion that just ended
+	 */
+	DHT_StatusTypeDef DHTupdate()
+	{
+		uint32_t interval = sensor_interval();
+
+		if (phase != DHT_PHASE_IDLE)
+		{
+			int16_t RH;
+			int16_t temp;
+			DHT_StatusTypeDef status = DHTpoll(&RH, &temp);
+			if (status == DHT_OK)
+			{
+				cachedRH = RH;
+				cachedTemp = temp;
+				cachedTick = HAL_GetTick();
+				cachedStart = lastStart;
+				cachedValid = 1;
+				failures = 0;
+			}
+			else if (status != DHT_BUSY)
+			{
+				if (failures < UINT8_MAX)
+				{
+					failures++;
+				}
+				retryDelay = retry_delay(interval);
+			}
+			return status;
+		}
+
+		if (triggered || HAL_GetTick() - lastStart < (failures ? retryDelay : interval))
+		{
+			return DHT_IDLE;
+		}
+		lastStart = HAL_GetTick();
+		DHTstart_read();
+		return DHT_BUSY;
+	}
+
+	/*
+	 * @brief	Time until DHTtrigger will start a conversion, for scheduling
+	 * 			the retry at the end of a backoff
+	 * @param	None
+	 * @retval	Milliseconds, 0 if a trigger would start a conversion now
+	 */
+	uint32_t DHTnext_conversion()
+	{
+		uint32_t interval = sensor_interval();
+		uint32_t wait = failures ? retryDelay : interval - DHT_TRIGGER_SLACK;
+		uint32_t elapsed = HAL_GetTick() - lastStart;
+
+		return elapsed >= wait ? 0 : wait - elapsed;
+	}
+
+	/*
+	 * @brief	Start a conversion now, for sampling on an external schedule.
+	 * 			May be called from a timer interrupt of lower priority than the
+	 * 			EXTI interrupt of the line. From the first call on, DHTupdate
+	 * 			only completes conversions and no longer starts them.
+	 * 			The trigger is skipped while a conversion is in progress,
+	 * 			during the backoff after failures and while the minimum
+	 * 			interval of the model has not passed (DHT_TRIGGER_SLACK early
+	 * 			is accepted).
+	 * @param	None
+	 * @retval	DHT_BUSY if a conversion was started, DHT_IDLE if skipped
+	 */
+	DHT_StatusTypeDef DHTtrigger()
+	{
+		uint32_t interval = sensor_interval();
+		uint32_t elapsed = HAL_GetTick() - lastStart;
+
+		triggered = 1;
+		if (phase != DHT_PHASE_IDLE || elapsed + DHT_TRIGGER_SLACK < interval
+				|| (failures && elapsed < retryDelay))
+		{
+			return DHT_IDLE;
+		}
+		lastStart = HAL_GetTick();
+		DHTstart_read();
+		return DHT_BUSY;
+	}
+
+	/*
+	 * @brief	Last valid reading cached by DHTupdate
+	 * @param	RH variable for humidity x10
+	 * @param	temp variable for temperature x10
+	 * 			RH and temp are not changed when the sample is DHT_SAMPLE_INVALID
+	 * @param	age variable for the time since the conversion in ms (may be NULL)
+	 * @retval	DHT_SAMPLE_FRESH, DHT_SAMPLE_STALE when older than DHT_STALE_AGE,
+	 * 			DHT_SAMPLE_INVALID (0) before the first valid conversion
+	 */
+	uint8_t DHTlast_reading(int16_t *RH, int16_t *temp, uint32_t *age)
+	{
+		if (!cachedValid)
+		{
+			return DHT_SAMPLE_INVALID;
+		}
+		uint32_t elapsed = HAL_GetTick() - cachedTick;
+		*RH = cachedRH;
+		*temp = cachedTemp;
+		if (age != NULL)
+		{
+			*age = elapsed;
+		}
+		return elapsed > DHT_STALE_AGE ? DHT_SAMPLE_STALE : DHT_SAMPLE_FRESH;
+	}
+
+	/*
+	 * @brief	DHTupdate for the sensor interface
+	 * @param	context not used
+	 * @retval	DHT status mapped to the sensor status, errors are SENSOR_ERROR
+	 */
+	static Sensor_StatusTypeDef sensor_update_dht(void *context)
+	{
+		(void) context;
+		switch (DHTupdate())
+		{
+		case DHT_OK:
+			return SENSOR_OK;
+		case DHT_BUSY:
+			return SENSOR_BUSY;
+		case DHT_IDLE:
+			return SENSOR_IDLE;
+		default:
+			return SENSOR_ERROR;
+		}
+	}
+
+	/*
+	 * @brief	DHTtrigger for the sensor interface
+	 * @param	context not used
+	 * @retval	SENSOR_BUSY if a conversion was started, SENSOR_IDLE if skipped
+	 */
+	static Sensor_StatusTypeDef sensor_trigger_dht(void *context)
+	{
+		(void) context;
+		return DHTtrigger() == DHT_BUSY ? SENSOR_BUSY : SENSOR_IDLE;
+	}
+
+	/*
+	 * @brief	DHTlast_reading for the sensor interface
+	 * @param	context not used
+	 * @param	reading variable for humidity and temperature
+	 * @param	age variable for the time since the conversion in ms (may be NULL)
+	 * @retval	SENSOR_SAMPLE_ tag of the reading
+	 */
+	static uint8_t sensor_last_reading_dht(void *context, Sensor_ReadingTypeDef *reading,
+			uint32_t *age)
+	{
+		(void) context;
+		int16_t RH;
+		int16_t temp;
+		uint8_t tag = DHTlast_reading(&RH, &temp, age);
+		if (tag != DHT_SAMPLE_INVALID)
+		{
+			reading->RH = RH;
+			reading->temp = temp;
+			reading->pressure = 0;
+			reading->timestamp = cachedStart;
+			reading->fields = SENSOR_HAS_RH | SENSOR_HAS_TEMP;
+		}
+		return tag;
+	}
+
+	/*
+	 * @brief	DHTnext_conversion for the sensor interface
+	 * @param	context not used
+	 * @retval	See DHTnext_conversion
+	 */
+	static uint32_t sensor_next_conversion_dht(void *context)
+	{
+		(void) context;
+		return DHTnext_conversion();
+	}
+
+	const Sensor_DriverTypeDef DHT_sensor_driver =
+	{
+		"DHT",
+		sensor_update_dht,
+		sensor_trigger_dht,
+		sensor_last_reading_dht,
+		sensor_next_conversion_dht
+	};
+
+	/*
+	 * @brief	Start a read without blocking.
+	 * 			Pulls the line low for the start pulse and returns. DHTpoll
+	 * 			releases the line once the start pulse has passed, with an EXTI
+	 * 			interrupt on both edges. DHTcapture_edge timestamps every edge
+	 * 			with the timer counter and the frame is decoded from the pulse
+	 * 			widths once it is complete.
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTstart_read()
+	{
+		capturing = 0;
+
+		/* Pull line low for the minimum of 10 ms */
+		HAL_GPIO_WritePin(gpio, pin, GPIO_PIN_RESET);
+		phaseStart = __HAL_TIM_GET_COUNTER(timer);
+		phase = DHT_PHASE_START;
+	}
+
+	/*
+	 * @brief	Advance a read started by DHTstart_read, never blocks.
+	 * 			Start pulse, sensor response, frame reception and decoding
+	 * 			each end on a deadline of the timer counter, so the read fails
+	 * 			with a status instead of waiting for a missing edge.
+	 * @param	RH variable for humidity x10 as per DHT documentation
+	 * @param	temp variable for temperature x10 as per DHT documentation
+	 * 			RH and temp are only updated when the status is DHT_OK
+	 * @retval	DHT_BUSY while the read is in progress, then its result once
+	 * 			(DHT_OK, DHT_NO_RESPONSE, DHT_TIMEOUT or DHT_CHECKSUM),
+	 * 			DHT_IDLE when no read has been started
+	 */
+	DHT_StatusTypeDef DHTpoll(int16_t *RH, int16_t *temp)
+	{
+		uint32_t elapsed = __HAL_TIM_GET_COUNTER(timer) - phaseStart;
+		DHT_StatusTypeDef status;
+		DHTDecode_ResultTypeDef frame;
+
+		switch (phase)
+		{
+		case DHT_PHASE_START:
+			if (elapsed < start_pulse())
+			{
+				return DHT_BUSY;
+			}
+			HAL_GPIO_WritePin(gpio, pin, GPIO_PIN_SET);
+			edgeCount = 0;
+			capturing = 1;
+
+			/* Release line, the sensor response is the first edge */
+			__HAL_GPIO_EXTI_CLEAR_IT(pin);
+			GPIO_InitTypeDef GPIO_InitStruct = {0};
+			GPIO_InitStruct.Pin = pin;
+			GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
+			GPIO_InitStruct.Pull = GPIO_NOPULL;
+			HAL_GPIO_Init(gpio, &GPIO_InitStruct);
+
+			phaseStart = __HAL_TIM_GET_COUNTER(timer);
+			phase = DHT_PHASE_RESPONSE;
+			return DHT_BUSY;
+
+		case DHT_PHASE_RESPONSE:
+			if (edgeCount == 0)
+			{
+				if (elapsed < DHT_RESPONSE_TIMEOUT)
+				{
+					return DHT_BUSY;
+				}
+				status = DHT_NO_RESPONSE;
+				break;
+			}
+			phase = DHT_PHASE_RECEIVE;
+			/* fall through, the frame may already be complete */
+
+		case DHT_PHASE_RECEIVE:
+			/* Edges are counted from the release, like the deadline */
+			if (capturing && elapsed < DHT_FRAME_TIMEOUT)
+			{
+				return DHT_BUSY;
+			}
+			TELEMETRY(record_frame(phaseStart));
+			if (DHTdecode((const uint32_t *)edges, edgeCount, &frame, 0) == 0)
+			{
+				status = DHT_TIMEOUT;
+				break;
+			}
+			status = convert(frame.data, RH, temp);
+			break;
+
+		default:
+			return DHT_IDLE;
+		}
+
+		/* Finish: stop capturing and set communication line in idle for next update
+		 * (the timer keeps running, the sample clock shares it) */
+		capturing = 0;
+		EXTI->IMR &= ~pin;
+		com_set_idle();
+		phase = DHT_PHASE_IDLE;
+		TELEMETRY(record_status(status));
+		return status;
+	}
+
+	/*
+	 * @brief	Record an edge of the communication line.
+	 * 			Must be called from HAL_GPIO_EXTI_Callback for the DHT pin.
+	 * @param	None
+	 * @retval	None
+	 */
+	void DHTcapture_edge()
+	{
+		if (!capturing)
+		{
+			return;
+		}
+		edges[edgeCount++] = __HAL_TIM_GET_COUNTER(timer);
+		if (edgeCount == DHT_FRAME_EDGES)
+		{
+			capturing = 0;
+			EXTI->IMR &= ~pin; // No interrupts from com_set_idle
+		}
 	}
 
 	/*
@@ -83,20 +748,18 @@
 	 * 			The function performs preparation for communication pattern
 	 * 			between the MCU and AM2302.
 	 * @param	None
-	 * @retval	comStatus boolean value signifying the success of establishing
-	 * 			communication between the two devices
+	 * @retval	DHT_OK if communication between the two devices has been
+	 * 			established, DHT_NO_RESPONSE or DHT_TIMEOUT otherwise
 	 */
-	uint8_t begin_com()
+	DHT_StatusTypeDef begin_com()
 	{
-		uint8_t comStatus = 0;
-
 		/* Pull line low for the minimum of 10 ms */
 		HAL_GPIO_WritePin(gpio, pin, GPIO_PIN_RESET);
-		_us_delay(timer, 10000);
+		delay_us(start_pulse());
 
 		/* Pull line up for a duration of 20 - 40 us */
 		HAL_GPIO_WritePin(gpio, pin, GPIO_PIN_SET);
-		_us_delay(timer, 30); // 30us delay
+		delay_us(30); // 30us delay
 
 		/* Release line by setting the pin as input */
 		GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -106,49 +769,48 @@
 		HAL_GPIO_Init(gpio, &GPIO_InitStruct);
 
 		/* Check that sensor pulled line low after 40 us */
-		_us_delay(timer, 40);
-		if (HAL_GPIO_ReadPin(gpio, pin) == 0)
+		delay_us(40);
+		if (HAL_GPIO_ReadPin(gpio, pin) != 0)
 		{
-			/* Check that sensor pulled line up after 80 us */
-			_us_delay(timer, 80);
-			if (HAL_GPIO_ReadPin(gpio, pin) == 1)
-			{
-				comStatus = 1; // Communication has been established
-				while (HAL_GPIO_ReadPin(gpio, pin) != 0) // Wait until the end of preparation period
-				{
-					// Empty loop
-				}
-			}
-			return comStatus;
+			return DHT_NO_RESPONSE;
 		}
-		else
+
+		/* Check that sensor pulled line up after 80 us */
+		delay_us(80);
+		if (HAL_GPIO_ReadPin(gpio, pin) != 1)
 		{
-			return comStatus; // 0 by default - communication has not been established
+			return DHT_NO_RESPONSE;
 		}
+
+		/* Wait until the end of preparation period */
+		return wait_level(GPIO_PIN_RESET, DHT_EDGE_TIMEOUT);
 	}
 
 	/*
-	 * @brief	Receive one bit of data
-	 * @param	None
-	 * @retval	dataBit RH/Temp/Check-sum bit of data
+	 * @brief	Receive one bit of data: time its high pulse
+	 * 			The value is told by DHTdecode from the widths of the whole
+	 * 			frame, not by sampling the line at a fixed point
+	 * @param	frameStart cycle count (delay_now) the timestamps count from
+	 * @param	edges timestamps of the rise and the fall of the bit in
+	 * 			microseconds, as DHTdecode takes them
+	 * @retval	DHT_OK, or DHT_TIMEOUT if the sensor stopped sending
 	 */
-	uint8_t receive_bit()
+	DHT_StatusTypeDef receive_bit(uint32_t frameStart, uint32_t *edges)
 	{
-		while (HAL_GPIO_ReadPin(gpio, pin) == 0) // Wait for sensor to pull line high
+		/* Wait for sensor to pull line high */
+		if (wait_level(GPIO_PIN_SET, DHT_EDGE_TIMEOUT) != DHT_OK)
 		{
-			// Empty loop
+			return DHT_TIMEOUT;
 		}
-		_us_delay(timer, 40); // Skip 40 us
-		uint8_t dataBit = HAL_GPIO_ReadPin(gpio, pin);
-		if (dataBit == 1)
+		edges[0] = delay_elapsed_us(frameStart);
+
+		/* 26 - 28 us for a 0, 70 us for a 1, stretched or shrunk alike on a long cable or a clone */
+		if (wait_level(GPIO_PIN_RESET, DHT_EDGE_TIMEOUT) != DHT_OK)
 		{
-			while (HAL_GPIO_ReadPin(gpio, pin) != 0) /* If the bit was 1, we have to wait for
-			another ~30us for the sensor pull down the line */
-			{
-				// Empty loop
-			}
+			return DHT_TIMEOUT;
 		}
-		return dataBit;
+		edges[1] = delay_elapsed_us(frameStart);
+		return DHT_OK;
 	}
 
 	/*
@@ -7,23 +7,138 @@
 
 #include "Delay.h"
 
+	/* Core clock cycles per microsecond, set by delay_init */
+	static uint32_t cyclesPerUs;
+
+	/*
+	 * @brief	Cycles of a time in nanoseconds, rounded up
+	 * @param	ns	Time in nanoseconds
+	 * @retval	Core clock cycles
+	 */
+	static uint32_t ns_to_cycles(uint32_t ns)
+	{
+		/* Split so that ns * cyclesPerUs can not overflow */
+		return (ns / 1000) * cyclesPerUs + ((ns % 1000) * cyclesPerUs + 999) / 1000;
+	}
+
+	/*
+	 * @brief	Start the cycle counter, call once after the clock is configured
+	 * 			(calling it again only picks up a new SystemCoreClock)
+	 * @param	None
+	 * @retval	None
+	 */
+	void delay_init(void)
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		cyclesPerUs = SystemCoreClock / 1000000U;
+	}
+
+	/*
+	 * @brief	Current count of the cycle counter
+	 * @param	None
+	 * @retval	Core clock cycles, wraps at 2^32
+	 */
+	uint32_t delay_now(void)
+	{
+		return DWT->CYCCNT;
+	}
+
+	/*
+	 * @brief	Deadline some time from now
+	 * @param	ns/us	Time to the deadline, less than 2^31 cycles
+	 * @retval	Cycle count of the deadline, for delay_expired
+	 */
+	uint32_t delay_deadline_ns(uint32_t ns)
+	{
+		return DWT->CYCCNT + ns_to_cycles(ns);
+	}
+
+	uint32_t delay_deadline_us(uint32_t us)
+	{
+		return DWT->CYCCNT + us * cyclesPerUs;
+	}
+
+	/*
+	 * @brief	Whether a deadline has passed (wrap-safe)
+	 * @param	deadline	Cycle count from delay_deadline_ns/us or delay_now
+	 * @retval	1 once the cycle counter has reached the deadline, 0 before
+	 */
+	uint8_t delay_expired(uint32_t deadline)
+	{
+		return (int32_t) (DWT->CYCCNT - deadline) >= 0;
+	}
+
+	/*
+	 * @brief	Time since a cycle count
+	 * @param	since	Cycle count from delay_now, less than 2^32 cycles ago
+	 * @retval	Elapsed time in microseconds, rounded down
+	 */
+	uint32_t delay_elapsed_us(uint32_t since)
+	{
+		return (DWT->CYCCNT - since) / cyclesPerUs;
+	}
+
+	/*
+	 * @brief	Blocking delays of at least the given time
+	 * @param	ns/us	Time to wait, less than 2^31 cycles
+	 * @param	ms		Time to wait in milliseconds, any value
+	 * @retval	None
+	 */
+	void delay_ns(uint32_t ns)
+	{
+		uint32_t deadline = delay_deadline_ns(ns);
+		while (!delay_expired(deadline))
+		{
+			//Empty loop
+		}
+	}
+
+	void delay_us(uint32_t us)
+	{
+		uint32_t deadline = delay_deadline_us(us);
+		while (!delay_expired(deadline))
+		{
+			//Empty loop
+		}
+	}
+
+	void delay_ms(uint32_t ms)
+	{
+		/* One millisecond at a time, each deadline follows on from the last one */
+		uint32_t deadline = DWT->CYCCNT;
+		while (ms--)
+		{
+			deadline += 1000 * cyclesPerUs;
+			while (!delay_expired(deadline))
+			{
+				//Empty loop
+			}
+		}
+	}
+
 	/*
 	 * @brief	Provides blocking delay in microseconds.
+	 * 			Kept for existing callers, delay_us does not need a timer.
+	 * 			The timer is started if needed and left running.
 	 * @param	htim	TIM handle.
-	 * 					Must be setup prior with microsecond per tick
+	 * 					Must be setup prior with microsecond per tick and an
+	 * 					auto-reload value of 2^n - 1 (0xFFFF, 0xFFFFFFFF): the
+	 * 					ticks are counted modulo the reload value + 1
 	 * @param	delay	Desired delay in microseconds.
 	 * 					Max delay - 65535/(2^32 - 1) microseconds (16/32 bit timer).
 	 * @retval	None
 	 */
 	void _us_delay(TIM_HandleTypeDef htim, uint32_t delay)
 	{
-		HAL_TIM_Base_Start(&htim);
+		/* A counter wrapping at any other value would need the wrap added back */
+		assert_param((__HAL_TIM_GET_AUTORELOAD(&htim) & (__HAL_TIM_GET_AUTORELOAD(&htim) + 1)) == 0);
+		/* Never stopped, other users of the timer keep their time base */
+		__HAL_TIM_ENABLE(&htim);
 		uint32_t timer_val = __HAL_TIM_GET_COUNTER(&htim);
-		while ((__HAL_TIM_GET_COUNTER(&htim) - timer_val) != delay)
+		/* Masked with the reload value, the difference of a 16-bit counter wraps at 16 bits */
+		while (((__HAL_TIM_GET_COUNTER(&htim) - timer_val) & __HAL_TIM_GET_AUTORELOAD(&htim)) < delay)
 		{
 			//Empty loop
 		}
-		HAL_TIM_Base_Stop(&htim);
 	}
-
-
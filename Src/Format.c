@@ -0,0 +1,107 @@
+/*
+ * Format.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "Format.h"
+
+// longest number: sign, 10 digits and the decimal point
+#define FMT_NUMBER_SIZE 12
+
+	/*
+	 * @brief	Formats a magnitude and a sign as a fixed-point field.
+	 * @param	buffer		Destination, at least FMT_BUFFER_SIZE bytes.
+	 * @param	magnitude	Absolute value in units of 10^-decimals.
+	 * @param	negative	1 to write a minus sign.
+	 * @param	decimals, width, align	as for fmt_fixed.
+	 * @retval	Number of characters written, not counting the terminating null.
+	 */
+	static uint8_t format(char *buffer, uint32_t magnitude, uint8_t negative, uint8_t decimals, uint8_t width,
+			uint8_t align)
+	{
+		char digits[FMT_NUMBER_SIZE]; // least significant first
+		uint8_t count = 0;
+		uint8_t length = 0;
+
+		if (decimals > FMT_MAX_DECIMALS)
+			decimals = FMT_MAX_DECIMALS;
+		if (width > FMT_MAX_WIDTH)
+			width = FMT_MAX_WIDTH;
+
+		// Division by a constant compiles to a multiply and a shift,
+		// so each digit costs a few cycles (no library division)
+		do
+		{
+			uint32_t quotient = magnitude / 10;
+			digits[length++] = '0' + (char)(magnitude - quotient * 10);
+			magnitude = quotient;
+			if (++count == decimals)
+				digits[length++] = '.';
+		} while (magnitude != 0 || count <= decimals);
+
+		if (negative)
+			digits[length++] = '-';
+
+		uint8_t padding = width > length ? width - length : 0;
+		char *out = buffer;
+
+		if (align == FMT_ALIGN_RIGHT)
+		{
+			for (uint8_t i = 0; i < padding; i++)
+				*out++ = ' ';
+		}
+		for (uint8_t i = length; i > 0; i--)
+			*out++ = digits[i - 1];
+		if (align != FMT_ALIGN_RIGHT)
+		{
+			for (uint8_t i = 0; i < padding; i++)
+				*out++ = ' ';
+		}
+		*out = '\0';
+
+		return (uint8_t)(out - buffer);
+	}
+
+	/*
+	 * @brief	Formats an integer in decimal.
+	 * @param	buffer	Destination, at least FMT_BUFFER_SIZE bytes.
+	 * @param	value	Integer to format (the whole int32 range).
+	 * @retval	Number of characters written, not counting the terminating null.
+	 */
+	uint8_t fmt_int(char *buffer, int32_t value)
+	{
+		return fmt_fixed(buffer, value, 0, 0, FMT_ALIGN_LEFT);
+	}
+
+	/*
+	 * @brief	Formats an unsigned integer in decimal (counters, cycle counts).
+	 * @param	buffer	Destination, at least FMT_BUFFER_SIZE bytes.
+	 * @param	value	Integer to format (the whole uint32 range).
+	 * @retval	Number of characters written, not counting the terminating null.
+	 */
+	uint8_t fmt_uint(char *buffer, uint32_t value)
+	{
+		return format(buffer, value, 0, 0, 0, FMT_ALIGN_LEFT);
+	}
+
+	/*
+	 * @brief	Formats a fixed-point value, e.g. 725 with 1 decimal as "72.5".
+	 * 			Values between -1 and 1 get a leading zero ("-0.5").
+	 * @param	buffer		Destination, at least FMT_BUFFER_SIZE bytes.
+	 * @param	value		Value in units of 10^-decimals (deci-units for 1 decimal).
+	 * @param	decimals	Digits after the decimal point, 0 - FMT_MAX_DECIMALS.
+	 * @param	width		Minimum field width, padded with spaces (0 - FMT_MAX_WIDTH).
+	 * 						Numbers wider than the field are written in full.
+	 * @param	align		FMT_ALIGN_LEFT or FMT_ALIGN_RIGHT.
+	 * @retval	Number of characters written, not counting the terminating null.
+	 */
+	uint8_t fmt_fixed(char *buffer, int32_t value, uint8_t decimals, uint8_t width, uint8_t align)
+	{
+		uint8_t negative = value < 0;
+		// Negate as unsigned so INT32_MIN does not overflow
+		uint32_t magnitude = negative ? 0u - (uint32_t)value : (uint32_t)value;
+
+		return format(buffer, magnitude, negative, decimals, width, align);
+	}
@@ -1,17 +1,138 @@
 #include "LiquidCrystal.h"
+#include <string.h>
 
-	unsigned char _displaycontrol;
-    unsigned char _displayfunction;
-    unsigned char _displaymode;
-    unsigned char _numlines;
-    unsigned char _rowOffsets[4];
-    char          numstr[7];
+    // processQueue bus phases
+    #define LCD_PHASE_IDLE          0 // nothing on the bus, next byte may start
+    #define LCD_PHASE_ENABLE        1 // rs, rw and data are set up, raise enable
+    #define LCD_PHASE_LATCH         2 // enable has been high for a full tick, drop it
+    #define LCD_PHASE_BUSY_ENABLE   3 // bus turned around for a read, raise enable
+    #define LCD_PHASE_BUSY_READ     4 // sample the busy flag, drop enable
+    #define LCD_PHASE_WAIT          5 // no busy flag, wait out the execution time
 
-    uint16_t	  dataPins[8];
-    uint16_t	  _rs;
-    uint16_t	  _rw;
-    uint16_t      _enable;
-    GPIO_TypeDef  *gpioPort;
+    // Time between two processQueue calls of a display in flushAll: enable pulse
+    // >= 450 ns, busy flag valid (tDDR) >= 360 ns, three phases rise to rise >= 1000 ns
+    #define LCD_PHASE_NS            500
+
+    // Displays in DMA mode, so the transfer complete callback can find its display
+    static LCD_HandleTypeDef *dmaDisplays[LCD_MAX_DMA_DISPLAYS];
+
+    /*
+     * Core clock cycles of ns nanoseconds, at least one more than the exact count
+     * (split so that long times such as LCD_EXEC_LONG_NS can not overflow)
+     */
+    static uint32_t ns_cycles(uint32_t ns)
+    {
+        uint32_t perUs = SystemCoreClock / 1000000U;
+
+        return perUs * (ns / 1000U) + perUs * (ns % 1000U) / 1000U + 1;
+    }
+
+    /*
+     * Whether the DWT cycle counter runs (started by delay_init, see "Delay.h",
+     * or by a debugger)
+     */
+    static uint8_t cycle_counter_running(void)
+    {
+        return (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0;
+    }
+
+    /*
+     * Busy-wait for at least ns nanoseconds
+     * Used for the sub-microsecond enable timing of the busy flag mode
+     * Measured on the DWT cycle counter when it runs, otherwise
+     * counted in loop iterations, each takes at least one core clock cycle
+     */
+    static void delay_ns(uint32_t ns)
+    {
+        uint32_t cycles = ns_cycles(ns);
+
+        if (cycle_counter_running())
+        {
+            uint32_t start = DWT->CYCCNT;
+            while (DWT->CYCCNT - start < cycles)
+            {
+                // Empty loop
+            }
+            return;
+        }
+
+        volatile uint32_t count = cycles;
+        while (count--)
+        {
+            // Empty loop
+        }
+    }
+
+    /*
+     * Switch all the data pins to input (reading the LCD) or back to
+     * output (writing to the LCD) with a single MODER update
+     * Pull, speed and output type stay as configured by the user
+     */
+    static void data_pins_input(LCD_HandleTypeDef *lcd)
+    {
+        lcd->gpioPort->MODER &= ~lcd->dataModerMask;
+    }
+
+    static void data_pins_output(LCD_HandleTypeDef *lcd)
+    {
+        lcd->gpioPort->MODER = (lcd->gpioPort->MODER & ~lcd->dataModerMask) | lcd->dataModerOutput;
+    }
+
+    /*
+     * Turn the bus around for busy flag reads, processQueue raises enable next
+     */
+    static void busy_poll_start(LCD_HandleTypeDef *lcd)
+    {
+        data_pins_input(lcd);
+        lcd->gpioPort->BSRR = ((uint32_t)lcd->rs << 16) | lcd->rw;
+        lcd->busyTries = LCD_BUSY_TIMEOUT;
+        lcd->phase = LCD_PHASE_BUSY_ENABLE;
+    }
+
+    static void dma_complete(DMA_HandleTypeDef *hdma);
+    static void dma_pay_carry(LCD_HandleTypeDef *lcd);
+    static void bus_setup(LCD_HandleTypeDef *lcd);
+
+    static void parallel8_init(LCD_HandleTypeDef *lcd);
+    static void parallel8_send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode);
+    static void parallel8_write(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length, unsigned char mode);
+    static void parallel4_init(LCD_HandleTypeDef *lcd);
+    static void parallel4_send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode);
+    static void parallel4_write(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length, unsigned char mode);
+
+    static const LCD_TransportTypeDef transport8bit =
+    {
+        LCD_8BITMODE, parallel8_init, parallel8_send, parallel8_write
+    };
+
+    static const LCD_TransportTypeDef transport4bit =
+    {
+        LCD_4BITMODE, parallel4_init, parallel4_send, parallel4_write
+    };
+
+#ifdef HAL_I2C_MODULE_ENABLED
+    static void pcf8574_init(LCD_HandleTypeDef *lcd);
+    static void pcf8574_send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode);
+    static void pcf8574_write(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length, unsigned char mode);
+
+    static const LCD_TransportTypeDef transportI2C =
+    {
+        LCD_4BITMODE, pcf8574_init, pcf8574_send, pcf8574_write
+    };
+#endif
+
+    /*
+     * Two bit MODER field mask of a GPIO_PIN_x pin
+     */
+    static uint32_t moder_mask(uint16_t pin)
+    {
+        uint32_t position = 0;
+
+        while (((uint32_t)pin >> position) > 1U)
+            position++;
+
+        return 3U << (2U * position);
+    }
 
     /*
      * Pin setup
@@ -24,27 +145,133 @@
      * and that the pins are of the form GPIO_PIN_x (where x = 0, 1, 2, etc.)
      *
      * The function assumes all GPIO ports have already been initialized prior by the user
+     *
+     * The single port lets every byte go out with one BSRR store: the set/reset
+     * words for all 256 byte values are computed here once
      */
-    void pin_setup(GPIO_TypeDef *GPIOx, uint16_t d0, uint16_t d1, uint16_t d2, uint16_t d3,
+    void pin_setup(LCD_HandleTypeDef *lcd, GPIO_TypeDef *GPIOx, uint16_t d0, uint16_t d1, uint16_t d2, uint16_t d3,
     		uint16_t d4, uint16_t d5, uint16_t d6, uint16_t d7, uint16_t rs, uint16_t rw, uint16_t e)
     {
         // GPIO port
-    	gpioPort = GPIOx;
+    	lcd->gpioPort = GPIOx;
 
     	// LCD data signals are now on dataPins
-        dataPins[0] = d0;
-        dataPins[1] = d1;
-        dataPins[2] = d2;
-        dataPins[3] = d3;
-        dataPins[4] = d4;
-        dataPins[5] = d5;
-        dataPins[6] = d6;
-        dataPins[7] = d7;
+        lcd->dataPins[0] = d0;
+        lcd->dataPins[1] = d1;
+        lcd->dataPins[2] = d2;
+        lcd->dataPins[3] = d3;
+        lcd->dataPins[4] = d4;
+        lcd->dataPins[5] = d5;
+        lcd->dataPins[6] = d6;
+        lcd->dataPins[7] = d7;
 
         // LCD control signals are now on _rs, _rw, and _enable
-        _rs = rs;
-        _rw = rw;
-        _enable = e;
+        lcd->rs = rs;
+        lcd->rw = rw;
+        lcd->enable = e;
+
+        lcd->busyPin = d7;
+        lcd->transport = &transport8bit;
+        bus_setup(lcd);
+    }
+
+    /*
+     * Pin setup (4-bit)
+     * -------
+     * Maps the STM32 pins to the LCD pins for a 4-bit bus (D0 - D3 of the LCD left open)
+     * Same requirements as pin_setup, which it replaces
+     *
+     * Bytes are sent as two nibbles, high nibble first
+     */
+    void pin_setup_4bit(LCD_HandleTypeDef *lcd, GPIO_TypeDef *GPIOx, uint16_t d4, uint16_t d5, uint16_t d6, uint16_t d7,
+    		uint16_t rs, uint16_t rw, uint16_t e)
+    {
+        // GPIO port
+    	lcd->gpioPort = GPIOx;
+
+    	// In 4-bit mode the nibble goes out on the first four dataPins
+        lcd->dataPins[0] = d4;
+        lcd->dataPins[1] = d5;
+        lcd->dataPins[2] = d6;
+        lcd->dataPins[3] = d7;
+        lcd->dataPins[4] = 0;
+        lcd->dataPins[5] = 0;
+        lcd->dataPins[6] = 0;
+        lcd->dataPins[7] = 0;
+
+        // LCD control signals are now on _rs, _rw, and _enable
+        lcd->rs = rs;
+        lcd->rw = rw;
+        lcd->enable = e;
+
+        lcd->busyPin = d7;
+        lcd->transport = &transport4bit;
+        bus_setup(lcd);
+    }
+
+#ifdef HAL_I2C_MODULE_ENABLED
+    /*
+     * I2C setup
+     * -------
+     * Drive the LCD through a PCF8574 I2C backpack instead of GPIO pins
+     * (P0 = rs, P1 = rw, P2 = enable, P3 = backlight, P4 - P7 = D4 - D7)
+     * This function replaces pin_setup
+     *
+     * Whole strings are packed into one I2C transaction. If hi2c has a TX DMA
+     * stream linked the transaction is sent with DMA and the call returns
+     * right away (the next call waits for it to finish)
+     * The busy flag is not read, the bus speed (at most 400 kHz) provides the
+     * execution time between bytes
+     *
+     * hi2c: I2C handle, initialized by the user
+     * address: 7 bit address of the backpack (0x27 or 0x3F for most boards)
+     */
+    void i2c_setup(LCD_HandleTypeDef *lcd, I2C_HandleTypeDef *hi2c, uint8_t address)
+    {
+        lcd->i2c = hi2c;
+        lcd->i2cAddress = (uint16_t)address << 1;
+        lcd->i2cBacklight = LCD_PCF_BACKLIGHT;
+        lcd->transport = &transportI2C;
+        lcd->waitmode = LCD_WAIT_DELAY;
+    }
+#endif
+
+    /*
+     * Build the BSRR tables of the data and control pins
+     */
+    static void bus_setup(LCD_HandleTypeDef *lcd)
+    {
+        // Precompute the BSRR word of every byte so a byte goes out in one store
+        // (in 4-bit mode only the low nibble of the index is used)
+        for (int value = 0; value < 256; value++)
+        {
+            uint32_t word = 0;
+
+            for (int i = 0; i < 8; i++)
+            {
+                if ((value >> i) & 0x01)
+                    word |= lcd->dataPins[i];
+                else
+                    word |= (uint32_t)lcd->dataPins[i] << 16;
+            }
+            lcd->busTable[value] = word;
+        }
+
+        lcd->ctrlWords[0] = ((uint32_t)lcd->rs << 16) | ((uint32_t)lcd->rw << 16);
+        lcd->ctrlWords[1] = lcd->rs | ((uint32_t)lcd->rw << 16);
+
+        // MODER fields of the data pins, for switching them to input during busy flag reads
+        lcd->dataModerMask = 0;
+        lcd->dataModerOutput = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            if (lcd->dataPins[i] == 0)
+                continue;
+
+            uint32_t mask = moder_mask(lcd->dataPins[i]);
+            lcd->dataModerMask |= mask;
+            lcd->dataModerOutput |= mask & 0x55555555U;
+        }
 
     }
 
@@ -60,39 +287,46 @@
      *
      * dotsize: can be either LCD_5x8DOTS or LCD_5x10DOTS (mine is 5x8)
      */
-    void begin(unsigned char cols, unsigned char lines, unsigned char dotsize)
+    void begin(LCD_HandleTypeDef *lcd, unsigned char cols, unsigned char lines, unsigned char dotsize)
     {
+        // The busy flag can not be checked until the function set is done,
+        // so initialization always runs with fixed delays
+        unsigned char waitmode = lcd->waitmode;
+        unsigned char writemode = lcd->writemode;
+        lcd->waitmode = LCD_WAIT_DELAY;
+        lcd->writemode = LCD_WRITE_BLOCKING;
+
         // Display specifications
-        // Default: 8 bit mode, 1 line, 5x8 dots= size
+        // Default: bus width of the transport, 1 line, 5x8 dots= size
 
-        _displayfunction = LCD_8BITMODE | LCD_1LINE | LCD_5x8DOTS;
+        lcd->displayfunction = lcd->transport->bitmode | LCD_1LINE | LCD_5x8DOTS;
 
          if (lines > 1)
         {
-            _displayfunction |= LCD_2LINE;
+            lcd->displayfunction |= LCD_2LINE;
         }
 
-        _numlines = lines; // store the number of lines
+        lcd->numlines = lines; // store the number of lines
+        lcd->numcols = cols;
+
+        // The frame buffer holds one byte per visible cell
+        if ((unsigned int)cols * lines > LCD_DDRAM_SIZE)
+            lcd->numcols = LCD_DDRAM_SIZE / lines;
 
         // Figure 4 in the datasheet (page 11)
         // First row address in DDRAM starts at 0x00
         // Second row address in DDRAM start at 0x40
         // Third row (left of first row) address in DDRAM starts at 0x00 + cols
         // Fourth row (left of second row) address in DDRAM starts at 0x40 + cols)
-        setRowOffsets(0x00, 0x40, 0x00 + cols, 0x40 + cols);
+        setRowOffsets(lcd, 0x00, 0x40, 0x00 + cols, 0x40 + cols);
 
         if (dotsize != LCD_5x8DOTS)
-            _displayfunction |= LCD_5x10DOTS;
+            lcd->displayfunction |= LCD_5x10DOTS;
 
         // Initialize LCD
         // SEE PAGE 45/46 for initialization specifications
-        // We will just focus on 8 bits mode
         HAL_Delay(41); // We need at least 40 ms after power rises above 2.7 V
-        sendCommand(LCD_FUNCTIONSET | _displayfunction);
-        HAL_Delay(5); // wait for 4.1 ms
-        sendCommand(LCD_FUNCTIONSET | _displayfunction);
-        HAL_Delay(1); // wait for more than 100 us
-        sendCommand(LCD_FUNCTIONSET | _displayfunction);
+        lcd->transport->init(lcd);
 
         // When the display powers up, it is configured as follows:
         //
@@ -110,29 +344,50 @@
         //    S = 0; No shift
 
         // Now the LCD is on, we configure the lines and dotsize
-        sendCommand(LCD_FUNCTIONSET | _displayfunction);
+        sendCommand(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
 
         // turn the display on with no cursor or blinking default
 
-        _displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
-        displayON();
+        lcd->displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+        displayON(lcd);
 
         // clear it off
-        clear();
+        lcd->buffered = 0;
+        clear(lcd);
 
         // Initialize default text direction to left to right
-        _displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
-        sendCommand(LCD_ENTRYMODESET | _displaymode);
+        lcd->displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+        sendCommand(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+
+        // CGRAM content is undefined after power on
+        memset(lcd->glyphUsed, 0, sizeof(lcd->glyphUsed));
+        lcd->glyphClock = 0;
+        lcd->glyphUploads = 0;
 
+        lcd->waitmode = waitmode;
+        lcd->writemode = writemode;
     }
 
     /* write
      * -------
      * Write a character to the LCD
      */
-    void write(unsigned char chr)
+    void write(LCD_HandleTypeDef *lcd, unsigned char chr)
     {
-        sendData(chr);
+        if (lcd->buffered)
+        {
+            // cells outside of the visible area are dropped
+            if (lcd->frameCol < lcd->numcols)
+                lcd->frame[lcd->frameRow * lcd->numcols + lcd->frameCol] = chr;
+
+            if (lcd->displaymode & LCD_ENTRYLEFT)
+                lcd->frameCol++;
+            else
+                lcd->frameCol--;
+            return;
+        }
+
+        sendData(lcd, chr);
     }
 
     /* print
@@ -140,13 +395,19 @@
      * Print a string
      *
      */
-    void print(unsigned char *chr)
+    void print(LCD_HandleTypeDef *lcd, unsigned char *chr)
     {
-        while (*chr != '\0')
+        if (lcd->buffered)
         {
-            write(*chr);
-            chr++;
+            while (*chr != '\0')
+            {
+                write(lcd, *chr);
+                chr++;
+            }
+            return;
         }
+
+        writeBuffer(lcd, chr, strlen((const char *)chr));
     }
 
     /* print_int
@@ -154,10 +415,31 @@
      * Print an integer
      *
      */
-    void print_int(int num)
+    void print_int(LCD_HandleTypeDef *lcd, int num)
+    {
+        char numstr[FMT_BUFFER_SIZE];
+
+        fmt_int(numstr, num);
+        print(lcd, (unsigned char *)numstr);
+    }
+
+    /* print_fixed
+     * ------
+     * Print a fixed-point value in a field of constant width, so a shorter
+     * value overwrites all of a longer one without printing extra spaces
+     *
+     * value: value in units of 10^-decimals (e.g. 725 with 1 decimal is 72.5)
+     * decimals: digits after the decimal point (0 - FMT_MAX_DECIMALS)
+     * width: field width, padded with spaces (0 prints just the number)
+     * align: FMT_ALIGN_LEFT or FMT_ALIGN_RIGHT
+     */
+    void print_fixed(LCD_HandleTypeDef *lcd, int32_t value, unsigned char decimals, unsigned char width,
+            unsigned char align)
     {
-        sprintf(numstr, "%d", num);
-        print(numstr);
+        char numstr[FMT_BUFFER_SIZE];
+
+        fmt_fixed(numstr, value, decimals, width, align);
+        print(lcd, (unsigned char *)numstr);
     }
 
     /* displayON
@@ -165,10 +447,10 @@
      * Turn on the display
      *
      */
-    void displayON()
+    void displayON(LCD_HandleTypeDef *lcd)
     {
-        _displaycontrol |= LCD_DISPLAYON;
-        sendCommand(LCD_DISPLAYCONTROL | _displaycontrol);
+        lcd->displaycontrol |= LCD_DISPLAYON;
+        sendCommand(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
     }
 
     /* display
@@ -179,9 +461,9 @@
      *
      */
 
-    void display()
+    void display(LCD_HandleTypeDef *lcd)
     {
-        displayON();
+        displayON(lcd);
     }
 
      /* displayOFF
@@ -190,10 +472,10 @@
      *
      */
 
-    void displayOFF()
+    void displayOFF(LCD_HandleTypeDef *lcd)
     {
-        _displaycontrol &= ~LCD_DISPLAYON;
-        sendCommand(LCD_DISPLAYCONTROL | _displaycontrol);
+        lcd->displaycontrol &= ~LCD_DISPLAYON;
+        sendCommand(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
     }
 
     /* noDisplay
@@ -203,19 +485,28 @@
      * Arduino LiquidCrystal library
      *
      */
-    void noDisplay()
+    void noDisplay(LCD_HandleTypeDef *lcd)
     {
-        displayOFF();
+        displayOFF(lcd);
     }
 
     /* clear
      * -------
      * Clears the screen and return cursor to home
      */
-    void clear()
+    void clear(LCD_HandleTypeDef *lcd)
     {
-        sendCommand(LCD_CLEARDISPLAY); // clear display, set cursor position to zero
-        HAL_Delay(2); // this command takes a long time :)
+        if (lcd->buffered)
+        {
+            memset(lcd->frame, ' ', sizeof(lcd->frame));
+            lcd->frameCol = 0;
+            lcd->frameRow = 0;
+            return;
+        }
+
+        sendCommand(lcd, LCD_CLEARDISPLAY); // clear display, set cursor position to zero
+        if (lcd->waitmode == LCD_WAIT_DELAY && lcd->writemode == LCD_WRITE_BLOCKING)
+            HAL_Delay(2); // this command takes a long time :)
     }
 
     /* home
@@ -224,10 +515,18 @@
      * Doesn't clear the screen
      *
      */
-    void home()
+    void home(LCD_HandleTypeDef *lcd)
     {
-        sendCommand(LCD_RETURNHOME);
-        HAL_Delay(2);
+        if (lcd->buffered)
+        {
+            lcd->frameCol = 0;
+            lcd->frameRow = 0;
+            return;
+        }
+
+        sendCommand(lcd, LCD_RETURNHOME);
+        if (lcd->waitmode == LCD_WAIT_DELAY && lcd->writemode == LCD_WRITE_BLOCKING)
+            HAL_Delay(2);
     }
 
     /*
@@ -246,12 +545,12 @@
      * row3: starting address of second row in the second line
 
      */
-    void setRowOffsets(unsigned char row0, unsigned char row1, unsigned char row2, unsigned char row3)
+    void setRowOffsets(LCD_HandleTypeDef *lcd, unsigned char row0, unsigned char row1, unsigned char row2, unsigned char row3)
     {
-        _rowOffsets[0] = row0;
-        _rowOffsets[1] = row1;
-        _rowOffsets[2] = row2;
-        _rowOffsets[3] = row3;
+        lcd->rowOffsets[0] = row0;
+        lcd->rowOffsets[1] = row1;
+        lcd->rowOffsets[2] = row2;
+        lcd->rowOffsets[3] = row3;
 
     }
 
@@ -263,14 +562,21 @@
      * col: column number (in my case 0 to 31), the col after 15 are not visible (right of screen)
      * row: row number (in my case 0 to 3)
      */
-    void setCursor(unsigned char col, unsigned row)
+    void setCursor(LCD_HandleTypeDef *lcd, unsigned char col, unsigned row)
     {
 
         // if the row is not within range, assume it is on the last line
-        if (row >= _numlines)
-            row = _numlines - 1;
+        if (row >= lcd->numlines)
+            row = lcd->numlines - 1;
+
+        if (lcd->buffered)
+        {
+            lcd->frameCol = col;
+            lcd->frameRow = row;
+            return;
+        }
 
-        sendCommand(LCD_SETDDRAMADDR | (col + _rowOffsets[row]));
+        sendCommand(lcd, LCD_SETDDRAMADDR | (col + lcd->rowOffsets[row]));
     }
 
 
@@ -278,10 +584,10 @@
      *----------
      * Display the cursor as an underline
      */
-    void cursor()
+    void cursor(LCD_HandleTypeDef *lcd)
     {
-        _displaycontrol |= LCD_CURSORON;
-        sendCommand(LCD_DISPLAYCONTROL | _displaycontrol);
+        lcd->displaycontrol |= LCD_CURSORON;
+        sendCommand(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
 
     }
 
@@ -289,10 +595,10 @@
      *----------
      * Display the cursor as an underline
      */
-    void noCursor()
+    void noCursor(LCD_HandleTypeDef *lcd)
     {
-        _displaycontrol &= ~LCD_CURSORON;
-        sendCommand(LCD_DISPLAYCONTROL | _displaycontrol);
+        lcd->displaycontrol &= ~LCD_CURSORON;
+        sendCommand(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
 
     }
 
@@ -300,10 +606,10 @@
      *----------
      * blink on the blinking cursor
      */
-    void blink()
+    void blink(LCD_HandleTypeDef *lcd)
     {
-        _displaycontrol |= LCD_BLINKON;
-        sendCommand(LCD_DISPLAYCONTROL | _displaycontrol);
+        lcd->displaycontrol |= LCD_BLINKON;
+        sendCommand(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
 
     }
 
@@ -311,10 +617,10 @@
      *----------
      * turn off the blinking cursor
      */
-    void noBlink()
+    void noBlink(LCD_HandleTypeDef *lcd)
     {
-        _displaycontrol &= ~LCD_BLINKON;
-        sendCommand(LCD_DISPLAYCONTROL | _displaycontrol);
+        lcd->displaycontrol &= ~LCD_BLINKON;
+        sendCommand(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
 
     }
 
@@ -322,17 +628,17 @@
      * -------------------
      * Scrolls the contents of the display (text and cursor) one space to the left)
      */
-    void scrollDisplayLeft()
+    void scrollDisplayLeft(LCD_HandleTypeDef *lcd)
     {
-      sendCommand(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVELEFT);
+      sendCommand(lcd, LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVELEFT);
     }
 
     /* scrollDisplayRight
      * Scrolls the contents of the display (text and cursor) one space to the right
      */
-    void scrollDisplayRight()
+    void scrollDisplayRight(LCD_HandleTypeDef *lcd)
     {
-      sendCommand(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVERIGHT);
+      sendCommand(lcd, LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVERIGHT);
     }
 
     /* leftToRight
@@ -342,10 +648,10 @@
      * display will go from left to right, but does not affect previously-output
      * text.
      */
-    void leftToRight()
+    void leftToRight(LCD_HandleTypeDef *lcd)
     {
-      _displaymode |= LCD_ENTRYLEFT;
-      sendCommand(LCD_ENTRYMODESET | _displaymode);
+      lcd->displaymode |= LCD_ENTRYLEFT;
+      sendCommand(lcd, LCD_ENTRYMODESET | lcd->displaymode);
     }
 
     /* rightToLeft
@@ -355,10 +661,10 @@
      *  written to the display will go from right to left, but does not affect
      *  previously-output text.
      */
-    void rightToLeft()
+    void rightToLeft(LCD_HandleTypeDef *lcd)
     {
-      _displaymode &= ~LCD_ENTRYLEFT;
-      sendCommand(LCD_ENTRYMODESET | _displaymode);
+      lcd->displaymode &= ~LCD_ENTRYLEFT;
+      sendCommand(lcd, LCD_ENTRYMODESET | lcd->displaymode);
     }
 
     /* autoscroll
@@ -366,50 +672,680 @@
      * Turns on automatic scrolling of the LCD
      *
      */
-    void autoscroll(void)
+    void autoscroll(LCD_HandleTypeDef *lcd)
     {
-      _displaymode |= LCD_ENTRYSHIFTINCREMENT;
-      sendCommand(LCD_ENTRYMODESET | _displaymode);
+      lcd->displaymode |= LCD_ENTRYSHIFTINCREMENT;
+      sendCommand(lcd, LCD_ENTRYMODESET | lcd->displaymode);
     }
 
     /* noAutoscroll
      * ------------------
      * Turns off automatic scrolling of the LCD
      */
-    void noAutoscroll()
+    void noAutoscroll(LCD_HandleTypeDef *lcd)
     {
-      _displaymode &= ~LCD_ENTRYSHIFTINCREMENT;
-      sendCommand(LCD_ENTRYMODESET | _displaymode);
+      lcd->displaymode &= ~LCD_ENTRYSHIFTINCREMENT;
+      sendCommand(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+    }
+
+    /* setWaitMode
+     * ------------------
+     * Select how the driver waits for the LCD to finish each byte
+     *
+     * mode: LCD_WAIT_DELAY (default) uses fixed millisecond delays and never reads
+     *       from the LCD, LCD_WAIT_BUSYFLAG reads the busy flag on D7 through the
+     *       rw pin and sends the next byte as soon as the LCD is ready.
+     *       LCD_WAIT_BUSYFLAG requires rw to be wired to the MCU (not tied to ground)
+     *       and is ignored for the I2C backpack
+     *
+     * begin always initializes the LCD with fixed delays, since the busy flag
+     * can not be checked before the function set is complete
+     */
+    void setWaitMode(LCD_HandleTypeDef *lcd, unsigned char mode)
+    {
+#ifdef HAL_I2C_MODULE_ENABLED
+        // the I2C backpack is never read from
+        if (lcd->transport == &transportI2C)
+            return;
+#endif
+
+        lcd->waitmode = mode;
+    }
+
+    /* frameBufferON
+     * ------------------
+     * Route write, print, setCursor, clear and home to a RAM frame buffer
+     * Nothing is sent to the LCD until flush is called
+     *
+     * The LCD is cleared so that it matches the (blank) frame buffer
+     */
+    void frameBufferON(LCD_HandleTypeDef *lcd)
+    {
+        lcd->buffered = 0;
+        clear(lcd);
+        memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+        lcd->buffered = 1;
+        clear(lcd);
+    }
+
+    /* frameBufferOFF
+     * ------------------
+     * Write straight to the LCD again (the frame buffer content is kept
+     * on the screen but no longer tracked)
+     */
+    void frameBufferOFF(LCD_HandleTypeDef *lcd)
+    {
+        lcd->buffered = 0;
+    }
+
+    /* flush
+     * ------------------
+     * Send the cells of the frame buffer that differ from what the LCD holds
+     *
+     * Each run of changed cells of a row is sent as one LCD_SETDDRAMADDR
+     * followed by an auto-increment run. Unchanged cells are never resent:
+     * bridging even a single one costs the byte the address command saves.
+     * The LCD cursor is left after the last changed cell.
+     */
+    void flush(LCD_HandleTypeDef *lcd)
+    {
+        unsigned char mode = lcd->displaymode;
+        unsigned char modeChanged = 0;
+
+        for (unsigned char row = 0; row < lcd->numlines; row++)
+        {
+            unsigned char *frame = &lcd->frame[row * lcd->numcols];
+            unsigned char *shadow = &lcd->shadow[row * lcd->numcols];
+            unsigned char col = 0;
+
+            while (col < lcd->numcols)
+            {
+                if (frame[col] == shadow[col])
+                {
+                    col++;
+                    continue;
+                }
+
+                // Find the end of the run of changed cells
+                unsigned char start = col;
+                unsigned char end = col + 1;
+                while (end < lcd->numcols && frame[end] != shadow[end])
+                    end++;
+
+                // In asynchronous and DMA modes, leave whatever does not fit in the queue
+                // dirty for the next flush (entry mode set, address, run, restore)
+                if (lcd->writemode != LCD_WRITE_BLOCKING && queueSpace(lcd) < (unsigned int)(end - start) + 4)
+                    break;
+
+                // Runs rely on left to right auto-increment without display shift
+                if (!modeChanged && mode != (LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT))
+                {
+                    sendCommand(lcd, LCD_ENTRYMODESET | LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT);
+                    modeChanged = 1;
+                }
+
+                sendCommand(lcd, LCD_SETDDRAMADDR | (start + lcd->rowOffsets[row]));
+                writeBuffer(lcd, &frame[start], end - start);
+                memcpy(&shadow[start], &frame[start], end - start);
+                col = end;
+            }
+        }
+
+        if (modeChanged)
+            sendCommand(lcd, LCD_ENTRYMODESET | mode);
+
+        // Start streaming the new frame (or leave it for the next flush if
+        // the previous one is still going out)
+        if (lcd->writemode == LCD_WRITE_DMA)
+            dmaCommit(lcd);
+    }
+
+    /* flushAll
+     * ------------------
+     * flush several displays at once
+     *
+     * Displays on the 8-bit bus in blocking mode are switched to asynchronous
+     * mode for the duration of the call and their queues are drained one bus
+     * phase at a time, round robin, so one controller executes a byte while
+     * the next display's byte is put on its bus. The frame takes about as long
+     * as the slowest display instead of the sum of all of them.
+     * Two phases of the same display are at least 500 ns apart (enable pulse
+     * width, busy flag delay), timed on the DWT cycle counter when it runs.
+     * Displays in asynchronous or DMA mode are flushed into their own queues,
+     * the others (4-bit, I2C) one after the other.
+     *
+     * lcds: handles of the displays, only the first 32 are interleaved
+     * count: number of handles
+     */
+    void flushAll(LCD_HandleTypeDef **lcds, unsigned int count)
+    {
+        uint32_t interleaved = 0;
+        uint32_t due[32]; // cycle count of the next phase of each display
+        unsigned char paced = cycle_counter_running();
+        unsigned char busy;
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (i < 32 && lcds[i]->transport == &transport8bit && lcds[i]->writemode == LCD_WRITE_BLOCKING)
+            {
+                asyncON(lcds[i], NULL);
+                interleaved |= 1UL << i;
+                due[i] = paced ? DWT->CYCCNT : 0;
+            }
+            else
+            {
+                flush(lcds[i]);
+            }
+        }
+
+        do
+        {
+            busy = 0;
+            for (unsigned int i = 0; i < count && i < 32; i++)
+            {
+                if (!(interleaved & (1UL << i)))
+                    continue;
+
+                // Queue the frame, or what did not fit in the queue last time
+                if (isIdle(lcds[i]))
+                    flush(lcds[i]);
+
+                if (isIdle(lcds[i]))
+                    continue;
+                busy = 1;
+
+                // Each display gets its own LCD_PHASE_NS deadline, so the others
+                // are served while one holds its enable pulse
+                if (paced)
+                {
+                    if ((int32_t)(DWT->CYCCNT - due[i]) < 0)
+                        continue;
+                    due[i] = DWT->CYCCNT + ns_cycles(LCD_PHASE_NS);
+                }
+                processQueue(lcds[i]);
+            }
+
+            // Without the cycle counter a whole round is paced at once
+            if (!paced && busy)
+                delay_ns(LCD_PHASE_NS);
+        } while (busy);
+
+        for (unsigned int i = 0; i < count && i < 32; i++)
+        {
+            if (interleaved & (1UL << i))
+                asyncOFF(lcds[i]);
+        }
+    }
+
+    /*
+     * FNV-1a hash of a glyph bitmap, to skip most of the comparisons
+     * against the resident glyphs
+     */
+    static uint32_t glyph_hash(const unsigned char *bitmap)
+    {
+        uint32_t hash = 2166136261u;
+
+        for (int i = 0; i < 8; i++)
+        {
+            hash ^= bitmap[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /*
+     * Whether a cell shows CGRAM slot (codes 8 - 15 repeat 0 - 7), in the frame
+     * buffer or still on the LCD (shadow) until the next flush replaces it
+     */
+    static unsigned char glyph_on_screen(LCD_HandleTypeDef *lcd, int slot)
+    {
+        unsigned int cells = (unsigned int)lcd->numcols * lcd->numlines;
+
+        for (unsigned int i = 0; i < cells; i++)
+        {
+            if (lcd->frame[i] < 16 && (lcd->frame[i] & 0x07) == slot)
+                return 1;
+            if (lcd->shadow[i] < 16 && (lcd->shadow[i] & 0x07) == slot)
+                return 1;
+        }
+        return 0;
+    }
+
+    /*
+     * Blank a field of the frame buffer before it is redrawn, so the glyphs
+     * it showed may be replaced
+     */
+    static void glyph_field_blank(LCD_HandleTypeDef *lcd, unsigned char col, unsigned char row,
+            unsigned char width)
+    {
+        if (!lcd->buffered)
+            return;
+
+        setCursor(lcd, col, row);
+        for (unsigned char i = 0; i < width; i++)
+            write(lcd, ' ');
+    }
+
+    /*
+     * Print the cells of a field once all of its glyphs are loaded
+     * (uploads move the LCD address to CGRAM)
+     */
+    static void glyph_field_print(LCD_HandleTypeDef *lcd, unsigned char col, unsigned char row,
+            const unsigned char *cells, unsigned char width)
+    {
+        setCursor(lcd, col, row);
+        for (unsigned char i = 0; i < width; i++)
+            write(lcd, cells[i]);
+    }
+
+    /* loadGlyph
+     * ------------------
+     * Get a character code (0 - 7) that shows a custom 5x8 glyph
+     *
+     * The 8 CGRAM slots are used as a cache: a glyph that is already in one
+     * is not sent again, otherwise the least recently used slot that no frame
+     * buffer cell shows is overwritten (every slot is a candidate when the
+     * frame buffer is off). Returns -1 if every slot is on screen or, in
+     * asynchronous or DMA mode, if the queue has no room for the upload
+     *
+     * Uploading leaves the LCD address in CGRAM, so without the frame buffer
+     * call setCursor before printing again (flush takes care of it otherwise)
+     *
+     * bitmap: 8 rows, top first, the 5 low bits of each are the pixels
+     */
+    int loadGlyph(LCD_HandleTypeDef *lcd, const unsigned char *bitmap)
+    {
+        uint32_t hash = glyph_hash(bitmap);
+        int slot = -1;
+
+        lcd->glyphClock++;
+
+        // Already resident
+        for (int i = 0; i < 8; i++)
+        {
+            if (lcd->glyphUsed[i] && lcd->glyphHash[i] == hash && memcmp(lcd->glyphs[i], bitmap, 8) == 0)
+            {
+                lcd->glyphUsed[i] = lcd->glyphClock;
+                return i;
+            }
+        }
+
+        // Least recently used slot (empty slots first) that is not on screen
+        for (int i = 0; i < 8; i++)
+        {
+            if (lcd->buffered && glyph_on_screen(lcd, i))
+                continue;
+            if (slot < 0 || lcd->glyphUsed[i] < lcd->glyphUsed[slot])
+                slot = i;
+        }
+        if (slot < 0)
+            return -1;
+
+        // Entry mode, address, 8 rows and the mode again
+        if (lcd->writemode != LCD_WRITE_BLOCKING && queueSpace(lcd) < 11)
+            return -1;
+
+        // The CGRAM address auto-increments like the DDRAM address
+        unsigned char mode = lcd->displaymode;
+        if (mode != (LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT))
+            sendCommand(lcd, LCD_ENTRYMODESET | LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT);
+
+        sendCommand(lcd, LCD_SETCGRAMADDR | (slot << 3));
+        writeBuffer(lcd, bitmap, 8);
+
+        if (mode != (LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT))
+            sendCommand(lcd, LCD_ENTRYMODESET | mode);
+
+        memcpy(lcd->glyphs[slot], bitmap, 8);
+        lcd->glyphHash[slot] = hash;
+        lcd->glyphUsed[slot] = lcd->glyphClock;
+        lcd->glyphUploads++;
+
+        return slot;
+    }
+
+    /* printBar
+     * ------------------
+     * Print a horizontal bar gauge of width cells at col, row
+     * Full cells use the ROM block character (0xFF), the partly filled cell
+     * uses one of 4 cached glyphs
+     *
+     * value: filled part of the gauge, from 0 to max
+     */
+    void printBar(LCD_HandleTypeDef *lcd, unsigned char col, unsigned char row, int32_t value, int32_t max,
+            unsigned char width)
+    {
+        unsigned char cells[LCD_MAX_COLS];
+        unsigned char bitmap[8];
+        int32_t pixels;
+
+        if (width > LCD_MAX_COLS)
+            width = LCD_MAX_COLS;
+        if (max <= 0)
+            max = 1;
+        if (value < 0)
+            value = 0;
+        if (value > max)
+            value = max;
+
+        // Rounded to the nearest pixel column
+        pixels = (int32_t)(((int64_t)value * width * 5 + max / 2) / max);
+
+        glyph_field_blank(lcd, col, row, width);
+
+        for (unsigned char i = 0; i < width; i++)
+        {
+            int32_t fill = pixels - i * 5;
+
+            if (fill >= 5)
+            {
+                cells[i] = 0xFF;
+            }
+            else if (fill <= 0)
+            {
+                cells[i] = ' ';
+            }
+            else
+            {
+                memset(bitmap, (0x1F << (5 - fill)) & 0x1F, 8);
+                int code = loadGlyph(lcd, bitmap);
+                cells[i] = code < 0 ? ' ' : code;
+            }
+        }
+
+        glyph_field_print(lcd, col, row, cells, width);
+    }
+
+    /* printSparkline
+     * ------------------
+     * Print samples as a column chart at col, row, one pixel column per
+     * sample, 5 samples per cell (at most 40 samples, the 8 CGRAM slots)
+     * Cells whose glyph can not be loaded show '_'
+     *
+     * samples: oldest first
+     * min, max: values drawn as the lowest and the highest column
+     */
+    void printSparkline(LCD_HandleTypeDef *lcd, unsigned char col, unsigned char row, const int16_t *samples,
+            unsigned char count, int16_t min, int16_t max)
+    {
+        unsigned char cells[8];
+        unsigned char bitmap[8];
+        unsigned char width;
+
+        if (count > 40)
+            count = 40;
+        width = (count + 4) / 5;
+
+        glyph_field_blank(lcd, col, row, width);
+
+        for (unsigned char i = 0; i < width; i++)
+        {
+            memset(bitmap, 0, 8);
+
+            for (unsigned char j = 0; j < 5 && i * 5 + j < count; j++)
+            {
+                int32_t sample = samples[i * 5 + j];
+                unsigned char height = 1;
+
+                // 1 to 8 pixels, min and max at the ends of the range
+                if (max > min)
+                {
+                    if (sample < min)
+                        sample = min;
+                    if (sample > max)
+                        sample = max;
+                    height = 1 + (unsigned char)((sample - min) * 7 / (max - min));
+                }
+
+                for (unsigned char r = 8 - height; r < 8; r++)
+                    bitmap[r] |= 0x10 >> j;
+            }
+
+            int code = loadGlyph(lcd, bitmap);
+            cells[i] = code < 0 ? '_' : code;
+        }
+
+        glyph_field_print(lcd, col, row, cells, width);
+    }
+
+    /* asyncON
+     * ------------------
+     * Queue every byte instead of waiting for the LCD
+     * send, print, setCursor, clear, etc. return immediately and the bytes are
+     * put on the bus one phase at a time by processQueue
+     *
+     * htim: timer whose update interrupt calls processQueue, started whenever
+     *       there is something in the queue and stopped when it runs empty.
+     *       The period must be at least 1 us (enable pulse and cycle times)
+     *       NULL if the application calls processQueue itself
+     *
+     * Only available on the 8-bit parallel bus
+     */
+    void asyncON(LCD_HandleTypeDef *lcd, TIM_HandleTypeDef *htim)
+    {
+        if (lcd->transport != &transport8bit)
+            return;
+
+        lcd->asyncTimer = htim;
+        lcd->timerRunning = 0;
+        lcd->phase = LCD_PHASE_IDLE;
+        lcd->queueTail = lcd->queueHead;
+        lcd->writemode = LCD_WRITE_ASYNC;
+
+        // Blocking writes in busy flag mode return before the last byte is
+        // executed (e.g. the clear of frameBufferON), so the queue starts with a poll
+        if (lcd->waitmode == LCD_WAIT_BUSYFLAG)
+        {
+            busy_poll_start(lcd);
+            if (htim != NULL)
+            {
+                lcd->timerRunning = 1;
+                HAL_TIM_Base_Start_IT(htim);
+            }
+        }
+    }
+
+    /* asyncOFF
+     * ------------------
+     * Wait for the queue to drain and go back to blocking writes
+     */
+    void asyncOFF(LCD_HandleTypeDef *lcd)
+    {
+        while (!isIdle(lcd))
+        {
+            if (lcd->asyncTimer == NULL)
+                processQueue(lcd);
+        }
+        lcd->writemode = LCD_WRITE_BLOCKING;
+    }
+
+    /* dmaON
+     * ------------------
+     * Compile every byte into BSRR words (rs/rw/data setup, enable high,
+     * enable low and the execution time) that a DMA stream copies to the GPIO
+     * port's BSRR on every update event of a timer, so sending a frame costs
+     * no CPU time after it has been compiled
+     *
+     * The bytes are collected until dmaCommit (flush commits on its own)
+     * The busy flag is not used, every byte is given the worst case execution time
+     *
+     * htim: timer with its update event routed to hdma (e.g. TIM1_UP on DMA2
+     *       stream 5 channel 6), stopped while nothing is being sent
+     * hdma: memory to peripheral stream, word sized, normal mode
+     * tick_ns: timer period in nanoseconds, at least 100 ns
+     *
+     * Only available on the 8-bit parallel bus, for at most LCD_MAX_DMA_DISPLAYS
+     * displays at a time
+     */
+    void dmaON(LCD_HandleTypeDef *lcd, TIM_HandleTypeDef *htim, DMA_HandleTypeDef *hdma, uint32_t tick_ns)
+    {
+        assert_param(tick_ns >= LCD_DMA_MIN_TICK_NS);
+        if (lcd->transport != &transport8bit || tick_ns < LCD_DMA_MIN_TICK_NS)
+            return;
+
+        // Register the display so dma_complete can find it
+        int slot = -1;
+        for (int i = 0; i < LCD_MAX_DMA_DISPLAYS; i++)
+        {
+            if (dmaDisplays[i] == lcd || (slot < 0 && dmaDisplays[i] == NULL))
+                slot = i;
+        }
+        if (slot < 0)
+            return;
+        dmaDisplays[slot] = lcd;
+
+        lcd->dmaTimer = htim;
+        lcd->dmaHandle = hdma;
+        lcd->dmaHandle->XferCpltCallback = dma_complete;
+
+        lcd->dmaEnableTicks = (LCD_ENABLE_NS + tick_ns - 1) / tick_ns;
+        lcd->dmaExecTicks = (LCD_EXEC_NS + tick_ns - 1) / tick_ns;
+        lcd->dmaLongTicks = (LCD_EXEC_LONG_NS + tick_ns - 1) / tick_ns;
+
+        lcd->dmaLen = 0;
+        lcd->dmaCarry = 0;
+        lcd->dmaFill = 0;
+        lcd->dmaBusy = 0;
+        lcd->writemode = LCD_WRITE_DMA;
+    }
+
+    /* dmaOFF
+     * ------------------
+     * Send whatever is left, wait for it and go back to blocking writes
+     */
+    void dmaOFF(LCD_HandleTypeDef *lcd)
+    {
+        while (!isIdle(lcd))
+            dmaCommit(lcd);
+        lcd->writemode = LCD_WRITE_BLOCKING;
+
+        for (int i = 0; i < LCD_MAX_DMA_DISPLAYS; i++)
+        {
+            if (dmaDisplays[i] == lcd)
+                dmaDisplays[i] = NULL;
+        }
+    }
+
+    /* dmaCommit
+     * ------------------
+     * Start sending the bytes collected since the last commit
+     * Returns 0 if the previous transfer is still running (nothing is started,
+     * the bytes stay in the buffer and more can be added)
+     */
+    unsigned char dmaCommit(LCD_HandleTypeDef *lcd)
+    {
+        // Called from the application and from the transfer complete interrupt
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        if (lcd->dmaBusy)
+        {
+            __set_PRIMASK(primask);
+            return 0;
+        }
+
+        // The rest of a split wait goes first
+        dma_pay_carry(lcd);
+        if (lcd->dmaLen == 0)
+        {
+            __set_PRIMASK(primask);
+            return 1;
+        }
+
+        uint32_t *words = lcd->dmaBuffers[lcd->dmaFill];
+        unsigned int length = lcd->dmaLen;
+
+        lcd->dmaBusy = 1;
+        lcd->dmaFill ^= 1;
+        lcd->dmaLen = 0;
+
+        HAL_DMA_Start_IT(lcd->dmaHandle, (uint32_t)(uintptr_t)words,
+                (uint32_t)(uintptr_t)&lcd->gpioPort->BSRR, length);
+        __HAL_TIM_SET_COUNTER(lcd->dmaTimer, 0);
+        __HAL_TIM_ENABLE_DMA(lcd->dmaTimer, TIM_DMA_UPDATE);
+        __HAL_TIM_ENABLE(lcd->dmaTimer);
+
+        __set_PRIMASK(primask);
+        return 1;
+    }
+
+    /* isIdle
+     * ------------------
+     * Returns 1 when every queued byte has been executed by the LCD
+     * (always 1 in blocking mode)
+     */
+    unsigned char isIdle(LCD_HandleTypeDef *lcd)
+    {
+        return lcd->queueHead == lcd->queueTail && lcd->phase == LCD_PHASE_IDLE
+                && !lcd->dmaBusy && lcd->dmaLen == 0 && lcd->dmaCarry == 0;
     }
 
     //------------------------------------------------------------------
     //                    Lower level functions
     //------------------------------------------------------------------
 
+    /*
+     * Queue a byte, waiting for room when the queue or the DMA buffer is full
+     * In DMA mode the buffer is committed, or, while the previous transfer is
+     * still going out, sent by its transfer complete interrupt. The queue is
+     * drained by its timer interrupt, or here if the application calls
+     * processQueue itself
+     */
+    static void queue_push_wait(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode)
+    {
+        while (!queuePush(lcd, value, mode))
+        {
+            if (lcd->writemode == LCD_WRITE_DMA && dmaCommit(lcd))
+                continue;
+            if (lcd->writemode == LCD_WRITE_ASYNC && lcd->asyncTimer == NULL)
+                processQueue(lcd);
+            else
+                __WFI();
+        }
+    }
+
     /*
      * send
      * -------------
      * send Data or command to the LCD
      * the function will take care of setting the correct values for rs and rw
+     * In asynchronous and DMA modes the byte is queued, waiting for room if needed
      *
      * value: the 8 bits data value to be sent to the LCD driver
      * mode: 0 = command, 1 = data
      */
-    void send(unsigned char value, unsigned char mode)
+    void send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode)
     {
-        if (mode)
-        	HAL_GPIO_WritePin(gpioPort, _rs, GPIO_PIN_SET);
-        else
-        	HAL_GPIO_WritePin(gpioPort, _rs, GPIO_PIN_RESET);
-
+        if (lcd->writemode != LCD_WRITE_BLOCKING)
+        {
+            queue_push_wait(lcd, value, mode);
+            return;
+        }
 
-        HAL_GPIO_WritePin(gpioPort, _rw, GPIO_PIN_RESET);
+        lcd->transport->send(lcd, value, mode);
+    }
 
-        // use the 8 bit mode (the only one for now)
-        if (_displayfunction & LCD_8BITMODE)
+    /*
+     * writeBuffer
+     * -------------
+     * send a run of data bytes (characters) to the LCD
+     * rs and rw are computed once for the whole run and ride along with
+     * every data store, so each byte costs one BSRR write plus the enable pulse
+     * In asynchronous and DMA modes the bytes are queued, waiting for room if needed
+     *
+     * buffer: the bytes to send
+     * length: number of bytes in buffer
+     */
+    void writeBuffer(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length)
+    {
+        if (lcd->writemode != LCD_WRITE_BLOCKING)
         {
-            write8bits(value);
+            while (length--)
+                queue_push_wait(lcd, *buffer++, 1);
+            return;
         }
+
+        lcd->transport->write(lcd, buffer, length, 1);
     }
 
 
@@ -422,9 +1358,9 @@
      * value: the 8 bits data value to be sent to the LCD driver
      *
      */
-    void sendData(unsigned char value)
+    void sendData(LCD_HandleTypeDef *lcd, unsigned char value)
     {
-        send(value, 1);
+        send(lcd, value, 1);
     }
 
      /*
@@ -436,26 +1372,39 @@
      * value: the 8 bits command value to be sent to the LCD driver
      *
      */
-    void sendCommand(unsigned char value)
+    void sendCommand(LCD_HandleTypeDef *lcd, unsigned char value)
     {
-        send(value, 0);
+        send(lcd, value, 0);
     }
 
 
     /* pulseEnable
      * ----------------
-     * create a short tick (1 ms) on the enable pin
+     * create a short tick on the enable pin
+     * (1 ms in LCD_WAIT_DELAY mode, ~0.5 us in LCD_WAIT_BUSYFLAG mode)
      *
      * This function is used to issue an enable tick whenever you need to write
      * or read the value on the data pins
      */
-    void pulseEnable(void)
+    void pulseEnable(LCD_HandleTypeDef *lcd)
     {
-        HAL_GPIO_WritePin(gpioPort, _enable, GPIO_PIN_RESET);
+        if (lcd->waitmode == LCD_WAIT_BUSYFLAG)
+        {
+            // Enable pulse width >= 450 ns, enable cycle >= 1000 ns (page 52)
+            // The LCD is ready for the next byte when the busy flag says so
+            delay_ns(40); // rs and rw were just set, address setup time tAS >= 40 ns
+            lcd->gpioPort->BSRR = lcd->enable;
+            delay_ns(500);
+            lcd->gpioPort->BSRR = (uint32_t)lcd->enable << 16;
+            delay_ns(500);
+            return;
+        }
+
+        lcd->gpioPort->BSRR = (uint32_t)lcd->enable << 16;
         HAL_Delay(1);
-        HAL_GPIO_WritePin(gpioPort, _enable, GPIO_PIN_SET);
+        lcd->gpioPort->BSRR = lcd->enable;
         HAL_Delay(1);
-        HAL_GPIO_WritePin(gpioPort, _enable, GPIO_PIN_RESET);
+        lcd->gpioPort->BSRR = (uint32_t)lcd->enable << 16;
         HAL_Delay(1);
 
     }
@@ -466,13 +1415,462 @@
      * This function assumes an 8 bit mode
      *
      */
-    void write8bits(unsigned char value)
+    void write8bits(LCD_HandleTypeDef *lcd, unsigned char value)
     {
-        for (int i = 0; i < 8; i++)
+        lcd->gpioPort->BSRR = lcd->busTable[value];
+
+        pulseEnable(lcd);
+    }
+
+    /* waitReady
+     * ----------------
+     * Poll the busy flag until the LCD is ready to accept the next byte
+     * The data pins are switched to inputs for the duration of the poll
+     *
+     * Gives up after LCD_BUSY_TIMEOUT reads so a disconnected LCD can not hang the MCU
+     */
+    void waitReady(LCD_HandleTypeDef *lcd)
+    {
+        uint32_t tries = LCD_BUSY_TIMEOUT;
+        uint32_t busy;
+
+        // Release the data bus before the LCD starts driving it
+        data_pins_input(lcd);
+
+        // Instruction register read: rs = 0, rw = 1, held for tAS >= 40 ns before enable rises
+        lcd->gpioPort->BSRR = ((uint32_t)lcd->rs << 16) | lcd->rw;
+        delay_ns(40);
+
+        do
+        {
+            lcd->gpioPort->BSRR = lcd->enable;
+            delay_ns(500); // data delay time tDDR <= 360 ns
+            busy = lcd->gpioPort->IDR & lcd->busyPin;
+            lcd->gpioPort->BSRR = (uint32_t)lcd->enable << 16;
+            delay_ns(500);
+
+            // in 4-bit mode the low nibble (address counter) still has to be clocked out
+            if (lcd->transport->bitmode == LCD_4BITMODE)
+            {
+                lcd->gpioPort->BSRR = lcd->enable;
+                delay_ns(500);
+                lcd->gpioPort->BSRR = (uint32_t)lcd->enable << 16;
+                delay_ns(500);
+            }
+        } while (busy && --tries);
+
+        // Back to writing
+        lcd->gpioPort->BSRR = (uint32_t)lcd->rw << 16;
+        data_pins_output(lcd);
+    }
+
+    /* queuePush
+     * ----------------
+     * Append a byte to the asynchronous queue and make sure the timer is
+     * running to drain it (or, in DMA mode, compile it into the buffer
+     * being filled)
+     *
+     * value: the 8 bits data value to be sent to the LCD driver
+     * mode: 0 = command, 1 = data
+     * returns 0 if the queue is full (the byte is dropped)
+     */
+    unsigned char queuePush(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode)
+    {
+        if (lcd->writemode == LCD_WRITE_DMA)
+        {
+            unsigned int count = 0;
+
+            // The transfer complete interrupt may commit the buffer being filled
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+
+            dma_pay_carry(lcd);
+            if (lcd->dmaCarry == 0)
+            {
+                count = encodeWaveform(lcd, &lcd->dmaBuffers[lcd->dmaFill][lcd->dmaLen],
+                        LCD_DMA_WORDS - lcd->dmaLen, value, mode);
+                lcd->dmaLen += count;
+            }
+
+            __set_PRIMASK(primask);
+            return count != 0;
+        }
+
+        unsigned int head = lcd->queueHead;
+
+        if (head - lcd->queueTail >= LCD_QUEUE_SIZE)
+            return 0;
+
+        lcd->queue[head % LCD_QUEUE_SIZE] = value | (mode ? 0x100 : 0);
+        lcd->queueHead = head + 1;
+
+        // processQueue only stops the timer once the queue is empty,
+        // so it is either still running or needs to be started again
+        if (lcd->asyncTimer != NULL && !lcd->timerRunning)
+        {
+            lcd->timerRunning = 1;
+            HAL_TIM_Base_Start_IT(lcd->asyncTimer);
+        }
+        return 1;
+    }
+
+    /* queueSpace
+     * ----------------
+     * Number of bytes that can still be queued
+     */
+    unsigned int queueSpace(LCD_HandleTypeDef *lcd)
+    {
+        if (lcd->writemode == LCD_WRITE_DMA)
+        {
+            unsigned int room = LCD_DMA_WORDS - lcd->dmaLen;
+            if (lcd->dmaCarry >= room)
+                return 0;
+            return (room - lcd->dmaCarry) / (2 + lcd->dmaEnableTicks + lcd->dmaExecTicks);
+        }
+
+        return LCD_QUEUE_SIZE - (lcd->queueHead - lcd->queueTail);
+    }
+
+    /* processQueue
+     * ----------------
+     * Advance the asynchronous queue by one bus phase and return immediately
+     * Meant to be called from a timer interrupt (or the main loop), the time
+     * between two calls provides the setup and hold times of each phase
+     *
+     * A byte takes three calls (setup, enable high, enable low) followed by
+     * busy flag reads in LCD_WAIT_BUSYFLAG mode, or a wait of LCD_EXEC_NS
+     * (LCD_EXEC_LONG_NS for clear and home) on the DWT cycle counter in
+     * LCD_WAIT_DELAY mode (at least 1 ms, 2 ms for clear and home, on the HAL
+     * tick if the cycle counter is not running)
+     */
+    void processQueue(LCD_HandleTypeDef *lcd)
+    {
+        switch (lcd->phase)
+        {
+        case LCD_PHASE_IDLE:
+            if (lcd->queueHead == lcd->queueTail)
+            {
+                if (lcd->asyncTimer != NULL && lcd->timerRunning)
+                {
+                    HAL_TIM_Base_Stop_IT(lcd->asyncTimer);
+                    lcd->timerRunning = 0;
+                }
+                return;
+            }
+            lcd->current = lcd->queue[lcd->queueTail % LCD_QUEUE_SIZE];
+            lcd->queueTail++;
+
+            // rs, rw and data in one store, enable stays low
+            lcd->gpioPort->BSRR = lcd->busTable[lcd->current & 0xFF] | lcd->ctrlWords[(lcd->current >> 8) & 1];
+            lcd->phase = LCD_PHASE_ENABLE;
+            break;
+
+        case LCD_PHASE_ENABLE:
+            lcd->gpioPort->BSRR = lcd->enable;
+            lcd->phase = LCD_PHASE_LATCH;
+            break;
+
+        case LCD_PHASE_LATCH:
+            lcd->gpioPort->BSRR = (uint32_t)lcd->enable << 16;
+            if (lcd->waitmode == LCD_WAIT_BUSYFLAG)
+            {
+                busy_poll_start(lcd);
+            }
+            else
+            {
+                lcd->waitStart = cycle_counter_running() ? DWT->CYCCNT : HAL_GetTick();
+                lcd->phase = LCD_PHASE_WAIT;
+            }
+            break;
+
+        case LCD_PHASE_BUSY_ENABLE:
+            lcd->gpioPort->BSRR = lcd->enable;
+            lcd->phase = LCD_PHASE_BUSY_READ;
+            break;
+
+        case LCD_PHASE_BUSY_READ:
+        {
+            uint32_t busy = lcd->gpioPort->IDR & lcd->busyPin;
+            lcd->gpioPort->BSRR = (uint32_t)lcd->enable << 16;
+
+            if (busy && --lcd->busyTries)
+            {
+                lcd->phase = LCD_PHASE_BUSY_ENABLE;
+            }
+            else
+            {
+                lcd->gpioPort->BSRR = (uint32_t)lcd->rw << 16;
+                data_pins_output(lcd);
+                lcd->phase = LCD_PHASE_IDLE;
+            }
+            break;
+        }
+
+        case LCD_PHASE_WAIT:
+        {
+            unsigned char slow = !(lcd->current & 0x100)
+                    && (lcd->current == LCD_CLEARDISPLAY || lcd->current == LCD_RETURNHOME);
+
+            // The execution time on the cycle counter, about 50 us per byte
+            if (cycle_counter_running())
+            {
+                if (DWT->CYCCNT - lcd->waitStart >= ns_cycles(slow ? LCD_EXEC_LONG_NS : LCD_EXEC_NS))
+                    lcd->phase = LCD_PHASE_IDLE;
+                break;
+            }
+
+            // Otherwise HAL ticks, they are 1 ms, so two ticks guarantee at least one full millisecond
+            if (HAL_GetTick() - lcd->waitStart >= (slow ? 3U : 2U))
+                lcd->phase = LCD_PHASE_IDLE;
+            break;
+        }
+
+        default:
+            lcd->phase = LCD_PHASE_IDLE;
+            break;
+        }
+    }
+
+    /* encodeWaveform
+     * ----------------
+     * Compile one byte into the BSRR words of its bus cycle, one word per timer tick:
+     * rs/rw/data with enable low, enable high held for at least LCD_ENABLE_NS,
+     * enable low, then empty words (no pin change) for the execution time
+     * (LCD_EXEC_NS, LCD_EXEC_LONG_NS for clear and home)
+     * Uses the tick length given to dmaON
+     * Empty words that do not fit are left in dmaCarry, to be sent first
+     * in the next buffer
+     *
+     * words: where to put the words
+     * maxWords: room left in words
+     * value: the 8 bits data value to be sent to the LCD driver
+     * mode: 0 = command, 1 = data
+     * returns the number of words written, 0 if the bus cycle does not fit
+     */
+    unsigned int encodeWaveform(LCD_HandleTypeDef *lcd, uint32_t *words, unsigned int maxWords, unsigned char value, unsigned char mode)
+    {
+        unsigned int execTicks = lcd->dmaExecTicks;
+        unsigned int count = 0;
+
+        if (!mode && (value == LCD_CLEARDISPLAY || (value & ~0x01) == LCD_RETURNHOME))
+            execTicks = lcd->dmaLongTicks;
+
+        if (2 + lcd->dmaEnableTicks > maxWords)
+            return 0;
+
+        // setup: rs, rw and data with enable low (tAS >= 40 ns before enable rises)
+        words[count++] = lcd->busTable[value] | lcd->ctrlWords[mode ? 1 : 0] | ((uint32_t)lcd->enable << 16);
+
+        // enable high for at least 450 ns
+        words[count++] = lcd->enable;
+        for (unsigned int i = 1; i < lcd->dmaEnableTicks; i++)
+            words[count++] = 0;
+
+        // enable low latches the byte, the data stays put until the next setup word
+        words[count++] = (uint32_t)lcd->enable << 16;
+
+        while (execTicks && count < maxWords)
+        {
+            words[count++] = 0;
+            execTicks--;
+        }
+        lcd->dmaCarry = execTicks;
+
+        return count;
+    }
+
+    /*
+     * Empty words owed by a split wait, at the start of the buffer being filled
+     * (as many as fit, the rest stays owed)
+     */
+    static void dma_pay_carry(LCD_HandleTypeDef *lcd)
+    {
+        unsigned int room = LCD_DMA_WORDS - lcd->dmaLen;
+        unsigned int count = lcd->dmaCarry < room ? lcd->dmaCarry : room;
+
+        memset(&lcd->dmaBuffers[lcd->dmaFill][lcd->dmaLen], 0, count * sizeof(uint32_t));
+        lcd->dmaLen += count;
+        lcd->dmaCarry -= count;
+    }
+
+    /*
+     * DMA transfer complete: stop the timer, then send the next buffer right
+     * away if a commit was refused in the meantime or a wait is split across
+     */
+    static void dma_complete(DMA_HandleTypeDef *hdma)
+    {
+        for (int i = 0; i < LCD_MAX_DMA_DISPLAYS; i++)
+        {
+            LCD_HandleTypeDef *lcd = dmaDisplays[i];
+
+            if (lcd != NULL && lcd->dmaHandle == hdma)
+            {
+                __HAL_TIM_DISABLE_DMA(lcd->dmaTimer, TIM_DMA_UPDATE);
+                __HAL_TIM_DISABLE(lcd->dmaTimer);
+                lcd->dmaBusy = 0;
+
+                if (lcd->dmaLen != 0 || lcd->dmaCarry != 0)
+                    dmaCommit(lcd);
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+    //                    Transports
+    //------------------------------------------------------------------
+
+    /*
+     * 8-bit parallel: reset sequence (page 45), the interface is already 8 bits
+     */
+    static void parallel8_init(LCD_HandleTypeDef *lcd)
+    {
+        sendCommand(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
+        HAL_Delay(5); // wait for 4.1 ms
+        sendCommand(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
+        HAL_Delay(1); // wait for more than 100 us
+        sendCommand(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
+    }
+
+    static void parallel8_send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode)
+    {
+        // Wait for the previous byte (instead of a fixed delay after it)
+        if (lcd->waitmode == LCD_WAIT_BUSYFLAG)
+            waitReady(lcd);
+
+        // data, rs and rw change in a single BSRR store
+        lcd->gpioPort->BSRR = lcd->busTable[value] | lcd->ctrlWords[mode ? 1 : 0];
+        pulseEnable(lcd);
+    }
+
+    static void parallel8_write(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length, unsigned char mode)
+    {
+        uint32_t ctrl = lcd->ctrlWords[mode ? 1 : 0];
+
+        while (length--)
         {
-        	HAL_GPIO_WritePin(gpioPort, dataPins[i], ((value >> i) & 0x0001)? GPIO_PIN_SET:GPIO_PIN_RESET);
+            if (lcd->waitmode == LCD_WAIT_BUSYFLAG)
+                waitReady(lcd);
+
+            lcd->gpioPort->BSRR = lcd->busTable[*buffer++] | ctrl;
+            pulseEnable(lcd);
         }
+    }
 
-        pulseEnable();
+    /*
+     * 4-bit parallel: reset sequence (page 46), the LCD starts out in 8-bit mode
+     * and only sees the upper nibble of each instruction until it is switched over
+     */
+    static void parallel4_init(LCD_HandleTypeDef *lcd)
+    {
+        lcd->gpioPort->BSRR = lcd->busTable[0x03] | lcd->ctrlWords[0];
+        pulseEnable(lcd);
+        HAL_Delay(5); // wait for 4.1 ms
+        pulseEnable(lcd);
+        HAL_Delay(1); // wait for more than 100 us
+        pulseEnable(lcd);
+        lcd->gpioPort->BSRR = lcd->busTable[0x02] | lcd->ctrlWords[0]; // 4-bit interface
+        pulseEnable(lcd);
     }
 
+    static void parallel4_send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode)
+    {
+        parallel4_write(lcd, &value, 1, mode);
+    }
+
+    static void parallel4_write(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length, unsigned char mode)
+    {
+        uint32_t ctrl = lcd->ctrlWords[mode ? 1 : 0];
+
+        while (length--)
+        {
+            if (lcd->waitmode == LCD_WAIT_BUSYFLAG)
+                waitReady(lcd);
+
+            lcd->gpioPort->BSRR = lcd->busTable[*buffer >> 4] | ctrl;
+            pulseEnable(lcd);
+            lcd->gpioPort->BSRR = lcd->busTable[*buffer & 0x0F] | ctrl;
+            pulseEnable(lcd);
+            buffer++;
+        }
+    }
+
+#ifdef HAL_I2C_MODULE_ENABLED
+    /*
+     * Send the first length bytes of _i2cBuffer to the backpack
+     */
+    static void pcf8574_transmit(LCD_HandleTypeDef *lcd, uint16_t length)
+    {
+        if (lcd->i2c->hdmatx != NULL)
+            HAL_I2C_Master_Transmit_DMA(lcd->i2c, lcd->i2cAddress, lcd->i2cBuffer, length);
+        else
+            HAL_I2C_Master_Transmit(lcd->i2c, lcd->i2cAddress, lcd->i2cBuffer, length, 100);
+    }
+
+    /*
+     * Wait for a DMA transaction still using _i2cBuffer
+     */
+    static void pcf8574_wait(LCD_HandleTypeDef *lcd)
+    {
+        while (HAL_I2C_GetState(lcd->i2c) != HAL_I2C_STATE_READY)
+        {
+            // Empty loop
+        }
+    }
+
+    /*
+     * PCF8574 backpack: same reset sequence as the 4-bit parallel bus
+     */
+    static void pcf8574_init(LCD_HandleTypeDef *lcd)
+    {
+        pcf8574_wait(lcd);
+
+        for (int i = 0; i < 4; i++)
+        {
+            uint8_t nibble = (i < 3 ? 0x30 : 0x20) | lcd->i2cBacklight;
+
+            lcd->i2cBuffer[0] = nibble | LCD_PCF_EN;
+            lcd->i2cBuffer[1] = nibble;
+            pcf8574_transmit(lcd, 2);
+            pcf8574_wait(lcd);
+            HAL_Delay(i == 0 ? 5 : 1); // 4.1 ms after the first, 100 us after the others
+        }
+    }
+
+    static void pcf8574_send(LCD_HandleTypeDef *lcd, unsigned char value, unsigned char mode)
+    {
+        pcf8574_write(lcd, &value, 1, mode);
+    }
+
+    static void pcf8574_write(LCD_HandleTypeDef *lcd, const unsigned char *buffer, unsigned int length, unsigned char mode)
+    {
+        uint8_t ctrl = (mode ? LCD_PCF_RS : 0) | lcd->i2cBacklight;
+        uint16_t count = 0;
+
+        pcf8574_wait(lcd);
+
+        // rs settles before the first enable pulse
+        lcd->i2cBuffer[count++] = ctrl;
+
+        while (length--)
+        {
+            uint8_t high = *buffer & 0xF0;
+            uint8_t low = (*buffer << 4) & 0xF0;
+            buffer++;
+
+            // the LCD latches each nibble when enable drops
+            lcd->i2cBuffer[count++] = high | ctrl | LCD_PCF_EN;
+            lcd->i2cBuffer[count++] = high | ctrl;
+            lcd->i2cBuffer[count++] = low | ctrl | LCD_PCF_EN;
+            lcd->i2cBuffer[count++] = low | ctrl;
+
+            if (count + 4 > LCD_I2C_BUFFER && length)
+            {
+                pcf8574_transmit(lcd, count);
+                pcf8574_wait(lcd);
+                count = 0;
+            }
+        }
+
+        pcf8574_transmit(lcd, count);
+    }
+#endif
@@ -0,0 +1,312 @@
+/*
+ * SHT3x.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "SHT3x.h"
+
+#ifdef HAL_I2C_MODULE_ENABLED
+
+	#define SHT3X_PHASE_IDLE	0 // waiting for the next measurement
+	#define SHT3X_PHASE_COMMAND	1 // measurement command being sent
+	#define SHT3X_PHASE_MEASURE	2 // sensor converting
+	#define SHT3X_PHASE_DATA	3 // read of the result
+
+	/*
+	 * @brief	CRC-8 of a data word as the sensor computes it
+	 * @param	data bytes, MSB first
+	 * @param	length number of bytes
+	 * @retval	CRC (0x92 for 0xBE 0xEF)
+	 */
+	uint8_t SHT3xcrc(const uint8_t *data, uint16_t length)
+	{
+		uint8_t crc = SHT3X_CRC_INIT;
+
+		for (uint16_t i = 0; i < length; i++)
+		{
+			crc ^= data[i];
+			for (uint8_t bit = 0; bit < 8; bit++)
+			{
+				crc = crc & 0x80 ? (uint8_t) ((crc << 1) ^ SHT3X_CRC_POLYNOMIAL) : (uint8_t) (crc << 1);
+			}
+		}
+		return crc;
+	}
+
+	/*
+	 * @brief	Send a command, blocking (SHT3xinit only)
+	 * @param	hsht sensor
+	 * @param	command SHT3X_CMD_x
+	 * @retval	HAL status of the transfer
+	 */
+	static HAL_StatusTypeDef send_command(SHT3x_HandleTypeDef *hsht, uint16_t command)
+	{
+		uint8_t bytes[2] = { (uint8_t) (command >> 8), (uint8_t) command };
+
+		return HAL_I2C_Master_Transmit(hsht->hi2c, hsht->address, bytes, 2, SHT3X_I2C_TIMEOUT);
+	}
+
+	/*
+	 * @brief	Check the CRCs of the result and convert it
+	 * 			(formulas of the SHT3x datasheet, section 4.13, rounded to 0.1)
+	 * @param	hsht sensor
+	 * @param	reading variable for humidity x10 and temperature x10
+	 * @retval	1 if both CRCs match, 0 otherwise
+	 */
+	static uint8_t convert(SHT3x_HandleTypeDef *hsht, Sensor_ReadingTypeDef *reading)
+	{
+		const uint8_t *data = hsht->buffer;
+
+		if (SHT3xcrc(&data[0], 2) != data[2] || SHT3xcrc(&data[3], 2) != data[5])
+		{
+			return 0;
+		}
+
+		int32_t rawT = (data[0] << 8) | data[1];
+		int32_t rawRH = (data[3] << 8) | data[4];
+
+		/* T = -45 + 175 * S / (2^16 - 1), RH = 100 * S / (2^16 - 1) */
+		reading->temp = (int16_t) (-450 + (1750 * rawT + 32767) / 65535);
+		reading->RH = (int16_t) ((1000 * rawRH + 32767) / 65535);
+		reading->fields = SENSOR_HAS_RH | SENSOR_HAS_TEMP;
+		return 1;
+	}
+
+	/*
+	 * @brief	Start a measurement: DMA transfer of the command
+	 * @param	hsht sensor
+	 * @retval	SENSOR_BUSY, SENSOR_ERROR if the transfer could not start
+	 */
+	static Sensor_StatusTypeDef start_measurement(SHT3x_HandleTypeDef *hsht)
+	{
+		hsht->lastStart = HAL_GetTick();
+		hsht->command[0] = (uint8_t) (SHT3X_CMD_MEASURE >> 8);
+		hsht->command[1] = (uint8_t) SHT3X_CMD_MEASURE;
+		if (HAL_I2C_Master_Transmit_DMA(hsht->hi2c, hsht->address, hsht->command, 2) != HAL_OK)
+		{
+			return SENSOR_ERROR;
+		}
+		hsht->phase = SHT3X_PHASE_COMMAND;
+		return SENSOR_BUSY;
+	}
+
+	/*
+	 * @brief	Reset the sensor, check that it answers with a valid status
+	 * 			word and start the first measurement
+	 * 			The measurement is completed by SHT3xupdate
+	 * @param	hsht handle to initialize
+	 * @param	hi2c I2C handle, must be setup prior with DMA streams
+	 * @param	address SHT3X_ADDRESS_LOW or SHT3X_ADDRESS_HIGH
+	 * @retval	HAL_OK, HAL_ERROR if there is no SHT3x at the address
+	 */
+	HAL_StatusTypeDef SHT3xinit(SHT3x_HandleTypeDef *hsht, I2C_HandleTypeDef *hi2c,
+			uint16_t address)
+	{
+		uint8_t status[3];
+
+		hsht->hi2c = hi2c;
+		hsht->address = address;
+		hsht->phase = SHT3X_PHASE_IDLE;
+		hsht->triggered = 0;
+		hsht->cachedValid = 0;
+
+		if (send_command(hsht, SHT3X_CMD_SOFT_RESET) != HAL_OK)
+		{
+			return HAL_ERROR;
+		}
+		HAL_Delay(SHT3X_RESET_TIME);
+
+		if (send_command(hsht, SHT3X_CMD_READ_STATUS) != HAL_OK
+				|| HAL_I2C_Master_Receive(hi2c, address, status, 3, SHT3X_I2C_TIMEOUT) != HAL_OK
+				|| SHT3xcrc(status, 2) != status[2])
+		{
+			return HAL_ERROR;
+		}
+
+		return start_measurement(hsht) == SENSOR_BUSY ? HAL_OK : HAL_ERROR;
+	}
+
+	/*
+	 * @brief	Sensor front-end, call as often as possible (never blocks)
+	 * 			Starts a measurement every SHT3X_INTERVAL, reads the result
+	 * 			once the conversion time has passed and caches it if both
+	 * 			CRCs match
+	 * 			Once SHT3xtrigger has been called, measurements are only
+	 * 			started by it
+	 * @param	hsht sensor
+	 * @retval	SENSOR_OK when a new reading was cached by this call,
+	 * 			SENSOR_BUSY while a measurement is in progress,
+	 * 			SENSOR_IDLE while waiting for the next measurement,
+	 * 			SENSOR_ERROR if a transfer failed or a CRC did not match
+	 */
+	Sensor_StatusTypeDef SHT3xupdate(SHT3x_HandleTypeDef *hsht)
+	{
+		Sensor_ReadingTypeDef reading;
+
+		if (hsht->phase == SHT3X_PHASE_IDLE)
+		{
+			if (hsht->triggered || HAL_GetTick() - hsht->lastStart < SHT3X_INTERVAL)
+			{
+				return SENSOR_IDLE;
+			}
+			return start_measurement(hsht);
+		}
+
+		if (HAL_I2C_GetState(hsht->hi2c) != HAL_I2C_STATE_READY)
+		{
+			return SENSOR_BUSY;
+		}
+		if (hsht->phase != SHT3X_PHASE_MEASURE && HAL_I2C_GetError(hsht->hi2c) != HAL_I2C_ERROR_NONE)
+		{
+			hsht->phase = SHT3X_PHASE_IDLE;
+			return SENSOR_ERROR;
+		}
+
+		switch (hsht->phase)
+		{
+		case SHT3X_PHASE_COMMAND:
+			hsht->phase = SHT3X_PHASE_MEASURE;
+			return SENSOR_BUSY;
+
+		case SHT3X_PHASE_MEASURE:
+			/* Strictly more ticks than the conversion time: the first tick may be cut short */
+			if (HAL_GetTick() - hsht->lastStart <= SHT3X_MEASURE_TIME)
+			{
+				return SENSOR_BUSY;
+			}
+			if (HAL_I2C_Master_Receive_DMA(hsht->hi2c, hsht->address, hsht->buffer,
+					SHT3X_DATA_SIZE) != HAL_OK)
+			{
+				hsht->phase = SHT3X_PHASE_IDLE;
+				return SENSOR_ERROR;
+			}
+			hsht->phase = SHT3X_PHASE_DATA;
+			return SENSOR_BUSY;
+
+		default:
+			hsht->phase = SHT3X_PHASE_IDLE;
+			if (!convert(hsht, &reading))
+			{
+				return SENSOR_ERROR;
+			}
+			break;
+		}
+
+		reading.timestamp = hsht->lastStart;
+		hsht->cached = reading;
+		hsht->cachedTick = HAL_GetTick();
+		hsht->cachedValid = 1;
+		return SENSOR_OK;
+	}
+
+	/*
+	 * @brief	Start a measurement now, for sampling on an external schedule
+	 * 			(may be called from an interrupt). From the first call on,
+	 * 			SHT3xupdate no longer starts measurements.
+	 * @param	hsht sensor
+	 * @retval	SENSOR_BUSY if the measurement was started, SENSOR_IDLE if
+	 * 			one is in progress, SENSOR_ERROR if it could not start
+	 */
+	Sensor_StatusTypeDef SHT3xtrigger(SHT3x_HandleTypeDef *hsht)
+	{
+		hsht->triggered = 1;
+		if (hsht->phase != SHT3X_PHASE_IDLE)
+		{
+			return SENSOR_IDLE;
+		}
+		return start_measurement(hsht);
+	}
+
+	/*
+	 * @brief	Last valid reading cached by SHT3xupdate
+	 * @param	hsht sensor
+	 * @param	reading variable for humidity and temperature
+	 * 			not changed when the sample is SENSOR_SAMPLE_INVALID
+	 * @param	age variable for the time since the measurement in ms (may be NULL)
+	 * @retval	SENSOR_SAMPLE_FRESH, SENSOR_SAMPLE_STALE when older than
+	 * 			SENSOR_STALE_AGE, SENSOR_SAMPLE_INVALID before the first reading
+	 */
+	uint8_t SHT3xlast_reading(SHT3x_HandleTypeDef *hsht, Sensor_ReadingTypeDef *reading,
+			uint32_t *age)
+	{
+		if (!hsht->cachedValid)
+		{
+			return SENSOR_SAMPLE_INVALID;
+		}
+		uint32_t elapsed = HAL_GetTick() - hsht->cachedTick;
+		*reading = hsht->cached;
+		if (age != NULL)
+		{
+			*age = elapsed;
+		}
+		return elapsed > SENSOR_STALE_AGE ? SENSOR_SAMPLE_STALE : SENSOR_SAMPLE_FRESH;
+	}
+
+	/*
+	 * @brief	Time until the next measurement is due, SHT3X_INTERVAL after the
+	 * 			last one started, for scheduling a retry or the first trigger
+	 * @param	hsht sensor
+	 * @retval	Milliseconds, 0 if a measurement is due now
+	 */
+	uint32_t SHT3xnext_conversion(SHT3x_HandleTypeDef *hsht)
+	{
+		uint32_t elapsed = HAL_GetTick() - hsht->lastStart;
+
+		return elapsed >= SHT3X_INTERVAL ? 0 : SHT3X_INTERVAL - elapsed;
+	}
+
+	/*
+	 * @brief	SHT3xupdate for the sensor interface
+	 * @param	context SHT3x_HandleTypeDef of the sensor
+	 * @retval	See SHT3xupdate
+	 */
+	static Sensor_StatusTypeDef sensor_update_sht3x(void *context)
+	{
+		return SHT3xupdate((SHT3x_HandleTypeDef*) context);
+	}
+
+	/*
+	 * @brief	SHT3xtrigger for the sensor interface
+	 * @param	context SHT3x_HandleTypeDef of the sensor
+	 * @retval	See SHT3xtrigger
+	 */
+	static Sensor_StatusTypeDef sensor_trigger_sht3x(void *context)
+	{
+		return SHT3xtrigger((SHT3x_HandleTypeDef*) context);
+	}
+
+	/*
+	 * @brief	SHT3xlast_reading for the sensor interface
+	 * @param	context SHT3x_HandleTypeDef of the sensor
+	 * @param	reading variable for the reading
+	 * @param	age variable for the time since the measurement in ms (may be NULL)
+	 * @retval	See SHT3xlast_reading
+	 */
+	static uint8_t sensor_last_reading_sht3x(void *context, Sensor_ReadingTypeDef *reading,
+			uint32_t *age)
+	{
+		return SHT3xlast_reading((SHT3x_HandleTypeDef*) context, reading, age);
+	}
+
+	/*
+	 * @brief	SHT3xnext_conversion for the sensor interface
+	 * @param	context SHT3x_HandleTypeDef of the sensor
+	 * @retval	See SHT3xnext_conversion
+	 */
+	static uint32_t sensor_next_conversion_sht3x(void *context)
+	{
+		return SHT3xnext_conversion((SHT3x_HandleTypeDef*) context);
+	}
+
+	const Sensor_DriverTypeDef SHT3x_sensor_driver =
+	{
+		"SHT3x",
+		sensor_update_sht3x,
+		sensor_trigger_sht3x,
+		sensor_last_reading_sht3x,
+		sensor_next_conversion_sht3x
+	};
+
+#endif /* HAL_I2C_MODULE_ENABLED */
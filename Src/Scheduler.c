@@ -0,0 +1,243 @@
+/*
+ * Scheduler.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "Scheduler.h"
+#include "Delay.h"
+#include "Format.h"
+
+	#define SCHED_QUEUE_MASK (SCHED_QUEUE_SIZE - 1)
+
+	/*
+	 * @brief	Raise a statistic to a value if it is lower (lock-free)
+	 * @param	statistic counter updated by several producers
+	 * @param	value new value
+	 * @retval	None
+	 */
+	static void atomic_max(uint32_t *statistic, uint32_t value)
+	{
+		uint32_t current = __atomic_load_n(statistic, __ATOMIC_RELAXED);
+		while (value > current
+				&& !__atomic_compare_exchange_n(statistic, &current, value, 1, __ATOMIC_RELAXED,
+						__ATOMIC_RELAXED))
+		{
+			// current was reloaded by the failed exchange
+		}
+	}
+
+	/*
+	 * @brief	Whether a task has an event ready to run
+	 * @param	task task
+	 * @retval	1 if the cell at the tail has been published
+	 */
+	static uint8_t task_pending(Scheduler_TaskTypeDef *task)
+	{
+		Scheduler_CellTypeDef *cell = &task->cells[task->tail & SCHED_QUEUE_MASK];
+		return __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) == task->tail + 1;
+	}
+
+	/*
+	 * @brief	Initialize a scheduler without tasks
+	 * @param	hsched handle to initialize
+	 * @retval	None
+	 */
+	void sched_init(Scheduler_HandleTypeDef *hsched)
+	{
+		hsched->count = 0;
+	}
+
+	/*
+	 * @brief	Add a task, tasks added first have the highest priority
+	 * @param	hsched scheduler
+	 * @param	handler function run for every event of the task
+	 * @retval	Task number for sched_post, SCHED_MAX_TASKS if there is no room
+	 */
+	uint8_t sched_add_task(Scheduler_HandleTypeDef *hsched, void (*handler)(uint32_t event))
+	{
+		if (hsched->count == SCHED_MAX_TASKS)
+		{
+			return SCHED_MAX_TASKS;
+		}
+		Scheduler_TaskTypeDef *task = &hsched->tasks[hsched->count];
+		task->handler = handler;
+		task->head = 0;
+		task->tail = 0;
+		for (uint32_t i = 0; i < SCHED_QUEUE_SIZE; i++)
+		{
+			task->cells[i].sequence = i;
+		}
+		sched_stats_reset(hsched, hsched->count);
+		return hsched->count++;
+	}
+
+	/*
+	 * @brief	Queue an event for a task, from an interrupt or the main loop
+	 * 			(lock-free, never blocks)
+	 * @param	hsched scheduler
+	 * @param	task task number from sched_add_task
+	 * @param	event value passed to the handler
+	 * @retval	1 if queued, 0 if the queue was full (counted as dropped)
+	 */
+	uint8_t sched_post(Scheduler_HandleTypeDef *hsched, uint8_t task, uint32_t event)
+	{
+		Scheduler_TaskTypeDef *queue = &hsched->tasks[task];
+		Scheduler_CellTypeDef *cell;
+		uint32_t position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+
+		/* Claim the cell at the head, retry if another producer got it first */
+		for (;;)
+		{
+			cell = &queue->cells[position & SCHED_QUEUE_MASK];
+			int32_t lag = (int32_t) (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - position);
+			if (lag == 0)
+			{
+				if (__atomic_compare_exchange_n(&queue->head, &position, position + 1, 1,
+						__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				{
+					break;
+				}
+			}
+			else if (lag < 0)
+			{
+				/* The cell still holds the event of the previous lap */
+				__atomic_fetch_add(&queue->stats.dropped, 1, __ATOMIC_RELAXED);
+				return 0;
+			}
+			else
+			{
+				position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+			}
+		}
+
+		cell->event = event;
+		cell->posted = delay_now();
+		__atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+		atomic_max(&queue->stats.highWater,
+				position + 1 - __atomic_load_n(&queue->tail, __ATOMIC_RELAXED));
+		return 1;
+	}
+
+	/*
+	 * @brief	Run the oldest event of the highest priority task that has one,
+	 * 			or sleep until the next interrupt if no task has an event.
+	 * 			Call in the main loop only.
+	 * @param	hsched scheduler
+	 * @retval	None
+	 */
+	void sched_run(Scheduler_HandleTypeDef *hsched)
+	{
+		for (uint8_t i = 0; i < hsched->count; i++)
+		{
+			Scheduler_TaskTypeDef *task = &hsched->tasks[i];
+			if (!task_pending(task))
+			{
+				continue;
+			}
+
+			Scheduler_CellTypeDef *cell = &task->cells[task->tail & SCHED_QUEUE_MASK];
+			uint32_t event = cell->event;
+			uint32_t latency = delay_now() - cell->posted;
+			/* Hand the cell back to the producers for the next lap */
+			__atomic_store_n(&cell->sequence, task->tail + SCHED_QUEUE_SIZE, __ATOMIC_RELEASE);
+			__atomic_store_n(&task->tail, task->tail + 1, __ATOMIC_RELAXED);
+
+			task->stats.events++;
+			atomic_max(&task->stats.latencyMax, latency);
+			task->handler(event);
+			return;
+		}
+
+		/* Nothing to run. Interrupts are masked from the check to WFI, so an
+		 * event posted in between still wakes the core (WFI returns on any
+		 * pending interrupt) and runs right after they are unmasked */
+		__disable_irq();
+		for (uint8_t i = 0; i < hsched->count; i++)
+		{
+			if (task_pending(&hsched->tasks[i]))
+			{
+				__enable_irq();
+				return;
+			}
+		}
+		__WFI();
+		__enable_irq();
+	}
+
+	/*
+	 * @brief	Copy the statistics of a task
+	 * @param	hsched scheduler
+	 * @param	task task number
+	 * @param	snapshot statistics since sched_add_task or the last sched_stats_reset
+	 * @retval	None
+	 */
+	void sched_stats(Scheduler_HandleTypeDef *hsched, uint8_t task, Scheduler_StatsTypeDef *snapshot)
+	{
+		Scheduler_StatsTypeDef *stats = &hsched->tasks[task].stats;
+		snapshot->events = __atomic_load_n(&stats->events, __ATOMIC_RELAXED);
+		snapshot->dropped = __atomic_load_n(&stats->dropped, __ATOMIC_RELAXED);
+		snapshot->highWater = __atomic_load_n(&stats->highWater, __ATOMIC_RELAXED);
+		snapshot->latencyMax = __atomic_load_n(&stats->latencyMax, __ATOMIC_RELAXED);
+	}
+
+	/*
+	 * @brief	Clear the statistics of a task
+	 * @param	hsched scheduler
+	 * @param	task task number
+	 * @retval	None
+	 */
+	void sched_stats_reset(Scheduler_HandleTypeDef *hsched, uint8_t task)
+	{
+		Scheduler_StatsTypeDef *stats = &hsched->tasks[task].stats;
+		__atomic_store_n(&stats->events, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&stats->dropped, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&stats->highWater, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&stats->latencyMax, 0, __ATOMIC_RELAXED);
+	}
+
+	/*
+	 * @brief	Send a text over SWO
+	 * @param	text null terminated
+	 * @retval	None
+	 */
+	static void swo_print(const char *text)
+	{
+		while (*text)
+		{
+			ITM_SendChar(*text++);
+		}
+	}
+
+	/*
+	 * @brief	Send the statistics of every task over SWO (ITM port 0),
+	 * 			nothing is sent without a debugger
+	 * 			One line per task in priority order, the latency in core cycles
+	 * 			"task0 events=12 dropped=0 high-water=1 latency=345"
+	 * @param	hsched scheduler
+	 * @retval	None
+	 */
+	void sched_report(Scheduler_HandleTypeDef *hsched)
+	{
+		static const char *const names[] = {" events=", " dropped=", " high-water=", " latency="};
+		char field[FMT_BUFFER_SIZE];
+
+		for (uint8_t task = 0; task < hsched->count; task++)
+		{
+			Scheduler_StatsTypeDef stats;
+			sched_stats(hsched, task, &stats);
+			const uint32_t counters[] = {stats.events, stats.dropped, stats.highWater, stats.latencyMax};
+
+			fmt_uint(field, task);
+			swo_print("task");
+			swo_print(field);
+			for (int i = 0; i < 4; i++)
+			{
+				fmt_uint(field, counters[i]);
+				swo_print(names[i]);
+				swo_print(field);
+			}
+			swo_print("\n");
+		}
+	}
@@ -0,0 +1,126 @@
+/*
+ * Sensor.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "Sensor.h"
+
+	/*
+	 * @brief	Advance the sensor, call as often as possible (never blocks)
+	 * @param	sensor sensor to update
+	 * @retval	SENSOR_OK when a new reading was cached by this call,
+	 * 			SENSOR_BUSY, SENSOR_IDLE or SENSOR_ERROR otherwise
+	 */
+	Sensor_StatusTypeDef sensor_update(const Sensor_HandleTypeDef *sensor)
+	{
+		return sensor->driver->update(sensor->context);
+	}
+
+	/*
+	 * @brief	Start a conversion now, for sampling on an external schedule
+	 * 			(may be called from a timer interrupt). From the first trigger
+	 * 			on, sensor_update only completes conversions and no longer
+	 * 			starts them on the backend's own interval.
+	 * @param	sensor sensor to trigger
+	 * @retval	SENSOR_BUSY if a conversion was started, SENSOR_IDLE if the
+	 * 			trigger was skipped (conversion in progress, backing off after
+	 * 			failures, too soon for the sensor), SENSOR_ERROR if it failed
+	 */
+	Sensor_StatusTypeDef sensor_trigger(const Sensor_HandleTypeDef *sensor)
+	{
+		return sensor->driver->trigger(sensor->context);
+	}
+
+	/*
+	 * @brief	Last valid reading of the sensor
+	 * @param	sensor sensor to read
+	 * @param	reading variable for the reading, not changed when invalid
+	 * @param	age variable for the time since the conversion in ms (may be NULL)
+	 * @retval	SENSOR_SAMPLE_FRESH, SENSOR_SAMPLE_STALE or SENSOR_SAMPLE_INVALID
+	 */
+	uint8_t sensor_last_reading(const Sensor_HandleTypeDef *sensor,
+			Sensor_ReadingTypeDef *reading, uint32_t *age)
+	{
+		return sensor->driver->last_reading(sensor->context, reading, age);
+	}
+
+	/*
+	 * @brief	Time until the sensor is due for its next conversion (the end of
+	 * 			its interval, or of the backoff after failures), for scheduling
+	 * 			a retry or the first trigger
+	 * @param	sensor sensor to ask
+	 * @retval	Milliseconds, 0 if a conversion is due now
+	 */
+	uint32_t sensor_next_conversion(const Sensor_HandleTypeDef *sensor)
+	{
+		return sensor->driver->next_conversion(sensor->context);
+	}
+
+	/*
+	 * @brief	Empty a sample record (version 0, SENSOR_SAMPLE_INVALID)
+	 * @param	record record to initialize
+	 * @retval	None
+	 */
+	void sensor_record_init(Sensor_RecordTypeDef *record)
+	{
+		const Sensor_RecordTypeDef empty = { 0 };
+		*record = empty;
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+	}
+
+	/*
+	 * @brief	Publish a sample, from a single writer context
+	 * @param	record record to update
+	 * @param	reading reading to publish
+	 * @param	tag SENSOR_SAMPLE_ tag of the reading
+	 * @retval	None
+	 */
+	void sensor_publish(Sensor_RecordTypeDef *record, const Sensor_ReadingTypeDef *reading,
+			uint8_t tag)
+	{
+		uint32_t version = record->version + 1;
+		uint8_t slot = version & 1;	// not the slot of the published version
+		uint32_t sequence = record->sequence[slot];
+
+		__atomic_store_n(&record->sequence[slot], sequence + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);	// odd before the slot changes
+		record->slots[slot].reading = *reading;
+		record->slots[slot].tag = tag;
+		record->slots[slot].version = version;
+		__atomic_store_n(&record->sequence[slot], sequence + 2, __ATOMIC_RELEASE);
+		__atomic_store_n(&record->version, version, __ATOMIC_RELEASE);
+	}
+
+	/*
+	 * @brief	Copy the last published sample, from any context (never blocks,
+	 * 			never disables interrupts). Succeeds on the first attempt unless
+	 * 			the writer publishes twice while it copies, which only happens
+	 * 			if the writer can preempt the reader.
+	 * @param	record record to read
+	 * @param	sample variable for the sample, only valid if 1 is returned
+	 * @retval	1 if a consistent sample was copied, 0 if the writer kept
+	 * 			overwriting it (read again later)
+	 */
+	uint8_t sensor_snapshot(const Sensor_RecordTypeDef *record, Sensor_SampleTypeDef *sample)
+	{
+		for (uint8_t attempt = 0; attempt < 2; attempt++)
+		{
+			uint32_t version = __atomic_load_n(&record->version, __ATOMIC_ACQUIRE);
+			uint8_t slot = version & 1;
+			uint32_t sequence = __atomic_load_n(&record->sequence[slot], __ATOMIC_ACQUIRE);
+			*sample = record->slots[slot];
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);	// copy before the check
+			/* The slot may already hold version + 2 if the writer published twice
+			 * since version was loaded: newer than the record, so the next
+			 * snapshot would go back to version + 1 */
+			if (!(sequence & 1)
+					&& __atomic_load_n(&record->sequence[slot], __ATOMIC_RELAXED) == sequence
+					&& sample->version == version)
+			{
+				return 1;
+			}
+		}
+		return 0;
+	}
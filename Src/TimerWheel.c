@@ -0,0 +1,498 @@
+/*
+ * TimerWheel.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "TimerWheel.h"
+#include "Format.h"
+
+	/* Compare interrupt and event of a channel (CC1 to CC4 for TIM_CHANNEL_1 to 4) */
+	#define WHEEL_IT(channel) (TIM_IT_CC1 << ((channel) >> 2))
+	#define WHEEL_EVENT(channel) (TIM_EGR_CC1G << ((channel) >> 2))
+
+	#define WHEEL_SLOT_MASK (WHEEL_SLOTS - 1)
+
+	/*
+	 * @brief	Current tick, the processed tick plus the ticks since its start
+	 * @param	hwheel wheel
+	 * @retval	Tick
+	 */
+	static uint32_t current_tick(TimerWheel_HandleTypeDef *hwheel)
+	{
+		return hwheel->now + (__HAL_TIM_GET_COUNTER(hwheel->htim) - hwheel->base) / WHEEL_TICK;
+	}
+
+	/*
+	 * @brief	Put a timer in the slot of its expiry, on the lowest level that
+	 * 			reaches it from the processed tick
+	 * @param	hwheel wheel
+	 * @param	timer timer with its expiry set, not linked
+	 * @retval	None
+	 */
+	static void link(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer)
+	{
+		uint32_t delta = timer->expires - hwheel->now;
+		uint8_t level = 0;
+
+		while (level < WHEEL_LEVELS - 1 && delta >> (WHEEL_SLOT_BITS * (level + 1)))
+		{
+			level++;
+		}
+		timer->level = level;
+		timer->slot = (timer->expires >> (WHEEL_SLOT_BITS * level)) & WHEEL_SLOT_MASK;
+
+		TimerWheel_TimerTypeDef **head = &hwheel->slots[level][timer->slot];
+		timer->prev = NULL;
+		timer->next = *head;
+		if (*head != NULL)
+		{
+			(*head)->prev = timer;
+		}
+		*head = timer;
+		hwheel->occupied[level] |= 1ULL << timer->slot;
+	}
+
+	/*
+	 * @brief	Take a timer out of its slot
+	 * @param	hwheel wheel
+	 * @param	timer linked timer
+	 * @retval	None
+	 */
+	static void unlink(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer)
+	{
+		if (timer->prev != NULL)
+		{
+			timer->prev->next = timer->next;
+		}
+		else
+		{
+			hwheel->slots[timer->level][timer->slot] = timer->next;
+			if (timer->next == NULL)
+			{
+				hwheel->occupied[timer->level] &= ~(1ULL << timer->slot);
+			}
+		}
+		if (timer->next != NULL)
+		{
+			timer->next->prev = timer->prev;
+		}
+	}
+
+	/*
+	 * @brief	Ticks from the processed tick to the next tick with work: the
+	 * 			expiry of a first level slot or the start of a higher level
+	 * 			slot, when its timers move down
+	 * @param	hwheel wheel
+	 * @retval	Ticks, 1 or more, UINT32_MAX if the wheel is empty
+	 */
+	static uint32_t next_work(TimerWheel_HandleTypeDef *hwheel)
+	{
+		uint32_t best = UINT32_MAX;
+
+		for (uint8_t level = 0; level < WHEEL_LEVELS; level++)
+		{
+			if (hwheel->occupied[level] == 0)
+			{
+				continue;
+			}
+			uint32_t shift = WHEEL_SLOT_BITS * level;
+			uint32_t current = hwheel->now >> shift;
+			/* Rotate the slot after the current one to bit 0 */
+			uint32_t rotate = (current + 1) & WHEEL_SLOT_MASK;
+			uint64_t bits = hwheel->occupied[level];
+			if (rotate != 0)
+			{
+				bits = (bits >> rotate) | (bits << (WHEEL_SLOTS - rotate));
+			}
+			uint32_t delta = ((current + __builtin_ctzll(bits) + 1) << shift) - hwheel->now;
+			if (delta < best)
+			{
+				best = delta;
+			}
+		}
+		return best;
+	}
+
+	/*
+	 * @brief	Set the compare to the next tick with work (or the longest sleep)
+	 * 			and raise the interrupt right away if that time has passed
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	static void program(TimerWheel_HandleTypeDef *hwheel)
+	{
+		uint32_t delta = next_work(hwheel);
+		if (delta > WHEEL_MAX_SLEEP)
+		{
+			delta = WHEEL_MAX_SLEEP;
+		}
+		uint32_t compare = hwheel->base + delta * WHEEL_TICK;
+		__HAL_TIM_SET_COMPARE(hwheel->htim, hwheel->channel, compare);
+		if ((int32_t) (__HAL_TIM_GET_COUNTER(hwheel->htim) - compare) >= 0)
+		{
+			hwheel->htim->Instance->EGR = WHEEL_EVENT(hwheel->channel);
+		}
+	}
+
+	/*
+	 * @brief	Move the timers of the higher level slots that start at the
+	 * 			processed tick down the wheel
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	static void cascade(TimerWheel_HandleTypeDef *hwheel)
+	{
+		for (uint8_t level = 1; level < WHEEL_LEVELS; level++)
+		{
+			/* A level turns over only when every level below it does */
+			if ((hwheel->now >> (WHEEL_SLOT_BITS * (level - 1))) & WHEEL_SLOT_MASK)
+			{
+				break;
+			}
+			uint8_t slot = (hwheel->now >> (WHEEL_SLOT_BITS * level)) & WHEEL_SLOT_MASK;
+			TimerWheel_TimerTypeDef *timer = hwheel->slots[level][slot];
+			hwheel->slots[level][slot] = NULL;
+			hwheel->occupied[level] &= ~(1ULL << slot);
+			while (timer != NULL)
+			{
+				TimerWheel_TimerTypeDef *next = timer->next;
+				link(hwheel, timer);
+				timer = next;
+			}
+		}
+	}
+
+	/*
+	 * @brief	Add the timestamp of a callback to the period statistics
+	 * @param	jitter statistics of the timer
+	 * @param	stamp timer count at the callback
+	 * @retval	None
+	 */
+	static void track(TimerWheel_JitterTypeDef *jitter, uint32_t stamp)
+	{
+		uint32_t period = stamp - jitter->stamp;
+
+		/* The first callback has no previous one to compare with */
+		if (jitter->samples++ != 0)
+		{
+			if (period < jitter->periodMin)
+			{
+				jitter->periodMin = period;
+			}
+			if (period > jitter->periodMax)
+			{
+				jitter->periodMax = period;
+			}
+		}
+		jitter->stamp = stamp;
+	}
+
+	/*
+	 * @brief	Run the timers of the first level slot of the processed tick
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	static void expire(TimerWheel_HandleTypeDef *hwheel)
+	{
+		uint8_t slot = hwheel->now & WHEEL_SLOT_MASK;
+
+		/* One at a time, a callback may cancel the other timers of the slot */
+		while (hwheel->slots[0][slot] != NULL)
+		{
+			TimerWheel_TimerTypeDef *timer = hwheel->slots[0][slot];
+			unlink(hwheel, timer);
+			timer->active = 0;
+
+			uint32_t latency = __HAL_TIM_GET_COUNTER(hwheel->htim) - hwheel->base;
+			hwheel->stats.expired++;
+			hwheel->stats.latencySum += latency;
+			if (latency < hwheel->stats.latencyMin)
+			{
+				hwheel->stats.latencyMin = latency;
+			}
+			if (latency > hwheel->stats.latencyMax)
+			{
+				hwheel->stats.latencyMax = latency;
+			}
+			if (timer->jitter != NULL)
+			{
+				track(timer->jitter, hwheel->base + latency);
+			}
+
+			/* Periodic timers stay on their grid, skipping the expiries already past */
+			if (timer->period != 0)
+			{
+				uint32_t now = current_tick(hwheel);
+				timer->expires += timer->period;
+				while ((int32_t) (now - timer->expires) >= 0)
+				{
+					timer->expires += timer->period;
+					hwheel->stats.missed++;
+				}
+				link(hwheel, timer);
+				timer->active = 1;
+			}
+			timer->callback(timer->context);
+		}
+	}
+
+	/*
+	 * @brief	Clear the statistics, interrupt of the wheel disabled
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	static void stats_clear(TimerWheel_HandleTypeDef *hwheel)
+	{
+		hwheel->stats.expired = 0;
+		hwheel->stats.missed = 0;
+		hwheel->stats.latencyMin = UINT32_MAX;
+		hwheel->stats.latencyMax = 0;
+		hwheel->stats.latencySum = 0;
+	}
+
+	/*
+	 * @brief	Start the wheel, empty, at tick 0
+	 * @param	hwheel handle to initialize
+	 * @param	htim TIM handle, must be setup prior as a free-running 32-bit
+	 * 			counter (period 0xFFFFFFFF) with its interrupt enabled
+	 * @param	channel TIM_CHANNEL_x of the compare, configured in timing mode
+	 * @retval	None
+	 */
+	void wheel_init(TimerWheel_HandleTypeDef *hwheel, TIM_HandleTypeDef *htim, uint32_t channel)
+	{
+		hwheel->htim = htim;
+		hwheel->channel = channel;
+		hwheel->now = 0;
+		for (uint8_t level = 0; level < WHEEL_LEVELS; level++)
+		{
+			hwheel->occupied[level] = 0;
+			for (uint8_t slot = 0; slot < WHEEL_SLOTS; slot++)
+			{
+				hwheel->slots[level][slot] = NULL;
+			}
+		}
+		stats_clear(hwheel);
+
+		HAL_TIM_Base_Start(htim);
+		hwheel->base = __HAL_TIM_GET_COUNTER(htim);
+		program(hwheel);
+		HAL_TIM_OC_Start_IT(htim, channel);
+	}
+
+	/*
+	 * @brief	Start (or restart) a timer
+	 * @param	hwheel wheel
+	 * @param	timer timer, must stay valid while it runs
+	 * @param	delay ticks to the first expiry, 1 to WHEEL_MAX_DELAY
+	 * @param	period ticks between the following expiries, 0 for a one-shot
+	 * 			timer, periodic timers stay on the grid of their first expiry
+	 * @param	callback function called in the timer interrupt on expiry
+	 * @param	context argument of the callback
+	 * @retval	None
+	 */
+	void wheel_start(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer,
+			uint32_t delay, uint32_t period, void (*callback)(void *context), void *context)
+	{
+		delay = delay < 1 ? 1 : delay > WHEEL_MAX_DELAY ? WHEEL_MAX_DELAY : delay;
+		period = period > WHEEL_MAX_DELAY ? WHEEL_MAX_DELAY : period;
+
+		__HAL_TIM_DISABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		if (timer->active)
+		{
+			unlink(hwheel, timer);
+		}
+		timer->expires = current_tick(hwheel) + delay;
+		timer->period = period;
+		timer->callback = callback;
+		timer->context = context;
+		link(hwheel, timer);
+		timer->active = 1;
+		program(hwheel);
+		__HAL_TIM_ENABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+	}
+
+	/*
+	 * @brief	Stop a timer, nothing happens if it is not running
+	 * @param	hwheel wheel
+	 * @param	timer timer to stop
+	 * @retval	None
+	 */
+	void wheel_cancel(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer)
+	{
+		__HAL_TIM_DISABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		if (timer->active)
+		{
+			unlink(hwheel, timer);
+			timer->active = 0;
+		}
+		__HAL_TIM_ENABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+	}
+
+	/*
+	 * @brief	Run the expired timers and set the compare to the next tick
+	 * 			with work, call from HAL_TIM_OC_DelayElapsedCallback for the
+	 * 			channel of the wheel
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	void wheel_process(TimerWheel_HandleTypeDef *hwheel)
+	{
+		uint32_t target = current_tick(hwheel);
+
+		/* Jump from one tick with work to the next, up to the current tick */
+		uint32_t delta = next_work(hwheel);
+		while (delta <= target - hwheel->now)
+		{
+			hwheel->now += delta;
+			hwheel->base += delta * WHEEL_TICK;
+			cascade(hwheel);
+			expire(hwheel);
+			delta = next_work(hwheel);
+		}
+
+		/* No work in the ticks left */
+		hwheel->base += (target - hwheel->now) * WHEEL_TICK;
+		hwheel->now = target;
+		program(hwheel);
+	}
+
+	/*
+	 * @brief	Current tick
+	 * @param	hwheel wheel
+	 * @retval	Ticks since wheel_init
+	 */
+	uint32_t wheel_now(TimerWheel_HandleTypeDef *hwheel)
+	{
+		/* now and base must come from the same wheel_process */
+		__HAL_TIM_DISABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		uint32_t tick = current_tick(hwheel);
+		__HAL_TIM_ENABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		return tick;
+	}
+
+	/*
+	 * @brief	Copy the timing statistics
+	 * @param	hwheel wheel
+	 * @param	snapshot statistics since wheel_init or the last wheel_stats_reset
+	 * @retval	None
+	 */
+	void wheel_stats(TimerWheel_HandleTypeDef *hwheel, TimerWheel_StatsTypeDef *snapshot)
+	{
+		__HAL_TIM_DISABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		*snapshot = hwheel->stats;
+		__HAL_TIM_ENABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+	}
+
+	/*
+	 * @brief	Clear the timing statistics
+	 * @param	hwheel wheel
+	 * @retval	None
+	 */
+	void wheel_stats_reset(TimerWheel_HandleTypeDef *hwheel)
+	{
+		__HAL_TIM_DISABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		stats_clear(hwheel);
+		__HAL_TIM_ENABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+	}
+
+	/*
+	 * @brief	Keep the period statistics of a timer from its next callback on
+	 * 			(running or not, wheel_start keeps them)
+	 * @param	hwheel wheel
+	 * @param	timer timer to track
+	 * @param	jitter statistics, cleared here, NULL to stop tracking
+	 * @retval	None
+	 */
+	void wheel_track(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer,
+			TimerWheel_JitterTypeDef *jitter)
+	{
+		__HAL_TIM_DISABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		if (jitter != NULL)
+		{
+			jitter->samples = 0;
+			jitter->stamp = 0;
+			jitter->periodMin = UINT32_MAX;
+			jitter->periodMax = 0;
+		}
+		timer->jitter = jitter;
+		__HAL_TIM_ENABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+	}
+
+	/*
+	 * @brief	Copy the period statistics of a tracked timer
+	 * @param	hwheel wheel
+	 * @param	timer tracked timer
+	 * @param	snapshot statistics since wheel_track
+	 * @retval	None
+	 */
+	void wheel_jitter(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer,
+			TimerWheel_JitterTypeDef *snapshot)
+	{
+		__HAL_TIM_DISABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+		*snapshot = *timer->jitter;
+		__HAL_TIM_ENABLE_IT(hwheel->htim, WHEEL_IT(hwheel->channel));
+	}
+
+	/*
+	 * @brief	Send a text over SWO
+	 * @param	text null terminated
+	 * @retval	None
+	 */
+	static void swo_print(const char *text)
+	{
+		while (*text)
+		{
+			ITM_SendChar(*text++);
+		}
+	}
+
+	/*
+	 * @brief	Send a named counter over SWO
+	 * @param	name text before the value
+	 * @param	value counter
+	 * @retval	None
+	 */
+	static void swo_field(const char *name, uint32_t value)
+	{
+		char field[FMT_BUFFER_SIZE];
+
+		fmt_uint(field, value);
+		swo_print(name);
+		swo_print(field);
+	}
+
+	/*
+	 * @brief	Send the timing statistics over SWO (ITM port 0), nothing is
+	 * 			sent without a debugger, times in timer counts (us at 1 MHz)
+	 * 			A line for the wheel, then one for the timer if it is tracked,
+	 * 			with its shortest and longest period
+	 * 			"wheel expired=30 missed=0 latency=2-9"
+	 * 			"timer samples=15 period=1999998-2000003"
+	 * @param	hwheel wheel
+	 * @param	timer timer tracked by wheel_track, may be NULL
+	 * @retval	None
+	 */
+	void wheel_report(TimerWheel_HandleTypeDef *hwheel, TimerWheel_TimerTypeDef *timer)
+	{
+		TimerWheel_StatsTypeDef stats;
+
+		wheel_stats(hwheel, &stats);
+		swo_field("wheel expired=", stats.expired);
+		swo_field(" missed=", stats.missed);
+		/* The minimums start at UINT32_MAX, reported as 0 until there is a value */
+		swo_field(" latency=", stats.expired ? stats.latencyMin : 0);
+		swo_field("-", stats.latencyMax);
+		swo_print("\n");
+
+		if (timer != NULL && timer->jitter != NULL)
+		{
+			TimerWheel_JitterTypeDef jitter;
+			wheel_jitter(hwheel, timer, &jitter);
+			swo_field("timer samples=", jitter.samples);
+			swo_field(" period=", jitter.samples > 1 ? jitter.periodMin : 0);
+			swo_field("-", jitter.periodMax);
+			swo_print("\n");
+		}
+	}
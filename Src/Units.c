@@ -0,0 +1,71 @@
+/*
+ * Units.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Jake Ivanov
+ */
+
+#include "Units.h"
+
+	/*
+	 * @brief	Divides to the nearest integer, halves away from zero, and
+	 * 			saturates to the int16 range.
+	 * @param	numerator	Any value that fits in 32 bits with divisor / 2 added.
+	 * @param	divisor		Positive divisor.
+	 * @retval	Rounded quotient.
+	 */
+	static Units_DeciTypeDef round_div(int32_t numerator, int32_t divisor)
+	{
+		int32_t quotient = numerator >= 0 ? (numerator + divisor / 2) / divisor
+				: -((-numerator + divisor / 2) / divisor);
+
+		if (quotient > INT16_MAX)
+		{
+			return INT16_MAX;
+		}
+		if (quotient < INT16_MIN)
+		{
+			return INT16_MIN;
+		}
+		return quotient;
+	}
+
+	/*
+	 * @brief	Converts a temperature from Celsius.
+	 * @param	celsius	Temperature in 0.1 C.
+	 * @param	unit	UNITS_CELSIUS, UNITS_FAHRENHEIT or UNITS_KELVIN.
+	 * @retval	Temperature in 0.1 of the unit, rounded to the nearest tenth
+	 * 			(halves away from zero), saturated to the int16 range.
+	 */
+	Units_DeciTypeDef units_temp(Units_DeciTypeDef celsius, uint8_t unit)
+	{
+		switch (unit)
+		{
+		case UNITS_FAHRENHEIT:
+			/* F = C * 9 / 5 + 32, in tenths: (9 C + 1600) / 5 */
+			return round_div(9 * (int32_t) celsius + 1600, 5);
+		case UNITS_KELVIN:
+			/* K = C + 273.15, in tenths: (2 C + 5463) / 2 */
+			return round_div(2 * (int32_t) celsius + 5463, 2);
+		default:
+			return celsius;
+		}
+	}
+
+	/*
+	 * @brief	Symbol of a temperature unit, for display.
+	 * @param	unit	UNITS_CELSIUS, UNITS_FAHRENHEIT or UNITS_KELVIN.
+	 * @retval	"C", "F" or "K".
+	 */
+	const char *units_temp_symbol(uint8_t unit)
+	{
+		switch (unit)
+		{
+		case UNITS_FAHRENHEIT:
+			return "F";
+		case UNITS_KELVIN:
+			return "K";
+		default:
+			return "C";
+		}
+	}
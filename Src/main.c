@@ -23,6 +23,12 @@
 /* USER CODE BEGIN Includes */
 #include "Delay.h"
 #include "LiquidCrystal.h"
+#include "DHTemp.h"
+#include "Sensor.h"
+#include "TimerWheel.h"
+#include "Scheduler.h"
+#include "Format.h"
+#include "Units.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -32,6 +38,24 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define SAMPLE_PERIOD_MS 2000 // sample period, the DHT22 rate
+#define DISPLAY_PERIOD_MS 500 // LCD refresh period
+#define UPLOAD_PERIOD_MS 60000 // UART upload period
+#define TEMP_UNIT UNITS_FAHRENHEIT // temperature unit of the LCD and the upload
+#define POLL_PERIOD_MS 1 // sensor polling while a conversion is in progress
+#define UPLOAD_BUFFER_SIZE (2 * FMT_BUFFER_SIZE) // a reading, temperature and humidity
+/* Events of the sample task */
+#define SAMPLE_EVENT_TRIGGER 0 // start a conversion
+#define SAMPLE_EVENT_POLL 1 // advance the conversion in progress
+/* Events of the render task */
+#define RENDER_EVENT_REFRESH 0 // redraw the LCD
+/* Events of the upload task */
+#define UPLOAD_EVENT_SEND 0 // send the last reading if it is fresh
+#define UPLOAD_EVENT_DONE 1 // UART transmission complete
+/* Events of the command task are the received bytes */
+#define COMMAND_SAMPLE 's' // sample now
+#define COMMAND_UPLOAD 'u' // upload now
+#define COMMAND_REPORT 'q' // report the scheduler and sampling statistics over SWO
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -40,8 +64,10 @@
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
+TIM_HandleTypeDef htim1;
 TIM_HandleTypeDef htim2;
 TIM_HandleTypeDef htim5;
+DMA_HandleTypeDef hdma_tim1_up;
 
 UART_HandleTypeDef huart1;
 
@@ -52,19 +78,49 @@ UART_HandleTypeDef huart1;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_TIM2_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_TIM5_Init(void);
+static void MX_TIM1_Init(void);
 /* USER CODE BEGIN PFP */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+static void sample_expired(void *context);
+static void poll_expired(void *context);
+static void display_expired(void *context);
+static void upload_expired(void *context);
+static void sample_task_run(uint32_t event);
+static void render_task_run(uint32_t event);
+static void upload_task_run(uint32_t event);
+static void command_task_run(uint32_t event);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-static volatile int8_t RH_whole;
-static volatile int8_t RH_frac;
-static volatile int8_t temp_f_whole;
-static volatile int8_t temp_f_frac;
+/* Last reading for the upload. The writer (render task) and the reader (upload task) are both
+ * tasks of the scheduler: they run to completion and never preempt each other, so a snapshot
+ * never meets a publication in progress. The seqlock keeps it safe to read from an interrupt too. */
+static Sensor_RecordTypeDef sample_record;
+static LCD_HandleTypeDef lcd;
+static const Sensor_HandleTypeDef sensor = { &DHT_sensor_driver, NULL }; // station sensor
+static TimerWheel_HandleTypeDef wheel; // all periodic work, on TIM5 channel 1
+static TimerWheel_TimerTypeDef sample_timer;
+static TimerWheel_JitterTypeDef sample_jitter; // period between the sample timestamps
+static TimerWheel_TimerTypeDef display_timer;
+static TimerWheel_TimerTypeDef upload_timer;
+static TimerWheel_TimerTypeDef retry_timer; // conversion at the end of a backoff
+static TimerWheel_TimerTypeDef poll_timer; // runs while a conversion is in progress
+static Scheduler_HandleTypeDef scheduler; // all work of the main loop
+static uint8_t sample_task; // task numbers, in priority order
+static uint8_t render_task;
+static uint8_t upload_task;
+static uint8_t command_task;
+static uint8_t upload_buffer[UPLOAD_BUFFER_SIZE]; // sent by the UART interrupt
+static uint8_t command_byte; // received by the UART interrupt
 /* USER CODE END 0 */
 
 /**
@@ -90,55 +146,57 @@ int main(void)
 	SystemClock_Config();
 
 	/* USER CODE BEGIN SysInit */
+	delay_init(); // cycle counter for the microsecond delays
 
 	/* USER CODE END SysInit */
 
 	/* Initialize all configured peripherals */
 	MX_GPIO_Init();
+	MX_DMA_Init();
 	MX_TIM2_Init();
 	MX_USART1_UART_Init();
 	MX_TIM5_Init();
+	MX_TIM1_Init();
 	/* USER CODE BEGIN 2 */
 	/* LCD setup */
-	pin_setup(GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7,
+	pin_setup(&lcd, GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7,
 	GPIO_PIN_8, GPIO_PIN_9, GPIO_PIN_10, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
-	begin(16, 2, LCD_5x8DOTS);
+	begin(&lcd, 16, 2, LCD_5x8DOTS);
+	setWaitMode(&lcd, LCD_WAIT_BUSYFLAG);
+	frameBufferON(&lcd);
+	dmaON(&lcd, &htim1, &hdma_tim1_up, 5000); // TIM1 paces DMA2 to the LCD port every 5 us
 	/* DHT setup */
-	DHTinit(GPIOA, GPIO_PIN_11, htim2);
-	int16_t RH = 0;
-	int16_t temp = 0;
+	DHTinit(GPIOA, GPIO_PIN_11, &htim2);
+	sensor_record_init(&sample_record);
 	/* LCD initial printing */
-	print("Temp: ");
-	setCursor(0, 1);
-	print("RH: ");
-	/* Start timer for UART interrupt */
-	HAL_TIM_Base_Start_IT(&htim5);
+	print(&lcd, "Temp: ");
+	setCursor(&lcd, 0, 1);
+	print(&lcd, "RH: ");
+	flush(&lcd);
+	/* Tasks, highest priority first */
+	sched_init(&scheduler);
+	sample_task = sched_add_task(&scheduler, sample_task_run);
+	render_task = sched_add_task(&scheduler, render_task_run);
+	upload_task = sched_add_task(&scheduler, upload_task_run);
+	command_task = sched_add_task(&scheduler, command_task_run);
+	HAL_UART_Receive_IT(&huart1, &command_byte, 1);
+	/* Sampling, display refresh and UART upload on the timer wheel */
+	sched_post(&scheduler, render_task, RENDER_EVENT_REFRESH);
+	wheel_init(&wheel, &htim5, TIM_CHANNEL_1);
+	wheel_start(&wheel, &sample_timer, SAMPLE_PERIOD_MS, SAMPLE_PERIOD_MS, sample_expired, NULL);
+	wheel_track(&wheel, &sample_timer, &sample_jitter); // every sample timestamped on TIM5
+	wheel_start(&wheel, &display_timer, DISPLAY_PERIOD_MS, DISPLAY_PERIOD_MS, display_expired,
+	NULL);
+	wheel_start(&wheel, &upload_timer, UPLOAD_PERIOD_MS, UPLOAD_PERIOD_MS, upload_expired, NULL);
 	/* USER CODE END 2 */
 
 	/* Infinite loop */
 	/* USER CODE BEGIN WHILE */
 	while (1)
 	{
-		DHTreceive_data(&RH, &temp);
-		RH_whole = RH / 10;
-		RH_frac = RH % 10;
-		int16_t temp_f = temp * 1.8;
-		temp_f_whole = temp_f / 10 + 32;
-		temp_f_frac = temp_f % 10;
-		if (temp_f_frac < 0)
-		{
-			temp_f_frac = -temp_f_frac;
-		}
-		setCursor(6, 0);
-		print_int(temp_f_whole);
-		print(".");
-		print_int(temp_f_frac);
-		print(" F   "); // print a few empty spaces to clear previous characters
-		setCursor(4, 1);
-		print_int(RH_whole);
-		print(".");
-		print_int(RH_frac);
-		print("%   ");
+		/* Interrupts only post events, the tasks run here to completion,
+		 * the core sleeps when no event is pending */
+		sched_run(&scheduler);
 		/* USER CODE END WHILE */
 
 		/* USER CODE BEGIN 3 */
@@ -257,6 +315,8 @@ static void MX_TIM5_Init(void)
 	{ 0 };
 	TIM_MasterConfigTypeDef sMasterConfig =
 	{ 0 };
+	TIM_OC_InitTypeDef sConfigOC =
+	{ 0 };
 
 	/* USER CODE BEGIN TIM5_Init 1 */
 
@@ -264,7 +324,7 @@ static void MX_TIM5_Init(void)
 	htim5.Instance = TIM5;
 	htim5.Init.Prescaler = 84 - 1;
 	htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
-	htim5.Init.Period = 60000000 - 1;
+	htim5.Init.Period = 4294967295;
 	htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
 	htim5.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
 	if (HAL_TIM_Base_Init(&htim5) != HAL_OK)
@@ -276,18 +336,78 @@ static void MX_TIM5_Init(void)
 	{
 		Error_Handler();
 	}
+	if (HAL_TIM_OC_Init(&htim5) != HAL_OK)
+	{
+		Error_Handler();
+	}
 	sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
 	sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
 	if (HAL_TIMEx_MasterConfigSynchronization(&htim5, &sMasterConfig) != HAL_OK)
 	{
 		Error_Handler();
 	}
+	sConfigOC.OCMode = TIM_OCMODE_TIMING;
+	sConfigOC.Pulse = 0;
+	sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+	sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+	if (HAL_TIM_OC_ConfigChannel(&htim5, &sConfigOC, TIM_CHANNEL_1) != HAL_OK)
+	{
+		Error_Handler();
+	}
 	/* USER CODE BEGIN TIM5_Init 2 */
 
 	/* USER CODE END TIM5_Init 2 */
 
 }
 
+/**
+ * @brief TIM1 Initialization Function
+ * @param None
+ * @retval None
+ */
+static void MX_TIM1_Init(void)
+{
+
+	/* USER CODE BEGIN TIM1_Init 0 */
+
+	/* USER CODE END TIM1_Init 0 */
+
+	TIM_ClockConfigTypeDef sClockSourceConfig =
+	{ 0 };
+	TIM_MasterConfigTypeDef sMasterConfig =
+	{ 0 };
+
+	/* USER CODE BEGIN TIM1_Init 1 */
+
+	/* USER CODE END TIM1_Init 1 */
+	htim1.Instance = TIM1;
+	htim1.Init.Prescaler = 84 - 1;
+	htim1.Init.CounterMode = TIM_COUNTERMODE_UP;
+	htim1.Init.Period = 5 - 1;
+	htim1.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	htim1.Init.RepetitionCounter = 0;
+	htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	if (HAL_TIM_Base_Init(&htim1) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+	if (HAL_TIM_ConfigClockSource(&htim1, &sClockSourceConfig) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+	sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+	if (HAL_TIMEx_MasterConfigSynchronization(&htim1, &sMasterConfig) != HAL_OK)
+	{
+		Error_Handler();
+	}
+	/* USER CODE BEGIN TIM1_Init 2 */
+
+	/* USER CODE END TIM1_Init 2 */
+
+}
+
 /**
  * @brief USART1 Initialization Function
  * @param None
@@ -321,6 +441,22 @@ static void MX_USART1_UART_Init(void)
 
 }
 
+/**
+ * Enable DMA controller clock
+ */
+static void MX_DMA_Init(void)
+{
+
+	/* DMA controller clock enable */
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	/* DMA interrupt init */
+	/* DMA2_Stream5_IRQn interrupt configuration */
+	HAL_NVIC_SetPriority(DMA2_Stream5_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream5_IRQn);
+
+}
+
 /**
  * @brief GPIO Initialization Function
  * @param None
@@ -354,17 +490,186 @@ static void MX_GPIO_Init(void)
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
 	HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
 
+	/* EXTI interrupt init*/
+	HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+
 }
 
 /* USER CODE BEGIN 4 */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if (GPIO_Pin == GPIO_PIN_11)
+	{
+		DHTcapture_edge(); // DHT line
+	}
+}
+
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+	if (htim->Instance == TIM5 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1)
+	{
+		wheel_process(&wheel); // timer wheel
+	}
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance == USART1)
+	{
+		sched_post(&scheduler, upload_task, UPLOAD_EVENT_DONE);
+	}
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance == USART1)
+	{
+		sched_post(&scheduler, command_task, command_byte);
+		HAL_UART_Receive_IT(&huart1, &command_byte, 1); // next command
+	}
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance == USART1)
+	{
+		HAL_UART_Receive_IT(&huart1, &command_byte, 1); // reception is aborted on errors
+	}
+}
+
+/* Timer wheel callbacks, run in the TIM5 interrupt */
+static void sample_expired(void *context)
+{
+	(void) context;
+	sched_post(&scheduler, sample_task, SAMPLE_EVENT_TRIGGER);
+}
+
+static void poll_expired(void *context)
+{
+	(void) context;
+	sched_post(&scheduler, sample_task, SAMPLE_EVENT_POLL);
+}
+
+static void display_expired(void *context)
+{
+	(void) context;
+	sched_post(&scheduler, render_task, RENDER_EVENT_REFRESH);
+}
+
+static void upload_expired(void *context)
+{
+	(void) context;
+	sched_post(&scheduler, upload_task, UPLOAD_EVENT_SEND);
+}
+
+/* Tasks, run to completion by sched_run */
+static void sample_task_run(uint32_t event)
+{
+	/* Conversions are started at a fixed rate by the sample timer, the bits
+	 * are timestamped by the EXTI interrupt and the conversion is polled
+	 * until it ends. A failed conversion schedules a retry at the end of its
+	 * backoff, the last valid reading is kept, tagged stale once it gets old */
+	if (event == SAMPLE_EVENT_TRIGGER)
+	{
+		sensor_trigger(&sensor);
+		wheel_start(&wheel, &poll_timer, POLL_PERIOD_MS, POLL_PERIOD_MS, poll_expired, NULL);
+		return;
+	}
+	Sensor_StatusTypeDef status = sensor_update(&sensor);
+	if (status == SENSOR_BUSY)
+	{
+		return;
+	}
+	wheel_cancel(&wheel, &poll_timer);
+	if (status == SENSOR_ERROR)
+	{
+		wheel_start(&wheel, &retry_timer, sensor_next_conversion(&sensor), 0, sample_expired, NULL);
+	}
+}
+
+static void render_task_run(uint32_t event)
+{
+	(void) event;
+	Sensor_ReadingTypeDef reading = { 0 };
+	uint8_t tag = sensor_last_reading(&sensor, &reading, NULL);
+	sensor_publish(&sample_record, &reading, tag); // with the tag of this refresh
+	setCursor(&lcd, 6, 0);
+	if (tag == SENSOR_SAMPLE_INVALID)
+	{
+		print(&lcd, " --.- ");
+		write(&lcd, *units_temp_symbol(TEMP_UNIT));
+		setCursor(&lcd, 4, 1);
+		print(&lcd, " --.-%");
+	}
+	else
+	{
+		// fixed width, -40 C to 80 C is 5 characters in any unit
+		print_fixed(&lcd, units_temp(reading.temp, TEMP_UNIT), 1, 5, FMT_ALIGN_RIGHT);
+		print(&lcd, " ");
+		write(&lcd, *units_temp_symbol(TEMP_UNIT));
+		setCursor(&lcd, 4, 1);
+		print_fixed(&lcd, reading.RH, 1, 5, FMT_ALIGN_RIGHT);
+		print(&lcd, "%");
+	}
+	setCursor(&lcd, 15, 0);
+	print(&lcd, tag == SENSOR_SAMPLE_STALE ? "?" : " "); // stale marker
+	flush(&lcd); // only the cells that changed are streamed to the LCD
+}
+
+static void upload_task_run(uint32_t event)
+{
+	static uint8_t sending; // upload_buffer is in use by the UART
+	char *buffer = (char*) upload_buffer;
+	int buffer_length = 0;
+	Sensor_SampleTypeDef sample;
+
+	if (event == UPLOAD_EVENT_DONE)
+	{
+		sending = 0;
+		return;
+	}
+#ifdef DHT_TELEMETRY
+	if (event == UPLOAD_EVENT_SEND)
+	{
+		DHTtelemetry_report(); // signal quality over SWO, the ESP8266 link only carries readings
+	}
+#endif
+	if (sending)
+	{
+		return; // the previous transmission is still going
+	}
+	if (sensor_snapshot(&sample_record, &sample)
+			&& sample.tag == SENSOR_SAMPLE_FRESH) // only fresh readings are uploaded
+	{
+		buffer_length = fmt_fixed(buffer, units_temp(sample.reading.temp, TEMP_UNIT), 1, 0,
+				FMT_ALIGN_LEFT);
+		buffer[buffer_length++] = ',';
+		buffer_length += fmt_fixed(&buffer[buffer_length], sample.reading.RH, 1, 0,
+				FMT_ALIGN_LEFT);
+	}
+	if (buffer_length > 0 && HAL_UART_Transmit_IT(&huart1, upload_buffer, buffer_length) == HAL_OK)
+	{
+		sending = 1;
+	}
+}
+
+static void command_task_run(uint32_t event)
 {
-	if (htim->Instance == TIM5)
+	switch (event)
 	{
-		char buffer[50];
-		int buffer_length = sprintf(buffer, "%i.%i,%i.%i", temp_f_whole,
-				temp_f_frac, RH_whole, RH_frac);
-		HAL_UART_Transmit(&huart1, (uint8_t*) buffer, buffer_length, 100);
+	case COMMAND_SAMPLE:
+		sched_post(&scheduler, sample_task, SAMPLE_EVENT_TRIGGER);
+		break;
+	case COMMAND_UPLOAD:
+		sched_post(&scheduler, upload_task, UPLOAD_EVENT_SEND);
+		break;
+	case COMMAND_REPORT:
+		sched_report(&scheduler); // over SWO, the ESP8266 link only carries readings
+		wheel_report(&wheel, &sample_timer);
+		break;
+	default:
+		break; // line endings and unknown commands
 	}
 }
 /* USER CODE END 4 */
@@ -0,0 +1,302 @@
+/*
+ *  BME280Test.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  BME280 driver against the emulated sensor on the mock I2C bus and its DMA:
+ *  the compensation vector of the datasheet, a sweep of the integer formulas
+ *  against the floating point ones (datasheet section 8.1), the set-up of
+ *  the sensor, the fetch interval and the failures of the bus.
+ */
+
+#include "BME280.h"
+#include "BME280Device.h"
+#include "Test.h"
+#include <math.h>
+#include <string.h>
+
+	static BME280Device_HandleTypeDef sensor;
+	static I2C_HandleTypeDef hi2c1;
+	static BME280_HandleTypeDef hbme;
+
+	/* Calibration of the example of the BMP280 datasheet (section 3.12), humidity of a BME280 part */
+	static const BME280Device_CalibTypeDef datasheetCalib =
+	{
+		27504, 26435, -1000,
+		36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+		75, 362, 0, 313, 50, 30
+	};
+
+	/* Floating point compensation: temperature in C, pressure in Pa, humidity in % */
+	typedef struct
+	{
+		double temp;
+		double pressure;
+		double RH;
+	} Reference;
+
+	static Reference reference(const BME280Device_CalibTypeDef *c, int32_t adcP, int32_t adcT, int32_t adcH)
+	{
+		Reference r;
+		double var1 = ((double) adcT / 16384.0 - (double) c->T1 / 1024.0) * (double) c->T2;
+		double var2 = ((double) adcT / 131072.0 - (double) c->T1 / 8192.0);
+		var2 = var2 * var2 * (double) c->T3;
+		int32_t tFine = (int32_t) (var1 + var2);
+		r.temp = (var1 + var2) / 5120.0;
+
+		var1 = (double) tFine / 2.0 - 64000.0;
+		var2 = var1 * var1 * (double) c->P6 / 32768.0;
+		var2 = var2 + var1 * (double) c->P5 * 2.0;
+		var2 = var2 / 4.0 + (double) c->P4 * 65536.0;
+		var1 = ((double) c->P3 * var1 * var1 / 524288.0 + (double) c->P2 * var1) / 524288.0;
+		var1 = (1.0 + var1 / 32768.0) * (double) c->P1;
+		double p = 1048576.0 - (double) adcP;
+		p = (p - var2 / 4096.0) * 6250.0 / var1;
+		var1 = (double) c->P9 * p * p / 2147483648.0;
+		var2 = p * (double) c->P8 / 32768.0;
+		r.pressure = p + (var1 + var2 + (double) c->P7) / 16.0;
+
+		double h = (double) tFine - 76800.0;
+		h = ((double) adcH - ((double) c->H4 * 64.0 + (double) c->H5 / 16384.0 * h))
+				* ((double) c->H2 / 65536.0
+						* (1.0 + (double) c->H6 / 67108864.0 * h * (1.0 + (double) c->H3 / 67108864.0 * h)));
+		h = h * (1.0 - (double) c->H1 * h / 524288.0);
+		r.RH = h < 0.0 ? 0.0 : h > 100.0 ? 100.0 : h;
+		return r;
+	}
+
+	/* Fresh mock with the sensor as set up by the test, the driver initialized, its first burst not run yet */
+	static HAL_StatusTypeDef setup(void)
+	{
+		mock_reset();
+		bme280_device_attach(&sensor, BME280_ADDRESS_LOW);
+		memset(&hi2c1, 0, sizeof(hi2c1));
+		hi2c1.State = HAL_I2C_STATE_READY;
+		return BME280init(&hbme, &hi2c1, BME280_ADDRESS_LOW);
+	}
+
+	/* Sensor at power-on with a calibration and a conversion */
+	static void power_on(const BME280Device_CalibTypeDef *calib, int32_t adcP, int32_t adcT, int32_t adcH)
+	{
+		bme280_device_init(&sensor);
+		bme280_device_set_calib(&sensor, calib);
+		bme280_device_set_raw(&sensor, (uint32_t) adcP, (uint32_t) adcT, (uint16_t) adcH);
+	}
+
+	/* BME280update every 100 us until the transfer in progress is over */
+	static Sensor_StatusTypeDef finish(void)
+	{
+		Sensor_StatusTypeDef status;
+
+		for (int i = 0; i < 1000; i++)
+		{
+			status = BME280update(&hbme);
+			if (status != SENSOR_BUSY)
+			{
+				return status;
+			}
+			mock_run_ns(100000);
+		}
+		return SENSOR_BUSY;
+	}
+
+	/* A fetch of the result registers by trigger, the reading it cached */
+	static Sensor_StatusTypeDef fetch(Sensor_ReadingTypeDef *reading)
+	{
+		Sensor_StatusTypeDef status;
+
+		if (BME280trigger(&hbme) != SENSOR_BUSY)
+		{
+			return SENSOR_ERROR;
+		}
+		status = finish();
+		if (status == SENSOR_OK)
+		{
+			BME280last_reading(&hbme, reading, NULL);
+		}
+		return status;
+	}
+
+	/* Vector of the datasheet: adc_T 519888 is 25.08 C, adc_P 415148 is 100653 Pa */
+	static void test_datasheet_vector(void)
+	{
+		Sensor_ReadingTypeDef reading;
+		Reference r = reference(&datasheetCalib, 415148, 519888, 30000);
+
+		power_on(&datasheetCalib, 415148, 519888, 30000);
+		CHECK_EQUAL(HAL_OK, setup());
+		CHECK_EQUAL(SENSOR_OK, finish());
+		CHECK_EQUAL(SENSOR_SAMPLE_FRESH, BME280last_reading(&hbme, &reading, NULL));
+		CHECK_EQUAL(SENSOR_HAS_RH | SENSOR_HAS_TEMP | SENSOR_HAS_PRESSURE, reading.fields);
+		CHECK_EQUAL(251, reading.temp);
+		CHECK_EQUAL(100653, reading.pressure);
+		CHECK(fabs(r.temp - 25.08) < 0.01);
+		CHECK(fabs(r.pressure - 100653.27) < 0.1);
+		CHECK(fabs(reading.RH - r.RH * 10.0) <= 1.0);
+
+		/* The calibration was parsed from the burst as the device packed it */
+		CHECK_EQUAL(27504, hbme.calib.T1);
+		CHECK_EQUAL(-1000, hbme.calib.T3);
+		CHECK_EQUAL(-14600, hbme.calib.P8);
+		CHECK_EQUAL(313, hbme.calib.H4);
+		CHECK_EQUAL(50, hbme.calib.H5);
+		CHECK_EQUAL(30, hbme.calib.H6);
+	}
+
+	/* Integer formulas against the floating point ones over the range of the sensor */
+	static void test_reference_sweep(void)
+	{
+		static const BME280Device_CalibTypeDef negatives =
+		{
+			28150, 26720, 50,
+			37894, -10560, 3024, 7560, -150, -7, 9900, -10230, 4285,
+			75, 352, 0, 340, 0, 30
+		};
+		const BME280Device_CalibTypeDef *calibs[] = { &datasheetCalib, &negatives };
+		Sensor_ReadingTypeDef reading;
+		double worstT = 0;
+		double worstP = 0;
+		double worstH = 0;
+		int fetches = 0;
+
+		for (int c = 0; c < 2; c++)
+		{
+			power_on(calibs[c], 0x80000, 0x80000, 0x8000);
+			CHECK_EQUAL(HAL_OK, setup());
+			CHECK_EQUAL(SENSOR_IDLE, finish());		// calibration, results skipped
+
+			for (int32_t adcT = 330000; adcT <= 690000; adcT += 24000)
+			{
+				for (int32_t adcP = 250000; adcP <= 580000; adcP += 30000)
+				{
+					for (int32_t adcH = 18000; adcH <= 42000; adcH += 2000)
+					{
+						Reference r = reference(calibs[c], adcP, adcT, adcH);
+
+						bme280_device_set_raw(&sensor, (uint32_t) adcP, (uint32_t) adcT, (uint16_t) adcH);
+						if (fetch(&reading) != SENSOR_OK)
+						{
+							CHECK(0);
+							return;
+						}
+						fetches++;
+						worstT = fmax(worstT, fabs(reading.temp - r.temp * 10.0));
+						worstP = fmax(worstP, fabs(reading.pressure - r.pressure));
+						worstH = fmax(worstH, fabs(reading.RH - r.RH * 10.0));
+					}
+				}
+			}
+		}
+
+		bench_report("BME280 worst temperature error", worstT / 10.0, "C");
+		bench_report("BME280 worst pressure error", worstP, "Pa");
+		bench_report("BME280 worst humidity error", worstH / 10.0, "%");
+		CHECK_EQUAL(2 * 16 * 12 * 13, fetches);
+		CHECK(worstT <= 0.6);		// rounding to 0.1 C
+		CHECK(worstP <= 1.5);
+		CHECK(worstH <= 0.6);		// rounding to 0.1 %
+	}
+
+	/* Chip id checked, configuration written, burst from 0x88 to 0xFE */
+	static void test_init(void)
+	{
+		power_on(&datasheetCalib, 0x80000, 0x80000, 0x8000);
+		CHECK_EQUAL(HAL_OK, setup());
+		CHECK_EQUAL(BME280_CTRL_HUM_VALUE, sensor.regs[BME280_REG_CTRL_HUM]);
+		CHECK_EQUAL(BME280_CTRL_MEAS_VALUE, sensor.regs[BME280_REG_CTRL_MEAS]);
+		CHECK_EQUAL(BME280_CONFIG_VALUE, sensor.regs[BME280_REG_CONFIG]);
+		CHECK_EQUAL(3, sensor.stats.writes);
+		CHECK_EQUAL(HAL_I2C_STATE_BUSY_RX, HAL_I2C_GetState(&hi2c1));
+		CHECK_EQUAL(SENSOR_IDLE, finish());		// power-on results are skipped
+		CHECK_EQUAL(1 + BME280_BURST_SIZE, sensor.stats.reads);
+
+		/* BMP280 (no humidity), nothing at the address, wrong address */
+		sensor.regs[BME280_REG_ID] = 0x58;
+		CHECK_EQUAL(HAL_ERROR, setup());
+		sensor.regs[BME280_REG_ID] = BME280_CHIP_ID;
+		sensor.present = 0;
+		CHECK_EQUAL(HAL_ERROR, setup());
+		sensor.present = 1;
+		CHECK_EQUAL(HAL_ERROR, BME280init(&hbme, &hi2c1, BME280_ADDRESS_HIGH));
+		CHECK_EQUAL(HAL_OK, BME280init(&hbme, &hi2c1, BME280_ADDRESS_LOW));
+	}
+
+	/* One fetch of the 8 result registers every BME280_INTERVAL, never blocking */
+	static void test_interval(void)
+	{
+		Sensor_ReadingTypeDef reading;
+		uint32_t readings = 0;
+		uint32_t reads;
+		uint32_t age = 0;
+
+		power_on(&datasheetCalib, 415148, 519888, 30000);
+		CHECK_EQUAL(HAL_OK, setup());
+		reads = sensor.stats.reads;
+
+		for (int ms = 0; ms < 10000; ms++)
+		{
+			uint64_t before = mock_now_ns();
+			if (BME280update(&hbme) == SENSOR_OK)
+			{
+				readings++;
+			}
+			CHECK(mock_now_ns() - before < 20000);
+			mock_run_ns(1000000);
+		}
+		CHECK_EQUAL(10, readings);
+		CHECK_EQUAL(reads + BME280_BURST_SIZE + 9 * BME280_DATA_SIZE, sensor.stats.reads);
+		CHECK_EQUAL(SENSOR_SAMPLE_FRESH, BME280last_reading(&hbme, &reading, &age));
+		CHECK(age < BME280_INTERVAL);
+		CHECK_EQUAL(251, reading.temp);
+
+		/* Next fetch through the sensor interface: the rest of the interval, then due */
+		const Sensor_HandleTypeDef handle = { &BME280_sensor_driver, &hbme };
+		uint32_t next = sensor_next_conversion(&handle);
+		CHECK(next <= BME280_INTERVAL);
+		mock_run_ns(next * 1000000ULL);
+		CHECK_EQUAL(0, sensor_next_conversion(&handle));
+		CHECK_EQUAL(SENSOR_BUSY, BME280update(&hbme));
+		CHECK_EQUAL(BME280_INTERVAL, sensor_next_conversion(&handle));
+		mock_run_ns(400000000ULL);
+		CHECK_EQUAL(BME280_INTERVAL - 400, sensor_next_conversion(&handle));
+	}
+
+	/* A failed burst keeps the old reading and fetches the calibration again */
+	static void test_bus_error(void)
+	{
+		Sensor_ReadingTypeDef reading;
+
+		power_on(&datasheetCalib, 415148, 519888, 30000);
+		CHECK_EQUAL(HAL_OK, setup());
+		CHECK_EQUAL(SENSOR_OK, finish());
+
+		/* Sensor gone for one fetch */
+		sensor.present = 0;
+		CHECK_EQUAL(SENSOR_ERROR, fetch(&reading));
+		CHECK_EQUAL(SENSOR_SAMPLE_FRESH, BME280last_reading(&hbme, &reading, NULL));
+		CHECK_EQUAL(251, reading.temp);
+
+		/* A failed calibration burst is done again with the next fetch */
+		sensor.present = 1;
+		CHECK_EQUAL(HAL_OK, setup());
+		sensor.present = 0;
+		CHECK_EQUAL(SENSOR_ERROR, finish());
+		CHECK_EQUAL(0, hbme.calib.T1);
+		sensor.present = 1;
+		bme280_device_set_raw(&sensor, 415148, 519888 + 2000, 30000);
+		CHECK_EQUAL(SENSOR_OK, fetch(&reading));
+		CHECK_EQUAL(27504, hbme.calib.T1);
+		CHECK(reading.temp > 251);
+	}
+
+	int main(void)
+	{
+		test_datasheet_vector();
+		test_reference_sweep();
+		test_init();
+		test_interval();
+		test_bus_error();
+
+		return test_report("BME280Test");
+	}
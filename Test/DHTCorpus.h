@@ -0,0 +1,220 @@
+/*
+ *  DHTCorpus.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  Waveforms of DHT frames for the decoder tests and benchmarks, in the form
+ *  the driver captures them: the TIM2 count (1 us) at every edge of the
+ *  line, from the start of the sensor response (see "DHTDecode.h").
+ *
+ *  The records are modeled on the sensors and wiring the station meets:
+ *  DHT22 and DHT11 within the datasheet, AM2302 clones with fast and slow
+ *  oscillators, long cables whose slow rising edges shorten every high
+ *  pulse, and out of spec timings (0 bits longer than 40 us, a timer
+ *  running at half the rate), with the widths of every pulse drawn within
+ *  the range of its kind. Each record holds the frame it carries.
+ */
+
+#ifndef TEST_DHTCORPUS_H_
+#define TEST_DHTCORPUS_H_
+
+#include "DHTDecode.h"
+
+/*
+ * A captured frame
+ */
+typedef struct
+{
+	const char *name;
+	uint8_t data[5];						// Frame (RH, temp, check-sum)
+	uint32_t edges[DHT_DECODE_EDGES];		// TIM2 counts of the edges
+} DHTCorpus_RecordTypeDef;
+
+	static const DHTCorpus_RecordTypeDef dhtCorpus[] =
+	{
+		/* DHT22 within the datasheet */
+		{ "DHT22, 21.5 C 40.0 %", { 0x01, 0x90, 0x00, 0xD7, 0x68 },
+			{
+			1221616, 1221697, 1221775, 1221829, 1221856, 1221905, 1221932, 1221982,
+			1222010, 1222064, 1222090, 1222141, 1222169, 1222220, 1222247, 1222302,
+			1222328, 1222381, 1222451, 1222506, 1222576, 1222624, 1222652, 1222707,
+			1222733, 1222788, 1222860, 1222911, 1222937, 1222992, 1223020, 1223071,
+			1223099, 1223149, 1223177, 1223226, 1223253, 1223303, 1223330, 1223379,
+			1223405, 1223458, 1223484, 1223536, 1223563, 1223612, 1223638, 1223690,
+			1223717, 1223770, 1223798, 1223849, 1223919, 1223972, 1224044, 1224093,
+			1224120, 1224174, 1224246, 1224299, 1224326, 1224378, 1224450, 1224503,
+			1224572, 1224620, 1224690, 1224745, 1224773, 1224822, 1224892, 1224944,
+			1225013, 1225066, 1225092, 1225143, 1225213, 1225266, 1225293, 1225346,
+			1225373, 1225428, 1225456
+			} },
+		/* DHT22 within the datasheet, below zero */
+		{ "DHT22, -10.5 C 100.0 %", { 0x03, 0xE8, 0x80, 0x69, 0xD4 },
+			{
+			15733300, 15733379, 15733458, 15733507, 15733535, 15733585, 15733613, 15733664,
+			15733692, 15733745, 15733771, 15733824, 15733849, 15733898, 15733926, 15733979,
+			15734048, 15734101, 15734170, 15734219, 15734287, 15734339, 15734408, 15734457,
+			15734527, 15734579, 15734604, 15734657, 15734728, 15734777, 15734804, 15734855,
+			15734881, 15734933, 15734958, 15735008, 15735076, 15735129, 15735155, 15735204,
+			15735232, 15735285, 15735312, 15735362, 15735388, 15735441, 15735469, 15735519,
+			15735544, 15735593, 15735620, 15735672, 15735698, 15735747, 15735817, 15735870,
+			15735939, 15735988, 15736013, 15736063, 15736133, 15736185, 15736210, 15736262,
+			15736287, 15736337, 15736406, 15736455, 15736526, 15736577, 15736647, 15736696,
+			15736721, 15736771, 15736839, 15736891, 15736917, 15736970, 15737040, 15737089,
+			15737114, 15737167, 15737194
+			} },
+		/* DHT11 (integer bytes) */
+		{ "DHT11, 23 C 51 %", { 0x33, 0x00, 0x17, 0x00, 0x4A },
+			{
+			307911, 307995, 308079, 308132, 308157, 308208, 308233, 308285,
+			308356, 308407, 308479, 308533, 308557, 308612, 308639, 308693,
+			308761, 308812, 308881, 308937, 308961, 309014, 309038, 309092,
+			309120, 309175, 309200, 309256, 309284, 309335, 309361, 309414,
+			309440, 309490, 309518, 309572, 309599, 309653, 309679, 309734,
+			309758, 309808, 309879, 309934, 309958, 310013, 310081, 310134,
+			310204, 310260, 310332, 310383, 310411, 310464, 310488, 310541,
+			310565, 310619, 310647, 310698, 310722, 310772, 310796, 310852,
+			310879, 310929, 310956, 311006, 311033, 311085, 311153, 311203,
+			311228, 311279, 311303, 311359, 311431, 311481, 311505, 311561,
+			311630, 311680, 311705
+			} },
+		/* clone about 15 % fast */
+		{ "AM2302 clone, fast oscillator", { 0x02, 0x8F, 0x00, 0xC6, 0x57 },
+			{
+			973078738, 973078807, 973078877, 973078921, 973078943, 973078988, 973079012, 973079058,
+			973079082, 973079127, 973079148, 973079192, 973079213, 973079258, 973079282, 973079328,
+			973079386, 973079430, 973079453, 973079499, 973079561, 973079603, 973079625, 973079671,
+			973079692, 973079736, 973079758, 973079804, 973079866, 973079908, 973079967, 973080012,
+			973080072, 973080114, 973080176, 973080219, 973080243, 973080285, 973080308, 973080353,
+			973080375, 973080419, 973080443, 973080488, 973080510, 973080553, 973080576, 973080621,
+			973080643, 973080686, 973080708, 973080754, 973080816, 973080860, 973080919, 973080961,
+			973080985, 973081028, 973081051, 973081096, 973081119, 973081162, 973081224, 973081270,
+			973081331, 973081376, 973081397, 973081440, 973081461, 973081506, 973081565, 973081611,
+			973081634, 973081680, 973081739, 973081781, 973081805, 973081850, 973081911, 973081955,
+			973082016, 973082062, 973082124
+			} },
+		/* clone about 20 % slow */
+		{ "AM2302 clone, slow oscillator", { 0x01, 0x38, 0x01, 0x1C, 0x56 },
+			{
+			2327, 2424, 2518, 2580, 2613, 2672, 2706, 2764,
+			2797, 2859, 2893, 2951, 2984, 3042, 3075, 3133,
+			3166, 3225, 3308, 3370, 3404, 3465, 3499, 3557,
+			3640, 3701, 3784, 3845, 3933, 3991, 4025, 4087,
+			4119, 4178, 4210, 4271, 4305, 4366, 4398, 4457,
+			4492, 4553, 4588, 4649, 4684, 4743, 4776, 4837,
+			4870, 4929, 5015, 5074, 5107, 5165, 5200, 5259,
+			5293, 5355, 5438, 5500, 5585, 5644, 5729, 5790,
+			5825, 5886, 5921, 5980, 6015, 6076, 6163, 6221,
+			6256, 6317, 6403, 6462, 6496, 6555, 6639, 6700,
+			6785, 6846, 6878
+			} },
+		/* slow rising edges: highs short, lows long */
+		{ "DHT22 on 20 m of cable", { 0x03, 0x69, 0x00, 0x7A, 0xE6 },
+			{
+			268372480, 268372567, 268372657, 268372716, 268372736, 268372796, 268372815, 268372873,
+			268372891, 268372950, 268372967, 268373027, 268373046, 268373104, 268373122, 268373178,
+			268373242, 268373298, 268373360, 268373416, 268373435, 268373494, 268373554, 268373612,
+			268373673, 268373729, 268373748, 268373804, 268373867, 268373924, 268373944, 268374002,
+			268374019, 268374077, 268374139, 268374197, 268374217, 268374277, 268374297, 268374356,
+			268374376, 268374434, 268374453, 268374513, 268374530, 268374586, 268374605, 268374665,
+			268374685, 268374743, 268374762, 268374822, 268374840, 268374900, 268374963, 268375023,
+			268375084, 268375140, 268375204, 268375260, 268375323, 268375379, 268375396, 268375453,
+			268375514, 268375573, 268375590, 268375647, 268375710, 268375769, 268375830, 268375888,
+			268375949, 268376006, 268376024, 268376082, 268376102, 268376161, 268376223, 268376282,
+			268376346, 268376402, 268376422
+			} },
+		/* very slow rising edges, a 0 is almost nothing */
+		{ "DHT22 on 30 m of cable", { 0x01, 0xA4, 0x00, 0x24, 0xC9 },
+			{
+			1048576, 1048667, 1048753, 1048814, 1048827, 1048887, 1048898, 1048962,
+			1048974, 1049039, 1049049, 1049115, 1049126, 1049190, 1049202, 1049267,
+			1049278, 1049342, 1049394, 1049457, 1049509, 1049571, 1049581, 1049643,
+			1049695, 1049757, 1049767, 1049827, 1049839, 1049905, 1049959, 1050025,
+			1050035, 1050095, 1050109, 1050172, 1050182, 1050248, 1050261, 1050324,
+			1050337, 1050399, 1050411, 1050474, 1050484, 1050548, 1050561, 1050626,
+			1050640, 1050705, 1050716, 1050781, 1050794, 1050856, 1050870, 1050934,
+			1050990, 1051053, 1051063, 1051129, 1051140, 1051204, 1051256, 1051320,
+			1051333, 1051394, 1051405, 1051466, 1051520, 1051580, 1051637, 1051703,
+			1051713, 1051773, 1051787, 1051847, 1051903, 1051966, 1051978, 1052042,
+			1052054, 1052115, 1052168
+			} },
+		/* out of spec: every 0 above 40 us */
+		{ "Clone with long 0 bits", { 0x01, 0xF4, 0x00, 0xFA, 0xEF },
+			{
+			2147483392, 2147483472, 2147483556, 2147483607, 2147483653, 2147483704, 2147483749, 2147483803,
+			2147483847, 2147483898, 2147483942, 2147483995, 2147484041, 2147484095, 2147484139, 2147484189,
+			2147484236, 2147484287, 2147484380, 2147484430, 2147484522, 2147484572, 2147484666, 2147484719,
+			2147484813, 2147484865, 2147484958, 2147485008, 2147485054, 2147485108, 2147485202, 2147485252,
+			2147485297, 2147485347, 2147485391, 2147485445, 2147485492, 2147485542, 2147485589, 2147485642,
+			2147485688, 2147485741, 2147485787, 2147485837, 2147485884, 2147485936, 2147485983, 2147486034,
+			2147486079, 2147486129, 2147486176, 2147486229, 2147486325, 2147486376, 2147486471, 2147486522,
+			2147486614, 2147486665, 2147486757, 2147486809, 2147486903, 2147486955, 2147486999, 2147487050,
+			2147487146, 2147487197, 2147487243, 2147487297, 2147487392, 2147487443, 2147487539, 2147487591,
+			2147487683, 2147487735, 2147487779, 2147487830, 2147487923, 2147487975, 2147488071, 2147488122,
+			2147488216, 2147488266, 2147488362
+			} },
+		/* out of spec: every width halved */
+		{ "Timer at 2 us per count", { 0x02, 0x67, 0x80, 0x2A, 0x13 },
+			{
+			349525, 349566, 349606, 349632, 349645, 349669, 349682, 349707,
+			349720, 349746, 349759, 349785, 349799, 349824, 349838, 349863,
+			349899, 349923, 349936, 349961, 349974, 349999, 350034, 350060,
+			350094, 350118, 350131, 350156, 350170, 350195, 350229, 350253,
+			350288, 350315, 350350, 350376, 350410, 350437, 350451, 350478,
+			350492, 350519, 350533, 350559, 350573, 350599, 350612, 350637,
+			350651, 350676, 350690, 350714, 350727, 350754, 350768, 350794,
+			350829, 350856, 350870, 350897, 350931, 350955, 350968, 350992,
+			351028, 351055, 351069, 351093, 351106, 351131, 351144, 351169,
+			351183, 351210, 351246, 351272, 351285, 351311, 351324, 351349,
+			351383, 351409, 351443
+			} },
+		/* noisy: +-10 us on every high pulse */
+		{ "DHT22 with jittery highs", { 0x02, 0x44, 0x00, 0xB1, 0xF7 },
+			{
+			19088743, 19088821, 19088897, 19088950, 19088969, 19089023, 19089055, 19089103,
+			19089136, 19089185, 19089208, 19089258, 19089277, 19089323, 19089346, 19089395,
+			19089473, 19089520, 19089552, 19089600, 19089633, 19089680, 19089758, 19089809,
+			19089840, 19089886, 19089919, 19089967, 19090003, 19090054, 19090134, 19090182,
+			19090203, 19090259, 19090290, 19090339, 19090369, 19090415, 19090437, 19090490,
+			19090521, 19090571, 19090597, 19090647, 19090670, 19090722, 19090750, 19090801,
+			19090828, 19090874, 19090905, 19090959, 19091027, 19091078, 19091101, 19091157,
+			19091221, 19091269, 19091346, 19091397, 19091424, 19091471, 19091488, 19091537,
+			19091568, 19091620, 19091689, 19091738, 19091804, 19091858, 19091926, 19091973,
+			19092049, 19092103, 19092174, 19092224, 19092245, 19092297, 19092374, 19092420,
+			19092493, 19092543, 19092613
+			} },
+		/* TIM2 count wraps in the frame */
+		{ "DHT22 over the timer wrap", { 0x01, 0xC3, 0x00, 0xCB, 0x8F },
+			{
+			4294965248, 4294965329, 4294965410, 4294965460, 4294965488, 4294965537, 4294965564, 4294965616,
+			4294965643, 4294965693, 4294965719, 4294965771, 4294965799, 4294965849, 4294965875, 4294965926,
+			4294965953, 4294966003, 4294966073, 4294966125, 4294966196, 4294966247, 4294966318, 4294966367,
+			4294966393, 4294966444, 4294966472, 4294966522, 4294966548, 4294966598, 4294966626, 4294966675,
+			4294966744, 4294966796, 4294966865, 4294966914, 4294966942, 4294966991, 4294967017, 4294967066,
+			4294967094, 4294967143, 4294967170, 4294967220, 4294967246, 4294967295, 25, 76,
+			104, 155, 181, 231, 301, 351, 421, 470,
+			498, 550, 577, 629, 698, 749, 775, 824,
+			895, 945, 1016, 1068, 1138, 1187, 1213, 1262,
+			1289, 1338, 1365, 1415, 1484, 1533, 1602, 1654,
+			1724, 1775, 1844
+			} },
+		/* every bit 0: one cluster */
+		{ "DHT22, 0.0 C 0.0 %", { 0x00, 0x00, 0x00, 0x00, 0x00 },
+			{
+			8192, 8272, 8352, 8401, 8428, 8478, 8506, 8558,
+			8585, 8637, 8665, 8716, 8742, 8791, 8818, 8869,
+			8897, 8949, 8977, 9026, 9053, 9103, 9129, 9181,
+			9209, 9260, 9287, 9336, 9363, 9413, 9441, 9490,
+			9518, 9569, 9597, 9647, 9675, 9724, 9751, 9803,
+			9829, 9880, 9907, 9957, 9984, 10033, 10059, 10111,
+			10137, 10188, 10215, 10265, 10291, 10343, 10370, 10419,
+			10445, 10495, 10522, 10572, 10598, 10648, 10675, 10725,
+			10751, 10801, 10828, 10879, 10907, 10957, 10984, 11033,
+			11060, 11112, 11138, 11188, 11214, 11265, 11291, 11341,
+			11367, 11419, 11446
+			} }
+	};
+
+#define DHT_CORPUS_RECORDS (sizeof(dhtCorpus) / sizeof(dhtCorpus[0]))
+
+#endif /* TEST_DHTCORPUS_H_ */
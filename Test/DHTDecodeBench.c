@@ -0,0 +1,243 @@
+/*
+ *  DHTDecodeBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  DHTdecode (widths split in two clusters) against the fixed 40 us
+ *  threshold it replaced in receive_bit: bit-error rate over the corpus of
+ *  "DHTCorpus.h" and over synthetic families of frames (random data, every
+ *  high pulse drawn around the nominal width of its bit), and decodes per
+ *  second. Plain computation takes no time on the mock clock, so the
+ *  decoders run natively and are timed on the host.
+ */
+
+#include "DHTDecode.h"
+#include "DHTCorpus.h"
+#include "Test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FRAMES 2000
+#define ROUNDS 20
+
+	/*
+	 * Frames of a kind of sensor or wiring, widths in microseconds, each
+	 * high pulse up to +-jitter from its nominal width
+	 */
+	typedef struct
+	{
+		const char *name;
+		uint32_t low;
+		uint32_t zero;
+		uint32_t one;
+		uint32_t jitter;
+	} Family;
+
+	static const Family families[] =
+	{
+		{ "DHT22", 50, 27, 70, 2 },
+		{ "clone 15 % fast", 44, 23, 60, 2 },
+		{ "clone 20 % slow", 60, 33, 85, 3 },
+		{ "20 m of cable", 58, 19, 62, 2 },
+		{ "0 bits of 45 us", 52, 45, 94, 2 },
+		{ "timer at 2 us", 25, 13, 35, 1 },
+		{ "+-12 us of noise", 50, 27, 70, 12 },
+		{ "+-18 us of noise", 50, 27, 70, 18 }
+	};
+
+	static uint32_t edges[FRAMES][DHT_DECODE_EDGES];
+	static uint8_t frames[FRAMES][5];
+	static volatile uint32_t sink;
+
+	static double now_ns(void)
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1e9 + ts.tv_nsec;
+	}
+
+	/* The rule of the old receive_bit: still high after 40 us is a 1 */
+	__attribute__((noinline)) static void decode_fixed(const uint32_t *edges, uint8_t data[5])
+	{
+		for (int i = 0; i < 5; i++)
+		{
+			data[i] = 0;
+		}
+		for (int i = 0; i < DHT_DECODE_BITS; i++)
+		{
+			if (edges[4 + 2 * i] - edges[3 + 2 * i] > DHT_DECODE_THRESHOLD)
+			{
+				data[i / 8] |= (uint8_t) (0x80 >> (i % 8));
+			}
+		}
+	}
+
+	static uint32_t bit_errors(const uint8_t expected[5], const uint8_t actual[5])
+	{
+		uint32_t errors = 0;
+
+		for (int i = 0; i < 5; i++)
+		{
+			errors += (uint32_t) __builtin_popcount(expected[i] ^ actual[i]);
+		}
+		return errors;
+	}
+
+	/* FRAMES frames of random readings of a family, from random timer counts */
+	static void build(const Family *family)
+	{
+		for (int f = 0; f < FRAMES; f++)
+		{
+			uint8_t *data = frames[f];
+			uint32_t t = (uint32_t) rand() * 2654435761U;
+
+			for (int i = 0; i < 4; i++)
+			{
+				data[i] = (uint8_t) rand();
+			}
+			data[4] = (uint8_t) (data[0] + data[1] + data[2] + data[3]);
+
+			edges[f][0] = t;
+			edges[f][1] = t += 80;
+			edges[f][2] = t += 80;
+			for (int i = 0; i < DHT_DECODE_BITS; i++)
+			{
+				uint32_t width = (data[i / 8] >> (7 - i % 8)) & 1 ? family->one : family->zero;
+				width += rand() % (2 * family->jitter + 1) - family->jitter;
+				edges[f][3 + 2 * i] = t += family->low;
+				edges[f][4 + 2 * i] = t += width;
+			}
+		}
+	}
+
+	/* Bit errors of both decoders over the frames of build */
+	static void errors(uint32_t *adaptive, uint32_t *fixed)
+	{
+		DHTDecode_ResultTypeDef result;
+		uint8_t data[5];
+
+		*adaptive = 0;
+		*fixed = 0;
+		for (int f = 0; f < FRAMES; f++)
+		{
+			DHTdecode(edges[f], DHT_DECODE_EDGES, &result, 0);
+			*adaptive += bit_errors(frames[f], result.data);
+			decode_fixed(edges[f], data);
+			*fixed += bit_errors(frames[f], data);
+		}
+	}
+
+	/* Decodes per second of the frames of build, best of a few runs (the host may be busy) */
+	static double rate(int decoder)
+	{
+		DHTDecode_ResultTypeDef result;
+		double best = 1e18;
+
+		for (int run = 0; run < 5; run++)
+		{
+			double start = now_ns();
+			for (int round = 0; round < ROUNDS; round++)
+			{
+				for (int f = 0; f < FRAMES; f++)
+				{
+					if (decoder == 2)
+					{
+						decode_fixed(edges[f], result.data);
+					}
+					else
+					{
+						DHTdecode(edges[f], DHT_DECODE_EDGES, &result, (uint8_t) decoder);
+					}
+					sink += result.data[4];
+				}
+			}
+			double elapsed = now_ns() - start;
+			best = elapsed < best ? elapsed : best;
+		}
+		return ROUNDS * FRAMES * 1e9 / best;
+	}
+
+	/* Bit errors of both decoders over the corpus, record by record */
+	static void bench_corpus(void)
+	{
+		DHTDecode_ResultTypeDef result;
+		uint8_t data[5];
+		uint32_t adaptive = 0;
+		uint32_t fixed = 0;
+		char name[64];
+
+		printf("Bit errors of the corpus with the fixed 40 us threshold (of 40 per record)\n");
+		for (unsigned int r = 0; r < DHT_CORPUS_RECORDS; r++)
+		{
+			const DHTCorpus_RecordTypeDef *record = &dhtCorpus[r];
+			DHTdecode(record->edges, DHT_DECODE_EDGES, &result, 0);
+			decode_fixed(record->edges, data);
+			uint32_t recordFixed = bit_errors(record->data, data);
+			adaptive += bit_errors(record->data, result.data);
+			fixed += recordFixed;
+			snprintf(name, sizeof(name), "%s, fixed", record->name);
+			bench_report(name, recordFixed, "bits");
+		}
+		bench_report("corpus, adaptive", adaptive, "bits");
+		bench_report("corpus, fixed", fixed, "bits");
+
+		CHECK_EQUAL(0, adaptive);
+		CHECK(fixed > 0);
+	}
+
+	/* Bit-error rate of both decoders per family */
+	static void bench_families(void)
+	{
+		char name[64];
+
+		printf("Bit-error rate of %d random frames, per million bits\n", FRAMES);
+		srand(16);
+		for (unsigned int i = 0; i < sizeof(families) / sizeof(families[0]); i++)
+		{
+			const Family *family = &families[i];
+			uint32_t adaptive;
+			uint32_t fixed;
+
+			build(family);
+			errors(&adaptive, &fixed);
+			snprintf(name, sizeof(name), "%s, adaptive", family->name);
+			bench_report(name, adaptive * 1e6 / (FRAMES * 40.0), "ppm");
+			snprintf(name, sizeof(name), "%s, fixed 40 us", family->name);
+			bench_report(name, fixed * 1e6 / (FRAMES * 40.0), "ppm");
+
+			/* Never worse than the fixed threshold, no error within reach of the clusters */
+			CHECK(adaptive <= fixed);
+			if (family->jitter < 12)
+			{
+				CHECK_EQUAL(0, adaptive);
+			}
+		}
+	}
+
+	static void bench_rate(void)
+	{
+		build(&families[0]);
+		double adaptive = rate(0);
+		double confidence = rate(1);
+		double fixed = rate(2);
+
+		printf("Decodes per second (host)\n");
+		bench_report("DHTdecode", adaptive, "frames/s");
+		bench_report("DHTdecode with confidence", confidence, "frames/s");
+		bench_report("fixed 40 us threshold", fixed, "frames/s");
+
+		/* A frame every 2 s on the station: the clustering is far from the budget */
+		CHECK(adaptive > fixed / 20);
+	}
+
+	int main(void)
+	{
+		bench_corpus();
+		bench_families();
+		bench_rate();
+
+		return test_report("DHTDecodeBench");
+	}
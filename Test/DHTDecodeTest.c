@@ -0,0 +1,210 @@
+/*
+ *  DHTDecodeTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  DHTdecode on edge timestamps built from known frames: nominal, stretched
+ *  and shrunk widths, jitter, single-valued frames, the timer wrap, short
+ *  captures and the confidence of every bit; then every waveform of the
+ *  corpus of "DHTCorpus.h".
+ */
+
+#include "DHTDecode.h"
+#include "DHTCorpus.h"
+#include "Test.h"
+#include <stdlib.h>
+#include <string.h>
+
+	/*
+	 * Timestamps of a frame starting at start: response (80 / 80 us), then
+	 * per bit 50 us low and zero or one us high, plus up to +-jitter us on
+	 * every high pulse
+	 */
+	static void build(uint32_t *edges, const uint8_t data[5], uint32_t start, uint32_t zero, uint32_t one,
+			uint32_t jitter)
+	{
+		uint32_t t = start;
+
+		edges[0] = t;
+		edges[1] = t += 80;
+		edges[2] = t += 80;
+		for (int i = 0; i < DHT_DECODE_BITS; i++)
+		{
+			uint32_t width = (data[i / 8] >> (7 - i % 8)) & 1 ? one : zero;
+			if (jitter)
+			{
+				width += rand() % (2 * jitter + 1) - jitter;
+			}
+			edges[3 + 2 * i] = t += 50;
+			edges[4 + 2 * i] = t += width;
+		}
+	}
+
+	static void check_frame(const uint8_t expected[5], const DHTDecode_ResultTypeDef *result)
+	{
+		for (int i = 0; i < 5; i++)
+		{
+			CHECK_EQUAL(expected[i], result->data[i]);
+		}
+	}
+
+	/* Nominal widths: clusters on 26 and 70 us, threshold half way */
+	static void test_nominal(void)
+	{
+		static const uint8_t data[5] = { 0x02, 0x8C, 0x80, 0x65, 0x73 };
+		uint32_t edges[DHT_DECODE_EDGES];
+		DHTDecode_ResultTypeDef result;
+
+		build(edges, data, 1000, 26, 70, 0);
+		CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 1));
+		check_frame(data, &result);
+		CHECK_EQUAL(26, result.zeroWidth);
+		CHECK_EQUAL(70, result.oneWidth);
+		CHECK_EQUAL(48, result.threshold);
+		for (int i = 0; i < DHT_DECODE_BITS; i++)
+		{
+			CHECK_EQUAL(255, result.confidence[i]);
+		}
+	}
+
+	/* Widths a fixed 40 us threshold gets wrong, both ways */
+	static void test_stretched(void)
+	{
+		static const uint8_t data[5] = { 0x03, 0x09, 0x00, 0x87, 0x93 };
+		uint32_t edges[DHT_DECODE_EDGES];
+		DHTDecode_ResultTypeDef result;
+
+		build(edges, data, 0, 45, 95, 0);
+		CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 0));
+		check_frame(data, &result);
+		CHECK_EQUAL(70, result.threshold);
+
+		build(edges, data, 0, 13, 35, 0);
+		CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 0));
+		check_frame(data, &result);
+		CHECK_EQUAL(24, result.threshold);
+	}
+
+	/* +-8 us on every pulse, many frames */
+	static void test_jitter(void)
+	{
+		uint32_t edges[DHT_DECODE_EDGES];
+		uint8_t data[5];
+		DHTDecode_ResultTypeDef result;
+
+		srand(1);
+		for (int frame = 0; frame < 1000; frame++)
+		{
+			for (int i = 0; i < 5; i++)
+			{
+				data[i] = (uint8_t) rand();
+			}
+			data[0] |= 0x80;	// at least one bit of each value
+			data[4] &= 0xFE;
+			build(edges, data, (uint32_t) rand(), 27, 70, 8);
+			CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 0));
+			if (memcmp(data, result.data, 5) != 0)
+			{
+				check_frame(data, &result);
+				break;
+			}
+		}
+	}
+
+	/* Every bit the same: one cluster, decided against the nominal threshold */
+	static void test_single_value(void)
+	{
+		static const uint8_t zeros[5] = { 0 };
+		static const uint8_t ones[5] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+		uint32_t edges[DHT_DECODE_EDGES];
+		DHTDecode_ResultTypeDef result;
+
+		build(edges, zeros, 0, 27, 70, 2);
+		CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 0));
+		check_frame(zeros, &result);
+		CHECK_EQUAL(DHT_DECODE_THRESHOLD, result.threshold);
+
+		build(edges, ones, 0, 27, 70, 2);
+		CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 0));
+		check_frame(ones, &result);
+		CHECK_EQUAL(DHT_DECODE_THRESHOLD, result.threshold);
+	}
+
+	/* Timer counter wrapping in the middle of the frame */
+	static void test_timer_wrap(void)
+	{
+		static const uint8_t data[5] = { 0x01, 0xF4, 0x00, 0xFA, 0xEF };
+		uint32_t edges[DHT_DECODE_EDGES];
+		DHTDecode_ResultTypeDef result;
+
+		build(edges, data, UINT32_MAX - 2000, 26, 70, 0);
+		CHECK(edges[DHT_DECODE_EDGES - 1] < edges[0]);
+		CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 0));
+		check_frame(data, &result);
+	}
+
+	/* A capture cut short is not decoded */
+	static void test_short_capture(void)
+	{
+		static const uint8_t data[5] = { 0x02, 0x8C, 0x80, 0x65, 0x73 };
+		uint32_t edges[DHT_DECODE_EDGES];
+		DHTDecode_ResultTypeDef result;
+
+		build(edges, data, 0, 26, 70, 0);
+		CHECK_EQUAL(0, DHTdecode(edges, DHT_DECODE_EDGES - 1, &result, 0));
+		CHECK_EQUAL(0, DHTdecode(edges, 0, &result, 0));
+	}
+
+	/* Confidence falls towards the threshold */
+	static void test_confidence(void)
+	{
+		static const uint8_t data[5] = { 0xF0, 0xF0, 0xF0, 0xF0, 0xC0 };
+		uint32_t edges[DHT_DECODE_EDGES];
+		DHTDecode_ResultTypeDef result;
+
+		build(edges, data, 0, 26, 70, 0);
+		edges[4] = edges[3] + 50;		// bit 0, a 1 just above the threshold
+		edges[4 + 2 * 4] = edges[3 + 2 * 4] + 38;	// bit 4, a 0 a little below it
+		CHECK_EQUAL(1, DHTdecode(edges, DHT_DECODE_EDGES, &result, 1));
+		CHECK_EQUAL(0xF0, result.data[0]);
+		CHECK(result.confidence[0] < 64);
+		CHECK(result.confidence[4] > 64);
+		CHECK(result.confidence[4] < 255);
+		CHECK_EQUAL(255, result.confidence[1]);
+		CHECK_EQUAL(255, result.confidence[5]);
+	}
+
+	/* Every record of the corpus gives its frame, and its check-sum holds */
+	static void test_corpus(void)
+	{
+		DHTDecode_ResultTypeDef result;
+
+		for (unsigned int r = 0; r < DHT_CORPUS_RECORDS; r++)
+		{
+			const DHTCorpus_RecordTypeDef *record = &dhtCorpus[r];
+			uint8_t sum = (uint8_t) (record->data[0] + record->data[1] + record->data[2] + record->data[3]);
+
+			CHECK_EQUAL(record->data[4], sum);
+			CHECK_EQUAL(1, DHTdecode(record->edges, DHT_DECODE_EDGES, &result, 0));
+			if (memcmp(record->data, result.data, 5) != 0)
+			{
+				CHECK_TEXT(record->name, "");
+				check_frame(record->data, &result);
+			}
+		}
+	}
+
+	int main(void)
+	{
+		test_nominal();
+		test_stretched();
+		test_jitter();
+		test_single_value();
+		test_timer_wrap();
+		test_short_capture();
+		test_confidence();
+		test_corpus();
+
+		return test_report("DHTDecodeTest");
+	}
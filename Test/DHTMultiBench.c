@@ -0,0 +1,267 @@
+/*
+ *  DHTMultiBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  DHTmulti_decode against decoding the same port samples one line at a
+ *  time, for 1 to 16 lines: plain computation takes no time on the mock
+ *  clock, so both run natively and are timed on the host, the ratio is what
+ *  carries over to the target. Then six emulated DHT22 sensors on GPIOA read
+ *  on the mock clock, all at once by DHTmulti_poll and one after the other
+ *  by DHTreceive_data: time the core is blocked and time of the round.
+ */
+
+#include "DHTMulti.h"
+#include "DHT22.h"
+#include "Test.h"
+#include <stdio.h>
+#include <time.h>
+
+#define ROUNDS 200
+#define SENSORS 6
+
+	static uint16_t samples[DHT_MULTI_SAMPLES];
+	static DHT22_HandleTypeDef sensors[SENSORS];
+	static TIM_HandleTypeDef htim2;
+	static DHTMulti_HandleTypeDef multi;
+	static volatile uint32_t sink;
+
+	static double now_ns(void)
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1e9 + ts.tv_nsec;
+	}
+
+	/* Port samples of a nominal frame on every line, line l answering l us later */
+	static void build(void)
+	{
+		for (uint32_t k = 0; k < DHT_MULTI_SAMPLES; k++)
+		{
+			samples[k] = 0;
+		}
+		for (int l = 0; l < DHT_MULTI_LINES; l++)
+		{
+			uint8_t data[5] = { (uint8_t) l, 0x8C, 0x00, (uint8_t) (0xE1 + l), 0 };
+			uint32_t edges[DHT22_EDGES];
+			uint32_t t = 20 + l;
+			uint16_t count = 0;
+			uint16_t next = 0;
+
+			data[4] = (uint8_t) (data[0] + data[1] + data[2] + data[3]);
+			edges[count++] = t;
+			edges[count++] = t += 80;
+			edges[count++] = t += 80;
+			for (int i = 0; i < 40; i++)
+			{
+				edges[count++] = t += 50;
+				edges[count++] = t += (data[i / 8] >> (7 - i % 8)) & 1 ? 70 : 26;
+			}
+			edges[count++] = t += 50;
+			for (uint32_t k = 0; k < DHT_MULTI_SAMPLES; k++)
+			{
+				while (next < count && edges[next] <= k * DHT_MULTI_SAMPLE_US)
+				{
+					next++;
+				}
+				if ((next & 1) == 0)
+				{
+					samples[k] |= (uint16_t) (1U << l);
+				}
+			}
+		}
+	}
+
+	/*
+	 * One line from the port samples, the way a single-sensor decoder walks
+	 * them: the length of every high pulse against the threshold
+	 */
+	__attribute__((noinline)) static uint8_t decode_line(const uint16_t *samples, uint32_t count, int line,
+			uint8_t frame[5])
+	{
+		uint64_t bits = 0;
+		uint32_t high = 0;
+		uint8_t falls = 0;
+		uint8_t previous = count ? (samples[0] >> line) & 1 : 0;
+
+		for (uint32_t k = 0; k < count; k++)
+		{
+			uint8_t level = (samples[k] >> line) & 1;
+			if (previous && !level)
+			{
+				bits = (bits << 1) | (high > DHT_MULTI_BIT_THRESHOLD);
+				falls++;
+			}
+			high = level ? high + 1 : 0;
+			previous = level;
+		}
+		for (int i = 0; i < 5; i++)
+		{
+			frame[i] = (uint8_t) (bits >> (32 - 8 * i));
+		}
+		return falls >= 42;
+	}
+
+	/* ns per read of the lines in pins, all at once */
+	static double run_multi(uint16_t pins)
+	{
+		uint8_t frames[DHT_MULTI_LINES][5];
+		DHT_StatusTypeDef status[DHT_MULTI_LINES];
+		double start = now_ns();
+
+		for (int round = 0; round < ROUNDS; round++)
+		{
+			DHTmulti_decode(samples, DHT_MULTI_SAMPLES, pins, frames, status);
+			sink += frames[0][4] + frames[__builtin_ctz(pins)][4];
+		}
+		return (now_ns() - start) / ROUNDS;
+	}
+
+	/* ns per read of the lines in pins, one after the other */
+	static double run_lines(uint16_t pins)
+	{
+		uint8_t frame[5];
+		double start = now_ns();
+
+		for (int round = 0; round < ROUNDS; round++)
+		{
+			for (int line = 0; line < DHT_MULTI_LINES; line++)
+			{
+				if ((pins >> line) & 1)
+				{
+					sink += decode_line(samples, DHT_MULTI_SAMPLES, line, frame) + frame[4];
+				}
+			}
+		}
+		return (now_ns() - start) / ROUNDS;
+	}
+
+	/* Both decoders give the frames of build */
+	static void check_decoders(void)
+	{
+		uint8_t frames[DHT_MULTI_LINES][5];
+		DHT_StatusTypeDef status[DHT_MULTI_LINES];
+		uint8_t frame[5];
+
+		DHTmulti_decode(samples, DHT_MULTI_SAMPLES, 0xFFFF, frames, status);
+		for (int l = 0; l < DHT_MULTI_LINES; l++)
+		{
+			CHECK_EQUAL(DHT_OK, status[l]);
+			CHECK_EQUAL(1, decode_line(samples, DHT_MULTI_SAMPLES, l, frame));
+			for (int i = 0; i < 5; i++)
+			{
+				CHECK_EQUAL(frame[i], frames[l][i]);
+			}
+			CHECK_EQUAL(0xE1 + l, frames[l][3]);
+		}
+	}
+
+	static void bench_decode(void)
+	{
+		static const int counts[] = { 1, 4, 8, 16 };
+		char name[64];
+		double multi16 = 0;
+		double lines16 = 0;
+
+		build();
+		check_decoders();
+		printf("Decode of a read (%u samples every %u us)\n", DHT_MULTI_SAMPLES, DHT_MULTI_SAMPLE_US);
+		for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+		{
+			uint16_t pins = (uint16_t) ((1UL << counts[c]) - 1);
+			/* Best of a few runs, the host may be busy */
+			double bitSliced = 1e12;
+			double oneByOne = 1e12;
+			for (int i = 0; i < 5; i++)
+			{
+				double t = run_multi(pins);
+				bitSliced = t < bitSliced ? t : bitSliced;
+				t = run_lines(pins);
+				oneByOne = t < oneByOne ? t : oneByOne;
+			}
+			snprintf(name, sizeof(name), "DHTmulti_decode, %d lines", counts[c]);
+			bench_report(name, bitSliced / 1000, "host us per read");
+			snprintf(name, sizeof(name), "one line at a time, %d lines", counts[c]);
+			bench_report(name, oneByOne / 1000, "host us per read");
+			multi16 = bitSliced;
+			lines16 = oneByOne;
+		}
+
+		/* All lines of the port for the cost of a few */
+		CHECK(multi16 < lines16 / 2);
+	}
+
+	/* Fresh mock, the sensors on PA0 to PA5 */
+	static void setup(void)
+	{
+		mock_reset();
+		mock_tim_init(&htim2, TIM2, 83, 0xFFFFFFFF);
+		for (int s = 0; s < SENSORS; s++)
+		{
+			dht22_init(&sensors[s]);
+			dht22_attach(&sensors[s], GPIOA, (uint16_t) (1U << s));
+			dht22_set_reading(&sensors[s], (int16_t) (450 + s), (int16_t) (200 + s));
+		}
+	}
+
+	static void bench_bus(void)
+	{
+		uint64_t blocked = 0;
+		uint64_t start;
+		int16_t RH;
+		int16_t temp;
+
+		/* All sensors at once: the start pulse does not block, the sampling does */
+		setup();
+		DHTmulti_init(&multi, GPIOA, (1U << SENSORS) - 1, &htim2);
+		start = mock_now_ns();
+		DHTmulti_start_read(&multi);
+		while (1)
+		{
+			uint64_t call = mock_now_ns();
+			DHT_StatusTypeDef status = DHTmulti_poll(&multi);
+			blocked += mock_now_ns() - call;
+			if (status != DHT_BUSY)
+			{
+				break;
+			}
+			mock_run_ns(100000);
+		}
+		double multiRound = (mock_now_ns() - start) / 1e6;
+		double multiBlocked = blocked / 1e6;
+		for (int s = 0; s < SENSORS; s++)
+		{
+			CHECK_EQUAL(DHT_OK, multi.status[s]);
+			CHECK_EQUAL(450 + s, multi.RH[s]);
+		}
+
+		/* One after the other, DHT22 start pulses (DHT_START_PULSE) */
+		setup();
+		start = mock_now_ns();
+		for (int s = 0; s < SENSORS; s++)
+		{
+			DHTinit(GPIOA, 1U << s, &htim2);
+			DHTset_model(DHT_MODEL_DHT22);
+			CHECK_EQUAL(DHT_OK, DHTreceive_data(&RH, &temp));
+			CHECK_EQUAL(200 + s, temp);
+		}
+		double sequential = (mock_now_ns() - start) / 1e6;
+
+		printf("Read of %d DHT22 on one port\n", SENSORS);
+		bench_report("DHTmulti, core blocked", multiBlocked, "ms");
+		bench_report("DHTmulti, round (18 ms start pulse)", multiRound, "ms");
+		bench_report("DHTreceive_data one by one, core blocked", sequential, "ms");
+
+		CHECK(multiBlocked < 6.5);
+		CHECK(multiBlocked * 3 < sequential);
+	}
+
+	int main(void)
+	{
+		bench_decode();
+		bench_bus();
+
+		return test_report("DHTMultiBench");
+	}
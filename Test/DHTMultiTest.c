@@ -0,0 +1,267 @@
+/*
+ *  DHTMultiTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  DHTmulti_decode on port samples built from known frames, one per line,
+ *  each with its own latency, bit widths and jitter, lines that do not
+ *  answer or stop in the middle of a frame and a capture cut short; then
+ *  DHTmulti_start_read and DHTmulti_poll against emulated DHT22 sensors on
+ *  six pins of GPIOA, TIM2 at 1 us per tick.
+ */
+
+#include "DHTMulti.h"
+#include "DHT22.h"
+#include "Test.h"
+#include <stdlib.h>
+
+/* Emulated sensors of the poll test, on PA0 to PA5 */
+#define SENSORS 6
+
+	/* Waveform of one line, times in microseconds from the release of the lines */
+	typedef struct
+	{
+		uint8_t data[5];
+		uint8_t respond;		// 0: the line stays high
+		uint8_t bits;			// bits sent before the line is let go
+		uint32_t latency;		// release to the response
+		uint32_t zero;			// high of a 0 bit
+		uint32_t one;			// high of a 1 bit
+		uint32_t jitter;		// up to +-jitter us on every high pulse
+	} Line;
+
+	static uint16_t samples[DHT_MULTI_SAMPLES];
+	static DHT22_HandleTypeDef sensors[SENSORS];
+	static TIM_HandleTypeDef htim2;
+	static DHTMulti_HandleTypeDef multi;
+
+	/* Frame of a reading, as a DHT22 encodes it */
+	static void encode(uint8_t data[5], int16_t RH, int16_t temp)
+	{
+		uint16_t magnitude = temp < 0 ? (uint16_t) (0x8000 | -temp) : (uint16_t) temp;
+
+		data[0] = (uint8_t) (RH >> 8);
+		data[1] = (uint8_t) RH;
+		data[2] = (uint8_t) (magnitude >> 8);
+		data[3] = (uint8_t) magnitude;
+		data[4] = (uint8_t) (data[0] + data[1] + data[2] + data[3]);
+	}
+
+	/* Edges of the line (falling on even indexes), as the sensor sends them */
+	static uint16_t edges_of(const Line *line, uint32_t edges[DHT22_EDGES])
+	{
+		uint32_t t = line->latency;
+		uint16_t count = 0;
+
+		if (!line->respond)
+		{
+			return 0;
+		}
+		edges[count++] = t;
+		edges[count++] = t += 80;
+		edges[count++] = t += 80;
+		for (int i = 0; i < line->bits && i < 40; i++)
+		{
+			uint32_t width = (line->data[i / 8] >> (7 - i % 8)) & 1 ? line->one : line->zero;
+			if (line->jitter)
+			{
+				width += rand() % (2 * line->jitter + 1) - line->jitter;
+			}
+			edges[count++] = t += 50;
+			edges[count++] = t += width;
+		}
+		edges[count++] = t += 50;
+		return count;
+	}
+
+	/* Port samples every DHT_MULTI_SAMPLE_US of the lines in pins (the others stay low) */
+	static void build(const Line lines[DHT_MULTI_LINES], uint16_t pins)
+	{
+		for (uint32_t k = 0; k < DHT_MULTI_SAMPLES; k++)
+		{
+			samples[k] = 0;
+		}
+		for (int l = 0; l < DHT_MULTI_LINES; l++)
+		{
+			uint32_t edges[DHT22_EDGES];
+			uint16_t count;
+			uint16_t next = 0;
+
+			if (((pins >> l) & 1) == 0)
+			{
+				continue;
+			}
+			count = edges_of(&lines[l], edges);
+			for (uint32_t k = 0; k < DHT_MULTI_SAMPLES; k++)
+			{
+				while (next < count && edges[next] <= k * DHT_MULTI_SAMPLE_US)
+				{
+					next++;
+				}
+				if ((next & 1) == 0)
+				{
+					samples[k] |= (uint16_t) (1U << l);
+				}
+			}
+		}
+	}
+
+	/* Line l of a full, nominal frame of a reading derived from l */
+	static Line nominal(int l)
+	{
+		Line line = { { 0 }, 1, 40, 30, 26, 70, 0 };
+
+		encode(line.data, (int16_t) (100 + 55 * l), (int16_t) (l & 1 ? -37 * l : 41 * l));
+		return line;
+	}
+
+	/* Sixteen lines, each with its own latency, widths and jitter */
+	static void test_decode_lines(void)
+	{
+		Line lines[DHT_MULTI_LINES];
+		uint8_t frames[DHT_MULTI_LINES][5];
+		DHT_StatusTypeDef status[DHT_MULTI_LINES];
+
+		srand(14);
+		for (int l = 0; l < DHT_MULTI_LINES; l++)
+		{
+			lines[l] = nominal(l);
+			lines[l].latency = 20 + (l * 7) % 21;
+			lines[l].zero = 22 + l % 8;
+			lines[l].one = 62 + (l * 5) % 16;
+			lines[l].jitter = l % 4;
+		}
+		build(lines, 0xFFFF);
+		DHTmulti_decode(samples, DHT_MULTI_SAMPLES, 0xFFFF, frames, status);
+		for (int l = 0; l < DHT_MULTI_LINES; l++)
+		{
+			CHECK_EQUAL(DHT_OK, status[l]);
+			for (int i = 0; i < 5; i++)
+			{
+				CHECK_EQUAL(lines[l].data[i], frames[l][i]);
+			}
+		}
+	}
+
+	/* Silent and cut lines, lines outside pins left alone, captures cut short */
+	static void test_decode_faults(void)
+	{
+		Line lines[DHT_MULTI_LINES];
+		uint8_t frames[DHT_MULTI_LINES][5];
+		DHT_StatusTypeDef status[DHT_MULTI_LINES];
+
+		for (int l = 0; l < DHT_MULTI_LINES; l++)
+		{
+			lines[l] = nominal(l);
+			status[l] = DHT_IDLE;
+		}
+		lines[0].respond = 0;
+		lines[1].bits = 12;
+		lines[2].bits = 39;
+		build(lines, 0xFFFF);
+
+		/* Lines 8 to 15 toggle, they are not decoded */
+		DHTmulti_decode(samples, DHT_MULTI_SAMPLES, 0x00FF, frames, status);
+		CHECK_EQUAL(DHT_NO_RESPONSE, status[0]);
+		CHECK_EQUAL(DHT_TIMEOUT, status[1]);
+		CHECK_EQUAL(DHT_TIMEOUT, status[2]);
+		for (int l = 3; l < 8; l++)
+		{
+			CHECK_EQUAL(DHT_OK, status[l]);
+			CHECK_EQUAL(lines[l].data[4], frames[l][4]);
+		}
+		for (int l = 8; l < DHT_MULTI_LINES; l++)
+		{
+			CHECK_EQUAL(DHT_IDLE, status[l]);
+		}
+
+		/* 2.4 ms of samples hold about half of every frame */
+		DHTmulti_decode(samples, 600, 0x00F8, frames, status);
+		for (int l = 3; l < 8; l++)
+		{
+			CHECK_EQUAL(DHT_TIMEOUT, status[l]);
+		}
+
+		/* Nothing sampled: no line answered */
+		DHTmulti_decode(samples, 0, 0x00F8, frames, status);
+		for (int l = 3; l < 8; l++)
+		{
+			CHECK_EQUAL(DHT_NO_RESPONSE, status[l]);
+		}
+	}
+
+	/* Fresh mock, the sensors on PA0 to PA5 */
+	static void setup(void)
+	{
+		mock_reset();
+		mock_tim_init(&htim2, TIM2, 83, 0xFFFFFFFF);
+		for (int s = 0; s < SENSORS; s++)
+		{
+			dht22_init(&sensors[s]);
+			dht22_attach(&sensors[s], GPIOA, (uint16_t) (1U << s));
+			dht22_set_reading(&sensors[s], (int16_t) (300 + 101 * s), (int16_t) (s & 1 ? -12 * s : 215 + s));
+		}
+		DHTmulti_init(&multi, GPIOA, (1U << SENSORS) - 1, &htim2);
+	}
+
+	/* One start pulse for all sensors, every frame sampled in the same 6 ms */
+	static void test_poll(void)
+	{
+		DHT_StatusTypeDef status = DHT_BUSY;
+
+		setup();
+		sensors[1].scale = 115;
+		sensors[2].scale = 90;
+		sensors[4].respond = 0;
+		sensors[5].data[4]++;
+		CHECK_EQUAL(DHT_IDLE, DHTmulti_poll(&multi));
+
+		DHTmulti_start_read(&multi);
+		CHECK_EQUAL(DHT_BUSY, DHTmulti_poll(&multi));
+		mock_run_ns(DHT11_START_PULSE * 1000ULL - 100000);
+		CHECK_EQUAL(DHT_BUSY, DHTmulti_poll(&multi));
+		for (int i = 0; i < 100 && status == DHT_BUSY; i++)
+		{
+			mock_run_ns(100000);
+			status = DHTmulti_poll(&multi);
+		}
+		CHECK_EQUAL(DHT_OK, status);
+		CHECK_EQUAL(DHT_IDLE, DHTmulti_poll(&multi));
+
+		for (int s = 0; s < 4; s++)
+		{
+			CHECK_EQUAL(DHT_OK, multi.status[s]);
+			CHECK_EQUAL(300 + 101 * s, multi.RH[s]);
+			CHECK_EQUAL(s & 1 ? -12 * s : 215 + s, multi.temp[s]);
+		}
+		CHECK_EQUAL(DHT_NO_RESPONSE, multi.status[4]);
+		CHECK_EQUAL(DHT_CHECKSUM, multi.status[5]);
+
+		for (int s = 0; s < SENSORS; s++)
+		{
+			CHECK_EQUAL(1, sensors[s].stats.pulses);
+			CHECK_EQUAL(s == 4 ? 0 : 1, sensors[s].stats.frames);
+			CHECK_EQUAL(0, sensors[s].stats.contentions);
+			CHECK_EQUAL(1, dht22_line(&sensors[s]));		// idle high
+		}
+
+		/* A second read gets the new readings */
+		dht22_set_reading(&sensors[0], 999, -400);
+		DHTmulti_start_read(&multi);
+		mock_run_ns(DHT11_START_PULSE * 1000ULL);
+		CHECK_EQUAL(DHT_OK, DHTmulti_poll(&multi));
+		CHECK_EQUAL(DHT_OK, multi.status[0]);
+		CHECK_EQUAL(999, multi.RH[0]);
+		CHECK_EQUAL(-400, multi.temp[0]);
+		CHECK_EQUAL(2, sensors[0].stats.frames);
+	}
+
+	int main(void)
+	{
+		test_decode_lines();
+		test_decode_faults();
+		test_poll();
+
+		return test_report("DHTMultiTest");
+	}
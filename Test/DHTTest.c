@@ -0,0 +1,544 @@
+/*
+ *  DHTTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  DHTemp against the emulated DHT22 on PA11, TIM2 at 1 us per tick and the
+ *  EXTI interrupt of the line as main.c sets them up. The drivers are built
+ *  with DHT_TELEMETRY, so the telemetry hooks run in every test.
+ */
+
+#include "DHTemp.h"
+#include "DHT22.h"
+#include "Test.h"
+
+	static DHT22_HandleTypeDef sensor;
+	static TIM_HandleTypeDef htim2;
+	static uint64_t worstReadNs;	// longest DHTreceive_data of test_blocking_read
+	static uint64_t worstPollNs;	// longest DHTpoll of test_state_machine
+
+	void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+	{
+		if (GPIO_Pin == GPIO_PIN_11)
+		{
+			DHTcapture_edge();
+		}
+	}
+
+	/* Fresh mock and sensor, the driver initialized as in main (model not known yet) */
+	static void setup(void)
+	{
+		mock_reset();
+		dht22_init(&sensor);
+		dht22_attach(&sensor, GPIOA, GPIO_PIN_11);
+		mock_tim_init(&htim2, TIM2, 83, 0xFFFFFFFF);
+		DHTinit(GPIOA, GPIO_PIN_11, &htim2);
+		DHTset_model(DHT_MODEL_AUTO);
+	}
+
+	/* A read with DHTstart_read and DHTpoll, polled every pollUs */
+	static DHT_StatusTypeDef read_async(int16_t *RH, int16_t *temp, uint32_t pollUs)
+	{
+		DHTstart_read();
+		for (int i = 0; i < 100000; i++)
+		{
+			DHT_StatusTypeDef status = DHTpoll(RH, temp);
+			if (status != DHT_BUSY)
+			{
+				return status;
+			}
+			mock_run_ns(pollUs * 1000ULL);
+		}
+		return DHT_BUSY;
+	}
+
+	/* Edges timestamped in the EXTI interrupt, however slow the polling */
+	static void test_edge_capture(void)
+	{
+		static const uint32_t pollUs[] = { 10, 1000, 5000 };
+		int16_t RH = 0;
+		int16_t temp = 0;
+
+		setup();
+		for (int i = 0; i < 3; i++)
+		{
+			dht22_set_reading(&sensor, 652 + i, 231 - i);
+			CHECK_EQUAL(DHT_OK, read_async(&RH, &temp, pollUs[i]));
+			CHECK_EQUAL(652 + i, RH);
+			CHECK_EQUAL(231 - i, temp);
+		}
+
+		dht22_set_reading(&sensor, 1000, -105);
+		CHECK_EQUAL(DHT_OK, read_async(&RH, &temp, 100));
+		CHECK_EQUAL(1000, RH);
+		CHECK_EQUAL(-105, temp);
+
+		CHECK_EQUAL(4, sensor.stats.frames);
+		CHECK_EQUAL(0, sensor.stats.aborted);
+		CHECK_EQUAL(1, dht22_line(&sensor));			// idle high
+		CHECK_EQUAL(0, EXTI->IMR & GPIO_PIN_11);		// no interrupts once done
+	}
+
+	/* The timer is started by DHTinit only and keeps running between reads */
+	static void test_timer_started_once(void)
+	{
+		int16_t RH;
+		int16_t temp;
+
+		setup();
+		CHECK_EQUAL(1, mock_tim_starts(TIM2));
+		for (int i = 0; i < 3; i++)
+		{
+			CHECK_EQUAL(DHT_OK, read_async(&RH, &temp, 100));
+		}
+		CHECK_EQUAL(1, mock_tim_starts(TIM2));
+	}
+
+	/* DHTreceive_data, timed into worstReadNs */
+	static DHT_StatusTypeDef receive_timed(int16_t *RH, int16_t *temp)
+	{
+		uint64_t start = mock_now_ns();
+		DHT_StatusTypeDef status = DHTreceive_data(RH, temp);
+
+		if (mock_now_ns() - start > worstReadNs)
+		{
+			worstReadNs = mock_now_ns() - start;
+		}
+		return status;
+	}
+
+	/* Blocking read: every wait bounded, the status tells what went wrong */
+	static void test_blocking_read(void)
+	{
+		int16_t RH = 0;
+		int16_t temp = 0;
+		uint64_t start;
+
+		setup();
+		dht22_set_reading(&sensor, 405, -72);
+		CHECK_EQUAL(DHT_OK, receive_timed(&RH, &temp));
+		CHECK_EQUAL(405, RH);
+		CHECK_EQUAL(-72, temp);
+		CHECK_EQUAL(1, sensor.stats.frames);
+
+		/* Wrong check-sum: values left alone */
+		sensor.data[4] ^= 0x01;
+		RH = 1;
+		temp = 2;
+		CHECK_EQUAL(DHT_CHECKSUM, receive_timed(&RH, &temp));
+		CHECK_EQUAL(1, RH);
+		CHECK_EQUAL(2, temp);
+
+		/* No answer: over right after the start pulse (10 ms for the detected DHT22) */
+		sensor.respond = 0;
+		start = mock_now_ns();
+		CHECK_EQUAL(DHT_NO_RESPONSE, receive_timed(&RH, &temp));
+		CHECK(mock_now_ns() - start < DHT_START_PULSE * 1000ULL + 200000);
+		sensor.respond = 1;
+
+		/* Sensor stops after 20 bits and lets the line go high: one edge timeout later */
+		dht22_set_reading(&sensor, 405, -72);
+		sensor.bits = 20;
+		start = mock_now_ns();
+		CHECK_EQUAL(DHT_TIMEOUT, receive_timed(&RH, &temp));
+		CHECK(mock_now_ns() - start < (DHT_START_PULSE + 190 + 20 * 120 + 2 * DHT_EDGE_TIMEOUT) * 1000ULL);
+		CHECK_EQUAL(1, RH);
+		sensor.bits = 40;
+
+		/* Line idle high after every outcome */
+		CHECK_EQUAL(1, dht22_line(&sensor));
+		CHECK_EQUAL(DHT_OK, receive_timed(&RH, &temp));
+		CHECK_EQUAL(405, RH);
+
+		/* Worst case of the outcomes above: the first read, with the 18 ms start pulse of the unknown model */
+		bench_report("DHTreceive_data, worst case", worstReadNs / 1000.0, "us");
+		CHECK(worstReadNs < (DHT11_START_PULSE + 190 + 40 * 120 + 100) * 1000ULL);
+	}
+
+	/* Check-sum and both encodings */
+	static void test_convert_frame(void)
+	{
+		static const uint8_t dht22[5] = { 0x02, 0x8C, 0x80, 0x65, 0x73 };		// 65.2 %, -10.1 C
+		static const uint8_t dht11[5] = { 0x37, 0x00, 0x18, 0x03, 0x52 };		// 55.0 %, 24.3 C
+		static const uint8_t wrapped[5] = { 0x03, 0xE8, 0x01, 0x90, 0x7C };		// sum 0x27C
+		uint8_t bad[5] = { 0x02, 0x8C, 0x80, 0x65, 0x74 };
+		int16_t RH = 0;
+		int16_t temp = 0;
+
+		CHECK_EQUAL(DHT_OK, DHTconvert_frame(dht22, DHT_MODEL_AUTO, &RH, &temp));
+		CHECK_EQUAL(652, RH);
+		CHECK_EQUAL(-101, temp);
+		CHECK_EQUAL(DHT_MODEL_DHT22, DHTdetect_model(dht22));
+
+		CHECK_EQUAL(DHT_OK, DHTconvert_frame(dht11, DHT_MODEL_AUTO, &RH, &temp));
+		CHECK_EQUAL(550, RH);
+		CHECK_EQUAL(243, temp);
+		CHECK_EQUAL(DHT_MODEL_DHT11, DHTdetect_model(dht11));
+
+		CHECK_EQUAL(DHT_OK, DHTconvert_frame(wrapped, DHT_MODEL_DHT22, &RH, &temp));
+		CHECK_EQUAL(1000, RH);
+		CHECK_EQUAL(400, temp);
+
+		CHECK_EQUAL(DHT_CHECKSUM, DHTconvert_frame(bad, DHT_MODEL_AUTO, &RH, &temp));
+		CHECK_EQUAL(1000, RH);
+		bad[4] = 0x73;
+		bad[0] ^= 0x01;
+		CHECK_EQUAL(DHT_CHECKSUM, DHTconvert_frame(bad, DHT_MODEL_AUTO, &RH, &temp));
+	}
+
+	/*
+	 * Polls every 10 us until the read ends, with the longest time spent in
+	 * one DHTpoll call (also kept in worstPollNs) and the time from the start
+	 * to the end of the read
+	 */
+	static DHT_StatusTypeDef poll_until_done(int16_t *RH, int16_t *temp, uint64_t *longestNs,
+			uint64_t *totalNs)
+	{
+		uint64_t start = mock_now_ns();
+		DHT_StatusTypeDef status = DHT_BUSY;
+
+		*longestNs = 0;
+		for (int i = 0; i < 100000 && status == DHT_BUSY; i++)
+		{
+			uint64_t before = mock_now_ns();
+			status = DHTpoll(RH, temp);
+			if (mock_now_ns() - before > *longestNs)
+			{
+				*longestNs = mock_now_ns() - before;
+			}
+			if (*longestNs > worstPollNs)
+			{
+				worstPollNs = *longestNs;
+			}
+			if (status == DHT_BUSY)
+			{
+				mock_run_ns(10000);
+			}
+		}
+		*totalNs = mock_now_ns() - start;
+		return status;
+	}
+
+	/* Non-blocking read: every phase ends on its deadline, DHTpoll never waits */
+	static void test_state_machine(void)
+	{
+		int16_t RH = 0;
+		int16_t temp = 0;
+		uint64_t longest;
+		uint64_t total;
+
+		setup();
+		CHECK_EQUAL(DHT_IDLE, DHTpoll(&RH, &temp));
+
+		/* Start pulse: line held low until it has passed (18 ms while the model is unknown) */
+		DHTstart_read();
+		mock_run_ns(DHT11_START_PULSE * 1000ULL - 100000);
+		CHECK_EQUAL(DHT_BUSY, DHTpoll(&RH, &temp));
+		CHECK_EQUAL(0, dht22_line(&sensor));
+		mock_run_ns(100000);
+		CHECK_EQUAL(DHT_BUSY, DHTpoll(&RH, &temp));
+		CHECK(EXTI->IMR & GPIO_PIN_11);
+
+		/* Response and frame captured by the interrupt, result reported once */
+		dht22_set_reading(&sensor, 0, 0);
+		CHECK_EQUAL(DHT_OK, poll_until_done(&RH, &temp, &longest, &total));
+		CHECK(longest < 5000);
+		CHECK_EQUAL(DHT_IDLE, DHTpoll(&RH, &temp));
+
+		/* No answer: DHT_NO_RESPONSE once the response timeout has passed */
+		sensor.respond = 0;
+		DHTstart_read();
+		CHECK_EQUAL(DHT_NO_RESPONSE, poll_until_done(&RH, &temp, &longest, &total));
+		CHECK(total >= (DHT_START_PULSE + DHT_RESPONSE_TIMEOUT) * 1000ULL);
+		CHECK(total < (DHT_START_PULSE + DHT_RESPONSE_TIMEOUT + 50) * 1000ULL);
+		CHECK(longest < 5000);
+		CHECK_EQUAL(0, EXTI->IMR & GPIO_PIN_11);
+		CHECK_EQUAL(1, dht22_line(&sensor));
+		sensor.respond = 1;
+
+		/* Frame cut after 12 bits: DHT_TIMEOUT at the frame deadline, not before */
+		sensor.bits = 12;
+		RH = 1;
+		DHTstart_read();
+		CHECK_EQUAL(DHT_TIMEOUT, poll_until_done(&RH, &temp, &longest, &total));
+		CHECK(total >= (DHT_START_PULSE + DHT_FRAME_TIMEOUT) * 1000ULL);
+		CHECK(total < (DHT_START_PULSE + DHT_FRAME_TIMEOUT + 50) * 1000ULL);
+		CHECK(longest < 5000);
+		CHECK_EQUAL(1, RH);
+		CHECK_EQUAL(0, EXTI->IMR & GPIO_PIN_11);
+		sensor.bits = 40;
+
+		/* Wrong check-sum */
+		sensor.data[4] ^= 0x80;
+		DHTstart_read();
+		CHECK_EQUAL(DHT_CHECKSUM, poll_until_done(&RH, &temp, &longest, &total));
+		CHECK_EQUAL(1, RH);
+
+		/* And back to a good read */
+		dht22_set_reading(&sensor, 512, 199);
+		DHTstart_read();
+		CHECK_EQUAL(DHT_OK, poll_until_done(&RH, &temp, &longest, &total));
+		CHECK_EQUAL(512, RH);
+		CHECK_EQUAL(199, temp);
+		CHECK_EQUAL(0, sensor.stats.aborted);
+
+		/* Worst DHTpoll over every outcome: the decode of the frame, never a wait */
+		bench_report("DHTpoll, worst case", worstPollNs / 1000.0, "us");
+		CHECK(worstPollNs < 5000);
+	}
+
+	/* DHTupdate from a main loop running every ms, for some time */
+	static void run_updates(uint32_t ms)
+	{
+		for (uint32_t i = 0; i < ms; i++)
+		{
+			DHTupdate();
+			mock_run_ns(1000000);
+		}
+	}
+
+	/* Conversions never closer than the interval of the model, readings cached */
+	static void test_min_interval(void)
+	{
+		static const uint8_t dht11[5] = { 0x37, 0x00, 0x18, 0x03, 0x52 };
+		int16_t RH = 0;
+		int16_t temp = 0;
+		uint32_t age;
+
+		/* DHT22: first conversion one interval after power up, then every 2 s */
+		setup();
+		dht22_set_reading(&sensor, 481, 226);
+		CHECK_EQUAL(DHT_SAMPLE_INVALID, DHTlast_reading(&RH, &temp, &age));
+		run_updates(1990);
+		CHECK_EQUAL(0, sensor.stats.starts);
+		run_updates(20010);
+		CHECK_EQUAL(10, sensor.stats.starts);
+		CHECK(sensor.stats.minGapNs >= DHT22_INTERVAL * 1000000ULL);
+		CHECK(sensor.stats.minGapNs < (DHT22_INTERVAL + 5) * 1000000ULL);
+		CHECK_EQUAL(DHT_SAMPLE_FRESH, DHTlast_reading(&RH, &temp, &age));
+		CHECK_EQUAL(481, RH);
+		CHECK_EQUAL(226, temp);
+		CHECK(age < DHT22_INTERVAL);
+
+		/* Cached reading ages once the sensor is gone */
+		sensor.respond = 0;
+		run_updates(DHT_STALE_AGE + 1000);
+		CHECK_EQUAL(DHT_SAMPLE_STALE, DHTlast_reading(&RH, &temp, &age));
+		CHECK_EQUAL(481, RH);
+		CHECK(age > DHT_STALE_AGE);
+
+		/* DHT11, detected from its first frame: every second from then on */
+		setup();
+		for (int i = 0; i < 5; i++)
+		{
+			sensor.data[i] = dht11[i];
+		}
+		run_updates(10500);
+		CHECK_EQUAL(9, sensor.stats.starts);
+		CHECK(sensor.stats.minGapNs >= DHT11_INTERVAL * 1000000ULL);
+		CHECK_EQUAL(DHT_SAMPLE_FRESH, DHTlast_reading(&RH, &temp, &age));
+		CHECK_EQUAL(550, RH);
+		CHECK_EQUAL(243, temp);
+	}
+
+	/*
+	 * Bit widths far from the nominal 26 / 70 us, on both sides of the old
+	 * fixed 40 us sampling point: both reads adapt the threshold to the frame
+	 */
+	static void test_adaptive_threshold(void)
+	{
+		static const uint32_t widths[][2] = { { 45000, 95000 }, { 13000, 35000 }, { 26000, 70000 } };
+		int16_t RH;
+		int16_t temp;
+
+		setup();
+		dht22_set_reading(&sensor, 777, 135);		// 0x0309 0x0087, both bit values in every byte
+		for (int i = 0; i < 3; i++)
+		{
+			sensor.zeroNs = widths[i][0];
+			sensor.oneNs = widths[i][1];
+
+			RH = 0;
+			temp = 0;
+			CHECK_EQUAL(DHT_OK, DHTreceive_data(&RH, &temp));
+			CHECK_EQUAL(777, RH);
+			CHECK_EQUAL(135, temp);
+
+			RH = 0;
+			temp = 0;
+			CHECK_EQUAL(DHT_OK, read_async(&RH, &temp, 100));
+			CHECK_EQUAL(777, RH);
+			CHECK_EQUAL(135, temp);
+		}
+
+		/* Every timing of a slow clone 20 % longer (the response stays within DHT_EDGE_TIMEOUT) */
+		sensor.zeroNs = DHT22_ZERO_NS;
+		sensor.oneNs = DHT22_ONE_NS;
+		sensor.scale = 120;
+		CHECK_EQUAL(DHT_OK, DHTreceive_data(&RH, &temp));
+		CHECK_EQUAL(777, RH);
+		CHECK_EQUAL(DHT_OK, read_async(&RH, &temp, 100));
+		CHECK_EQUAL(135, temp);
+	}
+
+	/* Counters and histograms of a run of reads with faults, reported over SWO */
+	static void test_telemetry(void)
+	{
+		DHT_TelemetryTypeDef telemetry;
+		int16_t RH;
+		int16_t temp;
+
+		setup();
+		DHTtelemetry_reset();
+		mock_itm_clear();
+		sensor.latencyNs = 35000;
+		dht22_set_reading(&sensor, 0, 0);		// 40 bits of 26 us
+
+		for (int i = 0; i < 3; i++)
+		{
+			CHECK_EQUAL(DHT_OK, read_async(&RH, &temp, 100));
+		}
+		sensor.respond = 0;
+		CHECK_EQUAL(DHT_NO_RESPONSE, read_async(&RH, &temp, 100));
+		sensor.respond = 1;
+		sensor.bits = 12;
+		CHECK_EQUAL(DHT_TIMEOUT, read_async(&RH, &temp, 100));
+		sensor.bits = 40;
+		sensor.data[4] = 0x01;		// one 70 us bit
+		CHECK_EQUAL(DHT_CHECKSUM, read_async(&RH, &temp, 100));
+		sensor.data[4] = 0x00;
+		CHECK_EQUAL(DHT_OK, read_async(&RH, &temp, 100));
+
+		DHTtelemetry(&telemetry);
+		CHECK_EQUAL(7, telemetry.reads);
+		CHECK_EQUAL(4, telemetry.ok);
+		CHECK_EQUAL(1, telemetry.noResponse);
+		CHECK_EQUAL(1, telemetry.timeouts);
+		CHECK_EQUAL(1, telemetry.checksums);
+		CHECK_EQUAL(3, telemetry.retries);			// the reads after NR, TO and CS
+		CHECK_EQUAL(6, telemetry.latency[3]);		// every answered read, 30 - 39 us
+		CHECK_EQUAL(5 * 40 + 12 - 1, telemetry.widths[3]);	// 24 - 31 us
+		CHECK_EQUAL(1, telemetry.widths[8]);			// 64 - 71 us
+
+		DHTtelemetry_report();
+		CHECK_TEXT("DHT reads=7 ok=4 no-response=1 timeouts=1 checksums=1 retries=3\n"
+				"DHT latency/10us 0,0,0,6,0,0,0,0\n"
+				"DHT width/8us 0,0,0,211,0,0,0,0,1,0,0,0,0,0,0,0\n", mock_itm_text());
+
+		/* Histogram bins saturate */
+		DHTtelemetry_reset();
+		for (int i = 0; i < 1700; i++)
+		{
+			read_async(&RH, &temp, 500);
+		}
+		DHTtelemetry(&telemetry);
+		CHECK_EQUAL(1700, telemetry.ok);
+		CHECK_EQUAL(UINT16_MAX, telemetry.widths[3]);
+		CHECK_EQUAL(1700, telemetry.latency[3]);
+
+		DHTtelemetry_reset();
+		DHTtelemetry(&telemetry);
+		CHECK_EQUAL(0, telemetry.reads);
+		CHECK_EQUAL(0, telemetry.widths[3]);
+	}
+
+	/* Polls DHTupdate every ms until the conversion in progress ends */
+	static DHT_StatusTypeDef finish_conversion(void)
+	{
+		DHT_StatusTypeDef status = DHT_BUSY;
+
+		for (int i = 0; i < 100 && status == DHT_BUSY; i++)
+		{
+			status = DHTupdate();
+			mock_run_ns(1000000);
+		}
+		return status;
+	}
+
+	/*
+	 * Retries after failures: the interval doubles up to DHT_BACKOFF_MAX with
+	 * up to a quarter of jitter, and is back to normal after a valid reading.
+	 * Runs last, DHTtrigger switches the driver to triggered conversions for good.
+	 */
+	static void test_backoff(void)
+	{
+		uint32_t jittered = 0;
+		uint32_t pulses;
+		uint32_t wait;
+
+		/* DHTupdate: gaps between the start pulses of failed conversions */
+		setup();
+		dht22_set_reading(&sensor, 500, 200);
+		sensor.respond = 0;
+		run_updates(2000 + 2500 + 5000 + 10000 + 20000 + 40000 + 75000 + 75000 + 1000);
+		CHECK(sensor.stats.pulses >= 8);
+		for (uint32_t k = 1; k < 8 && k < sensor.stats.pulses; k++)
+		{
+			uint32_t base = DHT22_INTERVAL << (k - 1 < DHT_BACKOFF_SHIFT_MAX ? k - 1 : DHT_BACKOFF_SHIFT_MAX);
+			base = base < DHT_BACKOFF_MAX ? base : DHT_BACKOFF_MAX;
+			uint64_t gap = (sensor.pulseLog[k] - sensor.pulseLog[k - 1]) / 1000000;
+			CHECK(gap + 1 >= base);
+			CHECK(gap <= base + base / 4 + 2);
+			jittered += gap > base + 2;
+		}
+		CHECK(jittered > 0);
+
+		/* Sensor back: the next retry reads it and the interval is normal again */
+		sensor.respond = 1;
+		pulses = sensor.stats.pulses;
+		run_updates(DHT_BACKOFF_MAX + DHT_BACKOFF_MAX / 4 + 2 * DHT22_INTERVAL + 100);
+		CHECK(sensor.stats.pulses >= pulses + 2);
+		CHECK(sensor.pulseLog[pulses + 1] - sensor.pulseLog[pulses] < (DHT22_INTERVAL + 2) * 1000000ULL);
+		CHECK(sensor.pulseLog[pulses + 1] - sensor.pulseLog[pulses] >= (DHT22_INTERVAL - 1) * 1000000ULL);
+
+		/* DHTtrigger as main.c uses it: skipped during the backoff, retried when DHTnext_conversion says */
+		setup();
+		sensor.respond = 0;
+		mock_run_ns(DHT22_INTERVAL * 1000000ULL);
+		CHECK_EQUAL(DHT_BUSY, DHTtrigger());
+		CHECK_EQUAL(DHT_NO_RESPONSE, finish_conversion());
+		for (uint32_t k = 1; k <= 3; k++)
+		{
+			uint32_t base = DHT22_INTERVAL << (k - 1);
+			wait = DHTnext_conversion();
+			CHECK(wait + 100 >= base);
+			CHECK(wait <= base + base / 4);
+			CHECK_EQUAL(DHT_IDLE, DHTtrigger());
+			mock_run_ns((wait - 1) * 1000000ULL);
+			CHECK_EQUAL(DHT_IDLE, DHTtrigger());
+			mock_run_ns(2000000);
+			CHECK_EQUAL(0, DHTnext_conversion());
+			if (k == 3)
+			{
+				sensor.respond = 1;
+			}
+			CHECK_EQUAL(DHT_BUSY, DHTtrigger());
+			CHECK_EQUAL(k == 3 ? DHT_OK : DHT_NO_RESPONSE, finish_conversion());
+		}
+
+		/* Back to the normal interval, DHTupdate no longer starts conversions */
+		wait = DHTnext_conversion();
+		CHECK(wait <= DHT22_INTERVAL - DHT_TRIGGER_SLACK);
+		CHECK(wait + 100 >= DHT22_INTERVAL - DHT_TRIGGER_SLACK);
+		pulses = sensor.stats.pulses;
+		run_updates(3 * DHT22_INTERVAL);
+		CHECK_EQUAL(pulses, sensor.stats.pulses);
+		CHECK_EQUAL(DHT_BUSY, DHTtrigger());
+		CHECK_EQUAL(DHT_OK, finish_conversion());
+	}
+
+	int main(void)
+	{
+		test_edge_capture();
+		test_timer_started_once();
+		test_blocking_read();
+		test_convert_frame();
+		test_state_machine();
+		test_min_interval();
+		test_adaptive_threshold();
+		test_telemetry();
+		test_backoff();
+
+		return test_report("DHTTest");
+	}
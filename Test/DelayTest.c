@@ -0,0 +1,158 @@
+/*
+ *  DelayTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  Delays and deadlines on the cycle counter of the mock: the rounding of
+ *  nanoseconds to cycles against a 64-bit reference, deadlines and delays
+ *  across the wrap of the counter, and _us_delay across the wrap of 16-bit
+ *  and 32-bit timers.
+ */
+
+#include "Delay.h"
+#include "HalMock.h"
+#include "Test.h"
+
+	static TIM_HandleTypeDef htim2;
+
+	/* Cycles of a time in nanoseconds rounded up, without overflow */
+	static uint64_t reference_cycles(uint32_t ns, uint32_t hz)
+	{
+		return ((uint64_t) ns * (hz / 1000000U) + 999U) / 1000U;
+	}
+
+	/* Cycles from the counter read of delay_now to the one of delay_deadline_ns */
+	static uint32_t deadline_cycles(uint32_t ns)
+	{
+		uint32_t before = delay_now();
+		return delay_deadline_ns(ns) - before - MOCK_DWT_CYCLES;
+	}
+
+	/* Let the cycle counter run until it is some cycles short of its wrap */
+	static void run_to_wrap(uint32_t cycles)
+	{
+		uint32_t left = UINT32_MAX - delay_now() - cycles;
+		mock_run_ns(MOCK_CYCLES_NS(left));
+	}
+
+	/* Rounded up at every clock, whatever the size of the time */
+	static void test_ns_rounding(void)
+	{
+		static const uint32_t clocks[] = { 84000000U, 16000000U, 168000000U };
+		static const uint32_t large[] = { 999999U, 1000001U, 25000000U, 2147483647U, UINT32_MAX };
+
+		for (unsigned int c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++)
+		{
+			mock_reset();
+			SystemCoreClock = clocks[c];
+			delay_init();
+			for (uint32_t ns = 0; ns <= 100000; ns++)
+			{
+				if (!CHECK_EQUAL(reference_cycles(ns, clocks[c]), deadline_cycles(ns)))
+				{
+					break;
+				}
+			}
+			for (unsigned int i = 0; i < sizeof(large) / sizeof(large[0]); i++)
+			{
+				CHECK_EQUAL((uint32_t) reference_cycles(large[i], clocks[c]), deadline_cycles(large[i]));
+			}
+		}
+
+		/* At 84 MHz, a cycle is 11.9 ns */
+		mock_reset();
+		delay_init();
+		CHECK_EQUAL(0, deadline_cycles(0));
+		CHECK_EQUAL(1, deadline_cycles(1));
+		CHECK_EQUAL(1, deadline_cycles(11));
+		CHECK_EQUAL(2, deadline_cycles(12));
+		CHECK_EQUAL(84, deadline_cycles(1000));
+		CHECK_EQUAL(85, deadline_cycles(1001));
+		CHECK_EQUAL(360777253, deadline_cycles(UINT32_MAX));
+	}
+
+	/* A deadline past the wrap is numerically smaller than now and not yet reached */
+	static void test_expired_wrap(void)
+	{
+		mock_reset();
+		delay_init();
+		run_to_wrap(840);
+
+		uint32_t start = delay_now();
+		uint32_t deadline = delay_deadline_us(100);
+		CHECK(deadline < start);
+		CHECK(!delay_expired(deadline));
+		mock_run_ns(50000);
+		CHECK(delay_now() < start);
+		CHECK(!delay_expired(deadline));
+		mock_run_ns(50000);
+		CHECK(delay_expired(deadline));
+		CHECK_EQUAL(100, delay_elapsed_us(start));
+
+		/* Passed before the wrap: still expired after it, up to 2^31 cycles later */
+		run_to_wrap(84);
+		deadline = delay_now();
+		mock_run_ns(1000000);
+		CHECK(delay_now() < deadline);
+		CHECK(delay_expired(deadline));
+		CHECK(!delay_expired(delay_now() + 0x7FFFFFFFU));
+	}
+
+	/* Busy-waits across the wrap last as long as anywhere else */
+	static void test_delay_wrap(void)
+	{
+		mock_reset();
+		delay_init();
+
+		run_to_wrap(840);
+		uint64_t start = mock_now_ns();
+		delay_us(100);
+		uint64_t waited = mock_now_ns() - start;
+		CHECK(waited >= 100000);
+		CHECK(waited < 100100);
+
+		run_to_wrap(84);
+		start = mock_now_ns();
+		delay_ns(2500);
+		waited = mock_now_ns() - start;
+		CHECK(waited >= 2500);
+		CHECK(waited < 2600);
+
+		run_to_wrap(84000);
+		start = mock_now_ns();
+		delay_ms(3);
+		waited = mock_now_ns() - start;
+		CHECK(waited >= 3000000);
+		CHECK(waited < 3000100);
+	}
+
+	/* _us_delay with the counter about to reload, 16 and 32 bits */
+	static void test_timer_wrap(void)
+	{
+		static const uint32_t reloads[] = { 0xFFFFU, 0xFFFFFFFFU };
+
+		for (unsigned int i = 0; i < sizeof(reloads) / sizeof(reloads[0]); i++)
+		{
+			mock_reset();
+			mock_tim_init(&htim2, TIM2, 83, reloads[i]);
+			__HAL_TIM_SET_COUNTER(&htim2, reloads[i] - 20);
+
+			uint64_t start = mock_now_ns();
+			_us_delay(htim2, 100);
+			uint64_t waited = mock_now_ns() - start;
+			CHECK(__HAL_TIM_GET_COUNTER(&htim2) < 100);
+			CHECK(waited >= 99000);
+			CHECK(waited < 101000);
+		}
+	}
+
+	int main(void)
+	{
+		test_ns_rounding();
+		test_expired_wrap();
+		test_delay_wrap();
+		test_timer_wrap();
+
+		return test_report("DelayTest");
+	}
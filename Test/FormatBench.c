@@ -0,0 +1,85 @@
+/*
+ *  FormatBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  fmt_fixed against sprintf for the fields of the station screen (a
+ *  temperature in tenths, right aligned in 5 characters). Plain computation
+ *  takes no time on the mock clock, so both run natively and are timed on
+ *  the host; the ratio is what carries over to the target.
+ */
+
+#include "Format.h"
+#include "Test.h"
+#include <stdio.h>
+#include <time.h>
+
+#define ROUNDS 200
+
+	static volatile uint32_t sink;
+
+	static double now_ns(void)
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1e9 + ts.tv_nsec;
+	}
+
+	/* -40.0 C to 80.0 C, as the render task formats them */
+	static double run_fmt(void)
+	{
+		char text[FMT_BUFFER_SIZE];
+		double start = now_ns();
+
+		for (int round = 0; round < ROUNDS; round++)
+			for (int32_t value = -400; value <= 800; value++)
+			{
+				fmt_fixed(text, value, 1, 5, FMT_ALIGN_RIGHT);
+				sink += text[4];
+			}
+
+		return (now_ns() - start) / (ROUNDS * 1201.0);
+	}
+
+	/* The sprintf call fmt_fixed replaced, without the padding (and wrong for -0.9 to -0.1) */
+	static double run_sprintf(void)
+	{
+		char text[FMT_BUFFER_SIZE];
+		double start = now_ns();
+
+		for (int round = 0; round < ROUNDS; round++)
+			for (int32_t value = -400; value <= 800; value++)
+			{
+				int whole = value / 10;
+				int frac = value % 10;
+				sprintf(text, "%i.%i", whole, frac < 0 ? -frac : frac);
+				sink += text[2];
+			}
+
+		return (now_ns() - start) / (ROUNDS * 1201.0);
+	}
+
+	int main(void)
+	{
+		/* Best of a few runs, the host may be busy */
+		double fmt = 1e9;
+		double sprintf_ = 1e9;
+		for (int i = 0; i < 5; i++)
+		{
+			double t = run_fmt();
+			fmt = t < fmt ? t : fmt;
+			t = run_sprintf();
+			sprintf_ = t < sprintf_ ? t : sprintf_;
+		}
+
+		printf("Temperature field, 5 characters with 1 decimal\n");
+		bench_report("fmt_fixed", fmt, "ns per field");
+		bench_report("sprintf", sprintf_, "ns per field");
+		bench_report("speed-up", sprintf_ / fmt, "x");
+
+		CHECK(fmt < sprintf_);
+
+		return test_report("FormatBench");
+	}
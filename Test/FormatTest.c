@@ -0,0 +1,145 @@
+/*
+ *  FormatTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  fmt_int and fmt_fixed against snprintf: every int16 value with 0 - 3
+ *  decimals, in both alignments and with fields narrower and wider than the
+ *  number, then the ends of the int32 range, fmt_uint over the uint32 range
+ *  and the clamped arguments.
+ */
+
+#include "Format.h"
+#include "Test.h"
+#include <stdio.h>
+#include <string.h>
+
+	/* The same field built with snprintf */
+	static int reference(char *buffer, int32_t value, uint8_t decimals, uint8_t width, uint8_t align)
+	{
+		char number[FMT_BUFFER_SIZE];
+		uint32_t scale = 1;
+		for (uint8_t i = 0; i < decimals; i++)
+			scale *= 10;
+
+		uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+		if (decimals)
+			snprintf(number, sizeof(number), "%s%lu.%0*lu", value < 0 ? "-" : "",
+					(unsigned long) (magnitude / scale), decimals & 0x0F, (unsigned long) (magnitude % scale));
+		else
+			snprintf(number, sizeof(number), "%s%lu", value < 0 ? "-" : "", (unsigned long) magnitude);
+
+		return snprintf(buffer, FMT_BUFFER_SIZE, align == FMT_ALIGN_RIGHT ? "%*s" : "%-*s", width, number);
+	}
+
+	/* One field, the first mismatch is reported in full */
+	static uint32_t compare(int32_t value, uint8_t decimals, uint8_t width, uint8_t align)
+	{
+		static uint8_t reported;
+		char expected[FMT_BUFFER_SIZE];
+		char actual[FMT_BUFFER_SIZE];
+
+		int length = reference(expected, value, decimals, width, align);
+		uint8_t written = fmt_fixed(actual, value, decimals, width, align);
+
+		if (written == length && strcmp(expected, actual) == 0)
+			return 0;
+
+		if (!reported)
+		{
+			reported = 1;
+			printf("fmt_fixed(%ld, %u, %u, %u)\n", (long) value, decimals, width, align);
+			CHECK_TEXT(expected, actual);
+			CHECK_EQUAL(length, written);
+		}
+		return 1;
+	}
+
+	static void test_int16_range(void)
+	{
+		static const uint8_t widths[] = { 0, 3, 5, 8, FMT_MAX_WIDTH };
+		uint32_t mismatches = 0;
+
+		for (int32_t value = INT16_MIN; value <= INT16_MAX; value++)
+			for (uint8_t decimals = 0; decimals <= 3; decimals++)
+				for (unsigned int w = 0; w < sizeof(widths); w++)
+				{
+					mismatches += compare(value, decimals, widths[w], FMT_ALIGN_LEFT);
+					mismatches += compare(value, decimals, widths[w], FMT_ALIGN_RIGHT);
+				}
+
+		CHECK_EQUAL(0, mismatches);
+	}
+
+	static void test_int32_ends(void)
+	{
+		static const int32_t values[] = { INT32_MIN, INT32_MIN + 1, -1000000000, -1, 0, 1, 999999999, 1000000000,
+				INT32_MAX };
+		uint32_t mismatches = 0;
+		char text[FMT_BUFFER_SIZE];
+
+		for (unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+			for (uint8_t decimals = 0; decimals <= FMT_MAX_DECIMALS; decimals++)
+				mismatches += compare(values[i], decimals, 12, FMT_ALIGN_RIGHT);
+		CHECK_EQUAL(0, mismatches);
+
+		CHECK_EQUAL(11, fmt_int(text, INT32_MIN));
+		CHECK_TEXT("-2147483648", text);
+		CHECK_EQUAL(10, fmt_int(text, INT32_MAX));
+		CHECK_TEXT("2147483647", text);
+		CHECK_EQUAL(1, fmt_int(text, 0));
+		CHECK_TEXT("0", text);
+	}
+
+	/* fmt_uint over the whole uint32 range, above INT32_MAX included */
+	static void test_uint(void)
+	{
+		uint32_t mismatches = 0;
+		char expected[FMT_BUFFER_SIZE];
+		char text[FMT_BUFFER_SIZE];
+
+		for (uint64_t value = 0; value <= UINT32_MAX; value = value * 3 + 1)
+			for (int delta = -1; delta <= 1; delta++)
+			{
+				uint32_t v = (uint32_t) (value + delta);
+				int length = snprintf(expected, sizeof(expected), "%lu", (unsigned long) v);
+				if (fmt_uint(text, v) != length || strcmp(expected, text) != 0)
+					mismatches++;
+			}
+		CHECK_EQUAL(0, mismatches);
+
+		CHECK_EQUAL(10, fmt_uint(text, UINT32_MAX));
+		CHECK_TEXT("4294967295", text);
+		CHECK_EQUAL(10, fmt_uint(text, 2147483648U));
+		CHECK_TEXT("2147483648", text);
+		CHECK_EQUAL(1, fmt_uint(text, 0));
+		CHECK_TEXT("0", text);
+	}
+
+	/* Out of range decimals and widths are clamped, not overrun */
+	static void test_clamping(void)
+	{
+		char text[FMT_BUFFER_SIZE + 8];
+
+		memset(text, '#', sizeof(text));
+		CHECK_EQUAL(FMT_MAX_WIDTH, fmt_fixed(text, 5, 1, 200, FMT_ALIGN_RIGHT));
+		CHECK_EQUAL('\0', text[FMT_MAX_WIDTH]);
+		CHECK_EQUAL('#', text[FMT_MAX_WIDTH + 1]);
+
+		fmt_fixed(text, 5, 20, 0, FMT_ALIGN_LEFT);
+		CHECK_TEXT("0.000000005", text);
+
+		fmt_fixed(text, -5, 1, 0, FMT_ALIGN_LEFT);
+		CHECK_TEXT("-0.5", text);
+	}
+
+	int main(void)
+	{
+		test_int16_range();
+		test_int32_ends();
+		test_uint();
+		test_clamping();
+
+		return test_report("FormatTest");
+	}
@@ -0,0 +1,345 @@
+/*
+ *  LiquidCrystalBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  Cost of a full 16x2 frame in every LiquidCrystal mode, on the virtual
+ *  84 MHz clock of the mock: time until the frame is on the screen, time the
+ *  CPU is held in the driver calls and GPIO register accesses per character.
+ *  A 16 character run also goes out through the data path as it was before
+ *  the single BSRR store (one HAL_GPIO_WritePin per line) for comparison.
+ *  Then a main loop with display traffic: iterations per second and the
+ *  longest iteration with the blocking driver and with the asynchronous
+ *  queue drained by the loop itself.
+ *  Only register accesses and waits take time on the mock clock, plain
+ *  computation (e.g. compiling DMA words) is free, so the CPU figures are the
+ *  time blocked on the bus.
+ */
+
+#include "LiquidCrystal.h"
+#include "Delay.h"
+#include "HD44780.h"
+#include "Test.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_CHARS 32
+
+/* Work of one main loop iteration besides the display (sensor poll, UART) */
+#define LOOP_WORK_NS 20000
+
+	static LCD_HandleTypeDef lcd;
+	static HD44780_HandleTypeDef hd;
+	static TIM_HandleTypeDef htim1;
+	static DMA_HandleTypeDef hdma_tim1_up;
+	static I2C_HandleTypeDef hi2c1;
+
+	static const uint16_t dataPins[8] = { GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8,
+			GPIO_PIN_9, GPIO_PIN_10 };
+	static const uint16_t nibblePins[8] = { 0, 0, 0, 0, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6 };
+
+	typedef struct
+	{
+		double frameUs;		// until the frame is on the screen
+		double cpuUs;		// in the driver calls
+		double storesPerChar;
+		double loadsPerChar;
+		uint32_t violations;	// bus timing rules broken
+	} Cost;
+
+	static void setup_port(void)
+	{
+		GPIO_InitTypeDef init = { 0 };
+
+		mock_reset();
+		delay_init();
+		memset(&lcd, 0, sizeof(lcd));
+		hd44780_init(&hd);
+
+		init.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4 | GPIO_PIN_5 | GPIO_PIN_6
+				| GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10;
+		init.Mode = GPIO_MODE_OUTPUT_PP;
+		HAL_GPIO_Init(GPIOC, &init);
+	}
+
+	static void setup_8bit(unsigned char waitmode)
+	{
+		setup_port();
+		hd44780_attach_gpio(&hd, GPIOC, dataPins, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		pin_setup(&lcd, GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8, GPIO_PIN_9,
+				GPIO_PIN_10, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+		setWaitMode(&lcd, waitmode);
+	}
+
+	static void setup_4bit(unsigned char waitmode)
+	{
+		setup_port();
+		hd44780_attach_gpio(&hd, GPIOC, nibblePins, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		pin_setup_4bit(&lcd, GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_0, GPIO_PIN_1,
+				GPIO_PIN_2);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+		setWaitMode(&lcd, waitmode);
+	}
+
+	static void setup_dma(void)
+	{
+		setup_8bit(LCD_WAIT_DELAY);
+		mock_tim_init(&htim1, TIM1, 83, 4);
+		memset(&hdma_tim1_up, 0, sizeof(hdma_tim1_up));
+		__HAL_LINKDMA(&htim1, hdma[TIM_DMA_ID_UPDATE], hdma_tim1_up);
+		dmaON(&lcd, &htim1, &hdma_tim1_up, 5000);
+	}
+
+	static void setup_i2c(void)
+	{
+		setup_port();
+		memset(&hi2c1, 0, sizeof(hi2c1));
+		hi2c1.State = HAL_I2C_STATE_READY;
+		hd44780_attach_pcf8574(&hd, 0x27);
+		i2c_setup(&lcd, &hi2c1, 0x27);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+	}
+
+	/*
+	 * The data path as it shipped before the single-store bus: every line is a
+	 * HAL_GPIO_WritePin call and the enable pulse waits with HAL_Delay
+	 */
+	static void baseline_pulse(void)
+	{
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_2, GPIO_PIN_RESET);
+		HAL_Delay(1);
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_2, GPIO_PIN_SET);
+		HAL_Delay(1);
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_2, GPIO_PIN_RESET);
+		HAL_Delay(1);
+	}
+
+	static void baseline_send(unsigned char value, unsigned char mode)
+	{
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_0, mode ? GPIO_PIN_SET : GPIO_PIN_RESET);
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_1, GPIO_PIN_RESET);
+		for (int i = 0; i < 8; i++)
+			HAL_GPIO_WritePin(GPIOC, dataPins[i], ((value >> i) & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+		baseline_pulse();
+	}
+
+	/* Register writes and time per character of a 16 character run */
+	static Cost run(int baseline)
+	{
+		static const unsigned char text[] = "0123456789ABCDEF";
+		Cost cost;
+
+		setup_8bit(LCD_WAIT_DELAY);
+		setCursor(&lcd, 0, 0);
+		mock_gpio_counters_reset();
+		uint64_t start = mock_now_ns();
+
+		if (baseline)
+			for (int i = 0; i < 16; i++)
+				baseline_send(text[i], 1);
+		else
+			writeBuffer(&lcd, text, 16);
+
+		cost.cpuUs = (mock_now_ns() - start) / 1000.0 / 16;
+		cost.frameUs = cost.cpuUs;
+		cost.storesPerChar = (double) mock_gpio_stores(GPIOC) / 16;
+		cost.loadsPerChar = (double) mock_gpio_loads(GPIOC) / 16;
+		cost.violations = hd44780_violations(&hd);
+
+		char row[17];
+		hd44780_row(&hd, 0, 16, row);
+		CHECK_TEXT("0123456789ABCDEF", row);
+
+		return cost;
+	}
+
+	static Cost report_run(const char *path, Cost cost)
+	{
+		printf("%s\n", path);
+		bench_report("time per character", cost.cpuUs, "us");
+		bench_report("GPIO register writes per character", cost.storesPerChar, "");
+		bench_report("bus timing violations", cost.violations, "");
+
+		return cost;
+	}
+
+	/* Two full rows, then whatever the mode needs to get them out */
+	static Cost frame(void)
+	{
+		Cost cost;
+		uint64_t start;
+		uint64_t returned;
+
+		mock_gpio_counters_reset();
+		start = mock_now_ns();
+
+		setCursor(&lcd, 0, 0);
+		print(&lcd, (unsigned char*) "Temp:    21.5 C ");
+		setCursor(&lcd, 0, 1);
+		print(&lcd, (unsigned char*) "RH:      40.0 % ");
+		if (lcd.writemode == LCD_WRITE_DMA)
+			dmaCommit(&lcd);
+		returned = mock_now_ns();
+
+		while (!isIdle(&lcd) || hd44780_busy(&hd))
+			mock_run_ns(1000);
+
+		cost.frameUs = (mock_now_ns() - start) / 1000.0;
+		cost.cpuUs = (returned - start) / 1000.0;
+		cost.storesPerChar = (double) mock_gpio_stores(GPIOC) / FRAME_CHARS;
+		cost.loadsPerChar = (double) mock_gpio_loads(GPIOC) / FRAME_CHARS;
+
+		cost.violations = hd44780_violations(&hd);
+
+		char row[17];
+		hd44780_row(&hd, 1, 16, row);
+		CHECK_TEXT("RH:      40.0 % ", row);
+
+		return cost;
+	}
+
+	static Cost report(const char *mode, Cost cost)
+	{
+		printf("%s\n", mode);
+		bench_report("frame on screen", cost.frameUs, "us");
+		bench_report("CPU blocked in the driver", cost.cpuUs, "us");
+		bench_report("GPIO stores per character", cost.storesPerChar, "");
+		bench_report("GPIO loads per character", cost.loadsPerChar, "");
+		bench_report("bus timing violations", cost.violations, "");
+
+		return cost;
+	}
+
+	/* Main loop figures under display traffic */
+	typedef struct
+	{
+		double iterationsPerSecond;
+		double longestUs;
+	} Loop;
+
+	/*
+	 * One second of a main loop that redraws the screen fps times a second
+	 * (a new reading every frame) and otherwise does LOOP_WORK_NS of work per
+	 * iteration; in asynchronous mode it also calls processQueue
+	 */
+	static Loop main_loop(unsigned int fps)
+	{
+		Loop loop = { 0, 0 };
+		uint64_t start = mock_now_ns();
+		uint64_t next = start;
+		uint32_t iterations = 0;
+		unsigned int frames = 0;
+
+		while (mock_now_ns() - start < 1000000000ULL)
+		{
+			uint64_t begin = mock_now_ns();
+
+			if (fps && mock_now_ns() >= next)
+			{
+				setCursor(&lcd, 0, 0);
+				print(&lcd, (unsigned char*) "Temp:    21.5 C ");
+				setCursor(&lcd, 0, 1);
+				print(&lcd, (unsigned char*) "RH:      40.0 % ");
+				setCursor(&lcd, 14, 0);
+				write(&lcd, (unsigned char) ('0' + frames % 10));
+				frames++;
+				next += 1000000000ULL / fps;
+			}
+			if (lcd.writemode == LCD_WRITE_ASYNC)
+				processQueue(&lcd);
+			mock_run_ns(LOOP_WORK_NS);
+
+			double us = (mock_now_ns() - begin) / 1000.0;
+			if (us > loop.longestUs)
+				loop.longestUs = us;
+			iterations++;
+		}
+		loop.iterationsPerSecond = iterations * 1e9 / (mock_now_ns() - start);
+
+		/* Every frame made it to the screen */
+		while (!isIdle(&lcd))
+		{
+			processQueue(&lcd);
+			mock_run_ns(1000);
+		}
+		if (fps)
+		{
+			char row[17];
+			hd44780_row(&hd, 0, 16, row);
+			CHECK_EQUAL('0' + (frames - 1) % 10, row[14]);
+		}
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+
+		return loop;
+	}
+
+	/* The main loop at 0 to 50 frames per second in one mode, figures at 50 */
+	static Loop report_loop(const char *mode, unsigned char waitmode, unsigned char async)
+	{
+		static const unsigned int rates[] = { 0, 10, 25, 50 };
+		char name[64];
+		Loop loop = { 0, 0 };
+
+		printf("Main loop, %s\n", mode);
+		for (unsigned int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+		{
+			setup_8bit(waitmode);
+			if (async)
+				asyncON(&lcd, NULL);
+			loop = main_loop(rates[i]);
+			snprintf(name, sizeof(name), "iterations per second, %u frames/s", rates[i]);
+			bench_report(name, loop.iterationsPerSecond, "");
+			snprintf(name, sizeof(name), "longest iteration, %u frames/s", rates[i]);
+			bench_report(name, loop.longestUs, "us");
+		}
+		return loop;
+	}
+
+	int main(void)
+	{
+		Cost before = report_run("Characters, HAL_GPIO_WritePin per line (before)", run(1));
+		Cost after = report_run("Characters, one BSRR store per byte (after)", run(0));
+
+		/* 13 HAL calls per character before, one store for the byte plus the three enable edges after */
+		CHECK_EQUAL(13, before.storesPerChar);
+		CHECK_EQUAL(4, after.storesPerChar);
+		CHECK_EQUAL(0, after.violations);
+
+		setup_8bit(LCD_WAIT_DELAY);
+		Cost delay = report("8-bit, fixed delays", frame());
+
+		setup_8bit(LCD_WAIT_BUSYFLAG);
+		Cost busy = report("8-bit, busy flag", frame());
+
+		setup_4bit(LCD_WAIT_BUSYFLAG);
+		report("4-bit, busy flag", frame());
+
+		setup_dma();
+		Cost dma = report("8-bit, DMA (5 us tick)", frame());
+
+		setup_i2c();
+		report("PCF8574 at 100 kHz", frame());
+
+		/* Busy flag beats the fixed delays, DMA leaves the CPU almost free */
+		CHECK(busy.frameUs * 10 < delay.frameUs);
+		CHECK_EQUAL(0, busy.violations);
+		CHECK(dma.cpuUs * 10 < busy.cpuUs);
+
+		Loop idle;
+		setup_8bit(LCD_WAIT_DELAY);
+		idle = main_loop(0);
+		Loop blockingDelay = report_loop("blocking, fixed delays", LCD_WAIT_DELAY, 0);
+		Loop blockingBusy = report_loop("blocking, busy flag", LCD_WAIT_BUSYFLAG, 0);
+		Loop async = report_loop("asynchronous queue, fixed delays", LCD_WAIT_DELAY, 1);
+
+		/* The asynchronous loop keeps its rate and its iterations short under traffic */
+		CHECK(async.iterationsPerSecond > idle.iterationsPerSecond * 0.98);
+		CHECK(async.longestUs < 2 * LOOP_WORK_NS / 1000.0);
+		CHECK(blockingBusy.iterationsPerSecond < async.iterationsPerSecond);
+		CHECK(blockingBusy.longestUs > 10 * async.longestUs);
+		CHECK(blockingDelay.iterationsPerSecond < blockingBusy.iterationsPerSecond);
+
+		return test_report("LiquidCrystalBench");
+	}
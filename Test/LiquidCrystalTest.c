@@ -0,0 +1,709 @@
+/*
+ *  LiquidCrystalTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  LiquidCrystal against the emulated HD44780: what ends up on the screen and
+ *  in CGRAM, and a clean bus (no write while busy, no timing violation) in
+ *  every wait and write mode, and the glyph uploads of a day of history
+ *  drawn with printSparkline and printBar.
+ */
+
+#include "LiquidCrystal.h"
+#include "Delay.h"
+#include "HD44780.h"
+#include "Test.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+	static LCD_HandleTypeDef lcd;
+	static LCD_HandleTypeDef lcd2;
+	static HD44780_HandleTypeDef hd;
+	static HD44780_HandleTypeDef hd2;
+	static TIM_HandleTypeDef htim1;
+	static DMA_HandleTypeDef hdma_tim1_up;
+	static I2C_HandleTypeDef hi2c1;
+
+	static const uint16_t dataPins[8] = { GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8,
+			GPIO_PIN_9, GPIO_PIN_10 };
+	static const uint16_t nibblePins[8] = { 0, 0, 0, 0, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6 };
+
+	/* Fresh mock and controller, the LCD port set up as MX_GPIO_Init does */
+	static void setup_port(void)
+	{
+		GPIO_InitTypeDef init = { 0 };
+
+		mock_reset();
+		delay_init();
+		memset(&lcd, 0, sizeof(lcd));
+		hd44780_init(&hd);
+
+		init.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4 | GPIO_PIN_5 | GPIO_PIN_6
+				| GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10;
+		init.Mode = GPIO_MODE_OUTPUT_PP;
+		HAL_GPIO_Init(GPIOC, &init);
+	}
+
+	/* 16x2 display on the 8-bit bus of the station (D0 - D7 = PC3 - PC10, rs, rw, e = PC0 - PC2) */
+	static void setup_8bit(void)
+	{
+		setup_port();
+		hd44780_attach_gpio(&hd, GPIOC, dataPins, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		pin_setup(&lcd, GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8, GPIO_PIN_9,
+				GPIO_PIN_10, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+	}
+
+	static void setup_4bit(void)
+	{
+		setup_port();
+		hd44780_attach_gpio(&hd, GPIOC, nibblePins, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		pin_setup_4bit(&lcd, GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_0, GPIO_PIN_1,
+				GPIO_PIN_2);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+	}
+
+	/* TIM1 and DMA2 stream 5 as in main (5 us tick) */
+	static void setup_dma(void)
+	{
+		mock_tim_init(&htim1, TIM1, 83, 4);
+		memset(&hdma_tim1_up, 0, sizeof(hdma_tim1_up));
+		__HAL_LINKDMA(&htim1, hdma[TIM_DMA_ID_UPDATE], hdma_tim1_up);
+		dmaON(&lcd, &htim1, &hdma_tim1_up, 5000);
+	}
+
+	static void wait_idle(void)
+	{
+		for (int i = 0; i < 1000 && !isIdle(&lcd); i++)
+			mock_run_ns(100000);
+	}
+
+	static void check_rows(const char *row0, const char *row1)
+	{
+		char text[17];
+
+		hd44780_row(&hd, 0, 16, text);
+		CHECK_TEXT(row0, text);
+		hd44780_row(&hd, 1, 16, text);
+		CHECK_TEXT(row1, text);
+	}
+
+	static void print_station(void)
+	{
+		print(&lcd, (unsigned char*) "Temp: 21.5 C");
+		setCursor(&lcd, 0, 1);
+		print(&lcd, (unsigned char*) "RH: 40.0%");
+	}
+
+	static void test_begin(void)
+	{
+		setup_8bit();
+
+		CHECK_EQUAL(0x18, hd.function);			// 8-bit, 2 lines, 5x8
+		CHECK_EQUAL(0x04, hd.display);			// on, no cursor, no blink
+		CHECK_EQUAL(0x02, hd.entry);			// left to right, no shift
+		CHECK(!hd.fourBit);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+		check_rows("                ", "                ");
+	}
+
+	static void test_delay_mode(void)
+	{
+		setup_8bit();
+		print_station();
+
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+		CHECK_EQUAL(0, hd.stats.reads);
+	}
+
+	static void test_busy_flag_mode(void)
+	{
+		setup_8bit();
+		setWaitMode(&lcd, LCD_WAIT_BUSYFLAG);
+		print_station();
+
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+		CHECK(hd.stats.reads > 0);
+
+		/* Data pins are outputs again after every poll */
+		CHECK_EQUAL(0x00155555, GPIOC->MODER);
+	}
+
+	/* Each byte goes out as soon as the previous one is done, even on a slow controller */
+	static void test_busy_flag_timing(void)
+	{
+		setup_8bit();
+		setWaitMode(&lcd, LCD_WAIT_BUSYFLAG);
+		hd.scale = 150;
+
+		uint64_t start = mock_now_ns();
+		print(&lcd, (unsigned char*) "0123456789ABCDEF");
+		uint64_t elapsed = mock_now_ns() - start;
+
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+		CHECK_EQUAL(16, hd.stats.data);
+		/* 15 waits of 55.5 us plus at most ~2 us of polling and bus time per byte */
+		CHECK(elapsed >= 15 * 55500ULL);
+		CHECK(elapsed < 16 * 57500ULL);
+	}
+
+	/* A controller that never gets ready costs LCD_BUSY_TIMEOUT reads, not a hang */
+	static void test_busy_flag_timeout(void)
+	{
+		setup_8bit();
+		setWaitMode(&lcd, LCD_WAIT_BUSYFLAG);
+		hd.busyUntil = UINT64_MAX;
+
+		uint32_t reads = hd.stats.reads;
+		waitReady(&lcd);
+
+		CHECK_EQUAL(LCD_BUSY_TIMEOUT, hd.stats.reads - reads);
+		CHECK_EQUAL(0x00155555, GPIOC->MODER);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	static void test_4bit(void)
+	{
+		setup_4bit();
+		print_station();
+
+		CHECK(hd.fourBit);
+		CHECK_EQUAL(0x08, hd.function);
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	/* Nibbles on D4 - D7 (PC3 - PC6) and rs at each falling edge of E, next to the controller */
+	typedef struct
+	{
+		uint8_t e;
+		uint16_t count;
+		uint8_t nibbles[512];
+		uint8_t rs[512];
+	} NibbleLog;
+
+	static NibbleLog nibbleLog;
+
+	static void nibble_store(void *context, GPIO_TypeDef *port, unsigned int reg)
+	{
+		NibbleLog *log = (NibbleLog*) context;
+		uint8_t e = (port->ODR & GPIO_PIN_2) != 0;
+		(void) reg;
+
+		if (log->e && !e && log->count < sizeof(log->nibbles))
+		{
+			log->nibbles[log->count] = (port->ODR >> 3) & 0x0F;
+			log->rs[log->count] = (port->ODR & GPIO_PIN_0) != 0;
+			log->count++;
+		}
+		log->e = e;
+	}
+
+	/* 4-bit bus: the reset nibbles, then every byte high nibble first */
+	static void test_4bit_nibble_order(void)
+	{
+		static const MockGpio_DeviceTypeDef recorder = { nibble_store, NULL, &nibbleLog };
+
+		setup_port();
+		memset(&nibbleLog, 0, sizeof(nibbleLog));
+		mock_gpio_attach(GPIOC, &recorder);
+		hd44780_attach_gpio(&hd, GPIOC, nibblePins, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		pin_setup_4bit(&lcd, GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_0, GPIO_PIN_1,
+				GPIO_PIN_2);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+		write(&lcd, 'A');
+
+		/* Reset sequence of page 46: 0x3 three times, then 0x2 for the 4-bit interface */
+		CHECK(nibbleLog.count > 4);
+		CHECK_EQUAL(0x3, nibbleLog.nibbles[0]);
+		CHECK_EQUAL(0x3, nibbleLog.nibbles[1]);
+		CHECK_EQUAL(0x3, nibbleLog.nibbles[2]);
+		CHECK_EQUAL(0x2, nibbleLog.nibbles[3]);
+
+		/* Then pairs, high nibble first, that are the bytes the controller executed */
+		CHECK_EQUAL(0, (nibbleLog.count - 4) % 2);
+		CHECK_EQUAL((nibbleLog.count - 4) / 2, hd.historyLength - 4);
+		for (uint16_t i = 4; i + 1 < nibbleLog.count; i += 2)
+		{
+			uint16_t byte = (nibbleLog.nibbles[i] << 4) | nibbleLog.nibbles[i + 1];
+			if (nibbleLog.rs[i])
+				byte |= HD44780_HISTORY_DATA;
+			CHECK_EQUAL(hd.history[4 + (i - 4) / 2], byte);
+			CHECK_EQUAL(nibbleLog.rs[i], nibbleLog.rs[i + 1]);
+		}
+
+		/* The function set for 4 bits and 2 lines, and the character last */
+		CHECK_EQUAL(0x2, nibbleLog.nibbles[4]);
+		CHECK_EQUAL(0x8, nibbleLog.nibbles[5]);
+		CHECK_EQUAL(0x4, nibbleLog.nibbles[nibbleLog.count - 2]);
+		CHECK_EQUAL(0x1, nibbleLog.nibbles[nibbleLog.count - 1]);
+		CHECK_EQUAL(1, nibbleLog.rs[nibbleLog.count - 1]);
+		CHECK_EQUAL('A', hd.ddram[0]);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	static void test_cgram(void)
+	{
+		static const unsigned char degree[8] = { 0x06, 0x09, 0x09, 0x06, 0x00, 0x00, 0x00, 0x00 };
+
+		setup_8bit();
+		int slot = loadGlyph(&lcd, degree);
+		setCursor(&lcd, 0, 0);
+		write(&lcd, (unsigned char) slot);
+
+		CHECK(slot >= 0 && slot < 8);
+		CHECK(memcmp(&hd.cgram[slot * 8], degree, 8) == 0);
+		CHECK_EQUAL(slot, hd.ddram[0]);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+
+		/* Cached: the same glyph is not uploaded again */
+		uint32_t data = hd.stats.data;
+		CHECK_EQUAL(slot, loadGlyph(&lcd, degree));
+		CHECK_EQUAL(data, hd.stats.data);
+	}
+
+	/* Every glyph cell of the screen shows what the driver put in its slot */
+	static void check_glyph_cells(void)
+	{
+		char text[17];
+
+		for (uint8_t row = 0; row < 2; row++)
+		{
+			hd44780_row(&hd, row, 16, text);
+			for (int col = 0; col < 16; col++)
+			{
+				uint8_t code = (uint8_t) text[col];
+				if (code < 8)
+					CHECK(memcmp(&hd.cgram[code * 8], lcd.glyphs[code], 8) == 0);
+			}
+		}
+	}
+
+	/*
+	 * A day of readings, one frame a minute: the hourly means of temperature
+	 * since midnight as a sparkline (24 columns, 5 cells) with the current
+	 * value, the humidity as a bar (10 cells) with its value. A frame only
+	 * uploads the glyphs that changed, the others stay in their slots
+	 */
+	static void test_history_day(void)
+	{
+		int16_t hourly[24];
+		int32_t sum = 0;
+		uint32_t maxUploads = 0;
+		uint32_t framesUploading = 0;
+		char text[17];
+
+		setup_8bit();
+		frameBufferON(&lcd);
+		srand(9);
+		for (int h = 0; h < 24; h++)
+			hourly[h] = 50;
+
+		for (int minute = 0; minute < 24 * 60; minute++)
+		{
+			/* Coldest at 03:00, warmest at 15:00, humidity the other way, a little noise */
+			double phase = 2 * M_PI * (minute - 9 * 60) / (24 * 60);
+			int32_t temp = (int32_t) lround(180 + 70 * sin(phase)) + rand() % 5 - 2;
+			int32_t rh = (int32_t) lround(600 - 200 * sin(phase)) + rand() % 5 - 2;
+
+			/* Mean of the current hour so far */
+			if (minute % 60 == 0)
+				sum = 0;
+			sum += temp;
+			hourly[minute / 60] = (int16_t) (sum / (minute % 60 + 1));
+
+			uint32_t uploads = lcd.glyphUploads;
+			printSparkline(&lcd, 0, 0, hourly, 24, 50, 300);
+			setCursor(&lcd, 6, 0);
+			print_fixed(&lcd, temp, 1, 5, FMT_ALIGN_RIGHT);
+			print(&lcd, (unsigned char*) " C");
+			printBar(&lcd, 0, 1, rh, 1000, 10);
+			setCursor(&lcd, 11, 1);
+			print_fixed(&lcd, rh, 1, 5, FMT_ALIGN_RIGHT);
+			flush(&lcd);
+			uploads = lcd.glyphUploads - uploads;
+
+			/* The first frame loads the whole screen */
+			if (minute == 0)
+				CHECK(uploads <= 6);
+			else if (uploads > maxUploads)
+				maxUploads = uploads;
+			if (uploads)
+				framesUploading++;
+
+			/* Every sparkline cell got its glyph, no '_' */
+			hd44780_row(&hd, 0, 16, text);
+			for (int col = 0; col < 5; col++)
+				CHECK((uint8_t) text[col] < 8);
+			check_glyph_cells();
+		}
+
+		/* A cache miss per cell would upload the 5 sparkline cells and the bar end every frame */
+		bench_report("glyph uploads per frame", lcd.glyphUploads / 1440.0, "");
+		bench_report("most glyph uploads in a later frame", maxUploads, "");
+		bench_report("frames uploading a glyph", framesUploading, "of 1440");
+		bench_report("glyph uploads without the cache", 6 * 1440, "");
+		CHECK(maxUploads <= 2);
+		CHECK(lcd.glyphUploads < 1440 / 10);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	/* The main loop calls processQueue, the execution time is waited out on the cycle counter */
+	static void test_async_mode(void)
+	{
+		setup_8bit();
+		asyncON(&lcd, NULL);
+
+		uint32_t bytes = hd.stats.data + hd.stats.instructions;
+		uint64_t start = mock_now_ns();
+		print_station();
+		CHECK(mock_now_ns() - start < 20000);	// queued, nothing waited for
+
+		uint32_t calls = 0;
+		start = mock_now_ns();
+		while (!isIdle(&lcd) && calls < 1000000)
+		{
+			processQueue(&lcd);
+			mock_run_ns(1000);
+			calls++;
+		}
+		uint64_t elapsed = mock_now_ns() - start;
+
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+		/* 22 bytes (21 characters and the cursor move) of LCD_EXEC_NS each, not whole milliseconds of HAL ticks */
+		CHECK_EQUAL(22, hd.stats.data + hd.stats.instructions - bytes);
+		CHECK(elapsed >= 22 * 50000ULL);
+		CHECK(elapsed < 22 * 60000ULL);
+	}
+
+	/* A slot still shown on the LCD is not reused before the flush that replaces it */
+	static void test_glyph_on_lcd(void)
+	{
+		unsigned char bitmaps[9][8];
+
+		setup_8bit();
+		frameBufferON(&lcd);
+		memset(bitmaps, 0, sizeof(bitmaps));
+		for (int i = 0; i < 9; i++)
+			bitmaps[i][0] = (unsigned char) (i + 1);
+
+		/* All eight slots on screen */
+		for (int i = 0; i < 8; i++)
+		{
+			int slot = loadGlyph(&lcd, bitmaps[i]);
+			CHECK(slot >= 0);
+			setCursor(&lcd, i, 0);
+			write(&lcd, (unsigned char) slot);
+		}
+		flush(&lcd);
+
+		/* The first glyph leaves the frame buffer, but the LCD shows it until the flush */
+		setCursor(&lcd, 0, 0);
+		write(&lcd, ' ');
+		CHECK_EQUAL(-1, loadGlyph(&lcd, bitmaps[8]));
+		CHECK(memcmp(&hd.cgram[0], bitmaps[0], 8) == 0);
+
+		flush(&lcd);
+		int slot = loadGlyph(&lcd, bitmaps[8]);
+		CHECK(slot >= 0);
+		CHECK(memcmp(&hd.cgram[slot * 8], bitmaps[8], 8) == 0);
+		/* The other cells keep their glyphs */
+		for (int i = 1; i < 8; i++)
+			CHECK(memcmp(&hd.cgram[hd.ddram[i] * 8], bitmaps[i], 8) == 0);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	static void test_dma_mode(void)
+	{
+		setup_8bit();
+		setup_dma();
+		print_station();
+		dmaCommit(&lcd);
+		wait_idle();
+
+		CHECK(isIdle(&lcd));
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	/* At 1 us per tick a clear needs 2200 empty words, more than a buffer: the wait runs on into the next ones */
+	static void test_dma_split_wait(void)
+	{
+		setup_8bit();
+		print(&lcd, (unsigned char*) "old text");
+		mock_tim_init(&htim1, TIM1, 0, 83);
+		memset(&hdma_tim1_up, 0, sizeof(hdma_tim1_up));
+		__HAL_LINKDMA(&htim1, hdma[TIM_DMA_ID_UPDATE], hdma_tim1_up);
+		dmaON(&lcd, &htim1, &hdma_tim1_up, 1000);
+
+		uint64_t start = mock_now_ns();
+		clear(&lcd);
+		dmaCommit(&lcd);
+		CHECK(lcd.dmaCarry > LCD_DMA_WORDS);
+
+		/* No room until the last of the wait is in a buffer, the buffers are chained meanwhile */
+		CHECK_EQUAL(0, queueSpace(&lcd));
+		while (queueSpace(&lcd) == 0)
+			mock_run_ns(10000);
+		CHECK(mock_now_ns() - start > 3 * LCD_DMA_WORDS * 1000ULL);
+
+		print(&lcd, (unsigned char*) "21.5 C");
+		dmaCommit(&lcd);
+		wait_idle();
+
+		CHECK(isIdle(&lcd));
+		check_rows("21.5 C          ", "                ");
+		CHECK_EQUAL(0, hd.stats.busyWrites);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+		CHECK(mock_now_ns() - start > LCD_EXEC_LONG_NS);
+	}
+
+	/* Writes wait for room: after a clear still owing its wait, and rows longer than a buffer */
+	static void test_dma_full_buffer(void)
+	{
+		setup_8bit();
+		mock_tim_init(&htim1, TIM1, 0, 83);
+		memset(&hdma_tim1_up, 0, sizeof(hdma_tim1_up));
+		__HAL_LINKDMA(&htim1, hdma[TIM_DMA_ID_UPDATE], hdma_tim1_up);
+		dmaON(&lcd, &htim1, &hdma_tim1_up, 1000);
+
+		/* 40 words per byte at 1 us per tick, 12 bytes per buffer */
+		clear(&lcd);
+		CHECK(lcd.dmaCarry > 0);
+		print(&lcd, (unsigned char*) "Temperature 21.5");
+		setCursor(&lcd, 0, 1);
+		print(&lcd, (unsigned char*) "Humidity  40.0 %");
+		dmaCommit(&lcd);
+		wait_idle();
+
+		CHECK(isIdle(&lcd));
+		check_rows("Temperature 21.5", "Humidity  40.0 %");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	/* A commit refused while the previous buffer is still going out is sent when it is done */
+	static void test_dma_commit_retry(void)
+	{
+		setup_8bit();
+		setup_dma();
+		print(&lcd, (unsigned char*) "Temp: 21.5 C");
+		CHECK_EQUAL(1, dmaCommit(&lcd));
+		setCursor(&lcd, 0, 1);
+		print(&lcd, (unsigned char*) "RH: 40.0%");
+		CHECK_EQUAL(0, dmaCommit(&lcd));
+
+		wait_idle();
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	/* Ticks below LCD_DMA_MIN_TICK_NS are refused, the display stays in blocking mode */
+	static void test_dma_min_tick(void)
+	{
+		setup_8bit();
+		mock_tim_init(&htim1, TIM1, 0, 3);
+		memset(&hdma_tim1_up, 0, sizeof(hdma_tim1_up));
+		__HAL_LINKDMA(&htim1, hdma[TIM_DMA_ID_UPDATE], hdma_tim1_up);
+		dmaON(&lcd, &htim1, &hdma_tim1_up, 48);
+
+		CHECK_EQUAL(LCD_WRITE_BLOCKING, lcd.writemode);
+		print_station();
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+	}
+
+	static void test_i2c(void)
+	{
+		setup_port();
+		memset(&hi2c1, 0, sizeof(hi2c1));
+		hi2c1.State = HAL_I2C_STATE_READY;
+		hd44780_attach_pcf8574(&hd, 0x27);
+		i2c_setup(&lcd, &hi2c1, 0x27);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+		print_station();
+
+		CHECK(hd.fourBit);
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	/* PCF8574 bytes: P0 = rs, P2 = E, P3 = backlight, D7 - D4 on P7 - P4, E dropped after each nibble */
+	static void test_i2c_stream(void)
+	{
+		static const uint8_t reset[8] = { 0x3C, 0x38, 0x3C, 0x38, 0x3C, 0x38, 0x2C, 0x28 };
+		static const uint8_t character[5] = { 0x09, 0x4D, 0x49, 0x1D, 0x19 };	// 'A' = 0x41
+
+		setup_port();
+		memset(&hi2c1, 0, sizeof(hi2c1));
+		hi2c1.State = HAL_I2C_STATE_READY;
+		hd44780_attach_pcf8574(&hd, 0x27);
+		i2c_setup(&lcd, &hi2c1, 0x27);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+
+		/* Reset sequence, one transaction per nibble */
+		CHECK(memcmp(hd.pcfLog, reset, sizeof(reset)) == 0);
+
+		/* A character: rs settles first, then both nibbles in the same transaction */
+		uint32_t bytes = hd.pcfBytes;
+		uint32_t transactions = hd.pcfTransactions;
+		write(&lcd, 'A');
+		CHECK_EQUAL(1, hd.pcfTransactions - transactions);
+		CHECK_EQUAL(sizeof(character), hd.pcfBytes - bytes);
+		CHECK(memcmp(&hd.pcfLog[bytes], character, sizeof(character)) == 0);
+
+		/* 40 characters do not fit in one LCD_I2C_BUFFER: 1 + 32 x 4 bytes, then 8 x 4 */
+		bytes = hd.pcfBytes;
+		transactions = hd.pcfTransactions;
+		print(&lcd, (unsigned char*) "0123456789012345678901234567890123456789");
+		CHECK_EQUAL(2, hd.pcfTransactions - transactions);
+		CHECK_EQUAL(1 + 40 * 4, hd.pcfBytes - bytes);
+		CHECK_EQUAL('A', hd.ddram[0]);
+		CHECK_EQUAL('9', hd.ddram[40]);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	/* Second display on the same pins of GPIOB, both with the station screen in their frame buffers */
+	static void setup_two(unsigned char waitmode)
+	{
+		GPIO_InitTypeDef init = { 0 };
+
+		setup_8bit();
+		memset(&lcd2, 0, sizeof(lcd2));
+		hd44780_init(&hd2);
+		init.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4 | GPIO_PIN_5 | GPIO_PIN_6
+				| GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10;
+		init.Mode = GPIO_MODE_OUTPUT_PP;
+		HAL_GPIO_Init(GPIOB, &init);
+		hd44780_attach_gpio(&hd2, GPIOB, dataPins, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		pin_setup(&lcd2, GPIOB, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8, GPIO_PIN_9,
+				GPIO_PIN_10, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		begin(&lcd2, 16, 2, LCD_5x8DOTS);
+
+		LCD_HandleTypeDef *both[2] = { &lcd, &lcd2 };
+		for (int i = 0; i < 2; i++)
+		{
+			setWaitMode(both[i], waitmode);
+			frameBufferON(both[i]);
+			print(both[i], (unsigned char*) "Temp: 21.5 C");
+			setCursor(both[i], 0, 1);
+			print(both[i], (unsigned char*) "RH: 40.0%");
+		}
+	}
+
+	/* flushAll interleaves the displays, each keeps the bus timings (no back to back phases) */
+	static void test_flush_all(unsigned char waitmode)
+	{
+		LCD_HandleTypeDef *both[2] = { &lcd, &lcd2 };
+		char text[17];
+
+		/* One display alone, then both */
+		setup_two(waitmode);
+		uint64_t start = mock_now_ns();
+		flushAll(both, 1);
+		uint64_t one = mock_now_ns() - start;
+
+		setup_two(waitmode);
+		start = mock_now_ns();
+		flushAll(both, 2);
+		uint64_t two = mock_now_ns() - start;
+
+		check_rows("Temp: 21.5 C    ", "RH: 40.0%       ");
+		hd44780_row(&hd2, 0, 16, text);
+		CHECK_TEXT("Temp: 21.5 C    ", text);
+		hd44780_row(&hd2, 1, 16, text);
+		CHECK_TEXT("RH: 40.0%       ", text);
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+		CHECK_EQUAL(0, hd44780_violations(&hd2));
+		CHECK_EQUAL(LCD_WRITE_BLOCKING, lcd.writemode);
+
+		/* About as long as the slowest display, not the sum */
+		CHECK(two < one * 3 / 2);
+	}
+
+	/* The station screen as the render task draws it, into the frame buffer */
+	static uint32_t render(int32_t temp, int32_t rh)
+	{
+		uint32_t sent = hd.stats.instructions + hd.stats.data;
+
+		setCursor(&lcd, 6, 0);
+		print_fixed(&lcd, temp, 1, 5, FMT_ALIGN_RIGHT);
+		print(&lcd, (unsigned char*) " C");
+		setCursor(&lcd, 4, 1);
+		print_fixed(&lcd, rh, 1, 5, FMT_ALIGN_RIGHT);
+		print(&lcd, (unsigned char*) "%");
+		flush(&lcd);
+
+		return hd.stats.instructions + hd.stats.data - sent;
+	}
+
+	/* Bytes on the bus per flush over a recorded run of readings: only changed cells go out */
+	static void test_flush_diff(void)
+	{
+		setup_8bit();
+		frameBufferON(&lcd);
+		print(&lcd, (unsigned char*) "Temp: ");
+		setCursor(&lcd, 0, 1);
+		print(&lcd, (unsigned char*) "RH: ");
+		flush(&lcd);
+
+		/* First reading: "21.5", "C" (the space before it unchanged) and "40.0%", each an address and a run */
+		CHECK_EQUAL(1 + 4 + 1 + 1 + 1 + 5, render(215, 400));
+		check_rows("Temp:  21.5 C   ", "RH:  40.0%      ");
+
+		/* Same reading: nothing at all */
+		CHECK_EQUAL(0, render(215, 400));
+		CHECK_EQUAL(0, render(215, 400));
+
+		/* One digit: its address and the digit */
+		CHECK_EQUAL(2, render(216, 400));
+		CHECK_EQUAL(LCD_SETDDRAMADDR | 10, hd.history[hd.historyLength - 2]);
+		CHECK_EQUAL(HD44780_HISTORY_DATA | '6', hd.history[hd.historyLength - 1]);
+		CHECK_EQUAL(2, render(216, 401));
+
+		/* 21.6 -> 22.0: two runs around the unchanged '.', which is not resent */
+		CHECK_EQUAL(4, render(220, 401));
+		CHECK_EQUAL(LCD_SETDDRAMADDR | 8, hd.history[hd.historyLength - 4]);
+		CHECK_EQUAL(HD44780_HISTORY_DATA | '2', hd.history[hd.historyLength - 3]);
+		CHECK_EQUAL(LCD_SETDDRAMADDR | 10, hd.history[hd.historyLength - 2]);
+		CHECK_EQUAL(HD44780_HISTORY_DATA | '0', hd.history[hd.historyLength - 1]);
+
+		/* Both rows change */
+		CHECK_EQUAL(4, render(221, 400));
+		/* Sign change: "22.1" -> "-3.5", runs "-3" and "5" on both sides of the '.' */
+		CHECK_EQUAL(1 + 2 + 1 + 1, render(-35, 400));
+		CHECK_EQUAL(0, render(-35, 400));
+
+		check_rows("Temp:  -3.5 C   ", "RH:  40.0%      ");
+		CHECK_EQUAL(0, hd44780_violations(&hd));
+	}
+
+	int main(void)
+	{
+		test_begin();
+		test_delay_mode();
+		test_busy_flag_mode();
+		test_busy_flag_timing();
+		test_busy_flag_timeout();
+		test_4bit();
+		test_4bit_nibble_order();
+		test_cgram();
+		test_glyph_on_lcd();
+		test_history_day();
+		test_async_mode();
+		test_dma_mode();
+		test_dma_split_wait();
+		test_dma_full_buffer();
+		test_dma_commit_retry();
+		test_dma_min_tick();
+		test_i2c();
+		test_i2c_stream();
+		test_flush_diff();
+		test_flush_all(LCD_WAIT_DELAY);
+		test_flush_all(LCD_WAIT_BUSYFLAG);
+
+		return test_report("LiquidCrystalTest");
+	}
@@ -0,0 +1,101 @@
+/*
+ *  BME280Device.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ */
+
+#include "BME280Device.h"
+#include <string.h>
+
+	static void put16(BME280Device_HandleTypeDef *hdev, uint8_t reg, uint16_t value)
+	{
+		hdev->regs[reg] = (uint8_t) value;
+		hdev->regs[reg + 1] = (uint8_t) (value >> 8);
+	}
+
+	static uint8_t start(void *context, uint8_t read)
+	{
+		BME280Device_HandleTypeDef *hdev = (BME280Device_HandleTypeDef*) context;
+
+		hdev->stats.transactions++;
+		if (!hdev->present)
+		{
+			hdev->stats.nacks++;
+			return 0;
+		}
+		hdev->addressing = !read;
+		return 1;
+	}
+
+	static void write(void *context, uint8_t data)
+	{
+		BME280Device_HandleTypeDef *hdev = (BME280Device_HandleTypeDef*) context;
+
+		if (hdev->addressing)
+		{
+			hdev->pointer = data;
+			hdev->addressing = 0;
+			return;
+		}
+		hdev->regs[hdev->pointer++] = data;
+		hdev->stats.writes++;
+	}
+
+	static uint8_t read(void *context)
+	{
+		BME280Device_HandleTypeDef *hdev = (BME280Device_HandleTypeDef*) context;
+
+		hdev->stats.reads++;
+		return hdev->regs[hdev->pointer++];
+	}
+
+	void bme280_device_init(BME280Device_HandleTypeDef *hdev)
+	{
+		memset(hdev, 0, sizeof(*hdev));
+		hdev->present = 1;
+		hdev->regs[0xD0] = 0x60;
+		bme280_device_set_raw(hdev, 0x80000, 0x80000, 0x8000);
+	}
+
+	void bme280_device_attach(BME280Device_HandleTypeDef *hdev, uint16_t address)
+	{
+		hdev->i2cDevice.start = start;
+		hdev->i2cDevice.write = write;
+		hdev->i2cDevice.read = read;
+		hdev->i2cDevice.stop = NULL;
+		hdev->i2cDevice.context = hdev;
+		mock_i2c_attach(address, &hdev->i2cDevice);
+	}
+
+	void bme280_device_set_calib(BME280Device_HandleTypeDef *hdev, const BME280Device_CalibTypeDef *calib)
+	{
+		const int16_t p[] = { calib->P2, calib->P3, calib->P4, calib->P5, calib->P6, calib->P7, calib->P8,
+				calib->P9 };
+
+		put16(hdev, 0x88, calib->T1);
+		put16(hdev, 0x8A, (uint16_t) calib->T2);
+		put16(hdev, 0x8C, (uint16_t) calib->T3);
+		put16(hdev, 0x8E, calib->P1);
+		for (int i = 0; i < 8; i++)
+			put16(hdev, (uint8_t) (0x90 + 2 * i), (uint16_t) p[i]);
+		hdev->regs[0xA1] = calib->H1;
+		put16(hdev, 0xE1, (uint16_t) calib->H2);
+		hdev->regs[0xE3] = calib->H3;
+		hdev->regs[0xE4] = (uint8_t) (calib->H4 >> 4);
+		hdev->regs[0xE5] = (uint8_t) ((calib->H4 & 0x0F) | ((calib->H5 & 0x0F) << 4));
+		hdev->regs[0xE6] = (uint8_t) (calib->H5 >> 4);
+		hdev->regs[0xE7] = (uint8_t) calib->H6;
+	}
+
+	void bme280_device_set_raw(BME280Device_HandleTypeDef *hdev, uint32_t adcP, uint32_t adcT, uint16_t adcH)
+	{
+		hdev->regs[0xF7] = (uint8_t) (adcP >> 12);
+		hdev->regs[0xF8] = (uint8_t) (adcP >> 4);
+		hdev->regs[0xF9] = (uint8_t) (adcP << 4);
+		hdev->regs[0xFA] = (uint8_t) (adcT >> 12);
+		hdev->regs[0xFB] = (uint8_t) (adcT >> 4);
+		hdev->regs[0xFC] = (uint8_t) (adcT << 4);
+		hdev->regs[0xFD] = (uint8_t) (adcH >> 8);
+		hdev->regs[0xFE] = (uint8_t) adcH;
+	}
@@ -0,0 +1,102 @@
+/*
+ *  BME280Device.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Emulated BME280 on a mock I2C address, for the host tests (see
+ *  "HalMock.h").
+ *
+ *  The sensor is its register file: a write sets the register pointer with
+ *  its first byte and stores the following bytes, a read returns the
+ *  registers from the pointer on, both with auto-increment. The chip id,
+ *  the calibration and the result registers are set up by the test, the
+ *  result registers hold the "skipped" values after power-on.
+ */
+
+#ifndef MOCK_BME280DEVICE_H_
+#define MOCK_BME280DEVICE_H_
+
+#include "HalMock.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compensation parameters as trimmed in the factory (dig_T1 to dig_H6)
+ */
+typedef struct
+{
+	uint16_t T1;
+	int16_t T2, T3;
+	uint16_t P1;
+	int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+	uint8_t H1;
+	int16_t H2;
+	uint8_t H3;
+	int16_t H4, H5;
+	int8_t H6;
+} BME280Device_CalibTypeDef;
+
+/*
+ * Traffic since bme280_device_init
+ */
+typedef struct
+{
+	uint32_t transactions;		// addressed transfers (write and read parts counted apart)
+	uint32_t nacks;				// transfers not acknowledged
+	uint32_t reads;				// bytes read
+	uint32_t writes;			// registers written
+} BME280Device_StatsTypeDef;
+
+typedef struct
+{
+	uint8_t regs[256];
+	uint8_t present;			// 0 to not acknowledge the address
+	uint8_t pointer;			// register of the next access
+	uint8_t addressing;			// next written byte is the register pointer
+	MockI2C_DeviceTypeDef i2cDevice;
+	BME280Device_StatsTypeDef stats;
+} BME280Device_HandleTypeDef;
+
+	/*
+	 * @brief	Power-on state: chip id 0x60, blank calibration, skipped
+	 * 			results, not wired
+	 * @param	hdev handle
+	 * @retval	None
+	 */
+	void bme280_device_init(BME280Device_HandleTypeDef *hdev);
+
+	/*
+	 * @brief	Wire the sensor to an address of the mock I2C bus
+	 * @param	hdev handle, initialized
+	 * @param	address 8-bit (shifted) address
+	 * @retval	None
+	 */
+	void bme280_device_attach(BME280Device_HandleTypeDef *hdev, uint16_t address);
+
+	/*
+	 * @brief	Pack compensation parameters into the calibration registers
+	 * 			(0x88 - 0xA1 and 0xE1 - 0xE7, H4 and H5 sharing 0xE5)
+	 * @param	hdev handle
+	 * @param	calib parameters
+	 * @retval	None
+	 */
+	void bme280_device_set_calib(BME280Device_HandleTypeDef *hdev, const BME280Device_CalibTypeDef *calib);
+
+	/*
+	 * @brief	Result registers of a conversion (0xF7 - 0xFE)
+	 * @param	hdev handle
+	 * @param	adcP raw pressure (20 bits)
+	 * @param	adcT raw temperature (20 bits)
+	 * @param	adcH raw humidity (16 bits)
+	 * @retval	None
+	 */
+	void bme280_device_set_raw(BME280Device_HandleTypeDef *hdev, uint32_t adcP, uint32_t adcT, uint16_t adcH);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MOCK_BME280DEVICE_H_ */
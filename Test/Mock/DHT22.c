@@ -0,0 +1,179 @@
+/*
+ *  DHT22.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ */
+
+#include "DHT22.h"
+#include <string.h>
+
+	static uint64_t scaled_cycles(const DHT22_HandleTypeDef *hdht, uint32_t ns)
+	{
+		return MOCK_NS_CYCLES((uint64_t) ns * hdht->scale / 100U);
+	}
+
+	/* The MCU has the pin as an output */
+	static uint8_t mcu_output(const DHT22_HandleTypeDef *hdht)
+	{
+		int index = __builtin_ctz(hdht->pin);
+
+		return ((hdht->port->MODER >> (2 * index)) & 3U) == 1U;
+	}
+
+	uint8_t dht22_line(const DHT22_HandleTypeDef *hdht)
+	{
+		if (mcu_output(hdht))
+			return (hdht->port->ODR & hdht->pin) != 0;
+
+		return !hdht->sensorLow;
+	}
+
+	/* Answer a start pulse that ended at cycle t */
+	static void respond(DHT22_HandleTypeDef *hdht, uint64_t t)
+	{
+		uint64_t at = t + scaled_cycles(hdht, hdht->latencyNs);
+		uint64_t gapNs = MOCK_CYCLES_NS(hdht->lowSince - hdht->lastStart);
+		uint16_t count = 0;
+
+		if (hdht->stats.starts && (hdht->stats.minGapNs == 0 || gapNs < hdht->stats.minGapNs))
+			hdht->stats.minGapNs = gapNs;
+		hdht->stats.starts++;
+		hdht->lastStart = hdht->lowSince;
+
+		hdht->edges[count++] = at;
+		at += scaled_cycles(hdht, hdht->responseNs);
+		hdht->edges[count++] = at;
+		at += scaled_cycles(hdht, hdht->responseNs);
+		hdht->edges[count++] = at;
+
+		for (int i = 0; i < hdht->bits && i < 40; i++)
+		{
+			uint8_t one = (hdht->data[i / 8] >> (7 - i % 8)) & 1U;
+			at += scaled_cycles(hdht, hdht->lowNs);
+			hdht->edges[count++] = at;
+			at += scaled_cycles(hdht, one ? hdht->oneNs : hdht->zeroNs);
+			hdht->edges[count++] = at;
+		}
+
+		/* Line let go after the last low */
+		at += scaled_cycles(hdht, hdht->lowNs);
+		hdht->edges[count++] = at;
+
+		hdht->edgeCount = count;
+		hdht->nextEdge = 0;
+	}
+
+	static void store(void *context, GPIO_TypeDef *port, unsigned int reg)
+	{
+		DHT22_HandleTypeDef *hdht = (DHT22_HandleTypeDef*) context;
+		uint8_t output = mcu_output(hdht);
+		uint8_t low = output && !(port->ODR & hdht->pin);
+		uint64_t t = mock_cycles();
+
+		(void) reg;
+		if (output && !low && hdht->sensorLow)
+			hdht->stats.contentions++;
+
+		if (low && !hdht->mcuLow)
+		{
+			hdht->mcuLow = 1;
+			hdht->lowSince = t;
+		}
+		else if (!low && hdht->mcuLow)
+		{
+			hdht->mcuLow = 0;
+			hdht->stats.heldNs += MOCK_CYCLES_NS(t - hdht->lowSince);
+			if (t - hdht->lowSince < MOCK_NS_CYCLES(hdht->startNs))
+			{
+				hdht->stats.shortStarts++;
+				return;
+			}
+
+			if (hdht->stats.pulses < DHT22_PULSE_LOG)
+				hdht->pulseLog[hdht->stats.pulses] = MOCK_CYCLES_NS(hdht->lowSince);
+			hdht->stats.pulses++;
+			if (hdht->respond)
+			{
+				/* A start in the middle of a frame stops it */
+				if (hdht->nextEdge < hdht->edgeCount)
+					hdht->stats.aborted++;
+				respond(hdht, t);
+			}
+		}
+	}
+
+	static uint32_t load(void *context, GPIO_TypeDef *port, uint32_t idr)
+	{
+		DHT22_HandleTypeDef *hdht = (DHT22_HandleTypeDef*) context;
+
+		(void) port;
+		if (mcu_output(hdht))
+			return idr;
+
+		return dht22_line(hdht) ? idr | hdht->pin : idr & ~(uint32_t) hdht->pin;
+	}
+
+	static uint64_t next(void *context, uint64_t after)
+	{
+		DHT22_HandleTypeDef *hdht = (DHT22_HandleTypeDef*) context;
+
+		(void) after;
+		return hdht->nextEdge < hdht->edgeCount ? hdht->edges[hdht->nextEdge] : UINT64_MAX;
+	}
+
+	static void fire(void *context, uint64_t cycle)
+	{
+		DHT22_HandleTypeDef *hdht = (DHT22_HandleTypeDef*) context;
+		uint8_t rising = hdht->nextEdge & 1U;
+
+		(void) cycle;
+		hdht->sensorLow = !rising;
+		hdht->nextEdge++;
+		if (hdht->nextEdge == DHT22_EDGES - 1 && hdht->edgeCount == DHT22_EDGES)
+			hdht->stats.frames++;
+
+		if (!mcu_output(hdht))
+			mock_exti_edge(hdht->pin, rising);
+	}
+
+	void dht22_init(DHT22_HandleTypeDef *hdht)
+	{
+		memset(hdht, 0, sizeof(*hdht));
+		hdht->respond = 1;
+		hdht->bits = 40;
+		hdht->scale = 100;
+		hdht->startNs = DHT22_START_NS;
+		hdht->latencyNs = DHT22_LATENCY_NS;
+		hdht->responseNs = DHT22_RESPONSE_NS;
+		hdht->lowNs = DHT22_LOW_NS;
+		hdht->zeroNs = DHT22_ZERO_NS;
+		hdht->oneNs = DHT22_ONE_NS;
+	}
+
+	void dht22_attach(DHT22_HandleTypeDef *hdht, GPIO_TypeDef *port, uint16_t pin)
+	{
+		hdht->port = port;
+		hdht->pin = pin;
+
+		hdht->gpioDevice.store = store;
+		hdht->gpioDevice.load = load;
+		hdht->gpioDevice.context = hdht;
+		mock_gpio_attach(port, &hdht->gpioDevice);
+
+		hdht->eventSource.next = next;
+		hdht->eventSource.fire = fire;
+		hdht->eventSource.context = hdht;
+		mock_event_add(&hdht->eventSource);
+	}
+
+	void dht22_set_reading(DHT22_HandleTypeDef *hdht, int16_t RH, int16_t temp)
+	{
+		uint16_t magnitude = temp < 0 ? (uint16_t) -temp : (uint16_t) temp;
+
+		hdht->data[0] = (uint8_t) (RH >> 8);
+		hdht->data[1] = (uint8_t) RH;
+		hdht->data[2] = (uint8_t) ((magnitude >> 8) | (temp < 0 ? 0x80 : 0));
+		hdht->data[3] = (uint8_t) magnitude;
+		hdht->data[4] = (uint8_t) (hdht->data[0] + hdht->data[1] + hdht->data[2] + hdht->data[3]);
+	}
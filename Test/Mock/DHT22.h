@@ -0,0 +1,133 @@
+/*
+ *  DHT22.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Emulated DHT22 (AM2302) on a pin of a mock GPIO port, for the host tests
+ *  (see "HalMock.h").
+ *
+ *  The sensor watches the line: a low pulse of the MCU of at least the start
+ *  time is answered once the MCU lets the line go high, with the response
+ *  (80 us low, 80 us high) and the 40 bits of the frame (50 us low, then
+ *  26 us high for a 0 or 70 us high for a 1), after which the sensor lets
+ *  the line go. The edges are events on the mock clock and raise the EXTI
+ *  line of the pin when the MCU has it as an interrupt input.
+ *
+ *  Faults of the field can be set up: no answer, a frame cut short, a wrong
+ *  check-sum (raw data) and every timing stretched or shrunk.
+ */
+
+#ifndef MOCK_DHT22_H_
+#define MOCK_DHT22_H_
+
+#include "HalMock.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Timings (datasheet, typical) in nanoseconds */
+#define DHT22_START_NS 1000000		// shortest start pulse the sensor answers
+#define DHT22_LATENCY_NS 30000		// line high to the response (20 - 40 us)
+#define DHT22_RESPONSE_NS 80000		// response low and response high
+#define DHT22_LOW_NS 50000			// low before every bit and after the last one
+#define DHT22_ZERO_NS 26000			// high of a 0 bit (26 - 28 us)
+#define DHT22_ONE_NS 70000			// high of a 1 bit
+
+/* Edges of a frame: response low and high, start of the first bit, 2 per bit, release */
+#define DHT22_EDGES 84
+
+/* Start pulses kept in the log */
+#define DHT22_PULSE_LOG 64
+
+/*
+ * Traffic since dht22_init
+ */
+typedef struct
+{
+	uint32_t pulses;			// start pulses, answered or not
+	uint32_t starts;			// start pulses answered
+	uint32_t shortStarts;		// low pulses of the MCU too short for a start
+	uint32_t frames;			// frames sent to the last bit
+	uint32_t aborted;			// frames cut by a new start pulse
+	uint32_t contentions;		// MCU drove the line high while the sensor held it low
+	uint64_t minGapNs;			// shortest time between the beginnings of two answered start pulses
+	uint64_t heldNs;			// time the MCU held the line low, start pulses included
+} DHT22_StatsTypeDef;
+
+typedef struct
+{
+	/* Frame sent on the next start (RH, temp, check-sum) */
+	uint8_t data[5];
+
+	/* Behaviour */
+	uint8_t respond;			// 0 to ignore start pulses
+	uint8_t bits;				// bits sent before the sensor lets the line go (40 = full frame)
+	uint32_t scale;				// percent applied to every timing (100 = nominal)
+	uint32_t startNs;
+	uint32_t latencyNs;
+	uint32_t responseNs;
+	uint32_t lowNs;
+	uint32_t zeroNs;
+	uint32_t oneNs;
+
+	/* Line */
+	GPIO_TypeDef *port;
+	uint16_t pin;
+	uint8_t sensorLow;			// the sensor pulls the line low
+	uint8_t mcuLow;				// the MCU drives the line low
+	uint64_t lowSince;			// cycle the MCU started driving low
+	uint64_t lastStart;			// cycle the last answered start pulse began
+	MockGpio_DeviceTypeDef gpioDevice;
+
+	/* Time every start pulse began (ns), answered or not, oldest first */
+	uint64_t pulseLog[DHT22_PULSE_LOG];
+
+	/* Frame being sent, edge cycles (falling on even indexes) */
+	uint64_t edges[DHT22_EDGES];
+	uint16_t edgeCount;
+	uint16_t nextEdge;
+	MockEvent_SourceTypeDef eventSource;
+
+	DHT22_StatsTypeDef stats;
+} DHT22_HandleTypeDef;
+
+	/*
+	 * @brief	Power-on state: nominal timings, answers with a full frame of
+	 * 			0.0 % and 0.0 C, not wired
+	 * @param	hdht handle
+	 * @retval	None
+	 */
+	void dht22_init(DHT22_HandleTypeDef *hdht);
+
+	/*
+	 * @brief	Wire the sensor to a pin of a mock GPIO port (with its pull-up)
+	 * @param	hdht handle, initialized
+	 * @param	port GPIO port
+	 * @param	pin GPIO_PIN_x of the line
+	 * @retval	None
+	 */
+	void dht22_attach(DHT22_HandleTypeDef *hdht, GPIO_TypeDef *port, uint16_t pin);
+
+	/*
+	 * @brief	Frame of a reading, encoded as a DHT22 does, with its check-sum
+	 * @param	hdht handle
+	 * @param	RH humidity x10
+	 * @param	temp temperature x10
+	 * @retval	None
+	 */
+	void dht22_set_reading(DHT22_HandleTypeDef *hdht, int16_t RH, int16_t temp);
+
+	/*
+	 * @brief	Level of the line
+	 * @param	hdht handle
+	 * @retval	1 high, 0 low
+	 */
+	uint8_t dht22_line(const DHT22_HandleTypeDef *hdht);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MOCK_DHT22_H_ */
@@ -0,0 +1,442 @@
+/*
+ *  HD44780.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ */
+
+#include "HD44780.h"
+#include <string.h>
+
+/* PCF8574 pins */
+#define PCF_RS 0x01U
+#define PCF_RW 0x02U
+#define PCF_E 0x04U
+
+	/*
+	 * DDRAM index of an address (two lines of 40 at 0x00 and 0x40, or one of 80)
+	 */
+	static uint8_t ddram_index(const HD44780_HandleTypeDef *hlcd, uint8_t address)
+	{
+		if (!(hlcd->function & 0x08))
+			return address % 80;
+
+		return (address & 0x40) ? 40 + (address & 0x3F) % 40 : (address & 0x3F) % 40;
+	}
+
+	static void ac_move(HD44780_HandleTypeDef *hlcd)
+	{
+		uint8_t increment = (hlcd->entry & 0x02) != 0;
+
+		if (hlcd->cgramSelected)
+		{
+			hlcd->ac = (hlcd->ac + (increment ? 1 : 63)) & 0x3F;
+			return;
+		}
+
+		if (hlcd->function & 0x08)
+		{
+			if (increment)
+				hlcd->ac = hlcd->ac == 0x27 ? 0x40 : hlcd->ac == 0x67 ? 0x00 : hlcd->ac + 1;
+			else
+				hlcd->ac = hlcd->ac == 0x00 ? 0x67 : hlcd->ac == 0x40 ? 0x27 : hlcd->ac - 1;
+		}
+		else
+			hlcd->ac = increment ? (hlcd->ac + 1) % 80 : (hlcd->ac + 79) % 80;
+	}
+
+	static void display_shift(HD44780_HandleTypeDef *hlcd, uint8_t left)
+	{
+		hlcd->shift = (hlcd->shift + (left ? 1 : 39)) % 40;
+	}
+
+	static uint64_t exec_ns(const HD44780_HandleTypeDef *hlcd, uint32_t ns)
+	{
+		return (uint64_t) ns * hlcd->scale / 100U;
+	}
+
+	/* A complete byte was written */
+	static void execute(HD44780_HandleTypeDef *hlcd, uint8_t value, uint8_t rs, uint64_t t)
+	{
+		uint32_t ns = HD44780_EXEC_NS;
+
+		if (hlcd->historyLength < HD44780_HISTORY)
+			hlcd->history[hlcd->historyLength++] = value | (rs ? HD44780_HISTORY_DATA : 0);
+
+		if (rs)
+		{
+			hlcd->stats.data++;
+			if (hlcd->cgramSelected)
+				hlcd->cgram[hlcd->ac & 0x3F] = value;
+			else
+				hlcd->ddram[ddram_index(hlcd, hlcd->ac)] = value;
+			ac_move(hlcd);
+			if (!hlcd->cgramSelected && (hlcd->entry & 0x01))
+				display_shift(hlcd, (hlcd->entry & 0x02) != 0);
+		}
+		else
+		{
+			hlcd->stats.instructions++;
+			if (value & 0x80)
+			{
+				hlcd->cgramSelected = 0;
+				hlcd->ac = value & 0x7F;
+			}
+			else if (value & 0x40)
+			{
+				hlcd->cgramSelected = 1;
+				hlcd->ac = value & 0x3F;
+			}
+			else if (value & 0x20)
+			{
+				hlcd->function = value & 0x1C;
+				hlcd->fourBit = !(value & 0x10);
+			}
+			else if (value & 0x10)
+			{
+				if (value & 0x08)
+					display_shift(hlcd, !(value & 0x04));
+				else
+				{
+					uint8_t entry = hlcd->entry;
+					hlcd->entry = (value & 0x04) ? 0x02 : 0x00;
+					ac_move(hlcd);
+					hlcd->entry = entry;
+				}
+			}
+			else if (value & 0x08)
+				hlcd->display = value & 0x07;
+			else if (value & 0x04)
+				hlcd->entry = value & 0x03;
+			else if (value & 0x02)
+			{
+				hlcd->cgramSelected = 0;
+				hlcd->ac = 0;
+				hlcd->shift = 0;
+				ns = HD44780_LONG_NS;
+			}
+			else if (value & 0x01)
+			{
+				memset(hlcd->ddram, ' ', sizeof(hlcd->ddram));
+				hlcd->cgramSelected = 0;
+				hlcd->ac = 0;
+				hlcd->shift = 0;
+				hlcd->entry |= 0x02;
+				ns = HD44780_LONG_NS;
+			}
+		}
+
+		hlcd->busyUntil = t + exec_ns(hlcd, ns);
+	}
+
+	/* Byte a read returns now */
+	static uint8_t read_value(const HD44780_HandleTypeDef *hlcd, uint8_t rs)
+	{
+		if (!rs)
+			return (hd44780_busy(hlcd) ? 0x80 : 0x00) | (hlcd->ac & 0x7F);
+
+		if (hlcd->cgramSelected)
+			return hlcd->cgram[hlcd->ac & 0x3F];
+
+		return hlcd->ddram[ddram_index(hlcd, hlcd->ac)];
+	}
+
+	static void enable_rise(HD44780_HandleTypeDef *hlcd, uint64_t t)
+	{
+		if (hlcd->stats.pulses && t - hlcd->rise < HD44780_CYCLE_NS)
+			hlcd->stats.shortCycles++;
+		if (t - hlcd->controlChanged < HD44780_AS_NS)
+			hlcd->stats.setupErrors++;
+
+		hlcd->stats.pulses++;
+		hlcd->rise = t;
+		hlcd->contended = 0;
+	}
+
+	/* Latches on the fall of E, levels are the ones E was high with */
+	static void enable_fall(HD44780_HandleTypeDef *hlcd, uint64_t t, uint16_t levels)
+	{
+		uint8_t rs = (levels & HD44780_BUS_RS) != 0;
+		uint8_t value = levels & HD44780_BUS_DATA;
+
+		if (t - hlcd->rise < HD44780_PW_EH_NS)
+			hlcd->stats.shortPulses++;
+
+		if (levels & HD44780_BUS_RW)
+		{
+			if (hlcd->fourBit && !hlcd->readLow)
+			{
+				hlcd->readLow = 1;
+				return;
+			}
+			hlcd->readLow = 0;
+			hlcd->stats.reads++;
+			if (rs)
+				ac_move(hlcd);
+			return;
+		}
+
+		hlcd->readLow = 0;
+		if (t - hlcd->dataChanged < HD44780_DSW_NS)
+			hlcd->stats.setupErrors++;
+
+		if (hd44780_busy(hlcd))
+		{
+			hlcd->stats.busyWrites++;
+			return;
+		}
+
+		if (!hlcd->fourBit)
+		{
+			execute(hlcd, value, rs, t);
+			return;
+		}
+
+		if (!hlcd->nibble)
+		{
+			hlcd->nibble = 1;
+			hlcd->nibbleValue = value & 0xF0;
+			return;
+		}
+		hlcd->nibble = 0;
+		execute(hlcd, hlcd->nibbleValue | (value >> 4), rs, t);
+	}
+
+	void hd44780_bus(HD44780_HandleTypeDef *hlcd, uint16_t levels)
+	{
+		uint64_t t = mock_now_ns();
+		uint16_t previous = hlcd->levels;
+		uint16_t changed = levels ^ previous;
+
+		if (!changed)
+			return;
+
+		hlcd->levels = levels;
+		if (changed & HD44780_BUS_DATA)
+			hlcd->dataChanged = t;
+		if (changed & (HD44780_BUS_RS | HD44780_BUS_RW))
+		{
+			/* RS and R/W must hold while E is high */
+			if (previous & levels & HD44780_BUS_E)
+				hlcd->stats.setupErrors++;
+			hlcd->controlChanged = t;
+		}
+
+		if (changed & HD44780_BUS_E)
+		{
+			if (levels & HD44780_BUS_E)
+				enable_rise(hlcd, t);
+			else
+				enable_fall(hlcd, t, previous);
+		}
+	}
+
+	uint8_t hd44780_sample(HD44780_HandleTypeDef *hlcd)
+	{
+		uint8_t value;
+
+		if (mock_now_ns() - hlcd->rise < HD44780_DDR_NS)
+			hlcd->stats.earlyReads++;
+
+		value = read_value(hlcd, (hlcd->levels & HD44780_BUS_RS) != 0);
+		if (hlcd->fourBit)
+			value = hlcd->readLow ? (uint8_t) (value << 4) : (value & 0xF0);
+
+		return value;
+	}
+
+	uint8_t hd44780_busy(const HD44780_HandleTypeDef *hlcd)
+	{
+		return mock_now_ns() < hlcd->busyUntil;
+	}
+
+	/*
+	 * GPIO wiring
+	 */
+	static uint16_t gpio_levels(HD44780_HandleTypeDef *hlcd, GPIO_TypeDef *port)
+	{
+		uint32_t odr = port->ODR;
+		uint16_t levels = 0;
+
+		for (int i = 0; i < 8; i++)
+			if (hlcd->pins[i] && (odr & hlcd->pins[i]))
+				levels |= 1U << i;
+		if (odr & hlcd->rs)
+			levels |= HD44780_BUS_RS;
+		if (odr & hlcd->rw)
+			levels |= HD44780_BUS_RW;
+		if (odr & hlcd->e)
+			levels |= HD44780_BUS_E;
+
+		return levels;
+	}
+
+	static uint8_t reading(const HD44780_HandleTypeDef *hlcd)
+	{
+		return (hlcd->levels & (HD44780_BUS_RW | HD44780_BUS_E)) == (HD44780_BUS_RW | HD44780_BUS_E);
+	}
+
+	/* MCU and controller both drive a data line, counted once per pulse */
+	static void check_contention(HD44780_HandleTypeDef *hlcd, GPIO_TypeDef *port)
+	{
+		if (!reading(hlcd) || hlcd->contended)
+			return;
+
+		for (int i = 0; i < 8; i++)
+		{
+			if (!hlcd->pins[i])
+				continue;
+
+			int position = __builtin_ctz(hlcd->pins[i]);
+			if (((port->MODER >> (2 * position)) & 3U) == 1U)
+			{
+				hlcd->stats.contentions++;
+				hlcd->contended = 1;
+				return;
+			}
+		}
+	}
+
+	static void gpio_store(void *context, GPIO_TypeDef *port, unsigned int reg)
+	{
+		HD44780_HandleTypeDef *hlcd = (HD44780_HandleTypeDef*) context;
+
+		if (reg != MOCK_GPIO_BSRR && reg != MOCK_GPIO_ODR && reg != MOCK_GPIO_MODER)
+			return;
+
+		hd44780_bus(hlcd, gpio_levels(hlcd, port));
+		check_contention(hlcd, port);
+	}
+
+	static uint32_t gpio_load(void *context, GPIO_TypeDef *port, uint32_t idr)
+	{
+		HD44780_HandleTypeDef *hlcd = (HD44780_HandleTypeDef*) context;
+
+		if (!reading(hlcd))
+			return idr;
+
+		check_contention(hlcd, port);
+
+		uint8_t value = hd44780_sample(hlcd);
+		for (int i = 0; i < 8; i++)
+		{
+			if (!hlcd->pins[i])
+				continue;
+
+			int position = __builtin_ctz(hlcd->pins[i]);
+			if (((port->MODER >> (2 * position)) & 3U) == 1U)
+				continue;
+
+			if (value & (1U << i))
+				idr |= hlcd->pins[i];
+			else
+				idr &= ~(uint32_t) hlcd->pins[i];
+		}
+
+		return idr;
+	}
+
+	/*
+	 * PCF8574 wiring
+	 */
+	static uint16_t pcf_levels(uint8_t pins)
+	{
+		uint16_t levels = pins & 0xF0;
+
+		if (pins & PCF_RS)
+			levels |= HD44780_BUS_RS;
+		if (pins & PCF_RW)
+			levels |= HD44780_BUS_RW;
+		if (pins & PCF_E)
+			levels |= HD44780_BUS_E;
+
+		return levels;
+	}
+
+	static uint8_t pcf_start(void *context, uint8_t read)
+	{
+		HD44780_HandleTypeDef *hlcd = (HD44780_HandleTypeDef*) context;
+
+		(void) read;
+		hlcd->pcfTransactions++;
+		return 1;
+	}
+
+	static void pcf_write(void *context, uint8_t data)
+	{
+		HD44780_HandleTypeDef *hlcd = (HD44780_HandleTypeDef*) context;
+
+		if (hlcd->pcfBytes < HD44780_PCF_LOG)
+			hlcd->pcfLog[hlcd->pcfBytes] = data;
+		hlcd->pcfBytes++;
+		hlcd->pcfLatch = data;
+		hd44780_bus(hlcd, pcf_levels(data));
+	}
+
+	/* Quasi-bidirectional pins: a pin written high reads what the controller drives */
+	static uint8_t pcf_read(void *context)
+	{
+		HD44780_HandleTypeDef *hlcd = (HD44780_HandleTypeDef*) context;
+		uint8_t pins = hlcd->pcfLatch;
+
+		if (reading(hlcd))
+			pins &= 0x0F | hd44780_sample(hlcd);
+
+		return pins;
+	}
+
+	/*
+	 * Setup and inspection
+	 */
+	void hd44780_init(HD44780_HandleTypeDef *hlcd)
+	{
+		memset(hlcd, 0, sizeof(*hlcd));
+		memset(hlcd->ddram, ' ', sizeof(hlcd->ddram));
+		hlcd->entry = 0x02;
+		hlcd->function = 0x10;
+		hlcd->scale = 100;
+	}
+
+	void hd44780_attach_gpio(HD44780_HandleTypeDef *hlcd, GPIO_TypeDef *port, const uint16_t data[8],
+			uint16_t rs, uint16_t rw, uint16_t e)
+	{
+		hlcd->port = port;
+		memcpy(hlcd->pins, data, sizeof(hlcd->pins));
+		hlcd->rs = rs;
+		hlcd->rw = rw;
+		hlcd->e = e;
+
+		hlcd->gpioDevice.store = gpio_store;
+		hlcd->gpioDevice.load = gpio_load;
+		hlcd->gpioDevice.context = hlcd;
+		mock_gpio_attach(port, &hlcd->gpioDevice);
+	}
+
+	void hd44780_attach_pcf8574(HD44780_HandleTypeDef *hlcd, uint8_t address)
+	{
+		hlcd->i2cDevice.start = pcf_start;
+		hlcd->i2cDevice.write = pcf_write;
+		hlcd->i2cDevice.read = pcf_read;
+		hlcd->i2cDevice.stop = NULL;
+		hlcd->i2cDevice.context = hlcd;
+		mock_i2c_attach((uint16_t) address << 1, &hlcd->i2cDevice);
+	}
+
+	void hd44780_row(const HD44780_HandleTypeDef *hlcd, uint8_t row, uint8_t cols, char *text)
+	{
+		static const uint8_t lineStart[4] = { 0x00, 0x40, 0x00, 0x40 };
+		uint8_t offset = (row >= 2) ? cols : 0;
+
+		for (uint8_t col = 0; col < cols; col++)
+		{
+			uint8_t position = (uint8_t) ((offset + col + hlcd->shift) % 40);
+			text[col] = (char) hlcd->ddram[ddram_index(hlcd, lineStart[row & 3] + position)];
+		}
+		text[cols] = '\0';
+	}
+
+	uint32_t hd44780_violations(const HD44780_HandleTypeDef *hlcd)
+	{
+		return hlcd->stats.busyWrites + hlcd->stats.shortPulses + hlcd->stats.shortCycles
+				+ hlcd->stats.setupErrors + hlcd->stats.earlyReads + hlcd->stats.contentions;
+	}
@@ -0,0 +1,191 @@
+/*
+ *  HD44780.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Emulated HD44780 controller for the host tests, on GPIO pins of the mock
+ *  (see "HalMock.h") or behind an emulated PCF8574 I2C backpack.
+ *
+ *  The controller follows the bus levels with their time on the mock clock:
+ *  bytes and nibbles are latched on the falling edge of E, reads drive the
+ *  data pins the MCU left as inputs with the busy flag and address counter or
+ *  with RAM data. Instructions keep the state of the real controller (DDRAM,
+ *  CGRAM, address counter, entry mode, display shift, 4/8-bit interface) and
+ *  keep it busy for its execution time, a write while busy is dropped.
+ *
+ *  Every bus timing rule the drivers rely on is checked and counted, so a test
+ *  can require a clean bus on top of the right screen contents.
+ */
+
+#ifndef MOCK_HD44780_H_
+#define MOCK_HD44780_H_
+
+#include "HalMock.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Bus timings (datasheet, VCC = 4.5 - 5.5 V) in nanoseconds */
+#define HD44780_PW_EH_NS 450		// enable pulse width (high)
+#define HD44780_CYCLE_NS 1000		// enable cycle time, rise to rise
+#define HD44780_AS_NS 40			// RS and R/W setup before the rise of E
+#define HD44780_DSW_NS 80			// data setup before the fall of E
+#define HD44780_DDR_NS 360			// data delay of a read after the rise of E
+
+/* Execution times at the nominal 270 kHz oscillator */
+#define HD44780_EXEC_NS 37000
+#define HD44780_LONG_NS 1520000
+
+/* Bus levels: D0 - D7 in bits 0 - 7, then RS, R/W and E */
+#define HD44780_BUS_DATA 0x00FFU
+#define HD44780_BUS_RS 0x0100U
+#define HD44780_BUS_RW 0x0200U
+#define HD44780_BUS_E 0x0400U
+
+/* Bytes kept in the history (bit 8 set for data, clear for instructions) */
+#define HD44780_HISTORY 4096
+#define HD44780_HISTORY_DATA 0x100U
+
+/* PCF8574 bytes kept in the stream log */
+#define HD44780_PCF_LOG 1024
+
+/*
+ * Rule violations and traffic since hd44780_init
+ */
+typedef struct
+{
+	uint32_t instructions;		// instructions executed
+	uint32_t data;				// data bytes written
+	uint32_t reads;				// complete reads (busy flag or data)
+	uint32_t pulses;			// rising edges of E
+	uint32_t busyWrites;		// writes dropped because the controller was busy
+	uint32_t shortPulses;		// E high for less than HD44780_PW_EH_NS
+	uint32_t shortCycles;		// E rise to rise less than HD44780_CYCLE_NS
+	uint32_t setupErrors;		// RS, R/W or data changed too close to an edge of E
+	uint32_t earlyReads;		// data sampled less than HD44780_DDR_NS after the rise
+	uint32_t contentions;		// MCU drove data pins during a read
+} HD44780_StatsTypeDef;
+
+typedef struct
+{
+	/* Controller state */
+	uint8_t ddram[80];
+	uint8_t cgram[64];
+	uint8_t ac;					// address counter
+	uint8_t cgramSelected;		// AC points to CGRAM
+	uint8_t entry;				// entry mode bits (I/D, S)
+	uint8_t display;			// display control bits (D, C, B)
+	uint8_t function;			// function set bits (DL, N, F)
+	uint8_t shift;				// display shift, 0 - 39 to the left
+	uint8_t fourBit;			// 4-bit interface, bytes in two nibbles
+	uint8_t nibble;				// high nibble of a 4-bit write is held
+	uint8_t nibbleValue;
+	uint8_t readLow;			// next 4-bit read returns the low nibble
+	uint64_t busyUntil;			// ns on the mock clock
+
+	/* Execution time scale in percent (100 = nominal, 150 = slow oscillator) */
+	uint32_t scale;
+
+	/* Bus */
+	uint16_t levels;
+	uint64_t rise;
+	uint64_t controlChanged;
+	uint64_t dataChanged;
+	uint8_t contended;
+
+	/* GPIO wiring, pins of the port (0 = not connected) */
+	GPIO_TypeDef *port;
+	uint16_t pins[8];
+	uint16_t rs;
+	uint16_t rw;
+	uint16_t e;
+	MockGpio_DeviceTypeDef gpioDevice;
+
+	/* PCF8574 backpack (P0 = RS, P1 = R/W, P2 = E, P3 = backlight, P4 - P7 = D4 - D7) */
+	uint8_t pcfLatch;
+	uint8_t pcfLog[HD44780_PCF_LOG];
+	uint32_t pcfBytes;
+	uint32_t pcfTransactions;
+	MockI2C_DeviceTypeDef i2cDevice;
+
+	/* Executed bytes, oldest first */
+	uint16_t history[HD44780_HISTORY];
+	uint32_t historyLength;
+
+	HD44780_StatsTypeDef stats;
+} HD44780_HandleTypeDef;
+
+	/*
+	 * @brief	Power-on state: 8-bit interface, DDRAM blank, not busy, no wiring
+	 * @param	hlcd handle
+	 * @retval	None
+	 */
+	void hd44780_init(HD44780_HandleTypeDef *hlcd);
+
+	/*
+	 * @brief	Wire the controller to pins of a mock GPIO port
+	 * @param	hlcd handle, initialized
+	 * @param	port GPIO port of all the pins
+	 * @param	data GPIO_PIN_x of D0 - D7, 0 for the lines left open (D0 - D3 on a 4-bit bus)
+	 * @param	rs/rw/e GPIO_PIN_x of the control lines
+	 * @retval	None
+	 */
+	void hd44780_attach_gpio(HD44780_HandleTypeDef *hlcd, GPIO_TypeDef *port, const uint16_t data[8],
+			uint16_t rs, uint16_t rw, uint16_t e);
+
+	/*
+	 * @brief	Wire the controller behind a PCF8574 at an I2C address
+	 * @param	hlcd handle, initialized
+	 * @param	address 7-bit address of the backpack
+	 * @retval	None
+	 */
+	void hd44780_attach_pcf8574(HD44780_HandleTypeDef *hlcd, uint8_t address);
+
+	/*
+	 * @brief	New bus levels at the current time of the mock clock
+	 * @param	hlcd handle
+	 * @param	levels HD44780_BUS_x bits
+	 * @retval	None
+	 */
+	void hd44780_bus(HD44780_HandleTypeDef *hlcd, uint16_t levels);
+
+	/*
+	 * @brief	Data lines as driven by the controller during a read (D7 - D4 only
+	 * 			on a 4-bit interface), counted as an early read before tDDR
+	 * @param	hlcd handle
+	 * @retval	D7 - D0 levels
+	 */
+	uint8_t hd44780_sample(HD44780_HandleTypeDef *hlcd);
+
+	/*
+	 * @brief	Whether the controller is executing an instruction
+	 * @param	hlcd handle
+	 * @retval	1 while busy
+	 */
+	uint8_t hd44780_busy(const HD44780_HandleTypeDef *hlcd);
+
+	/*
+	 * @brief	Characters shown on a row, with the display shift
+	 * 			(rows start at 0x00, 0x40, cols, 0x40 + cols as set by begin)
+	 * @param	hlcd handle
+	 * @param	row row 0 - 3
+	 * @param	cols columns of the display
+	 * @param	text cols + 1 characters, null terminated
+	 * @retval	None
+	 */
+	void hd44780_row(const HD44780_HandleTypeDef *hlcd, uint8_t row, uint8_t cols, char *text);
+
+	/*
+	 * @brief	Total of the rule violations in the statistics
+	 * @param	hlcd handle
+	 * @retval	0 for a clean bus
+	 */
+	uint32_t hd44780_violations(const HD44780_HandleTypeDef *hlcd);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MOCK_HD44780_H_ */
@@ -0,0 +1,1054 @@
+/*
+ *  HalMock.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ */
+
+#include "HalMock.h"
+#include <string.h>
+
+#define CYCLES_PER_MS (MOCK_CORE_HZ / 1000U)
+
+/* Cycles of an interrupt entry, a HAL tick or state read, an SWO character */
+#define INTERRUPT_CYCLES 12
+#define POLL_CYCLES 4
+#define ITM_CYCLES 8
+
+#define MOCK_DEVICES 16
+#define MOCK_STREAMS 4
+
+/* Timer flags handled by the model (SR and DIER share the bit positions) */
+#define TIM_FLAGS (TIM_IT_UPDATE | TIM_IT_CC1 | TIM_IT_CC2 | TIM_IT_CC3 | TIM_IT_CC4)
+
+	uint32_t SystemCoreClock = MOCK_CORE_HZ;
+	GPIO_TypeDef mock_gpio_ports[MOCK_GPIO_PORTS];
+	TIM_TypeDef mock_timers[MOCK_TIMERS];
+	EXTI_TypeDef mock_exti;
+	CoreDebug_Type mock_core_debug;
+
+	/* Cycles since mock_reset, every event up to it has been handled */
+	static uint64_t now;
+	static DWT_Type dwt;
+	static uint32_t primask;
+	static uint8_t inInterrupt;
+
+	/* Counter of a running timer is baseCount at cycle base, counting from there */
+	typedef struct
+	{
+		TIM_HandleTypeDef *htim;
+		uint64_t base;
+		uint32_t baseCount;
+		uint32_t starts;
+	} Timer;
+
+	static Timer timers[MOCK_TIMERS];
+
+	/* Memory to GPIO DMA transfer, one word per update event of the parent timer */
+	typedef struct
+	{
+		DMA_HandleTypeDef *hdma;
+		const uint32_t *source;
+		GPIO_TypeDef *port;
+		unsigned int reg;
+		uint32_t remaining;
+		uint8_t complete;
+	} Stream;
+
+	static Stream streams[MOCK_STREAMS];
+
+	typedef struct
+	{
+		GPIO_TypeDef *port;
+		const MockGpio_DeviceTypeDef *device;
+	} GpioDevice;
+
+	static GpioDevice gpioDevices[MOCK_DEVICES];
+	static int gpioDeviceCount;
+	static uint32_t stores[MOCK_GPIO_PORTS];
+	static uint32_t loads[MOCK_GPIO_PORTS];
+
+	typedef struct
+	{
+		uint16_t address;
+		const MockI2C_DeviceTypeDef *device;
+	} I2cDevice;
+
+	/* I2C transfer as a list of byte steps: address, register address, data */
+	typedef struct
+	{
+		I2C_HandleTypeDef *hi2c;
+		const MockI2C_DeviceTypeDef *device;
+		uint8_t *data;
+		int32_t memAddress;
+		uint16_t step;
+		uint16_t steps;
+		uint8_t read;
+		uint8_t active;
+		uint64_t start;
+	} I2cTransfer;
+
+	static I2cDevice i2cDevices[MOCK_DEVICES];
+	static int i2cDeviceCount;
+	static uint32_t i2cHz;
+	static I2cTransfer i2cDma;
+
+	static const MockEvent_SourceTypeDef *sources[MOCK_DEVICES];
+	static int sourceCount;
+
+	static char itm[1 << 16];
+	static size_t itmLength;
+
+	static void run_until(uint64_t target);
+
+	/*
+	 * Timers
+	 */
+	static int timer_index(const TIM_TypeDef *instance)
+	{
+		return (int) (instance - mock_timers);
+	}
+
+	static uint8_t timer_running(int i)
+	{
+		return (mock_timers[i].CR1 & TIM_CR1_CEN) != 0;
+	}
+
+	static uint64_t timer_period(int i)
+	{
+		return (uint64_t) mock_timers[i].ARR + 1;
+	}
+
+	static uint64_t timer_divider(int i)
+	{
+		return (uint64_t) mock_timers[i].PSC + 1;
+	}
+
+	static uint32_t timer_count(int i)
+	{
+		if (!timer_running(i))
+			return mock_timers[i].CNT;
+
+		return (uint32_t) (((uint64_t) timers[i].baseCount + (now - timers[i].base) / timer_divider(i))
+				% timer_period(i));
+	}
+
+	static void timer_rebase(int i, uint32_t count)
+	{
+		timers[i].base = now;
+		timers[i].baseCount = count;
+		mock_timers[i].CNT = count;
+	}
+
+	/* Cycle of the first tick after now that brings the counter to value */
+	static uint64_t timer_next(int i, uint32_t value)
+	{
+		uint64_t period = timer_period(i);
+		if (value >= period)
+			return UINT64_MAX;
+
+		uint64_t offset = ((uint64_t) value + period - timers[i].baseCount % period) % period;
+		uint64_t first = (now - timers[i].base) / timer_divider(i) + 1;
+		uint64_t tick = offset;
+		if (tick < first)
+			tick += (first - offset + period - 1) / period * period;
+
+		return timers[i].base + tick * timer_divider(i);
+	}
+
+	/* Events a timer generates: update (bit 0) and the compare channels */
+	static uint32_t timer_events(int i)
+	{
+		if (!timer_running(i))
+			return 0;
+
+		uint32_t events = mock_timers[i].DIER & (TIM_IT_CC1 | TIM_IT_CC2 | TIM_IT_CC3 | TIM_IT_CC4);
+		if (mock_timers[i].DIER & (TIM_IT_UPDATE | TIM_DMA_UPDATE))
+			events |= TIM_IT_UPDATE;
+
+		return events;
+	}
+
+	static uint64_t timer_event_next(int i, uint32_t event)
+	{
+		if (event == TIM_IT_UPDATE)
+			return timer_next(i, 0);
+
+		return timer_next(i, (&mock_timers[i].CCR1)[__builtin_ctz(event) - 1]);
+	}
+
+	/* Software events written to EGR (UG reloads the counter) */
+	static void timer_generate(void)
+	{
+		for (int i = 0; i < MOCK_TIMERS; i++)
+		{
+			uint32_t egr = mock_timers[i].EGR;
+			if (!egr)
+				continue;
+
+			mock_timers[i].EGR = 0;
+			mock_timers[i].SR |= egr & TIM_FLAGS;
+			if (egr & TIM_IT_UPDATE)
+				timer_rebase(i, 0);
+		}
+	}
+
+	/*
+	 * GPIO
+	 */
+	static int port_index(const void *port)
+	{
+		return (int) ((const GPIO_TypeDef*) port - mock_gpio_ports);
+	}
+
+	static void gpio_write(GPIO_TypeDef *port, unsigned int reg, uint32_t value)
+	{
+		volatile uint32_t *words = (volatile uint32_t*) port;
+
+		stores[port_index(port)]++;
+		if (reg == MOCK_GPIO_BSRR)
+			port->ODR = (port->ODR & ~(value >> 16)) | (value & 0xFFFFU);
+		else if (reg != MOCK_GPIO_IDR)
+			words[reg] = value;
+
+		for (int i = 0; i < gpioDeviceCount; i++)
+			if (gpioDevices[i].port == port && gpioDevices[i].device->store)
+				gpioDevices[i].device->store(gpioDevices[i].device->context, port, reg);
+	}
+
+	static uint32_t gpio_read(GPIO_TypeDef *port, unsigned int reg)
+	{
+		volatile uint32_t *words = (volatile uint32_t*) port;
+
+		loads[port_index(port)]++;
+		if (reg == MOCK_GPIO_BSRR)
+			return 0;
+		if (reg != MOCK_GPIO_IDR)
+			return words[reg];
+
+		/* Output pins read back their own level, the devices add theirs */
+		uint32_t outputs = 0;
+		for (int pin = 0; pin < 16; pin++)
+			if (((port->MODER >> (2 * pin)) & 3U) == 1U)
+				outputs |= 1U << pin;
+
+		uint32_t idr = port->ODR & outputs;
+		for (int i = 0; i < gpioDeviceCount; i++)
+			if (gpioDevices[i].port == port && gpioDevices[i].device->load)
+				idr = gpioDevices[i].device->load(gpioDevices[i].device->context, port, idr);
+
+		port->IDR = idr;
+		return idr;
+	}
+
+	/*
+	 * DMA
+	 */
+	static void stream_request(int timer)
+	{
+		for (int i = 0; i < MOCK_STREAMS; i++)
+		{
+			Stream *stream = &streams[i];
+			if (!stream->hdma || !stream->remaining)
+				continue;
+
+			TIM_HandleTypeDef *parent = (TIM_HandleTypeDef*) stream->hdma->Parent;
+			if (!parent || parent->Instance != &mock_timers[timer])
+				continue;
+
+			gpio_write(stream->port, stream->reg, *stream->source++);
+			if (--stream->remaining == 0)
+				stream->complete = 1;
+		}
+	}
+
+	/*
+	 * I2C
+	 */
+	static uint64_t i2c_byte_cycles(void)
+	{
+		return (9ULL * MOCK_CORE_HZ + i2cHz - 1) / i2cHz;
+	}
+
+	static void i2c_begin(I2cTransfer *transfer, I2C_HandleTypeDef *hi2c, uint16_t address, int32_t memAddress,
+			uint8_t *data, uint16_t size, uint8_t read)
+	{
+		transfer->hi2c = hi2c;
+		transfer->device = NULL;
+		for (int i = 0; i < i2cDeviceCount; i++)
+			if (i2cDevices[i].address == address)
+				transfer->device = i2cDevices[i].device;
+
+		transfer->data = data;
+		transfer->memAddress = memAddress;
+		transfer->read = read;
+		transfer->step = 0;
+		transfer->steps = 1 + size + (memAddress >= 0 ? 1 + read : 0);
+		transfer->start = now;
+
+		hi2c->State = read ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+		hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+	}
+
+	/* Byte of the next step, 0 if an address byte was not acknowledged */
+	static uint8_t i2c_step(I2cTransfer *transfer)
+	{
+		const MockI2C_DeviceTypeDef *device = transfer->device;
+		uint32_t step = transfer->step++;
+
+		if (step == 0)
+			return device && device->start(device->context, transfer->memAddress >= 0 ? 0 : transfer->read);
+
+		step--;
+		if (transfer->memAddress >= 0)
+		{
+			if (step == 0)
+			{
+				device->write(device->context, (uint8_t) transfer->memAddress);
+				return 1;
+			}
+			step--;
+			if (transfer->read && step-- == 0)
+				return device->start(device->context, 1);
+		}
+
+		if (transfer->read)
+			transfer->data[step] = device->read(device->context);
+		else
+			device->write(device->context, transfer->data[step]);
+
+		return 1;
+	}
+
+	static void i2c_finish(I2cTransfer *transfer, uint8_t ack)
+	{
+		if (transfer->device && transfer->device->stop)
+			transfer->device->stop(transfer->device->context);
+
+		transfer->active = 0;
+		transfer->hi2c->ErrorCode = ack ? HAL_I2C_ERROR_NONE : HAL_I2C_ERROR_AF;
+		transfer->hi2c->State = HAL_I2C_STATE_READY;
+	}
+
+	static uint8_t i2c_ready(I2C_HandleTypeDef *hi2c)
+	{
+		return hi2c->State == HAL_I2C_STATE_READY || hi2c->State == HAL_I2C_STATE_RESET;
+	}
+
+	static HAL_StatusTypeDef i2c_blocking(I2C_HandleTypeDef *hi2c, uint16_t address, int32_t memAddress,
+			uint8_t *data, uint16_t size, uint8_t read)
+	{
+		I2cTransfer transfer;
+		uint8_t ack = 1;
+
+		if (!i2c_ready(hi2c))
+			return HAL_BUSY;
+
+		i2c_begin(&transfer, hi2c, address, memAddress, data, size, read);
+		while (ack && transfer.step < transfer.steps)
+		{
+			run_until(now + i2c_byte_cycles());
+			ack = i2c_step(&transfer);
+		}
+		i2c_finish(&transfer, ack);
+
+		return ack ? HAL_OK : HAL_ERROR;
+	}
+
+	static HAL_StatusTypeDef i2c_dma(I2C_HandleTypeDef *hi2c, uint16_t address, int32_t memAddress,
+			uint8_t *data, uint16_t size, uint8_t read)
+	{
+		if (!i2c_ready(hi2c) || i2cDma.active)
+			return HAL_BUSY;
+
+		i2c_begin(&i2cDma, hi2c, address, memAddress, data, size, read);
+		i2cDma.active = 1;
+
+		return HAL_OK;
+	}
+
+	/*
+	 * Event loop
+	 */
+
+	/* Nothing can happen on the clock but time passing */
+	static uint8_t quiet(void)
+	{
+		if (sourceCount || i2cDma.active || (mock_exti.PR & mock_exti.IMR))
+			return 0;
+
+		for (int i = 0; i < MOCK_TIMERS; i++)
+			if (mock_timers[i].EGR || timer_events(i) || (mock_timers[i].SR & mock_timers[i].DIER & TIM_FLAGS))
+				return 0;
+
+		for (int i = 0; i < MOCK_STREAMS; i++)
+			if (streams[i].hdma)
+				return 0;
+
+		return 1;
+	}
+
+	static uint64_t next_event(void)
+	{
+		uint64_t next = UINT64_MAX;
+
+		for (int i = 0; i < MOCK_TIMERS; i++)
+		{
+			uint32_t events = timer_events(i);
+			while (events)
+			{
+				uint32_t event = events & -events;
+				uint64_t at = timer_event_next(i, event);
+				if (at < next)
+					next = at;
+				events &= ~event;
+			}
+		}
+
+		if (i2cDma.active)
+		{
+			uint64_t at = i2cDma.start + (i2cDma.step + 1) * i2c_byte_cycles();
+			if (at < next)
+				next = at;
+		}
+
+		for (int i = 0; i < sourceCount; i++)
+		{
+			uint64_t at = sources[i]->next(sources[i]->context, now);
+			if (at < next)
+				next = at;
+		}
+
+		return next;
+	}
+
+	/* Hardware side of every event due at cycle at (the first one after now) */
+	static void fire(uint64_t at)
+	{
+		uint32_t timerDue[MOCK_TIMERS] = { 0 };
+		uint8_t sourceDue[MOCK_DEVICES] = { 0 };
+		uint8_t i2cDue = i2cDma.active && i2cDma.start + (i2cDma.step + 1) * i2c_byte_cycles() == at;
+
+		for (int i = 0; i < MOCK_TIMERS; i++)
+		{
+			uint32_t events = timer_events(i);
+			while (events)
+			{
+				uint32_t event = events & -events;
+				if (timer_event_next(i, event) == at)
+					timerDue[i] |= event;
+				events &= ~event;
+			}
+		}
+		for (int i = 0; i < sourceCount; i++)
+			sourceDue[i] = sources[i]->next(sources[i]->context, now) == at;
+
+		now = at;
+
+		for (int i = 0; i < MOCK_TIMERS; i++)
+		{
+			mock_timers[i].SR |= timerDue[i];
+			if ((timerDue[i] & TIM_IT_UPDATE) && (mock_timers[i].DIER & TIM_DMA_UPDATE))
+				stream_request(i);
+		}
+
+		if (i2cDue)
+		{
+			uint8_t ack = i2c_step(&i2cDma);
+			if (!ack || i2cDma.step == i2cDma.steps)
+				i2c_finish(&i2cDma, ack);
+		}
+
+		for (int i = 0; i < sourceCount; i++)
+			if (sourceDue[i])
+				sources[i]->fire(sources[i]->context, at);
+	}
+
+	static void interrupt_entry(void)
+	{
+		run_until(now + INTERRUPT_CYCLES);
+	}
+
+	/* Interrupt callbacks of everything pending, unless masked or already in one */
+	static void deliver(void)
+	{
+		if (primask || inInterrupt)
+			return;
+
+		inInterrupt = 1;
+		for (;;)
+		{
+			timer_generate();
+
+			uint32_t lines = mock_exti.PR & mock_exti.IMR;
+			if (lines)
+			{
+				uint32_t line = lines & -lines;
+				mock_exti.PR &= ~line;
+				interrupt_entry();
+				HAL_GPIO_EXTI_Callback((uint16_t) line);
+				continue;
+			}
+
+			int handled = 0;
+			for (int i = 0; i < MOCK_STREAMS && !handled; i++)
+			{
+				if (!streams[i].hdma || !streams[i].complete)
+					continue;
+
+				DMA_HandleTypeDef *hdma = streams[i].hdma;
+				streams[i].hdma = NULL;
+				streams[i].complete = 0;
+				interrupt_entry();
+				if (hdma->XferCpltCallback)
+					hdma->XferCpltCallback(hdma);
+				handled = 1;
+			}
+
+			for (int i = 0; i < MOCK_TIMERS && !handled; i++)
+			{
+				TIM_HandleTypeDef *htim = timers[i].htim;
+				uint32_t flags = mock_timers[i].SR & mock_timers[i].DIER & TIM_FLAGS;
+				if (!flags || !htim)
+					continue;
+
+				interrupt_entry();
+				for (int channel = 0; channel < 4; channel++)
+				{
+					uint32_t flag = TIM_IT_CC1 << channel;
+					if (!(mock_timers[i].SR & mock_timers[i].DIER & flag))
+						continue;
+
+					mock_timers[i].SR &= ~flag;
+					htim->Channel = (HAL_TIM_ActiveChannel) (1U << channel);
+					HAL_TIM_OC_DelayElapsedCallback(htim);
+					htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+				}
+				if (mock_timers[i].SR & mock_timers[i].DIER & TIM_IT_UPDATE)
+				{
+					mock_timers[i].SR &= ~TIM_IT_UPDATE;
+					HAL_TIM_PeriodElapsedCallback(htim);
+				}
+				handled = 1;
+			}
+
+			if (!handled)
+				break;
+		}
+		inInterrupt = 0;
+	}
+
+	static void run_until(uint64_t target)
+	{
+		for (;;)
+		{
+			timer_generate();
+			deliver();
+
+			uint64_t at = next_event();
+			if (at > target)
+				break;
+			fire(at);
+		}
+
+		if (now < target)
+			now = target;
+	}
+
+	/* Time taken by an access, atomic when nothing else runs on the clock
+	 * (threads of the scheduler and seqlock tests) */
+	static void advance(uint64_t cycles)
+	{
+		if (quiet())
+		{
+			__atomic_fetch_add(&now, cycles, __ATOMIC_RELAXED);
+			return;
+		}
+		run_until(now + cycles);
+	}
+
+	/*
+	 * Core
+	 */
+	DWT_Type* mock_dwt(void)
+	{
+		advance(MOCK_DWT_CYCLES);
+		dwt.CYCCNT = (uint32_t) __atomic_load_n(&now, __ATOMIC_RELAXED);
+		return &dwt;
+	}
+
+	void __disable_irq(void)
+	{
+		primask = 1;
+	}
+
+	void __enable_irq(void)
+	{
+		primask = 0;
+		deliver();
+	}
+
+	uint32_t __get_PRIMASK(void)
+	{
+		return primask;
+	}
+
+	void __set_PRIMASK(uint32_t priMask)
+	{
+		primask = priMask & 1U;
+		deliver();
+	}
+
+	void __WFI(void)
+	{
+		/* Returns on a pending interrupt even while masked, SysTick wakes every ms */
+		timer_generate();
+		for (int i = 0; i < MOCK_TIMERS; i++)
+			if (mock_timers[i].SR & mock_timers[i].DIER & TIM_FLAGS)
+				return;
+		for (int i = 0; i < MOCK_STREAMS; i++)
+			if (streams[i].complete)
+				return;
+		if (mock_exti.PR & mock_exti.IMR)
+			return;
+
+		uint64_t wake = (now / CYCLES_PER_MS + 1) * CYCLES_PER_MS;
+		uint64_t at = next_event();
+		run_until(at < wake ? at : wake);
+	}
+
+	uint32_t ITM_SendChar(uint32_t ch)
+	{
+		if (itmLength < sizeof(itm) - 1)
+			itm[itmLength++] = (char) ch;
+		advance(ITM_CYCLES);
+		return ch;
+	}
+
+	uint32_t HAL_GetTick(void)
+	{
+		advance(POLL_CYCLES);
+		return (uint32_t) (__atomic_load_n(&now, __ATOMIC_RELAXED) / CYCLES_PER_MS);
+	}
+
+	void HAL_Delay(uint32_t Delay)
+	{
+		uint64_t start = now / CYCLES_PER_MS;
+		uint64_t wait = Delay;
+
+		/* As the HAL: at least Delay full ticks */
+		if (wait < HAL_MAX_DELAY)
+			wait++;
+		run_until((start + wait) * CYCLES_PER_MS);
+	}
+
+	/*
+	 * GPIO
+	 */
+	uint32_t mock_gpio_load(void *port, unsigned int reg)
+	{
+		uint32_t value = gpio_read((GPIO_TypeDef*) port, reg);
+		advance(MOCK_GPIO_CYCLES);
+		return value;
+	}
+
+	void mock_gpio_store(void *port, unsigned int reg, uint32_t value)
+	{
+		gpio_write((GPIO_TypeDef*) port, reg, value);
+		advance(MOCK_GPIO_CYCLES);
+	}
+
+	void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+	{
+		uint32_t moder = GPIOx->MODER;
+
+		for (int pin = 0; pin < 16; pin++)
+		{
+			uint32_t bit = 1U << pin;
+			if (!(GPIO_Init->Pin & bit))
+				continue;
+
+			moder = (moder & ~(3U << (2 * pin))) | ((GPIO_Init->Mode & 3U) << (2 * pin));
+			if (GPIO_Init->Mode & 0x10U)
+				GPIOx->OTYPER |= bit;
+			else
+				GPIOx->OTYPER &= ~bit;
+			GPIOx->PUPDR = (GPIOx->PUPDR & ~(3U << (2 * pin))) | ((GPIO_Init->Pull & 3U) << (2 * pin));
+
+			mock_exti.IMR &= ~bit;
+			mock_exti.RTSR &= ~bit;
+			mock_exti.FTSR &= ~bit;
+			if (GPIO_Init->Mode & 0x10000000U)
+			{
+				mock_exti.IMR |= bit;
+				if (GPIO_Init->Mode & 0x00100000U)
+					mock_exti.RTSR |= bit;
+				if (GPIO_Init->Mode & 0x00200000U)
+					mock_exti.FTSR |= bit;
+			}
+		}
+
+		gpio_write(GPIOx, MOCK_GPIO_MODER, moder);
+		advance(4 * MOCK_HAL_GPIO_CYCLES);
+	}
+
+	GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+	{
+		GPIO_PinState state = (gpio_read(GPIOx, MOCK_GPIO_IDR) & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+		advance(MOCK_HAL_GPIO_CYCLES);
+		return state;
+	}
+
+	void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+	{
+		gpio_write(GPIOx, MOCK_GPIO_BSRR, PinState != GPIO_PIN_RESET ? GPIO_Pin : (uint32_t) GPIO_Pin << 16);
+		advance(MOCK_HAL_GPIO_CYCLES);
+	}
+
+	void mock_exti_clear(uint32_t lines)
+	{
+		mock_exti.PR &= ~lines;
+	}
+
+	/*
+	 * TIM
+	 */
+	uint32_t mock_tim_get_counter(TIM_HandleTypeDef *htim)
+	{
+		advance(MOCK_GPIO_CYCLES);
+		return timer_count(timer_index(htim->Instance));
+	}
+
+	void mock_tim_set_counter(TIM_HandleTypeDef *htim, uint32_t counter)
+	{
+		int i = timer_index(htim->Instance);
+
+		if (timer_running(i))
+			timer_rebase(i, counter);
+		else
+			mock_timers[i].CNT = counter;
+		advance(MOCK_GPIO_CYCLES);
+	}
+
+	void mock_tim_set_autoreload(TIM_HandleTypeDef *htim, uint32_t autoreload)
+	{
+		int i = timer_index(htim->Instance);
+		uint32_t count = timer_count(i);
+
+		/* No preload: effective right away, a counter past it restarts from 0 */
+		mock_timers[i].ARR = autoreload;
+		if (count > autoreload)
+			count = 0;
+		if (timer_running(i))
+			timer_rebase(i, count);
+		else
+			mock_timers[i].CNT = count;
+		advance(MOCK_GPIO_CYCLES);
+	}
+
+	void mock_tim_enable(TIM_HandleTypeDef *htim, uint8_t enable)
+	{
+		int i = timer_index(htim->Instance);
+
+		if (enable && !timer_running(i))
+		{
+			mock_timers[i].CR1 |= TIM_CR1_CEN;
+			timer_rebase(i, mock_timers[i].CNT);
+		}
+		else if (!enable && timer_running(i))
+		{
+			mock_timers[i].CNT = timer_count(i);
+			mock_timers[i].CR1 &= ~TIM_CR1_CEN;
+		}
+		advance(MOCK_GPIO_CYCLES);
+	}
+
+	HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+	{
+		timers[timer_index(htim->Instance)].starts++;
+		mock_tim_enable(htim, 1);
+		return HAL_OK;
+	}
+
+	HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim)
+	{
+		mock_tim_enable(htim, 0);
+		return HAL_OK;
+	}
+
+	HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+	{
+		htim->Instance->DIER |= TIM_IT_UPDATE;
+		return HAL_TIM_Base_Start(htim);
+	}
+
+	HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim)
+	{
+		htim->Instance->DIER &= ~TIM_IT_UPDATE;
+		return HAL_TIM_Base_Stop(htim);
+	}
+
+	HAL_StatusTypeDef HAL_TIM_OC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel)
+	{
+		htim->Instance->DIER |= TIM_IT_CC1 << (Channel >> 2);
+		mock_tim_enable(htim, 1);
+		return HAL_OK;
+	}
+
+	__attribute__((weak)) void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+	{
+		(void) htim;
+	}
+
+	__attribute__((weak)) void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+	{
+		(void) htim;
+	}
+
+	__attribute__((weak)) void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+	{
+		(void) GPIO_Pin;
+	}
+
+	/*
+	 * DMA
+	 */
+	HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress,
+			uint32_t DataLength)
+	{
+		Stream *free = NULL;
+
+		for (int i = 0; i < MOCK_STREAMS; i++)
+		{
+			if (streams[i].hdma == hdma)
+				return HAL_BUSY;
+			if (!streams[i].hdma && !free)
+				free = &streams[i];
+		}
+		if (!free || !DataLength)
+			return HAL_ERROR;
+
+		uintptr_t destination = (uintptr_t) DstAddress;
+		uintptr_t ports = (uintptr_t) mock_gpio_ports;
+		if (destination < ports || destination >= ports + sizeof(mock_gpio_ports))
+			return HAL_ERROR;
+
+		free->hdma = hdma;
+		free->source = (const uint32_t*) (uintptr_t) SrcAddress;
+		free->port = &mock_gpio_ports[(destination - ports) / sizeof(GPIO_TypeDef)];
+		free->reg = (unsigned int) ((destination - (uintptr_t) free->port) / sizeof(uint32_t));
+		free->remaining = DataLength;
+		free->complete = 0;
+		advance(4 * MOCK_GPIO_CYCLES);
+
+		return HAL_OK;
+	}
+
+	/*
+	 * I2C
+	 */
+	HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+			uint16_t Size, uint32_t Timeout)
+	{
+		(void) Timeout;
+		return i2c_blocking(hi2c, DevAddress, -1, pData, Size, 0);
+	}
+
+	HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+			uint16_t Size)
+	{
+		return i2c_dma(hi2c, DevAddress, -1, pData, Size, 0);
+	}
+
+	HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+			uint16_t Size, uint32_t Timeout)
+	{
+		(void) Timeout;
+		return i2c_blocking(hi2c, DevAddress, -1, pData, Size, 1);
+	}
+
+	HAL_StatusTypeDef HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+			uint16_t Size)
+	{
+		return i2c_dma(hi2c, DevAddress, -1, pData, Size, 1);
+	}
+
+	HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+			uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+	{
+		(void) MemAddSize;
+		(void) Timeout;
+		return i2c_blocking(hi2c, DevAddress, MemAddress, pData, Size, 1);
+	}
+
+	HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+			uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+	{
+		(void) MemAddSize;
+		(void) Timeout;
+		return i2c_blocking(hi2c, DevAddress, MemAddress, pData, Size, 0);
+	}
+
+	HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+			uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+	{
+		(void) MemAddSize;
+		return i2c_dma(hi2c, DevAddress, MemAddress, pData, Size, 1);
+	}
+
+	HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c)
+	{
+		advance(POLL_CYCLES);
+		return hi2c->State;
+	}
+
+	uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c)
+	{
+		advance(POLL_CYCLES);
+		return hi2c->ErrorCode;
+	}
+
+	/*
+	 * Controls
+	 */
+	void mock_reset(void)
+	{
+		memset(mock_gpio_ports, 0, sizeof(mock_gpio_ports));
+		memset(mock_timers, 0, sizeof(mock_timers));
+		memset(&mock_exti, 0, sizeof(mock_exti));
+		memset(&mock_core_debug, 0, sizeof(mock_core_debug));
+		memset(&dwt, 0, sizeof(dwt));
+		memset(timers, 0, sizeof(timers));
+		memset(streams, 0, sizeof(streams));
+		memset(&i2cDma, 0, sizeof(i2cDma));
+		memset(stores, 0, sizeof(stores));
+		memset(loads, 0, sizeof(loads));
+
+		SystemCoreClock = MOCK_CORE_HZ;
+		now = 0;
+		primask = 0;
+		inInterrupt = 0;
+		gpioDeviceCount = 0;
+		i2cDeviceCount = 0;
+		sourceCount = 0;
+		i2cHz = MOCK_I2C_HZ;
+		itmLength = 0;
+		itm[0] = '\0';
+	}
+
+	uint64_t mock_cycles(void)
+	{
+		return __atomic_load_n(&now, __ATOMIC_RELAXED);
+	}
+
+	uint64_t mock_now_ns(void)
+	{
+		return MOCK_CYCLES_NS(mock_cycles());
+	}
+
+	void mock_run_cycles(uint64_t cycles)
+	{
+		advance(cycles);
+	}
+
+	void mock_run_ns(uint64_t ns)
+	{
+		advance(MOCK_NS_CYCLES(ns));
+	}
+
+	void mock_run_until_ns(uint64_t ns)
+	{
+		uint64_t target = MOCK_NS_CYCLES(ns);
+
+		if (target > now)
+			advance(target - now);
+	}
+
+	uint8_t mock_in_interrupt(void)
+	{
+		return inInterrupt;
+	}
+
+	void mock_gpio_attach(GPIO_TypeDef *port, const MockGpio_DeviceTypeDef *device)
+	{
+		if (gpioDeviceCount < MOCK_DEVICES)
+		{
+			gpioDevices[gpioDeviceCount].port = port;
+			gpioDevices[gpioDeviceCount].device = device;
+			gpioDeviceCount++;
+		}
+	}
+
+	uint32_t mock_gpio_stores(GPIO_TypeDef *port)
+	{
+		return stores[port_index(port)];
+	}
+
+	uint32_t mock_gpio_loads(GPIO_TypeDef *port)
+	{
+		return loads[port_index(port)];
+	}
+
+	void mock_gpio_counters_reset(void)
+	{
+		memset(stores, 0, sizeof(stores));
+		memset(loads, 0, sizeof(loads));
+	}
+
+	void mock_tim_init(TIM_HandleTypeDef *htim, TIM_TypeDef *instance, uint32_t prescaler, uint32_t period)
+	{
+		int i = timer_index(instance);
+
+		memset(instance, 0, sizeof(*instance));
+		instance->PSC = prescaler;
+		instance->ARR = period;
+		htim->Instance = instance;
+		htim->Init.Prescaler = prescaler;
+		htim->Init.Period = period;
+		htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+		timers[i].htim = htim;
+		timers[i].starts = 0;
+		timer_rebase(i, 0);
+	}
+
+	uint32_t mock_tim_starts(TIM_TypeDef *instance)
+	{
+		return timers[timer_index(instance)].starts;
+	}
+
+	void mock_i2c_attach(uint16_t address, const MockI2C_DeviceTypeDef *device)
+	{
+		if (i2cDeviceCount < MOCK_DEVICES)
+		{
+			i2cDevices[i2cDeviceCount].address = address;
+			i2cDevices[i2cDeviceCount].device = device;
+			i2cDeviceCount++;
+		}
+	}
+
+	void mock_i2c_set_clock(uint32_t hz)
+	{
+		i2cHz = hz;
+	}
+
+	void mock_event_add(const MockEvent_SourceTypeDef *source)
+	{
+		if (sourceCount < MOCK_DEVICES)
+			sources[sourceCount++] = source;
+	}
+
+	void mock_exti_edge(uint32_t lines, uint8_t rising)
+	{
+		mock_exti.PR |= lines & mock_exti.IMR & (rising ? mock_exti.RTSR : mock_exti.FTSR);
+	}
+
+	const char* mock_itm_text(void)
+	{
+		itm[itmLength] = '\0';
+		return itm;
+	}
+
+	void mock_itm_clear(void)
+	{
+		itmLength = 0;
+	}
@@ -0,0 +1,192 @@
+/*
+ *  HalMock.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Controls of the host HAL ("stm32f4xx_hal.h" in this directory) for the
+ *  tests: the virtual clock, device models on GPIO ports and I2C addresses,
+ *  event sources (EXTI edges), access counters and the SWO output.
+ *
+ *  The clock counts core cycles at MOCK_CORE_HZ. Hardware events (timer
+ *  compares and updates, DMA words, I2C bytes, line edges) happen at their
+ *  exact cycle even while interrupts are masked or an interrupt runs, their
+ *  callbacks are called in interrupt context as soon as interrupts are
+ *  allowed (no nesting, EXTI before DMA before TIM).
+ */
+
+#ifndef MOCK_HALMOCK_H_
+#define MOCK_HALMOCK_H_
+
+#include "stm32f4xx_hal.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Core clock, SystemCoreClock and the clock of every timer */
+#define MOCK_CORE_HZ 84000000U
+
+/* Cycles per DWT access, per GPIO register access and per HAL GPIO call */
+#define MOCK_DWT_CYCLES 1
+#define MOCK_GPIO_CYCLES 2
+#define MOCK_HAL_GPIO_CYCLES 12
+
+/* Default I2C bus clock */
+#define MOCK_I2C_HZ 100000U
+
+/* Nanoseconds of a number of cycles and back (rounded up) */
+#define MOCK_CYCLES_NS(cycles) ((uint64_t) (cycles) * 1000U / (MOCK_CORE_HZ / 1000000U))
+#define MOCK_NS_CYCLES(ns) (((uint64_t) (ns) * (MOCK_CORE_HZ / 1000000U) + 999U) / 1000U)
+
+/*
+ * Device on a GPIO port, called after every store to the port (with the
+ * register that was written, ODR already updated for BSRR) and on every load
+ * of IDR, with the levels the port drives itself, to add its own outputs
+ */
+typedef struct
+{
+	void (*store)(void *context, GPIO_TypeDef *port, unsigned int reg);
+	uint32_t (*load)(void *context, GPIO_TypeDef *port, uint32_t idr);
+	void *context;
+} MockGpio_DeviceTypeDef;
+
+/*
+ * Device at an I2C address, called byte by byte at the time each byte ends
+ * start returns 0 to not acknowledge the address
+ */
+typedef struct
+{
+	uint8_t (*start)(void *context, uint8_t read);
+	void (*write)(void *context, uint8_t data);
+	uint8_t (*read)(void *context);
+	void (*stop)(void *context);
+	void *context;
+} MockI2C_DeviceTypeDef;
+
+/*
+ * Source of events on the clock (e.g. edges of a line), next returns the
+ * cycle of the first event after a cycle (UINT64_MAX for none), fire handles
+ * the event at that cycle (hardware side only, no callbacks)
+ */
+typedef struct
+{
+	uint64_t (*next)(void *context, uint64_t after);
+	void (*fire)(void *context, uint64_t cycle);
+	void *context;
+} MockEvent_SourceTypeDef;
+
+	/*
+	 * @brief	Clock to 0, registers and counters cleared, devices, sources and
+	 * 			transfers removed, interrupts enabled, SystemCoreClock set
+	 * @param	None
+	 * @retval	None
+	 */
+	void mock_reset(void);
+
+	/*
+	 * @brief	Time of the clock
+	 * @param	None
+	 * @retval	Cycles or nanoseconds since mock_reset
+	 */
+	uint64_t mock_cycles(void);
+	uint64_t mock_now_ns(void);
+
+	/*
+	 * @brief	Move the clock forward, handling the events on the way
+	 * @param	cycles/ns time to move by, or the time to move to
+	 * @retval	None
+	 */
+	void mock_run_cycles(uint64_t cycles);
+	void mock_run_ns(uint64_t ns);
+	void mock_run_until_ns(uint64_t ns);
+
+	/*
+	 * @brief	Whether an interrupt callback is running
+	 * @param	None
+	 * @retval	1 in interrupt context
+	 */
+	uint8_t mock_in_interrupt(void);
+
+	/*
+	 * @brief	Attach a device model to a GPIO port (at most 4 in all)
+	 * @param	port GPIO port
+	 * @param	device callbacks, must stay valid
+	 * @retval	None
+	 */
+	void mock_gpio_attach(GPIO_TypeDef *port, const MockGpio_DeviceTypeDef *device);
+
+	/*
+	 * @brief	Register accesses of a port since mock_reset or the last
+	 * 			mock_gpio_counters_reset (DMA stores included)
+	 * @param	port GPIO port
+	 * @retval	Number of stores or loads
+	 */
+	uint32_t mock_gpio_stores(GPIO_TypeDef *port);
+	uint32_t mock_gpio_loads(GPIO_TypeDef *port);
+	void mock_gpio_counters_reset(void);
+
+	/*
+	 * @brief	Configure a timer as CubeMX would (stopped, counter 0) and
+	 * 			register its handle for the interrupt callbacks
+	 * @param	htim handle
+	 * @param	instance TIM1, TIM2 or TIM5
+	 * @param	prescaler timer clock is MOCK_CORE_HZ / (prescaler + 1)
+	 * @param	period auto-reload value
+	 * @retval	None
+	 */
+	void mock_tim_init(TIM_HandleTypeDef *htim, TIM_TypeDef *instance, uint32_t prescaler,
+			uint32_t period);
+
+	/*
+	 * @brief	Attach a device model to an I2C address (at most 4 in all)
+	 * @param	address 8-bit address as given to the HAL (7-bit address << 1)
+	 * @param	device callbacks, must stay valid
+	 * @retval	None
+	 */
+	void mock_i2c_attach(uint16_t address, const MockI2C_DeviceTypeDef *device);
+
+	/*
+	 * @brief	Bus clock of the I2C transfers
+	 * @param	hz bus clock (MOCK_I2C_HZ after mock_reset)
+	 * @retval	None
+	 */
+	void mock_i2c_set_clock(uint32_t hz);
+
+	/*
+	 * @brief	Add a source of events (at most 4)
+	 * @param	source callbacks, must stay valid
+	 * @retval	None
+	 */
+	void mock_event_add(const MockEvent_SourceTypeDef *source);
+
+	/*
+	 * @brief	Edge on EXTI lines, from the fire callback of a source (pending
+	 * 			for the lines enabled in EXTI->IMR with that edge selected)
+	 * @param	lines GPIO_PIN_x of the lines
+	 * @param	rising 1 for a rising edge, 0 for a falling edge
+	 * @retval	None
+	 */
+	void mock_exti_edge(uint32_t lines, uint8_t rising);
+
+	/*
+	 * @brief	Calls of HAL_TIM_Base_Start/_IT on a timer since mock_tim_init
+	 * @param	instance TIM1, TIM2 or TIM5
+	 * @retval	Number of calls
+	 */
+	uint32_t mock_tim_starts(TIM_TypeDef *instance);
+
+	/*
+	 * @brief	Characters sent to SWO port 0 since mock_reset or the last
+	 * 			mock_itm_clear, null terminated
+	 * @param	None
+	 * @retval	Text
+	 */
+	const char *mock_itm_text(void);
+	void mock_itm_clear(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MOCK_HALMOCK_H_ */
@@ -0,0 +1,145 @@
+/*
+ *  SHT3xDevice.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ */
+
+#include "SHT3xDevice.h"
+#include <string.h>
+
+	uint8_t sht3x_device_crc(uint8_t msb, uint8_t lsb)
+	{
+		uint16_t reg = 0xFF00;
+		uint16_t word = (uint16_t) ((msb << 8) | lsb);
+
+		/* Bit by bit long division of the word by 0x131 */
+		for (int bit = 15; bit >= 0; bit--)
+		{
+			uint8_t top = ((reg >> 15) ^ (word >> bit)) & 1U;
+			reg = (uint16_t) (reg << 1);
+			if (top)
+				reg ^= 0x3100;
+		}
+		return (uint8_t) (reg >> 8);
+	}
+
+	static void put_word(SHT3xDevice_HandleTypeDef *hdev, uint16_t word)
+	{
+		uint8_t msb = (uint8_t) (word >> 8);
+		uint8_t lsb = (uint8_t) word;
+
+		hdev->out[hdev->outLength++] = msb;
+		hdev->out[hdev->outLength++] = lsb;
+		hdev->out[hdev->outLength++] = sht3x_device_crc(msb, lsb);
+	}
+
+	static void execute(SHT3xDevice_HandleTypeDef *hdev)
+	{
+		uint16_t command = (uint16_t) ((hdev->command[0] << 8) | hdev->command[1]);
+
+		hdev->stats.commands++;
+		switch (command)
+		{
+		case 0x2400:
+			hdev->stats.measurements++;
+			hdev->measuring = 1;
+			hdev->outLength = 0;
+			hdev->readyAt = mock_cycles() + MOCK_NS_CYCLES(hdev->measureNs);
+			break;
+		case 0x30A2:
+			hdev->stats.resets++;
+			hdev->measuring = 0;
+			hdev->outLength = 0;
+			break;
+		case 0xF32D:
+			hdev->outLength = 0;
+			put_word(hdev, hdev->status);
+			break;
+		default:
+			hdev->stats.unknown++;
+			break;
+		}
+	}
+
+	static uint8_t start(void *context, uint8_t read)
+	{
+		SHT3xDevice_HandleTypeDef *hdev = (SHT3xDevice_HandleTypeDef*) context;
+
+		if (!hdev->present)
+			return 0;
+
+		hdev->writing = !read;
+		hdev->commandLength = 0;
+		hdev->outIndex = 0;
+		if (!read)
+			return 1;
+
+		if (hdev->measuring)
+		{
+			if (mock_cycles() < hdev->readyAt)
+			{
+				hdev->stats.earlyReads++;
+				return 0;
+			}
+			hdev->measuring = 0;
+			hdev->outLength = 0;
+			put_word(hdev, hdev->rawT);
+			put_word(hdev, hdev->rawRH);
+			if (hdev->corrupt)
+				hdev->out[2] ^= 0x01;
+			hdev->stats.results++;
+		}
+		else if (!hdev->outLength)
+		{
+			return 0;		// nothing to read
+		}
+		return 1;
+	}
+
+	static void write(void *context, uint8_t data)
+	{
+		SHT3xDevice_HandleTypeDef *hdev = (SHT3xDevice_HandleTypeDef*) context;
+
+		if (hdev->commandLength < 2)
+			hdev->command[hdev->commandLength++] = data;
+	}
+
+	static uint8_t read(void *context)
+	{
+		SHT3xDevice_HandleTypeDef *hdev = (SHT3xDevice_HandleTypeDef*) context;
+
+		return hdev->outIndex < hdev->outLength ? hdev->out[hdev->outIndex++] : 0xFF;
+	}
+
+	static void stop(void *context)
+	{
+		SHT3xDevice_HandleTypeDef *hdev = (SHT3xDevice_HandleTypeDef*) context;
+
+		if (hdev->writing && hdev->commandLength == 2)
+			execute(hdev);
+		else if (!hdev->writing && hdev->outIndex)
+			hdev->outLength = 0;		// read out
+		hdev->writing = 0;
+		hdev->commandLength = 0;
+	}
+
+	void sht3x_device_init(SHT3xDevice_HandleTypeDef *hdev)
+	{
+		memset(hdev, 0, sizeof(*hdev));
+		hdev->present = 1;
+		hdev->measureNs = SHT3X_DEVICE_MEASURE_NS;
+		hdev->rawT = 0x6666;		// 25.0 C
+		hdev->rawRH = 0x8000;		// 50.0 %
+		hdev->status = 0x8010;		// alert pending, reset detected
+	}
+
+	void sht3x_device_attach(SHT3xDevice_HandleTypeDef *hdev, uint16_t address)
+	{
+		hdev->i2cDevice.start = start;
+		hdev->i2cDevice.write = write;
+		hdev->i2cDevice.read = read;
+		hdev->i2cDevice.stop = stop;
+		hdev->i2cDevice.context = hdev;
+		mock_i2c_attach(address, &hdev->i2cDevice);
+	}
@@ -0,0 +1,99 @@
+/*
+ *  SHT3xDevice.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Emulated SHT3x on a mock I2C address, for the host tests (see
+ *  "HalMock.h").
+ *
+ *  The sensor takes 16-bit commands: a single shot measurement without
+ *  clock stretching (0x2400), soft reset (0x30A2) and status read (0xF32D).
+ *  While a measurement converts a read is not acknowledged, as on the part;
+ *  after it the read returns the temperature and humidity words, each
+ *  followed by its CRC-8 (computed here, apart from the driver).
+ *
+ *  Faults of the field can be set up: no answer, a corrupted CRC and a
+ *  longer conversion time.
+ */
+
+#ifndef MOCK_SHT3XDEVICE_H_
+#define MOCK_SHT3XDEVICE_H_
+
+#include "HalMock.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Conversion time of a high repeatability measurement (datasheet, max) */
+#define SHT3X_DEVICE_MEASURE_NS 15500000
+
+/*
+ * Traffic since sht3x_device_init
+ */
+typedef struct
+{
+	uint32_t commands;			// commands received, of any kind
+	uint32_t measurements;		// measurements started
+	uint32_t results;			// results read out
+	uint32_t resets;
+	uint32_t earlyReads;		// reads not acknowledged, conversion in progress
+	uint32_t unknown;			// commands not understood
+} SHT3xDevice_StatsTypeDef;
+
+typedef struct
+{
+	/* Result of the next measurements */
+	uint16_t rawT;
+	uint16_t rawRH;
+
+	/* Behaviour */
+	uint8_t present;			// 0 to not acknowledge the address
+	uint8_t corrupt;			// flip a bit of the temperature CRC of the results
+	uint32_t measureNs;			// conversion time
+	uint16_t status;			// status word
+
+	/* Bus */
+	uint8_t command[2];
+	uint8_t commandLength;
+	uint8_t writing;			// transfer in progress is a write
+	uint8_t measuring;			// measurement started, result not read yet
+	uint64_t readyAt;			// cycle the conversion ends
+	uint8_t out[6];				// bytes of the next read
+	uint8_t outLength;
+	uint8_t outIndex;
+	MockI2C_DeviceTypeDef i2cDevice;
+
+	SHT3xDevice_StatsTypeDef stats;
+} SHT3xDevice_HandleTypeDef;
+
+	/*
+	 * @brief	Power-on state: 25.0 C and 50.0 %, maximum conversion time,
+	 * 			not wired
+	 * @param	hdev handle
+	 * @retval	None
+	 */
+	void sht3x_device_init(SHT3xDevice_HandleTypeDef *hdev);
+
+	/*
+	 * @brief	Wire the sensor to an address of the mock I2C bus
+	 * @param	hdev handle, initialized
+	 * @param	address 8-bit (shifted) address
+	 * @retval	None
+	 */
+	void sht3x_device_attach(SHT3xDevice_HandleTypeDef *hdev, uint16_t address);
+
+	/*
+	 * @brief	CRC-8 of the sensor (polynomial 0x31, initial value 0xFF)
+	 * @param	msb first byte of the word
+	 * @param	lsb second byte of the word
+	 * @retval	CRC
+	 */
+	uint8_t sht3x_device_crc(uint8_t msb, uint8_t lsb);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MOCK_SHT3XDEVICE_H_ */
@@ -0,0 +1,61 @@
+/*
+ *  Test.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ */
+
+#include "Test.h"
+#include <stdio.h>
+#include <string.h>
+
+	static unsigned int checks;
+	static unsigned int failures;
+
+	uint8_t test_check(uint8_t passed, const char *expression, const char *file, int line)
+	{
+		checks++;
+		if (!passed)
+		{
+			failures++;
+			printf("%s:%d: failed: %s\n", file, line, expression);
+		}
+		return passed;
+	}
+
+	uint8_t test_equal(int64_t expected, int64_t actual, const char *expression, const char *file, int line)
+	{
+		checks++;
+		if (expected != actual)
+		{
+			failures++;
+			printf("%s:%d: failed: %s is %lld, expected %lld\n", file, line, expression, (long long) actual,
+					(long long) expected);
+			return 0;
+		}
+		return 1;
+	}
+
+	uint8_t test_text(const char *expected, const char *actual, const char *expression, const char *file,
+			int line)
+	{
+		checks++;
+		if (strcmp(expected, actual) != 0)
+		{
+			failures++;
+			printf("%s:%d: failed: %s is \"%s\", expected \"%s\"\n", file, line, expression, actual, expected);
+			return 0;
+		}
+		return 1;
+	}
+
+	void bench_report(const char *name, double value, const char *unit)
+	{
+		printf("  %-48s %12.2f %s\n", name, value, unit);
+	}
+
+	int test_report(const char *name)
+	{
+		printf("%s: %u checks, %u failed\n", name, checks, failures);
+		return failures != 0;
+	}
@@ -0,0 +1,57 @@
+/*
+ *  Test.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Checks and report of the host tests: every test is a program that runs
+ *  its checks, prints the failed ones and returns the test_report result
+ *  from main (0 when everything passed), as ctest expects.
+ *  Benchmarks print their figures with bench_report and check the result
+ *  they are meant to show, so a regression fails the run.
+ */
+
+#ifndef MOCK_TEST_H_
+#define MOCK_TEST_H_
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define CHECK(condition) test_check((condition) != 0, #condition, __FILE__, __LINE__)
+#define CHECK_EQUAL(expected, actual) \
+	test_equal((int64_t) (expected), (int64_t) (actual), #actual, __FILE__, __LINE__)
+#define CHECK_TEXT(expected, actual) test_text((expected), (actual), #actual, __FILE__, __LINE__)
+
+	/*
+	 * @brief	Record a check, print it if it failed
+	 * @retval	The outcome, 1 if it passed
+	 */
+	uint8_t test_check(uint8_t passed, const char *expression, const char *file, int line);
+	uint8_t test_equal(int64_t expected, int64_t actual, const char *expression, const char *file, int line);
+	uint8_t test_text(const char *expected, const char *actual, const char *expression, const char *file,
+			int line);
+
+	/*
+	 * @brief	Print one benchmark figure
+	 * @param	name what was measured
+	 * @param	value the figure
+	 * @param	unit unit of the figure
+	 * @retval	None
+	 */
+	void bench_report(const char *name, double value, const char *unit);
+
+	/*
+	 * @brief	Print the number of checks and failures
+	 * @param	name name of the test program
+	 * @retval	0 if every check passed, 1 otherwise
+	 */
+	int test_report(const char *name);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MOCK_TEST_H_ */
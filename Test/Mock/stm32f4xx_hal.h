@@ -0,0 +1,417 @@
+/*
+ *  stm32f4xx_hal.h
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Yaakov (Jake) Ivanov
+ *
+ *  Host stand-in for the parts of the STM32F4 HAL and CMSIS the drivers in
+ *  Src use, so they build and run unchanged on a PC (see "HalMock.h" for the
+ *  controls of the tests).
+ *
+ *  Time is virtual: the DWT cycle counter, the HAL tick and the timer counters
+ *  all follow one core clock cycle count, which moves forward on every register
+ *  access, busy wait and delay. Timer compares and updates, DMA requests and
+ *  EXTI edges are events on that clock that call the usual HAL callbacks, so
+ *  timing results are exact and do not depend on the speed of the host.
+ *
+ *  In C++ the GPIO registers are objects whose loads and stores go through the
+ *  mock, so the device models (HD44780, DHT line) see every access of a driver
+ *  built as C++ (LiquidCrystal.c, see CMakeLists.txt). C sources only reach the
+ *  pins through HAL_GPIO_ReadPin/WritePin, the register layout is the same.
+ */
+
+#ifndef MOCK_STM32F4XX_HAL_H_
+#define MOCK_STM32F4XX_HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/* Modules the drivers check for */
+#define HAL_TIM_MODULE_ENABLED
+#define HAL_I2C_MODULE_ENABLED
+
+typedef enum
+{
+	HAL_OK = 0x00U,
+	HAL_ERROR = 0x01U,
+	HAL_BUSY = 0x02U,
+	HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+/* As stm32f4xx_hal_conf.h without USE_FULL_ASSERT, the drivers check their arguments themselves */
+#define assert_param(expr) ((void) 0U)
+
+extern uint32_t SystemCoreClock;
+
+/*
+ * Core
+ */
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+/* Every access of DWT reads the virtual clock and takes a cycle */
+DWT_Type *mock_dwt(void);
+extern CoreDebug_Type mock_core_debug;
+#define DWT (mock_dwt())
+#define CoreDebug (&mock_core_debug)
+
+/* Interrupts are held while masked and delivered on __enable_irq,
+ * __WFI moves the clock to the next event */
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __WFI(void);
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DSB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __ISB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __NOP() do {} while (0)
+
+/* SWO stimulus port 0, the characters are collected by the mock */
+uint32_t ITM_SendChar(uint32_t ch);
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+/*
+ * GPIO
+ */
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+#define GPIO_PIN_All ((uint16_t)0xFFFF)
+
+#define GPIO_MODE_INPUT 0x00000000U
+#define GPIO_MODE_OUTPUT_PP 0x00000001U
+#define GPIO_MODE_OUTPUT_OD 0x00000011U
+#define GPIO_MODE_IT_RISING 0x10110000U
+#define GPIO_MODE_IT_FALLING 0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING 0x10310000U
+#define GPIO_NOPULL 0x00000000U
+#define GPIO_PULLUP 0x00000001U
+#define GPIO_SPEED_FREQ_LOW 0x00000000U
+#define GPIO_SPEED_FREQ_HIGH 0x00000002U
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+	uint32_t Pin;
+	uint32_t Mode;
+	uint32_t Pull;
+	uint32_t Speed;
+	uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+/* Register numbers of a port (word offsets) */
+#define MOCK_GPIO_MODER 0
+#define MOCK_GPIO_IDR 4
+#define MOCK_GPIO_ODR 5
+#define MOCK_GPIO_BSRR 6
+
+/* Load and store of a port register through the mock, reg is a word offset */
+uint32_t mock_gpio_load(void *port, unsigned int reg);
+void mock_gpio_store(void *port, unsigned int reg, uint32_t value);
+
+#ifdef	__cplusplus
+}
+
+/*
+ * A GPIO register that forwards its loads and stores to the mock
+ * (C++ linkage, drivers include the HAL inside their extern "C" blocks)
+ */
+extern "C++" {
+template<unsigned int index>
+class MockGpioRegister
+{
+public:
+	operator uint32_t() const
+	{
+		return mock_gpio_load(port(), index);
+	}
+
+	MockGpioRegister &operator=(uint32_t value)
+	{
+		mock_gpio_store(port(), index, value);
+		return *this;
+	}
+
+	MockGpioRegister &operator=(const MockGpioRegister &other)
+	{
+		return *this = (uint32_t) other;
+	}
+
+	MockGpioRegister &operator&=(uint32_t value)
+	{
+		return *this = (uint32_t) *this & value;
+	}
+
+	MockGpioRegister &operator|=(uint32_t value)
+	{
+		return *this = (uint32_t) *this | value;
+	}
+
+private:
+	void *port() const
+	{
+		return (void*) ((const volatile uint32_t*) &word - index);
+	}
+
+	volatile uint32_t word;
+};
+
+typedef struct
+{
+	MockGpioRegister<0> MODER;
+	MockGpioRegister<1> OTYPER;
+	MockGpioRegister<2> OSPEEDR;
+	MockGpioRegister<3> PUPDR;
+	MockGpioRegister<4> IDR;
+	MockGpioRegister<5> ODR;
+	MockGpioRegister<6> BSRR;
+	MockGpioRegister<7> LCKR;
+	volatile uint32_t AFR[2];
+} GPIO_TypeDef;
+}
+
+extern "C" {
+#else
+typedef struct
+{
+	volatile uint32_t MODER;
+	volatile uint32_t OTYPER;
+	volatile uint32_t OSPEEDR;
+	volatile uint32_t PUPDR;
+	volatile uint32_t IDR;
+	volatile uint32_t ODR;
+	volatile uint32_t BSRR;
+	volatile uint32_t LCKR;
+	volatile uint32_t AFR[2];
+} GPIO_TypeDef;
+#endif
+
+#define MOCK_GPIO_PORTS 3
+extern GPIO_TypeDef mock_gpio_ports[MOCK_GPIO_PORTS];
+#define GPIOA (&mock_gpio_ports[0])
+#define GPIOB (&mock_gpio_ports[1])
+#define GPIOC (&mock_gpio_ports[2])
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+typedef struct
+{
+	volatile uint32_t IMR;
+	volatile uint32_t EMR;
+	volatile uint32_t RTSR;
+	volatile uint32_t FTSR;
+	volatile uint32_t SWIER;
+	volatile uint32_t PR;
+} EXTI_TypeDef;
+
+/* Pending lines are kept by the mock (PR is write 1 to clear) */
+void mock_exti_clear(uint32_t lines);
+extern EXTI_TypeDef mock_exti;
+#define EXTI (&mock_exti)
+#define __HAL_GPIO_EXTI_CLEAR_IT(__EXTI_LINE__) mock_exti_clear(__EXTI_LINE__)
+
+/*
+ * TIM, the counter is derived from the clock: read, set, start and stop it
+ * through the HAL macros, not through CNT and CR1
+ */
+typedef struct
+{
+	volatile uint32_t CR1;
+	volatile uint32_t CR2;
+	volatile uint32_t SMCR;
+	volatile uint32_t DIER;
+	volatile uint32_t SR;
+	volatile uint32_t EGR;
+	volatile uint32_t CCMR1;
+	volatile uint32_t CCMR2;
+	volatile uint32_t CCER;
+	volatile uint32_t CNT;
+	volatile uint32_t PSC;
+	volatile uint32_t ARR;
+	volatile uint32_t RCR;
+	volatile uint32_t CCR1;
+	volatile uint32_t CCR2;
+	volatile uint32_t CCR3;
+	volatile uint32_t CCR4;
+} TIM_TypeDef;
+
+typedef struct
+{
+	uint32_t Prescaler;
+	uint32_t CounterMode;
+	uint32_t Period;
+	uint32_t ClockDivision;
+	uint32_t RepetitionCounter;
+	uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef enum
+{
+	HAL_TIM_ACTIVE_CHANNEL_1 = 0x01U,
+	HAL_TIM_ACTIVE_CHANNEL_2 = 0x02U,
+	HAL_TIM_ACTIVE_CHANNEL_3 = 0x04U,
+	HAL_TIM_ACTIVE_CHANNEL_4 = 0x08U,
+	HAL_TIM_ACTIVE_CHANNEL_CLEARED = 0x00U
+} HAL_TIM_ActiveChannel;
+
+struct __DMA_HandleTypeDef;
+
+typedef struct
+{
+	TIM_TypeDef *Instance;
+	TIM_Base_InitTypeDef Init;
+	HAL_TIM_ActiveChannel Channel;
+	struct __DMA_HandleTypeDef *hdma[7];
+} TIM_HandleTypeDef;
+
+#define TIM_CHANNEL_1 0x00000000U
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_CHANNEL_3 0x00000008U
+#define TIM_CHANNEL_4 0x0000000CU
+
+#define TIM_CR1_CEN (1UL << 0)
+#define TIM_IT_UPDATE (1UL << 0)
+#define TIM_IT_CC1 (1UL << 1)
+#define TIM_IT_CC2 (1UL << 2)
+#define TIM_IT_CC3 (1UL << 3)
+#define TIM_IT_CC4 (1UL << 4)
+#define TIM_DMA_UPDATE (1UL << 8)
+#define TIM_EGR_CC1G (1UL << 1)
+#define TIM_DMA_ID_UPDATE 0
+
+#define MOCK_TIMERS 3
+extern TIM_TypeDef mock_timers[MOCK_TIMERS];
+#define TIM1 (&mock_timers[0])
+#define TIM2 (&mock_timers[1])
+#define TIM5 (&mock_timers[2])
+
+uint32_t mock_tim_get_counter(TIM_HandleTypeDef *htim);
+void mock_tim_set_counter(TIM_HandleTypeDef *htim, uint32_t counter);
+void mock_tim_set_autoreload(TIM_HandleTypeDef *htim, uint32_t autoreload);
+void mock_tim_enable(TIM_HandleTypeDef *htim, uint8_t enable);
+
+#define __HAL_TIM_GET_COUNTER(__HANDLE__) mock_tim_get_counter(__HANDLE__)
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__) mock_tim_set_counter((__HANDLE__), (__COUNTER__))
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__) ((__HANDLE__)->Instance->ARR)
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) mock_tim_set_autoreload((__HANDLE__), (__AUTORELOAD__))
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) \
+	(*(&(__HANDLE__)->Instance->CCR1 + ((__CHANNEL__) >> 2U)) = (__COMPARE__))
+#define __HAL_TIM_ENABLE(__HANDLE__) mock_tim_enable((__HANDLE__), 1)
+#define __HAL_TIM_DISABLE(__HANDLE__) mock_tim_enable((__HANDLE__), 0)
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->DIER |= (__INTERRUPT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->Instance->DIER &= ~(__INTERRUPT__))
+#define __HAL_TIM_ENABLE_DMA(__HANDLE__, __DMA__) ((__HANDLE__)->Instance->DIER |= (__DMA__))
+#define __HAL_TIM_DISABLE_DMA(__HANDLE__, __DMA__) ((__HANDLE__)->Instance->DIER &= ~(__DMA__))
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+	do { (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); (__DMA_HANDLE__).Parent = (__HANDLE__); } while (0)
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_OC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim);
+
+/*
+ * DMA, a memory to peripheral stream paced by the update event of the timer
+ * it is linked to (Parent), one word per event
+ */
+typedef struct __DMA_HandleTypeDef
+{
+	void *Instance;
+	void *Parent;
+	void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+	void (*XferErrorCallback)(struct __DMA_HandleTypeDef *hdma);
+} DMA_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress,
+		uint32_t DataLength);
+
+/*
+ * I2C, transfers go to the device model attached at the address
+ */
+typedef enum
+{
+	HAL_I2C_STATE_RESET = 0x00U,
+	HAL_I2C_STATE_READY = 0x20U,
+	HAL_I2C_STATE_BUSY_TX = 0x21U,
+	HAL_I2C_STATE_BUSY_RX = 0x22U
+} HAL_I2C_StateTypeDef;
+
+#define HAL_I2C_ERROR_NONE 0x00000000U
+#define HAL_I2C_ERROR_AF 0x00000004U
+#define I2C_MEMADD_SIZE_8BIT 0x00000001U
+
+typedef struct
+{
+	void *Instance;
+	DMA_HandleTypeDef *hdmatx;
+	DMA_HandleTypeDef *hdmarx;
+	volatile HAL_I2C_StateTypeDef State;
+	volatile uint32_t ErrorCode;
+} I2C_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+		uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+		uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+		uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Master_Receive_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+		uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+		uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+		uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+		uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif /* MOCK_STM32F4XX_HAL_H_ */
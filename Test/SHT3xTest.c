@@ -0,0 +1,241 @@
+/*
+ *  SHT3xTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  SHT3x driver against the emulated sensor on the mock I2C bus and its DMA:
+ *  the CRC and conversion vectors of the datasheet, the phases of a single
+ *  shot measurement, the interval, the trigger and the failures (no answer,
+ *  a CRC mismatch, a conversion slower than specified).
+ */
+
+#include "SHT3x.h"
+#include "SHT3xDevice.h"
+#include "Test.h"
+#include <string.h>
+
+	static SHT3xDevice_HandleTypeDef sensor;
+	static I2C_HandleTypeDef hi2c1;
+	static SHT3x_HandleTypeDef hsht;
+
+	/* Fresh mock with the sensor as set up by the test, the driver initialized */
+	static HAL_StatusTypeDef setup(void)
+	{
+		mock_reset();
+		sht3x_device_attach(&sensor, SHT3X_ADDRESS_LOW);
+		memset(&hi2c1, 0, sizeof(hi2c1));
+		hi2c1.State = HAL_I2C_STATE_READY;
+		return SHT3xinit(&hsht, &hi2c1, SHT3X_ADDRESS_LOW);
+	}
+
+	/* SHT3xupdate every 100 us until the measurement in progress is over */
+	static Sensor_StatusTypeDef finish(void)
+	{
+		Sensor_StatusTypeDef status;
+
+		for (int i = 0; i < 1000; i++)
+		{
+			status = SHT3xupdate(&hsht);
+			if (status != SENSOR_BUSY)
+			{
+				return status;
+			}
+			mock_run_ns(100000);
+		}
+		return SENSOR_BUSY;
+	}
+
+	/* A measurement by trigger, the reading it cached */
+	static Sensor_StatusTypeDef measure(Sensor_ReadingTypeDef *reading)
+	{
+		Sensor_StatusTypeDef status;
+
+		if (SHT3xtrigger(&hsht) != SENSOR_BUSY)
+		{
+			return SENSOR_ERROR;
+		}
+		status = finish();
+		if (status == SENSOR_OK)
+		{
+			SHT3xlast_reading(&hsht, reading, NULL);
+		}
+		return status;
+	}
+
+	/* CRC example of the datasheet, the driver against the emulator over every word */
+	static void test_crc(void)
+	{
+		static const uint8_t example[2] = { 0xBE, 0xEF };
+		uint8_t word[2];
+
+		CHECK_EQUAL(0x92, SHT3xcrc(example, 2));
+		CHECK_EQUAL(0x92, sht3x_device_crc(0xBE, 0xEF));
+		CHECK_EQUAL(SHT3X_CRC_INIT, SHT3xcrc(word, 0));
+
+		for (uint32_t w = 0; w <= 0xFFFF; w++)
+		{
+			word[0] = (uint8_t) (w >> 8);
+			word[1] = (uint8_t) w;
+			if (SHT3xcrc(word, 2) != sht3x_device_crc(word[0], word[1]))
+			{
+				CHECK_EQUAL(sht3x_device_crc(word[0], word[1]), SHT3xcrc(word, 2));
+				break;
+			}
+		}
+	}
+
+	/* Ends of the ranges and points of the conversion formulas, rounded to 0.1 */
+	static void test_conversion(void)
+	{
+		static const struct
+		{
+			uint16_t rawT;
+			int16_t temp;
+			uint16_t rawRH;
+			int16_t RH;
+		} vectors[] =
+		{
+			{ 0x0000, -450, 0x0000, 0 },
+			{ 0xFFFF, 1300, 0xFFFF, 1000 },
+			{ 0x6666, 250, 0x8000, 500 },
+			{ 0x4000, -12, 0x4000, 250 },		// -1.2493 C
+			{ 0x3FFF, -13, 0x0043, 1 },			// -1.2520 C, 0.102 %
+			{ 0x3FFA, -13, 0x0020, 0 },			// -1.2654 C, 0.049 %
+		};
+		Sensor_ReadingTypeDef reading;
+
+		sht3x_device_init(&sensor);
+		CHECK_EQUAL(HAL_OK, setup());
+		CHECK_EQUAL(SENSOR_OK, finish());
+		CHECK_EQUAL(SENSOR_SAMPLE_FRESH, SHT3xlast_reading(&hsht, &reading, NULL));
+		CHECK_EQUAL(SENSOR_HAS_RH | SENSOR_HAS_TEMP, reading.fields);
+		CHECK_EQUAL(250, reading.temp);
+		CHECK_EQUAL(500, reading.RH);
+
+		for (unsigned i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+		{
+			sensor.rawT = vectors[i].rawT;
+			sensor.rawRH = vectors[i].rawRH;
+			CHECK_EQUAL(SENSOR_OK, measure(&reading));
+			CHECK_EQUAL(vectors[i].temp, reading.temp);
+			CHECK_EQUAL(vectors[i].RH, reading.RH);
+		}
+	}
+
+	/* Reset and status read in init, then command, wait and read, never blocking */
+	static void test_measurement(void)
+	{
+		uint64_t start;
+		uint64_t ready = 0;
+		uint32_t readings = 0;
+		Sensor_ReadingTypeDef reading;
+
+		sht3x_device_init(&sensor);
+		CHECK_EQUAL(HAL_OK, setup());
+		CHECK_EQUAL(1, sensor.stats.resets);
+		CHECK_EQUAL(2, sensor.stats.commands);		// reset and status, the measurement is sent by DMA
+		CHECK_EQUAL(0, sensor.stats.unknown);
+		CHECK(mock_now_ns() >= SHT3X_RESET_TIME * 1000000ULL);
+
+		/* The result is read once the conversion is over, never before */
+		start = mock_now_ns();
+		for (int i = 0; i < 400 && !ready; i++)
+		{
+			uint64_t before = mock_now_ns();
+			if (SHT3xupdate(&hsht) == SENSOR_OK)
+			{
+				ready = mock_now_ns();
+			}
+			CHECK(mock_now_ns() - before < 20000);
+			mock_run_ns(100000);
+		}
+		CHECK_EQUAL(0, sensor.stats.earlyReads);
+		CHECK_EQUAL(1, sensor.stats.results);
+		CHECK(ready - start > SHT3X_DEVICE_MEASURE_NS);
+		CHECK(ready - start < 19000000);
+
+		/* One measurement every SHT3X_INTERVAL, from the first one on */
+		for (int ms = 0; ms < 10000; ms++)
+		{
+			if (SHT3xupdate(&hsht) == SENSOR_OK)
+			{
+				readings++;
+			}
+			mock_run_ns(1000000);
+		}
+		CHECK_EQUAL(9, readings);
+		CHECK_EQUAL(11, sensor.stats.measurements);		// the last one still converting
+		CHECK_EQUAL(0, sensor.stats.earlyReads);
+		CHECK_EQUAL(SENSOR_SAMPLE_FRESH, SHT3xlast_reading(&hsht, &reading, NULL));
+
+		/* After the first trigger, measurements only start with it */
+		CHECK_EQUAL(SENSOR_OK, finish());
+		CHECK_EQUAL(SENSOR_BUSY, SHT3xtrigger(&hsht));
+		CHECK_EQUAL(SENSOR_IDLE, SHT3xtrigger(&hsht));
+		CHECK_EQUAL(SENSOR_OK, finish());
+		for (int ms = 0; ms < 3000; ms++)
+		{
+			CHECK_EQUAL(SENSOR_IDLE, SHT3xupdate(&hsht));
+			mock_run_ns(1000000);
+		}
+		CHECK_EQUAL(12, sensor.stats.measurements);
+		CHECK_EQUAL(SENSOR_SAMPLE_FRESH, SHT3xlast_reading(&hsht, &reading, NULL));
+
+		/* Due again SHT3X_INTERVAL after the last trigger, through the sensor interface */
+		const Sensor_HandleTypeDef handle = { &SHT3x_sensor_driver, &hsht };
+		CHECK_EQUAL(0, sensor_next_conversion(&handle));
+		CHECK_EQUAL(SENSOR_BUSY, sensor_trigger(&handle));
+		CHECK_EQUAL(SHT3X_INTERVAL, sensor_next_conversion(&handle));
+		mock_run_ns(400000000ULL);
+		CHECK_EQUAL(SHT3X_INTERVAL - 400, sensor_next_conversion(&handle));
+	}
+
+	/* No sensor, a bad status word, a bad CRC, a conversion slower than specified */
+	static void test_errors(void)
+	{
+		Sensor_ReadingTypeDef reading;
+
+		sht3x_device_init(&sensor);
+		sensor.present = 0;
+		CHECK_EQUAL(HAL_ERROR, setup());
+		CHECK_EQUAL(SENSOR_SAMPLE_INVALID, SHT3xlast_reading(&hsht, &reading, NULL));
+		sensor.present = 1;
+		CHECK_EQUAL(HAL_ERROR, SHT3xinit(&hsht, &hi2c1, SHT3X_ADDRESS_HIGH));
+
+		/* CRC mismatch: the reading is dropped, the cached one kept */
+		CHECK_EQUAL(HAL_OK, setup());
+		CHECK_EQUAL(SENSOR_OK, finish());
+		sensor.rawT = 0xFFFF;
+		sensor.corrupt = 1;
+		CHECK_EQUAL(SENSOR_ERROR, measure(&reading));
+		CHECK_EQUAL(SENSOR_SAMPLE_FRESH, SHT3xlast_reading(&hsht, &reading, NULL));
+		CHECK_EQUAL(250, reading.temp);
+		sensor.corrupt = 0;
+		CHECK_EQUAL(SENSOR_OK, measure(&reading));
+		CHECK_EQUAL(1300, reading.temp);
+
+		/* Sensor still converting when read: not acknowledged */
+		sensor.measureNs = 30000000;
+		CHECK_EQUAL(SENSOR_ERROR, measure(&reading));
+		CHECK_EQUAL(1, sensor.stats.earlyReads);
+		sensor.measureNs = SHT3X_DEVICE_MEASURE_NS;
+		mock_run_ns(30000000);
+		CHECK_EQUAL(SENSOR_OK, measure(&reading));
+
+		/* Sensor gone: the command is not acknowledged */
+		sensor.present = 0;
+		CHECK_EQUAL(SENSOR_ERROR, measure(&reading));
+		sensor.present = 1;
+		CHECK_EQUAL(SENSOR_OK, measure(&reading));
+	}
+
+	int main(void)
+	{
+		test_crc();
+		test_conversion();
+		test_measurement();
+		test_errors();
+
+		return test_report("SHT3xTest");
+	}
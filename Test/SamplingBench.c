@@ -0,0 +1,365 @@
+/*
+ *  SamplingBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  Period jitter of the station samples on the mock clock, before and after
+ *  the sample timer, with the DHT22 on PA11 and the LCD on port C:
+ *  - before, the free-running loop of the first main.c: a blocking DHT read,
+ *    then the LCD redraw on the data path as it shipped (one
+ *    HAL_GPIO_WritePin per line, HAL_Delay around the enable pulse), so a
+ *    sample comes whenever both are done
+ *  - after, the sample timer of the timer wheel on TIM5, conversions by edge
+ *    capture from the sample task and an LCD refresh every 500 ms by DMA
+ *    from the render task, as main.c runs them
+ *  The reading changes with every sample (the redraw varies with the number
+ *  of digits) and the sensor misses one start pulse in seven.
+ */
+
+#include "DHTemp.h"
+#include "DHT22.h"
+#include "Format.h"
+#include "HD44780.h"
+#include "LiquidCrystal.h"
+#include "Scheduler.h"
+#include "Sensor.h"
+#include "TimerWheel.h"
+#include "Test.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SAMPLE_PERIOD_MS 2000
+#define DISPLAY_PERIOD_MS 500
+#define POLL_PERIOD_MS 1
+/* Run time of each variant, the blocking reads of the loop are slow to simulate */
+#define BEFORE_NS 10000000000ULL
+#define AFTER_NS 120000000000ULL
+
+#define SAMPLE_EVENT_TRIGGER 0
+#define SAMPLE_EVENT_POLL 1
+
+	static DHT22_HandleTypeDef dht;
+	static HD44780_HandleTypeDef hd;
+	static LCD_HandleTypeDef lcd;
+	static TIM_HandleTypeDef htim1;
+	static TIM_HandleTypeDef htim2;
+	static TIM_HandleTypeDef htim5;
+	static DMA_HandleTypeDef hdma_tim1_up;
+	static TimerWheel_HandleTypeDef wheel;
+	static TimerWheel_TimerTypeDef sample_timer;
+	static TimerWheel_TimerTypeDef display_timer;
+	static TimerWheel_TimerTypeDef retry_timer;
+	static TimerWheel_TimerTypeDef poll_timer;
+	static TimerWheel_JitterTypeDef sample_jitter;
+	static Scheduler_HandleTypeDef scheduler;
+	static uint8_t sample_task;
+	static uint8_t render_task;
+	static uint8_t wheelRunning;
+	static uint32_t samples;
+
+	/* Readings cached after, those not acquired on the grid of the first one and retries after failures */
+	static uint32_t readings;
+	static uint32_t offGrid;
+	static uint32_t firstTimestamp;
+	static uint32_t retries;
+
+	static const Sensor_HandleTypeDef sensor = { &DHT_sensor_driver, NULL };
+	static const uint16_t dataPins[8] = { GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8,
+			GPIO_PIN_9, GPIO_PIN_10 };
+
+	/* Period statistics in microseconds */
+	typedef struct
+	{
+		uint32_t samples;
+		double periodMin;
+		double periodMax;
+		double periodMean;
+	} Jitter;
+
+	void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+	{
+		if (GPIO_Pin == GPIO_PIN_11)
+		{
+			DHTcapture_edge();
+		}
+	}
+
+	void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+	{
+		if (wheelRunning && htim->Instance == TIM5 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1)
+		{
+			wheel_process(&wheel);
+		}
+	}
+
+	/* Reading of the next conversion, the sensor silent for one start pulse in seven */
+	static void next_reading(void)
+	{
+		dht22_set_reading(&dht, (int16_t) (300 + samples * 53 % 650), (int16_t) (-150 + samples * 131 % 600));
+		dht.respond = dht.stats.pulses % 7 != 6;
+		samples++;
+	}
+
+	/* DHT22 on PA11 with TIM2 at 1 us, TIM5 free-running at 1 us, LCD pins on port C */
+	static void setup(void)
+	{
+		GPIO_InitTypeDef init = { 0 };
+
+		mock_reset();
+		delay_init();
+		samples = 0;
+		wheelRunning = 0;
+
+		dht22_init(&dht);
+		dht22_attach(&dht, GPIOA, GPIO_PIN_11);
+		mock_tim_init(&htim2, TIM2, 83, 0xFFFFFFFF);
+		DHTinit(GPIOA, GPIO_PIN_11, &htim2);
+		DHTset_model(DHT_MODEL_DHT22);
+		mock_tim_init(&htim5, TIM5, 83, 0xFFFFFFFF);
+
+		init.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4 | GPIO_PIN_5 | GPIO_PIN_6
+				| GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_9 | GPIO_PIN_10;
+		init.Mode = GPIO_MODE_OUTPUT_PP;
+		HAL_GPIO_Init(GPIOC, &init);
+		hd44780_init(&hd);
+		hd44780_attach_gpio(&hd, GPIOC, dataPins, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+	}
+
+	/*
+	 * Before: the LCD data path as it shipped, every line a HAL_GPIO_WritePin
+	 * call and the enable pulse timed with HAL_Delay
+	 */
+	static void baseline_send(unsigned char value, unsigned char mode)
+	{
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_0, mode ? GPIO_PIN_SET : GPIO_PIN_RESET);
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_1, GPIO_PIN_RESET);
+		for (int i = 0; i < 8; i++)
+			HAL_GPIO_WritePin(GPIOC, dataPins[i], ((value >> i) & 0x01) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_2, GPIO_PIN_RESET);
+		HAL_Delay(1);
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_2, GPIO_PIN_SET);
+		HAL_Delay(1);
+		HAL_GPIO_WritePin(GPIOC, GPIO_PIN_2, GPIO_PIN_RESET);
+		HAL_Delay(1);
+	}
+
+	static void baseline_print(const char *text)
+	{
+		while (*text)
+			baseline_send((unsigned char) *text++, 1);
+	}
+
+	static void baseline_print_int(int32_t value)
+	{
+		char text[FMT_BUFFER_SIZE];
+
+		text[fmt_int(text, value)] = '\0';
+		baseline_print(text);
+	}
+
+	/* The redraw of the first main.c: temperature in F and humidity, whole and tenths */
+	static void baseline_redraw(int16_t RH, int16_t temp)
+	{
+		int16_t temp_f = temp * 1.8;
+		int16_t temp_f_frac = temp_f % 10;
+
+		baseline_send(0x80 | 6, 0);
+		baseline_print_int(temp_f / 10 + 32);
+		baseline_print(".");
+		baseline_print_int(temp_f_frac < 0 ? -temp_f_frac : temp_f_frac);
+		baseline_print(" F   ");
+		baseline_send(0x80 | 0x44, 0);
+		baseline_print_int(RH / 10);
+		baseline_print(".");
+		baseline_print_int(RH % 10);
+		baseline_print("%   ");
+	}
+
+	/* Period between the starts of the loop iterations, read on TIM5 */
+	static Jitter run_before(void)
+	{
+		Jitter jitter = { 0, 1e30, 0, 0 };
+		int16_t RH = 0;
+		int16_t temp = 0;
+		uint32_t first = 0;
+		uint32_t stamp = 0;
+
+		setup();
+		HAL_TIM_Base_Start(&htim5);
+		while (mock_now_ns() < BEFORE_NS)
+		{
+			uint32_t now = __HAL_TIM_GET_COUNTER(&htim5);
+			if (jitter.samples++ == 0)
+			{
+				first = now;
+			}
+			else
+			{
+				double period = now - stamp;
+				jitter.periodMin = period < jitter.periodMin ? period : jitter.periodMin;
+				jitter.periodMax = period > jitter.periodMax ? period : jitter.periodMax;
+			}
+			stamp = now;
+
+			next_reading();
+			DHTreceive_data(&RH, &temp);
+			baseline_redraw(RH, temp);
+		}
+		jitter.periodMean = (double) (stamp - first) / (jitter.samples - 1);
+		return jitter;
+	}
+
+	/* After: the timer callbacks and tasks of main.c */
+	static void sample_expired(void *context)
+	{
+		(void) context;
+		sched_post(&scheduler, sample_task, SAMPLE_EVENT_TRIGGER);
+	}
+
+	static void poll_expired(void *context)
+	{
+		(void) context;
+		sched_post(&scheduler, sample_task, SAMPLE_EVENT_POLL);
+	}
+
+	static void display_expired(void *context)
+	{
+		(void) context;
+		sched_post(&scheduler, render_task, 0);
+	}
+
+	static void sample_task_run(uint32_t event)
+	{
+		if (event == SAMPLE_EVENT_TRIGGER)
+		{
+			next_reading();
+			sensor_trigger(&sensor);
+			wheel_start(&wheel, &poll_timer, POLL_PERIOD_MS, POLL_PERIOD_MS, poll_expired, NULL);
+			return;
+		}
+		Sensor_StatusTypeDef status = sensor_update(&sensor);
+		if (status == SENSOR_BUSY)
+		{
+			return;
+		}
+		wheel_cancel(&wheel, &poll_timer);
+		if (status == SENSOR_OK)
+		{
+			Sensor_ReadingTypeDef reading;
+			sensor_last_reading(&sensor, &reading, NULL);
+			if (readings++ == 0)
+			{
+				firstTimestamp = reading.timestamp;
+			}
+			else if ((reading.timestamp - firstTimestamp) % SAMPLE_PERIOD_MS != 0)
+			{
+				offGrid++;
+			}
+		}
+		if (status == SENSOR_ERROR)
+		{
+			retries++;
+			wheel_start(&wheel, &retry_timer, sensor_next_conversion(&sensor), 0, sample_expired, NULL);
+		}
+	}
+
+	static void render_task_run(uint32_t event)
+	{
+		Sensor_ReadingTypeDef reading = { 0 };
+
+		(void) event;
+		sensor_last_reading(&sensor, &reading, NULL);
+		setCursor(&lcd, 6, 0);
+		print_fixed(&lcd, reading.temp * 9 / 5 + 320, 1, 5, FMT_ALIGN_RIGHT);
+		print(&lcd, (unsigned char*) " F");
+		setCursor(&lcd, 4, 1);
+		print_fixed(&lcd, reading.RH, 1, 5, FMT_ALIGN_RIGHT);
+		print(&lcd, (unsigned char*) "%");
+		flush(&lcd);
+	}
+
+	/* Period between the timestamps of the sample timer callbacks */
+	static Jitter run_after(void)
+	{
+		Jitter jitter;
+		TimerWheel_JitterTypeDef snapshot;
+		uint32_t first = 0;
+
+		setup();
+		pin_setup(&lcd, GPIOC, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7, GPIO_PIN_8, GPIO_PIN_9,
+				GPIO_PIN_10, GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2);
+		begin(&lcd, 16, 2, LCD_5x8DOTS);
+		setWaitMode(&lcd, LCD_WAIT_BUSYFLAG);
+		frameBufferON(&lcd);
+		mock_tim_init(&htim1, TIM1, 83, 4);
+		memset(&hdma_tim1_up, 0, sizeof(hdma_tim1_up));
+		__HAL_LINKDMA(&htim1, hdma[TIM_DMA_ID_UPDATE], hdma_tim1_up);
+		dmaON(&lcd, &htim1, &hdma_tim1_up, 5000);
+
+		readings = 0;
+		offGrid = 0;
+		retries = 0;
+		sched_init(&scheduler);
+		sample_task = sched_add_task(&scheduler, sample_task_run);
+		render_task = sched_add_task(&scheduler, render_task_run);
+		memset(&sample_timer, 0, sizeof(sample_timer));
+		memset(&display_timer, 0, sizeof(display_timer));
+		memset(&retry_timer, 0, sizeof(retry_timer));
+		memset(&poll_timer, 0, sizeof(poll_timer));
+		wheelRunning = 1;
+		wheel_init(&wheel, &htim5, TIM_CHANNEL_1);
+		wheel_start(&wheel, &sample_timer, SAMPLE_PERIOD_MS, SAMPLE_PERIOD_MS, sample_expired, NULL);
+		wheel_track(&wheel, &sample_timer, &sample_jitter);
+		wheel_start(&wheel, &display_timer, DISPLAY_PERIOD_MS, DISPLAY_PERIOD_MS, display_expired, NULL);
+
+		while (mock_now_ns() < AFTER_NS)
+		{
+			sched_run(&scheduler);
+			if (sample_jitter.samples == 1 && first == 0)
+			{
+				first = sample_jitter.stamp;
+			}
+		}
+
+		wheel_jitter(&wheel, &sample_timer, &snapshot);
+		jitter.samples = snapshot.samples;
+		jitter.periodMin = snapshot.periodMin;
+		jitter.periodMax = snapshot.periodMax;
+		jitter.periodMean = (double) (snapshot.stamp - first) / (snapshot.samples - 1);
+		return jitter;
+	}
+
+	static void report(const char *name, const Jitter *jitter)
+	{
+		char label[64];
+
+		printf("%s, %u samples\n", name, (unsigned) jitter->samples);
+		snprintf(label, sizeof(label), "mean period");
+		bench_report(label, jitter->periodMean / 1000.0, "ms");
+		snprintf(label, sizeof(label), "jitter (max - min period)");
+		bench_report(label, jitter->periodMax - jitter->periodMin, "us");
+		snprintf(label, sizeof(label), "jitter / mean period");
+		bench_report(label, (jitter->periodMax - jitter->periodMin) / jitter->periodMean * 1e6, "ppm");
+	}
+
+	int main(void)
+	{
+		Jitter before = run_before();
+		Jitter after = run_after();
+
+		report("Before: free-running loop, blocking DHT read and LCD redraw", &before);
+		report("After: sample timer on the timer wheel, DHT by edge capture, LCD by DMA", &after);
+
+		/* The wheel samples on its grid, only the interrupt latency moves a timestamp */
+		CHECK(after.samples >= AFTER_NS / 1000000 / SAMPLE_PERIOD_MS - 1);
+		CHECK(after.periodMean > SAMPLE_PERIOD_MS * 1000.0 - 1 && after.periodMean < SAMPLE_PERIOD_MS * 1000.0 + 1);
+		CHECK(after.periodMax - after.periodMin < 50);
+		CHECK_EQUAL(dht.stats.frames, readings);
+		CHECK(offGrid <= retries);		// on the grid of the sample timer, but for the retries after a failure
+		CHECK(before.periodMax - before.periodMin > 1000);
+		CHECK((after.periodMax - after.periodMin) / after.periodMean
+				< (before.periodMax - before.periodMin) / before.periodMean / 100);
+
+		return test_report("SamplingBench");
+	}
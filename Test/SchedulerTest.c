@@ -0,0 +1,115 @@
+/*
+ *  SchedulerTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  Scheduler statistics and their report over SWO: events run in priority
+ *  order, events dropped by a full queue, the queue high-water mark, and the
+ *  counters printed unsigned over their whole range.
+ */
+
+#include "Scheduler.h"
+#include "Delay.h"
+#include "HalMock.h"
+#include "Test.h"
+#include <stdio.h>
+
+	static Scheduler_HandleTypeDef scheduler;
+	static uint32_t order[2 * SCHED_QUEUE_SIZE];
+	static uint32_t ran;
+
+	static void high_run(uint32_t event)
+	{
+		order[ran++] = 100 + event;
+	}
+
+	static void low_run(uint32_t event)
+	{
+		order[ran++] = event;
+	}
+
+	static void setup(void)
+	{
+		mock_reset();
+		delay_init();
+		mock_itm_clear();
+		ran = 0;
+		sched_init(&scheduler);
+		sched_add_task(&scheduler, high_run);
+		sched_add_task(&scheduler, low_run);
+	}
+
+	/* Higher priority first, each queue in order, full queues drop */
+	static void test_stats(void)
+	{
+		Scheduler_StatsTypeDef stats;
+
+		setup();
+		for (uint32_t i = 0; i < SCHED_QUEUE_SIZE + 3; i++)
+		{
+			CHECK_EQUAL(i < SCHED_QUEUE_SIZE, sched_post(&scheduler, 1, i));
+		}
+		CHECK(sched_post(&scheduler, 0, 7));
+		for (uint32_t i = 0; i < SCHED_QUEUE_SIZE + 1; i++)
+		{
+			sched_run(&scheduler);
+		}
+		CHECK_EQUAL(SCHED_QUEUE_SIZE + 1, ran);
+		CHECK_EQUAL(107, order[0]);
+		CHECK_EQUAL(0, order[1]);
+		CHECK_EQUAL(SCHED_QUEUE_SIZE - 1, order[SCHED_QUEUE_SIZE]);
+
+		sched_stats(&scheduler, 1, &stats);
+		CHECK_EQUAL(SCHED_QUEUE_SIZE, stats.events);
+		CHECK_EQUAL(3, stats.dropped);
+		CHECK_EQUAL(SCHED_QUEUE_SIZE, stats.highWater);
+		CHECK(stats.latencyMax > 0);
+		sched_stats(&scheduler, 0, &stats);
+		CHECK_EQUAL(1, stats.events);
+		CHECK_EQUAL(0, stats.dropped);
+		CHECK_EQUAL(1, stats.highWater);
+	}
+
+	/* One line per task over SWO, the figures of sched_stats */
+	static void test_swo_report(void)
+	{
+		Scheduler_StatsTypeDef high;
+		Scheduler_StatsTypeDef low;
+		char expected[256];
+
+		setup();
+		sched_post(&scheduler, 0, 1);
+		sched_post(&scheduler, 1, 2);
+		sched_post(&scheduler, 1, 3);
+		sched_run(&scheduler);
+		sched_run(&scheduler);
+		sched_run(&scheduler);
+		sched_stats(&scheduler, 0, &high);
+		sched_stats(&scheduler, 1, &low);
+		snprintf(expected, sizeof(expected),
+				"task0 events=1 dropped=0 high-water=1 latency=%u\n"
+				"task1 events=2 dropped=0 high-water=2 latency=%u\n",
+				(unsigned int) high.latencyMax, (unsigned int) low.latencyMax);
+		sched_report(&scheduler);
+		CHECK_TEXT(expected, mock_itm_text());
+
+		/* Counters past INT32_MAX are not printed negative */
+		mock_itm_clear();
+		scheduler.tasks[1].stats.events = 4000000000U;
+		scheduler.tasks[1].stats.dropped = 2147483648U;
+		scheduler.tasks[1].stats.latencyMax = UINT32_MAX;
+		sched_stats_reset(&scheduler, 0);
+		sched_report(&scheduler);
+		CHECK_TEXT("task0 events=0 dropped=0 high-water=0 latency=0\n"
+				"task1 events=4000000000 dropped=2147483648 high-water=2 latency=4294967295\n",
+				mock_itm_text());
+	}
+
+	int main(void)
+	{
+		test_stats();
+		test_swo_report();
+
+		return test_report("SchedulerTest");
+	}
@@ -0,0 +1,350 @@
+/*
+ *  SensorBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  CPU time per reading of the sensor backends, on the mock clock: the
+ *  blocking DHT read, the DHT read by edge capture, the BME280 and the SHT3x
+ *  by DMA. The non-blocking backends run from a 1 ms main loop for 20 s and
+ *  are charged every update call, idle ones included, and for the DHT the
+ *  EXTI callbacks of the edges (plus the interrupt entry, 12 cycles each).
+ *  Then an hour of a healthy DHT22 and an hour of outage (the sensor never
+ *  answers), for the loop of the first main.c, DHTreceive_data back to back,
+ *  against DHTupdate, which starts conversions at the rate of the model (or
+ *  of its backoff) and leaves the last valid reading in its cache: CPU time,
+ *  conversions (a start pulse and a frame on the line each), retries and
+ *  bus time per hour, and what the front-end saves.
+ *  Plain computation takes no time on the mock clock: the figures are the
+ *  time the CPU is held by the bus, the line and the HAL calls.
+ */
+
+#include "BME280.h"
+#include "BME280Device.h"
+#include "DHTemp.h"
+#include "DHT22.h"
+#include "SHT3x.h"
+#include "SHT3xDevice.h"
+#include "Test.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RUN_MS 20000
+#define ENTRY_NS MOCK_CYCLES_NS(12)
+#define HOUR_NS 3600000000000ULL
+
+/* Run of the back to back loop, scaled to an hour (its reads are slow to simulate) */
+#define BACK_TO_BACK_NS 200000000ULL
+
+	static DHT22_HandleTypeDef dht;
+	static TIM_HandleTypeDef htim2;
+	static BME280Device_HandleTypeDef bme;
+	static SHT3xDevice_HandleTypeDef sht;
+	static I2C_HandleTypeDef hi2c1;
+
+	/* Time spent in the EXTI callbacks and their number */
+	static uint64_t callbackNs;
+	static uint32_t callbacks;
+
+	void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+	{
+		uint64_t start = mock_now_ns();
+
+		if (GPIO_Pin == GPIO_PIN_11)
+		{
+			DHTcapture_edge();
+		}
+		callbackNs += mock_now_ns() - start;
+		callbacks++;
+	}
+
+	static void setup_dht(void)
+	{
+		mock_reset();
+		dht22_init(&dht);
+		dht22_attach(&dht, GPIOA, GPIO_PIN_11);
+		dht22_set_reading(&dht, 652, 231);
+		mock_tim_init(&htim2, TIM2, 83, 0xFFFFFFFF);
+		DHTinit(GPIOA, GPIO_PIN_11, &htim2);
+		DHTset_model(DHT_MODEL_DHT22);
+		callbackNs = 0;
+		callbacks = 0;
+	}
+
+	/* DHT traffic, per hour */
+	typedef struct
+	{
+		double conversions;		// start pulses
+		double readings;		// valid readings
+		double cpuUs;			// CPU held by the driver
+		double busUs;			// line held low by the MCU
+	} Hourly;
+
+	/* Figures of the emulated sensor and of the CPU time over a run of ns */
+	static Hourly hourly(uint64_t busyNs, uint32_t readings, uint64_t ns)
+	{
+		Hourly hour;
+		double scale = (double) HOUR_NS / ns;
+
+		hour.conversions = dht.stats.pulses * scale;
+		hour.readings = readings * scale;
+		hour.cpuUs = busyNs / 1000.0 * scale;
+		hour.busUs = dht.stats.heldNs / 1000.0 * scale;
+		return hour;
+	}
+
+	/* The loop of the first main.c: a blocking read again as soon as one ends */
+	static Hourly run_back_to_back(uint64_t ns)
+	{
+		int16_t RH;
+		int16_t temp;
+		uint32_t readings = 0;
+		uint64_t start = mock_now_ns();
+
+		while (mock_now_ns() - start < ns)
+		{
+			if (DHTreceive_data(&RH, &temp) == DHT_OK)
+			{
+				readings++;
+			}
+		}
+		return hourly(mock_now_ns() - start, readings, mock_now_ns() - start);
+	}
+
+	/*
+	 * DHTupdate from a main loop that polls every millisecond during a
+	 * conversion and sleeps until DHTnext_conversion between them (an hour
+	 * of 1 ms polls is slow to simulate, the idle ones cost next to nothing)
+	 */
+	static Hourly run_front_end(uint64_t ns)
+	{
+		uint64_t busyNs = 0;
+		uint32_t readings = 0;
+		uint64_t start = mock_now_ns();
+
+		while (mock_now_ns() - start < ns)
+		{
+			uint64_t call = mock_now_ns();
+			DHT_StatusTypeDef status = DHTupdate();
+			busyNs += mock_now_ns() - call;
+			if (status == DHT_OK)
+			{
+				readings++;
+			}
+			uint32_t sleep = status == DHT_BUSY ? 0 : DHTnext_conversion();
+			mock_run_ns((sleep ? sleep : 1) * 1000000ULL);
+		}
+		busyNs += callbackNs + callbacks * ENTRY_NS;
+		return hourly(busyNs, readings, mock_now_ns() - start);
+	}
+
+	static void report_hourly(const char *name, const Hourly *hour)
+	{
+		printf("%s, per hour\n", name);
+		bench_report("conversions started", hour->conversions, "");
+		bench_report("valid readings", hour->readings, "");
+		bench_report("CPU time", hour->cpuUs, "us");
+		bench_report("bus time (line held low)", hour->busUs, "us");
+	}
+
+	/* A healthy sensor for an hour: DHT22_INTERVAL enforced, readings between conversions from the cache */
+	static void bench_hour(void)
+	{
+		int16_t RH;
+		int16_t temp;
+		uint32_t age;
+
+		setup_dht();
+		Hourly before = run_back_to_back(BACK_TO_BACK_NS);
+
+		setup_dht();
+		Hourly after = run_front_end(HOUR_NS);
+
+		report_hourly("DHTreceive_data back to back", &before);
+		report_hourly("DHTupdate and DHTlast_reading", &after);
+		printf("Saved by the front-end, per hour\n");
+		bench_report("CPU time", before.cpuUs - after.cpuUs, "us");
+		bench_report("bus transactions (conversions)", before.conversions - after.conversions, "");
+		bench_report("bus time", before.busUs - after.busUs, "us");
+
+		/* One conversion per interval, every one valid and served from the cache until the next */
+		CHECK(after.conversions > 3600000 / DHT22_INTERVAL - 2);
+		CHECK(after.conversions < 3600000 / DHT22_INTERVAL + 2);
+		CHECK(after.readings >= after.conversions - 1);
+		CHECK_EQUAL(DHT_SAMPLE_FRESH, DHTlast_reading(&RH, &temp, &age));
+		CHECK_EQUAL(652, RH);
+		CHECK(age < DHT22_INTERVAL);
+		CHECK(before.readings > 100 * after.readings);
+		CHECK(after.cpuUs < before.cpuUs / 1000);
+		CHECK(after.busUs < before.busUs / 100);
+	}
+
+	/* The sensor silent for an hour: every conversion after the first is a retry */
+	static void bench_outage(void)
+	{
+		setup_dht();
+		dht.respond = 0;
+		Hourly before = run_back_to_back(BACK_TO_BACK_NS);
+
+		setup_dht();
+		dht.respond = 0;
+		Hourly after = run_front_end(HOUR_NS);
+
+		report_hourly("Outage, DHTreceive_data back to back", &before);
+		report_hourly("Outage, DHTupdate with backoff", &after);
+		printf("Outage, per hour\n");
+		bench_report("retries, back to back", before.conversions - 1, "");
+		bench_report("retries, backoff", after.conversions - 1, "");
+		bench_report("bus time, back to back", before.busUs, "us");
+		bench_report("bus time, backoff", after.busUs, "us");
+
+		/* Back to back holds the line low most of the hour, the backoff settles on DHT_BACKOFF_MAX */
+		CHECK_EQUAL(0, before.readings);
+		CHECK_EQUAL(0, after.readings);
+		CHECK(before.busUs > 0.9 * HOUR_NS / 1000);
+		CHECK(after.conversions <= 6 + 3600000 / DHT_BACKOFF_MAX);
+		CHECK(after.conversions >= 6 + 3600000 / (DHT_BACKOFF_MAX * 5 / 4));
+		CHECK(after.busUs < before.busUs / 1000);
+		CHECK(after.cpuUs < before.cpuUs / 1000);
+	}
+
+	static void setup_i2c(void)
+	{
+		memset(&hi2c1, 0, sizeof(hi2c1));
+		hi2c1.State = HAL_I2C_STATE_READY;
+	}
+
+	/* Blocking read every DHT22_INTERVAL: the whole read holds the CPU */
+	static double run_dht_blocking(void)
+	{
+		int16_t RH;
+		int16_t temp;
+		uint64_t busyNs = 0;
+		uint32_t readings = 0;
+
+		setup_dht();
+		for (int i = 0; i < RUN_MS / DHT22_INTERVAL; i++)
+		{
+			uint64_t start = mock_now_ns();
+			if (DHTreceive_data(&RH, &temp) == DHT_OK)
+			{
+				readings++;
+			}
+			busyNs += mock_now_ns() - start;
+			mock_run_ns(DHT22_INTERVAL * 1000000ULL - (mock_now_ns() - start));
+		}
+
+		CHECK_EQUAL(RUN_MS / DHT22_INTERVAL, readings);
+		return readings ? busyNs / 1000.0 / readings : 0;
+	}
+
+	/* DHTupdate from the main loop, edges timestamped by the EXTI callback */
+	static double run_dht_capture(void)
+	{
+		uint64_t busyNs = 0;
+		uint32_t readings = 0;
+
+		setup_dht();
+		for (int ms = 0; ms < RUN_MS; ms++)
+		{
+			uint64_t start = mock_now_ns();
+			if (DHTupdate() == DHT_OK)
+			{
+				readings++;
+			}
+			busyNs += mock_now_ns() - start;
+			mock_run_ns(1000000);
+		}
+		busyNs += callbackNs + callbacks * ENTRY_NS;
+
+		CHECK_EQUAL(RUN_MS / DHT22_INTERVAL - 1, readings);		// the first an interval after DHTinit
+		CHECK_EQUAL(readings * DHT_FRAME_EDGES, callbacks);
+		return readings ? busyNs / 1000.0 / readings : 0;
+	}
+
+	/* BME280update from the main loop, burst and fetches by DMA */
+	static double run_bme280(void)
+	{
+		static const BME280Device_CalibTypeDef calib =
+		{
+			27504, 26435, -1000,
+			36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000,
+			75, 362, 0, 313, 50, 30
+		};
+		BME280_HandleTypeDef hbme;
+		uint64_t busyNs = 0;
+		uint32_t readings = 0;
+
+		mock_reset();
+		bme280_device_init(&bme);
+		bme280_device_set_calib(&bme, &calib);
+		bme280_device_set_raw(&bme, 415148, 519888, 30000);
+		bme280_device_attach(&bme, BME280_ADDRESS_LOW);
+		setup_i2c();
+		CHECK_EQUAL(HAL_OK, BME280init(&hbme, &hi2c1, BME280_ADDRESS_LOW));
+		for (int ms = 0; ms < RUN_MS; ms++)
+		{
+			uint64_t start = mock_now_ns();
+			if (BME280update(&hbme) == SENSOR_OK)
+			{
+				readings++;
+			}
+			busyNs += mock_now_ns() - start;
+			mock_run_ns(1000000);
+		}
+
+		CHECK_EQUAL(RUN_MS / BME280_INTERVAL, readings);
+		return readings ? busyNs / 1000.0 / readings : 0;
+	}
+
+	/* SHT3xupdate from the main loop, command and result by DMA */
+	static double run_sht3x(void)
+	{
+		SHT3x_HandleTypeDef hsht;
+		uint64_t busyNs = 0;
+		uint32_t readings = 0;
+
+		mock_reset();
+		sht3x_device_init(&sht);
+		sht3x_device_attach(&sht, SHT3X_ADDRESS_LOW);
+		setup_i2c();
+		CHECK_EQUAL(HAL_OK, SHT3xinit(&hsht, &hi2c1, SHT3X_ADDRESS_LOW));
+		for (int ms = 0; ms < RUN_MS; ms++)
+		{
+			uint64_t start = mock_now_ns();
+			if (SHT3xupdate(&hsht) == SENSOR_OK)
+			{
+				readings++;
+			}
+			busyNs += mock_now_ns() - start;
+			mock_run_ns(1000000);
+		}
+
+		CHECK_EQUAL(RUN_MS / SHT3X_INTERVAL, readings);
+		return readings ? busyNs / 1000.0 / readings : 0;
+	}
+
+	int main(void)
+	{
+		double blocking = run_dht_blocking();
+		double capture = run_dht_capture();
+		double bme280 = run_bme280();
+		double sht3x = run_sht3x();
+
+		printf("CPU time per reading, 1 ms main loop\n");
+		bench_report("DHT22 blocking read", blocking, "us");
+		bench_report("DHT22 edge capture", capture, "us");
+		bench_report("BME280 DMA", bme280, "us");
+		bench_report("SHT3x DMA", sht3x, "us");
+
+		/* Start pulse and frame held by the blocking read, only the polls and edges otherwise */
+		CHECK(blocking > DHT_START_PULSE);
+		CHECK(capture * 50 < blocking);
+		CHECK(bme280 < capture);
+		CHECK(sht3x < capture);
+
+		bench_hour();
+		bench_outage();
+
+		return test_report("SensorBench");
+	}
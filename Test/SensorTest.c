@@ -0,0 +1,183 @@
+/*
+ *  SensorTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  The sample record (seqlock over two slots) of "Sensor.h": the empty
+ *  record, then one writer thread publishing as fast as it can while reader
+ *  threads take snapshots. On the station the writer and the reader are
+ *  tasks of the scheduler that never preempt each other; threads on several
+ *  host cores race much harder, on every field of every copy. A snapshot may
+ *  fail, but one that succeeds is never torn and versions never go back.
+ */
+
+#include "Sensor.h"
+#include "Test.h"
+#include <pthread.h>
+
+#define PUBLICATIONS 30000000
+#define READERS 3
+
+	static Sensor_RecordTypeDef record;
+	static volatile uint8_t writing;
+
+	/* Results of a reader thread */
+	typedef struct
+	{
+		uint32_t snapshots;
+		uint32_t failed;		// sensor_snapshot returned 0
+		uint32_t torn;			// fields from different publications
+		uint32_t backwards;		// version older than the previous snapshot
+		uint32_t versions;		// distinct versions seen
+	} ReaderResult;
+
+	/* Every field of publication version is derived from it */
+	static void reading_of(uint32_t version, Sensor_ReadingTypeDef *reading, uint8_t *tag)
+	{
+		reading->RH = (Units_DeciTypeDef) (version % 1000);
+		reading->temp = (Units_DeciTypeDef) (version % 1201) - 400;
+		reading->pressure = version * 3U;
+		reading->timestamp = version ^ 0xA5A5A5A5U;
+		reading->fields = (uint8_t) version;
+		*tag = (uint8_t) (version % 3);
+	}
+
+	static uint8_t consistent(const Sensor_SampleTypeDef *sample)
+	{
+		Sensor_ReadingTypeDef expected;
+		uint8_t tag;
+
+		if (sample->version == 0)
+		{
+			return sample->tag == SENSOR_SAMPLE_INVALID;
+		}
+		reading_of(sample->version, &expected, &tag);
+		return sample->reading.RH == expected.RH && sample->reading.temp == expected.temp
+				&& sample->reading.pressure == expected.pressure
+				&& sample->reading.timestamp == expected.timestamp
+				&& sample->reading.fields == expected.fields && sample->tag == tag;
+	}
+
+	static void *writer_run(void *argument)
+	{
+		Sensor_ReadingTypeDef reading;
+		uint8_t tag;
+
+		(void) argument;
+		for (uint32_t version = 1; version <= PUBLICATIONS; version++)
+		{
+			reading_of(version, &reading, &tag);
+			sensor_publish(&record, &reading, tag);
+		}
+		__atomic_store_n(&writing, 0, __ATOMIC_RELEASE);
+		return NULL;
+	}
+
+	static void *reader_run(void *argument)
+	{
+		ReaderResult *result = (ReaderResult*) argument;
+		Sensor_SampleTypeDef sample;
+		uint32_t last = 0;
+
+		while (__atomic_load_n(&writing, __ATOMIC_ACQUIRE))
+		{
+			result->snapshots++;
+			if (!sensor_snapshot(&record, &sample))
+			{
+				result->failed++;
+				continue;
+			}
+			if (!consistent(&sample))
+			{
+				result->torn++;
+			}
+			if (sample.version < last)
+			{
+				result->backwards++;
+			}
+			if (sample.version != last)
+			{
+				result->versions++;
+			}
+			last = sample.version;
+		}
+		return NULL;
+	}
+
+	/* Before the first publication: version 0, invalid */
+	static void test_empty(void)
+	{
+		Sensor_SampleTypeDef sample;
+
+		sensor_record_init(&record);
+		CHECK_EQUAL(1, sensor_snapshot(&record, &sample));
+		CHECK_EQUAL(0, sample.version);
+		CHECK_EQUAL(SENSOR_SAMPLE_INVALID, sample.tag);
+	}
+
+	/* Publications one after the other alternate the slots, the last one is read */
+	static void test_sequence(void)
+	{
+		Sensor_ReadingTypeDef reading;
+		Sensor_SampleTypeDef sample;
+		uint8_t tag;
+
+		sensor_record_init(&record);
+		for (uint32_t version = 1; version <= 5; version++)
+		{
+			reading_of(version, &reading, &tag);
+			sensor_publish(&record, &reading, tag);
+			CHECK_EQUAL(1, sensor_snapshot(&record, &sample));
+			CHECK_EQUAL(version, sample.version);
+			CHECK(consistent(&sample));
+			CHECK_EQUAL(version & 1, record.version & 1);
+			CHECK_EQUAL(2 * ((version + 1) / 2), record.sequence[version & 1]);
+		}
+	}
+
+	/* One writer, several readers, all at full speed */
+	static void test_hammer(void)
+	{
+		pthread_t writer;
+		pthread_t readers[READERS];
+		ReaderResult results[READERS] = { 0 };
+		Sensor_SampleTypeDef sample;
+
+		sensor_record_init(&record);
+		writing = 1;
+		for (int i = 0; i < READERS; i++)
+		{
+			CHECK_EQUAL(0, pthread_create(&readers[i], NULL, reader_run, &results[i]));
+		}
+		CHECK_EQUAL(0, pthread_create(&writer, NULL, writer_run, NULL));
+		pthread_join(writer, NULL);
+		for (int i = 0; i < READERS; i++)
+		{
+			pthread_join(readers[i], NULL);
+		}
+
+		for (int i = 0; i < READERS; i++)
+		{
+			CHECK(results[i].snapshots > results[i].failed);
+			CHECK(results[i].versions > 1);
+			CHECK_EQUAL(0, results[i].torn);
+			CHECK_EQUAL(0, results[i].backwards);
+			bench_report("snapshots", results[i].snapshots, "");
+			bench_report("failed (writer published twice during the copy)", results[i].failed, "");
+			bench_report("versions seen", results[i].versions, "");
+		}
+
+		CHECK_EQUAL(1, sensor_snapshot(&record, &sample));
+		CHECK_EQUAL(PUBLICATIONS, sample.version);
+		CHECK(consistent(&sample));
+	}
+
+	int main(void)
+	{
+		test_empty();
+		test_sequence();
+		test_hammer();
+
+		return test_report("SensorTest");
+	}
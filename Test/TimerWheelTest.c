@@ -0,0 +1,301 @@
+/*
+ *  TimerWheelTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  The timer wheel on TIM5 channel 1 of the mock, free-running at 1 MHz as
+ *  main.c sets it up: expiries on the boundaries of the levels (64^k ticks),
+ *  in the slot of the current index one turn ahead (delta 64^k - 1), timers
+ *  started after the wheel slept for a long time, the wrap of the timer
+ *  count and the period statistics of wheel_track.
+ */
+
+#include "TimerWheel.h"
+#include "HalMock.h"
+#include "Test.h"
+#include <stdio.h>
+
+/* Longest time from the expiry tick to the callback in timer counts */
+#define MAX_LATENCY 20
+
+	static TIM_HandleTypeDef htim5;
+	static TimerWheel_HandleTypeDef wheel;
+	static uint8_t wheelRunning;
+	static uint32_t interrupts;
+
+	/* Timer count of tick 0 */
+	static uint32_t origin;
+
+	/* Callbacks of a timer */
+	typedef struct
+	{
+		uint32_t calls;
+		uint32_t tick;			// processed tick at the last callback
+		int32_t late;			// timer counts from the start of that tick to the callback
+		int32_t lateMax;
+	} Probe;
+
+	void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+	{
+		if (wheelRunning && htim->Instance == TIM5 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1)
+		{
+			interrupts++;
+			wheel_process(&wheel);
+		}
+	}
+
+	static void probe_expired(void *context)
+	{
+		Probe *probe = (Probe*) context;
+
+		probe->calls++;
+		probe->tick = wheel.now;
+		probe->late = (int32_t) (__HAL_TIM_GET_COUNTER(&htim5) - (origin + wheel.now * WHEEL_TICK));
+		if (probe->late > probe->lateMax)
+		{
+			probe->lateMax = probe->late;
+		}
+	}
+
+	/* Wheel on TIM5 at 1 us, the counter starting at count */
+	static void setup(uint32_t count)
+	{
+		mock_reset();
+		mock_tim_init(&htim5, TIM5, 83, 0xFFFFFFFF);
+		__HAL_TIM_SET_COUNTER(&htim5, count);
+		interrupts = 0;
+		wheel_init(&wheel, &htim5, TIM_CHANNEL_1);
+		origin = wheel.base;
+		wheelRunning = 1;
+	}
+
+	/* Run until a tick (1 ms each), plus a little for the callback */
+	static void run_to_tick(uint32_t tick)
+	{
+		/* In steps the timer count can not wrap in */
+		while ((int32_t) (tick - wheel_now(&wheel)) > 1000000)
+		{
+			mock_run_ns(1000000000000ULL);
+		}
+		int32_t left = (int32_t) (origin + tick * WHEEL_TICK - __HAL_TIM_GET_COUNTER(&htim5));
+		if (left > 0)
+		{
+			mock_run_ns((uint64_t) left * 1000);
+		}
+		mock_run_ns(MAX_LATENCY * 1000);
+	}
+
+	/* A one-shot timer from the current tick fires on the tick delay later, not before */
+	static void check_delay(uint32_t delay)
+	{
+		TimerWheel_TimerTypeDef timer = { 0 };
+		Probe probe = { 0 };
+
+		uint32_t expires = wheel_now(&wheel) + delay;
+		wheel_start(&wheel, &timer, delay, 0, probe_expired, &probe);
+		run_to_tick(expires - 1);
+		CHECK_EQUAL(0, probe.calls);
+		run_to_tick(expires);
+		CHECK_EQUAL(1, probe.calls);
+		CHECK_EQUAL(expires, probe.tick);
+		CHECK(probe.late >= 0 && probe.late < MAX_LATENCY);
+		CHECK_EQUAL(0, timer.active);
+	}
+
+	/* Expiries on and around 64, 64^2 and 64^3, from ticks on and off the grid of the levels */
+	static void test_level_boundaries(void)
+	{
+		static const uint32_t starts[] = { 0, 1, 63, 64, 4095, 4096 };
+
+		for (unsigned int s = 0; s < sizeof(starts) / sizeof(starts[0]); s++)
+		{
+			for (uint32_t span = WHEEL_SLOTS; span <= (1UL << (3 * WHEEL_SLOT_BITS)); span <<= WHEEL_SLOT_BITS)
+			{
+				setup(0);
+				run_to_tick(starts[s]);
+				/* Relative to the start, and to the next boundary of the level */
+				check_delay(span - 1);
+				check_delay(span);
+				check_delay(span + 1);
+				uint32_t boundary = (wheel_now(&wheel) / span + 1) * span;
+				check_delay(boundary - wheel_now(&wheel));
+				check_delay(boundary + span - wheel_now(&wheel));
+			}
+		}
+
+		/* Longest delay, on the last level */
+		setup(0);
+		check_delay(WHEEL_MAX_DELAY);
+	}
+
+	/*
+	 * Delta 64^k - 1 lands one turn ahead in the slot of the current index of
+	 * its level: it must wait for the turn, not fire on this one
+	 */
+	static void test_same_index(void)
+	{
+		for (uint32_t start = 0; start < 2 * WHEEL_SLOTS + 3; start++)
+		{
+			setup(0);
+			run_to_tick(start * 61);
+			uint32_t now = wheel_now(&wheel);
+			uint32_t delay = (1UL << (2 * WHEEL_SLOT_BITS)) - 1;
+			if (now & (WHEEL_SLOTS - 1))
+			{
+				CHECK_EQUAL((now >> WHEEL_SLOT_BITS) & (WHEEL_SLOTS - 1),
+						((now + delay) >> WHEEL_SLOT_BITS) & (WHEEL_SLOTS - 1));
+			}
+			check_delay(delay);
+			check_delay((1UL << (3 * WHEEL_SLOT_BITS)) - 1);
+		}
+	}
+
+	/*
+	 * Empty for an hour, the wheel wakes up every WHEEL_MAX_SLEEP only: a
+	 * timer started then counts from the current tick, not the one of the
+	 * last interrupt, and so does one started long after that interrupt
+	 */
+	static void test_long_sleep(void)
+	{
+		TimerWheel_TimerTypeDef periodic = { 0 };
+		Probe probe = { 0 };
+
+		setup(0);
+		mock_run_ns(3600000000000ULL);
+		CHECK_EQUAL(3600000 / WHEEL_MAX_SLEEP, interrupts);
+		CHECK(wheel.now < wheel_now(&wheel) - (1UL << (3 * WHEEL_SLOT_BITS)));
+		check_delay(10);
+		check_delay(5000);
+
+		/* Processed tick stale by more than a turn of the third level */
+		mock_run_ns(20ULL * 60 * 1000000000ULL);
+		CHECK(wheel.now < wheel_now(&wheel) - (1UL << (3 * WHEEL_SLOT_BITS)));
+		check_delay(1);
+		check_delay(4095);
+
+		/* A periodic timer keeps its grid through the sleeps between its expiries */
+		uint32_t first = wheel_now(&wheel) + 100;
+		wheel_start(&wheel, &periodic, 100, 1000000, probe_expired, &probe);
+		run_to_tick(first + 3 * 1000000);
+		CHECK_EQUAL(4, probe.calls);
+		CHECK_EQUAL(first + 3 * 1000000, probe.tick);
+		CHECK(probe.lateMax < MAX_LATENCY);
+		CHECK_EQUAL(0, wheel.stats.missed);
+	}
+
+	/* The 32-bit count wraps every 71.6 minutes, the ticks go on */
+	static void test_counter_wrap(void)
+	{
+		TimerWheel_TimerTypeDef fast = { 0 };
+		TimerWheel_TimerTypeDef slow = { 0 };
+		Probe fastProbe = { 0 };
+		Probe slowProbe = { 0 };
+
+		/* Wrap 5.5 ticks in */
+		setup(0xFFFFFFFFU - 5500);
+		wheel_start(&wheel, &fast, 1, 1, probe_expired, &fastProbe);
+		check_delay(7);
+		CHECK(__HAL_TIM_GET_COUNTER(&htim5) < origin);
+		run_to_tick(20);
+		CHECK_EQUAL(20, fastProbe.calls);
+		CHECK_EQUAL(20, fastProbe.tick);
+		CHECK(fastProbe.lateMax < MAX_LATENCY);
+		wheel_cancel(&wheel, &fast);
+
+		/* Two wraps of a 10 minute timer and of the wheel sleeping in between */
+		setup(0);
+		wheel_start(&wheel, &slow, 600000, 600000, probe_expired, &slowProbe);
+		run_to_tick(15 * 600000);
+		CHECK_EQUAL(15, slowProbe.calls);
+		CHECK_EQUAL(15 * 600000, slowProbe.tick);
+		CHECK(slowProbe.lateMax < MAX_LATENCY);
+		CHECK_EQUAL(0, wheel.stats.missed);
+		check_delay(3);
+	}
+
+	/* Periods between the timestamps of a tracked timer, also when the interrupt is held off */
+	static void test_jitter(void)
+	{
+		TimerWheel_TimerTypeDef timer = { 0 };
+		TimerWheel_JitterTypeDef jitter;
+		TimerWheel_JitterTypeDef snapshot;
+		Probe probe = { 0 };
+
+		setup(0);
+		wheel_track(&wheel, &timer, &jitter);
+		wheel_start(&wheel, &timer, 2000, 2000, probe_expired, &probe);
+		run_to_tick(20000);
+		wheel_jitter(&wheel, &timer, &snapshot);
+		CHECK_EQUAL(10, snapshot.samples);
+		CHECK(snapshot.periodMin >= 2000 * WHEEL_TICK - MAX_LATENCY);
+		CHECK(snapshot.periodMax <= 2000 * WHEEL_TICK + MAX_LATENCY);
+
+		/* An expiry 300 us late stretches one period and shrinks the next */
+		run_to_tick(21999);
+		__disable_irq();
+		mock_run_ns(1300000);
+		__enable_irq();
+		run_to_tick(24000);
+		wheel_jitter(&wheel, &timer, &snapshot);
+		CHECK_EQUAL(12, snapshot.samples);
+		CHECK(snapshot.periodMax >= 2000 * WHEEL_TICK + 300);
+		CHECK(snapshot.periodMin <= 2000 * WHEEL_TICK - 300 + MAX_LATENCY);
+		CHECK_EQUAL(0, wheel.stats.missed);
+
+		/* Cleared by wheel_track, the first callback has no period */
+		wheel_track(&wheel, &timer, &jitter);
+		run_to_tick(26000);
+		wheel_jitter(&wheel, &timer, &snapshot);
+		CHECK_EQUAL(1, snapshot.samples);
+		CHECK_EQUAL(UINT32_MAX, snapshot.periodMin);
+		CHECK_EQUAL(0, snapshot.periodMax);
+	}
+
+	/* Report over SWO: the statistics of the wheel, then those of a tracked timer */
+	static void test_report_swo(void)
+	{
+		TimerWheel_TimerTypeDef timer = { 0 };
+		TimerWheel_JitterTypeDef jitter;
+		TimerWheel_StatsTypeDef stats;
+		Probe probe = { 0 };
+		char expected[128];
+
+		/* Nothing expired yet: no minimum to report */
+		setup(0);
+		mock_itm_clear();
+		wheel_track(&wheel, &timer, &jitter);
+		wheel_report(&wheel, &timer);
+		CHECK_TEXT("wheel expired=0 missed=0 latency=0-0\ntimer samples=0 period=0-0\n", mock_itm_text());
+
+		wheel_start(&wheel, &timer, 2000, 2000, probe_expired, &probe);
+		run_to_tick(6000);
+		wheel_stats(&wheel, &stats);
+		snprintf(expected, sizeof(expected), "wheel expired=3 missed=0 latency=%u-%u\ntimer samples=3 period=%u-%u\n",
+				(unsigned int) stats.latencyMin, (unsigned int) stats.latencyMax,
+				(unsigned int) jitter.periodMin, (unsigned int) jitter.periodMax);
+		mock_itm_clear();
+		wheel_report(&wheel, &timer);
+		CHECK_TEXT(expected, mock_itm_text());
+
+		/* Without a tracked timer, unsigned over the whole range */
+		wheel.stats.expired = 3000000000U;
+		wheel.stats.latencyMax = UINT32_MAX;
+		snprintf(expected, sizeof(expected), "wheel expired=3000000000 missed=0 latency=%u-4294967295\n",
+				(unsigned int) stats.latencyMin);
+		mock_itm_clear();
+		wheel_report(&wheel, NULL);
+		CHECK_TEXT(expected, mock_itm_text());
+	}
+
+	int main(void)
+	{
+		test_level_boundaries();
+		test_same_index();
+		test_long_sleep();
+		test_counter_wrap();
+		test_jitter();
+		test_report_swo();
+
+		return test_report("TimerWheelTest");
+	}
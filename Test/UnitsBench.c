@@ -0,0 +1,118 @@
+/*
+ *  UnitsBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  units_temp against the conversion it replaced (temp * 1.8 + 320, a double
+ *  expression truncated to int16) over the range of the station, -40.0 C to
+ *  125.0 C: cycles per conversion and how many results are not the nearest
+ *  tenth. Plain computation takes no time on the mock clock, so both run
+ *  natively and are timed with the host cycle counter (nanoseconds where
+ *  there is none). The host has a double-precision FPU, the Cortex-M4 only a
+ *  single-precision one: there the double expression is four calls into the
+ *  soft-float library (int to double, multiply, add, double to int), so the
+ *  host figures are a lower bound for it. They show what the integer
+ *  conversion costs on its own and that it stays within a small factor of
+ *  hardware double arithmetic.
+ */
+
+#include "Units.h"
+#include "Test.h"
+#include <math.h>
+#include <stdio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLE_UNIT "host cycles per conversion"
+#else
+#include <time.h>
+#define CYCLE_UNIT "ns per conversion"
+#endif
+
+#define ROUNDS 2000
+#define LOWEST -400
+#define HIGHEST 1250
+
+	static volatile int32_t sink;
+
+	static double now_cycles(void)
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		return (double) __rdtsc();
+#else
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1e9 + ts.tv_nsec;
+#endif
+	}
+
+	/* The conversion of the first main.c */
+	__attribute__((noinline)) static int16_t temp_f_deci(int16_t temp)
+	{
+		return temp * 1.8 + 320;
+	}
+
+	__attribute__((noinline)) static int16_t temp_units(int16_t temp)
+	{
+		return units_temp(temp, UNITS_FAHRENHEIT);
+	}
+
+	static double run(int16_t (*convert)(int16_t))
+	{
+		int32_t sum = 0;
+		double start = now_cycles();
+
+		for (int round = 0; round < ROUNDS; round++)
+		{
+			for (int16_t temp = LOWEST; temp <= HIGHEST; temp++)
+			{
+				sum += convert(temp);
+			}
+		}
+		sink = sum;
+		return (now_cycles() - start) / (ROUNDS * (HIGHEST - LOWEST + 1.0));
+	}
+
+	/* Results that are not the nearest tenth of the exact value */
+	static uint32_t errors(int16_t (*convert)(int16_t))
+	{
+		uint32_t count = 0;
+
+		for (int16_t temp = LOWEST; temp <= HIGHEST; temp++)
+		{
+			if (convert(temp) != (int16_t) round(temp * 9.0 / 5.0 + 320.0))
+			{
+				count++;
+			}
+		}
+		return count;
+	}
+
+	int main(void)
+	{
+		/* Best of a few runs, the host may be busy */
+		double integer = 1e9;
+		double floating = 1e9;
+		for (int i = 0; i < 5; i++)
+		{
+			double t = run(temp_units);
+			integer = t < integer ? t : integer;
+			t = run(temp_f_deci);
+			floating = t < floating ? t : floating;
+		}
+		uint32_t integerErrors = errors(temp_units);
+		uint32_t floatingErrors = errors(temp_f_deci);
+
+		printf("Celsius to Fahrenheit in tenths, -40.0 C to 125.0 C\n");
+		bench_report("units_temp", integer, CYCLE_UNIT);
+		bench_report("temp * 1.8 + 320", floating, CYCLE_UNIT);
+		bench_report("units_temp, not the nearest tenth", integerErrors, "of 1651");
+		bench_report("temp * 1.8 + 320, not the nearest tenth", floatingErrors, "of 1651");
+
+		CHECK_EQUAL(0, integerErrors);
+		CHECK_EQUAL(658, floatingErrors);
+		CHECK(integer < 4 * floating);
+
+		return test_report("UnitsBench");
+	}
@@ -0,0 +1,92 @@
+/*
+ *  UnitsTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *  Author: Jake Ivanov
+ *
+ *  units_temp against a double-precision reference for every int16 input in
+ *  every unit (nearest tenth, halves away from zero, saturated), and the
+ *  unit symbols.
+ */
+
+#include "Units.h"
+#include "Test.h"
+#include <math.h>
+
+	/* Exact conversion in double, rounded and saturated as units_temp promises */
+	static int32_t reference(int16_t celsius, uint8_t unit)
+	{
+		double value;
+
+		switch (unit)
+		{
+		case UNITS_FAHRENHEIT:
+			value = celsius * 9.0 / 5.0 + 320.0;
+			break;
+		case UNITS_KELVIN:
+			value = celsius + 2731.5;
+			break;
+		default:
+			value = celsius;
+			break;
+		}
+		value = round(value);
+		return value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : (int32_t) value;
+	}
+
+	/* All 65536 inputs of the three units */
+	static void test_exhaustive(void)
+	{
+		static const uint8_t units[] = { UNITS_CELSIUS, UNITS_FAHRENHEIT, UNITS_KELVIN };
+
+		for (unsigned int u = 0; u < sizeof(units) / sizeof(units[0]); u++)
+		{
+			uint32_t mismatches = 0;
+			for (int32_t celsius = INT16_MIN; celsius <= INT16_MAX; celsius++)
+			{
+				if (units_temp((int16_t) celsius, units[u]) != reference((int16_t) celsius, units[u]))
+				{
+					if (mismatches++ == 0)
+					{
+						CHECK_EQUAL(reference((int16_t) celsius, units[u]), units_temp((int16_t) celsius, units[u]));
+					}
+				}
+			}
+			CHECK_EQUAL(0, mismatches);
+		}
+	}
+
+	/* Known values, the halves of Kelvin and both ends of the range */
+	static void test_vectors(void)
+	{
+		CHECK_EQUAL(320, units_temp(0, UNITS_FAHRENHEIT));
+		CHECK_EQUAL(322, units_temp(1, UNITS_FAHRENHEIT));		// 32.18 F
+		CHECK_EQUAL(-400, units_temp(-400, UNITS_FAHRENHEIT));	// -40 is the same in both
+		CHECK_EQUAL(2120, units_temp(1000, UNITS_FAHRENHEIT));
+		CHECK_EQUAL(318, units_temp(-1, UNITS_FAHRENHEIT));	// 31.82 F
+		CHECK_EQUAL(2732, units_temp(0, UNITS_KELVIN));		// 273.15 K, half up
+		CHECK_EQUAL(-2732, units_temp(-5463, UNITS_KELVIN));	// -273.15 K, half away from zero
+		CHECK_EQUAL(1, units_temp(-2731, UNITS_KELVIN));		// 0.05 K
+		CHECK_EQUAL(INT16_MAX, units_temp(INT16_MAX, UNITS_FAHRENHEIT));
+		CHECK_EQUAL(INT16_MIN, units_temp(INT16_MIN, UNITS_FAHRENHEIT));
+		CHECK_EQUAL(INT16_MAX, units_temp(INT16_MAX, UNITS_KELVIN));
+		CHECK_EQUAL(253, units_temp(253, UNITS_CELSIUS));
+		CHECK_EQUAL(253, units_temp(253, 7));					// unknown units stay Celsius
+	}
+
+	static void test_symbols(void)
+	{
+		CHECK_TEXT("C", units_temp_symbol(UNITS_CELSIUS));
+		CHECK_TEXT("F", units_temp_symbol(UNITS_FAHRENHEIT));
+		CHECK_TEXT("K", units_temp_symbol(UNITS_KELVIN));
+		CHECK_TEXT("C", units_temp_symbol(7));
+	}
+
+	int main(void)
+	{
+		test_exhaustive();
+		test_vectors();
+		test_symbols();
+
+		return test_report("UnitsTest");
+	}